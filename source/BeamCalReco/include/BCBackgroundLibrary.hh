@@ -0,0 +1,67 @@
+#ifndef BCBACKGROUNDLIBRARY_HH
+#define BCBACKGROUNDLIBRARY_HH 1
+
+#include "BCPadEnergies.hh"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Pregenerated background bunch crossings in a flat binary file, which is mapped    //
+// into memory, so the energies are added straight from the page cache. The file is  //
+// written with ConvertBeamCalBackground from the bcTree of the background ROOT files //
+//                                                                                   //
+// Layout: a 64 byte header followed by the bunch crossings, each with the pads of   //
+// the left and then of the right BeamCal as float or double, every array starting   //
+// at a multiple of 64 bytes. Numbers are stored in the byte order of the machine    //
+///////////////////////////////////////////////////////////////////////////////////////
+
+class BCBackgroundLibrary {
+
+public:
+
+  enum ElementType_t { kFloat = 4, kDouble = 8 };
+
+  /// Map the file, throws std::runtime_error if it cannot be opened or is not a valid library
+  explicit BCBackgroundLibrary(const std::string& fileName);
+  ~BCBackgroundLibrary();
+
+  /// Check if the file starts with the header of a background library
+  static bool isBackgroundLibrary(const std::string& fileName);
+
+  inline int getNumberOfBunchCrossings() const { return m_nBunchCrossings; }
+  inline int getPadsPerBeamCal() const { return m_nPads; }
+  inline ElementType_t getElementType() const { return m_elementType; }
+  inline const std::string& getFileName() const { return m_fileName; }
+
+  /// Add the energies of the bunch crossing to the pads of the given side
+  void addEnergies(int bunchCrossing, BCPadEnergies::BeamCalSide_t side, BCPadEnergies& energies) const;
+
+  /// Write the header for a library with nBunchCrossings of nPads each
+  static void writeHeader(std::ostream& output, ElementType_t elementType, int nPads, int nBunchCrossings);
+  /// Append one bunch crossing, this has to be called nBunchCrossings times after writeHeader
+  static void writeBunchCrossing(std::ostream& output, ElementType_t elementType,
+				 const std::vector<double>& left, const std::vector<double>& right);
+
+private:
+  /// Bytes of one side of a bunch crossing, including the padding
+  static long getArraySize(ElementType_t elementType, int nPads);
+
+  std::string m_fileName;
+  ElementType_t m_elementType;
+  int m_nPads;
+  int m_nBunchCrossings;
+  long m_arraySize;
+  long m_dataOffset;
+
+  const char* m_mapping;
+  long m_mappingSize;
+
+public:
+  BCBackgroundLibrary(const BCBackgroundLibrary&);
+  BCBackgroundLibrary& operator=(const BCBackgroundLibrary&);
+
+};
+
+#endif // BCBACKGROUNDLIBRARY_HH
@@ -0,0 +1,64 @@
+#ifndef BCBACKGROUNDSAMPLER_HH
+#define BCBACKGROUNDSAMPLER_HH 1
+
+#include <vector>
+
+class BCGaussianGenerator;
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Samples the energy summed over nBX bunch crossings in the pads of one BeamCal     //
+// from the fitted energy distribution of a single bunch crossing. A bunch crossing  //
+// leaves no energy with probability zeroRate, otherwise the energy follows the      //
+// given density, whose cumulative distribution is tabulated at init. The number of  //
+// bunch crossings with energy is drawn from the binomial distribution, so an event  //
+// only needs one table lookup for each bunch crossing with energy, where a guide    //
+// table gives the bin to start searching from                                       //
+///////////////////////////////////////////////////////////////////////////////////////
+
+class BCBackgroundSampler {
+
+public:
+
+  typedef double (*Density_t)(double *x, double *parameters);
+
+  BCBackgroundSampler(int nPads, int nBX);
+
+  /**
+   * Tabulate the density on [minimum, maximum] for this pad. Returns false and leaves
+   * the pad without distribution if the integral of the density is below minimumIntegral
+   */
+  bool setDistribution(int pad, double zeroRate, Density_t density, double *parameters,
+		       double minimum, double maximum, double minimumIntegral);
+
+  inline bool hasDistribution(int pad) const { return m_tableOffset[pad] >= 0; }
+
+  /// energy of nBX bunch crossings in the pad, the pad must have a distribution
+  double sample(int pad, BCGaussianGenerator& random) const;
+
+private:
+  /// number of equally wide energy bins of the cumulative distribution
+  static const int nBins = 100;
+  /// number of steps used to integrate the density in each bin
+  static const int nStepsPerBin = 10;
+
+  int drawNonZeroBX(int pad, BCGaussianGenerator& random) const;
+
+  int m_nBX;
+  /// start of the table of the pad in m_cumulative, -1 if it has no distribution
+  std::vector<int> m_tableOffset;
+  /// normalised cumulative distribution at the nBins+1 edges of the energy bins
+  std::vector<float> m_cumulative;
+  /// first bin reaching u = i/nBins for each i, the start of the search for u
+  std::vector<unsigned char> m_guide;
+  std::vector<double> m_minimum;
+  std::vector<double> m_binWidth;
+
+  /// binomial distribution of the number of bunch crossings with (or, if flipped, without)
+  /// energy: probability of zero, and the ratio p/(1-p) for the recursion
+  std::vector<double> m_binomialZero;
+  std::vector<double> m_binomialRatio;
+  std::vector<bool> m_binomialFlipped;
+
+};
+
+#endif // BCBACKGROUNDSAMPLER_HH
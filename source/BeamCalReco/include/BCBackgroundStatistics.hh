@@ -0,0 +1,71 @@
+#ifndef BCBACKGROUNDSTATISTICS_HH
+#define BCBACKGROUNDSTATISTICS_HH 1
+
+#include <vector>
+
+class BCPadEnergies;
+class BCTowerCovariance;
+class BeamCalGeo;
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Mean and standard deviation of the pad and tower energies of background samples,   //
+// updated sample by sample, so the samples are not kept. The means are the plain     //
+// sums divided by the number of samples, the squares and the covariance are summed   //
+// with Welford's method. The tower energy is the sum over the layers used for the    //
+// tower chi2, the covariance is only accumulated for the pads given to               //
+// setCovariancePads                                                                  //
+////////////////////////////////////////////////////////////////////////////////////////
+
+class BCBackgroundStatistics {
+
+public:
+
+  /// towers are summed over nLayers starting from startLayer
+  BCBackgroundStatistics(const BeamCalGeo& bcg, int startLayer, int nLayers);
+
+  /// Accumulate the covariance of these pads, has to be called before the first sample
+  void setCovariancePads(const std::vector<int>& padIndices);
+
+  /// Also add the tower energies of every sample to this covariance, which is not owned
+  void setTowerCovariance(BCTowerCovariance* towerCovariance) { m_towerCovariance = towerCovariance; }
+
+  void addSample(const BCPadEnergies& sample);
+
+  inline int getNumberOfSamples() const { return m_nSamples; }
+
+  /// standard deviations are divided by the number of samples, not the number minus one, as the
+  /// background errors always were. The covariances are divided by the number minus one
+  void getMeans(BCPadEnergies& means) const;
+  void getSigmas(BCPadEnergies& sigmas) const;
+  void getTowerSigmas(std::vector<double>& sigmas) const;
+  double getTotalEnergyMean() const;
+  double getTotalEnergySigma() const;
+
+  inline const std::vector<int>& getCovariancePads() const { return m_covariancePads; }
+  /// Covariance of the covariance pads in the order given, row by row, divided by the number of samples minus one
+  void getCovariance(std::vector<double>& covariance) const;
+
+private:
+  int m_padsPerLayer;
+  int m_startLayer;
+  int m_nLayers;
+  int m_nSamples;
+
+  std::vector<double> m_padSums;
+  std::vector<double> m_padSquares;
+  std::vector<double> m_towerSums;
+  std::vector<double> m_towerSquares;
+  double m_totalEnergySum;
+  double m_totalEnergySquares;
+
+  std::vector<int> m_covariancePads;
+  std::vector<double> m_comoments;
+  BCTowerCovariance* m_towerCovariance;
+
+  /// scratch for the tower energies and the differences to the mean of one sample
+  std::vector<double> m_towerEnergies;
+  std::vector<double> m_deltas;
+
+};
+
+#endif // BCBACKGROUNDSTATISTICS_HH
@@ -0,0 +1,100 @@
+#ifndef BCCLUSTERBATCH_HH
+#define BCCLUSTERBATCH_HH 1
+
+#include "BCClusterWorkspace.hh"
+#include "BCPadEnergies.hh"
+
+#include <mutex>
+#include <vector>
+
+class BCPCuts;
+class BeamCalGeo;
+class TaskPool;
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Clustering of many events of one BeamCal side in one call, for scans over signal  //
+// and background overlays outside of Marlin. The pad energies of all events are one //
+// array, event after event, the background and its sigma are shared by the events.  //
+// The clusters are the same as from the BCPadEnergies functions, but only their     //
+// sums are kept, in one table for all events. With a TaskPool the events are shared //
+// out between the threads in small groups, the table is in the order of the events //
+///////////////////////////////////////////////////////////////////////////////////////
+
+class BCClusterBatch {
+
+public:
+
+  /// One reconstructed cluster, the angles as in BeamCalCluster
+  struct Cluster_t {
+    int event;
+    /// seed tower, i.e. the pad index in the layer
+    int seedTower;
+    int nPads;
+    double energy;
+    double theta;
+    double phi;
+    double ring;
+  };
+
+  BCClusterBatch(const BeamCalGeo& bcg, BCPadEnergies::BeamCalSide_t side);
+  ~BCClusterBatch();
+
+  /// number of pads of one event in the energy array
+  inline int getPadsPerEvent() const { return m_padsPerBeamCal; }
+
+  /// Same as BCPadEnergies::lookForNeighbouringClustersOverSigma for every event
+  void lookForNeighbouringClustersOverSigma(const std::vector<double>& energies, const BCPadEnergies& backgroundSigma,
+					    const BCPCuts& cuts, TaskPool* pool = NULL);
+  /// Same as BCPadEnergies::lookForNeighbouringClustersOverWithVetoAndCheck for every event
+  void lookForNeighbouringClustersOverWithVetoAndCheck(const std::vector<double>& energies, const BCPadEnergies& background,
+						       const BCPadEnergies& backgroundSigma, const BCPCuts& cuts,
+						       TaskPool* pool = NULL);
+
+  /// clusters of all events of the last call, ordered by event
+  inline const std::vector<Cluster_t>& getClusters() const { return m_clusters; }
+  inline int getNumberOfEvents() const { return int(m_firstCluster.size()) - 1; }
+  /// clusters of the event are getClusters()[getFirstCluster(event)..getFirstCluster(event+1))
+  inline int getFirstCluster(int event) const { return m_firstCluster[event]; }
+
+private:
+  /// scratch of one thread
+  struct Scratch_t {
+    Scratch_t(const BeamCalGeo& bcg, BCPadEnergies::BeamCalSide_t side);
+    BCPadEnergies testPads;
+    BCClusterWorkspace workspace;
+    /// sums over the pads of each cluster
+    std::vector<BCPadEnergies::ClusterSums_t> sums;
+  };
+
+  void reconstruct(const std::vector<double>& energies, const BCPadEnergies* background,
+		   const BCPadEnergies& backgroundSigma, const BCPCuts& cuts, TaskPool* pool);
+  void reconstructEvent(int event, const double* energies, const BCPadEnergies* background,
+			const BCPadEnergies& backgroundSigma, const BCPCuts& cuts, Scratch_t& scratch,
+			std::vector<Cluster_t>& clusters) const;
+
+  Scratch_t* takeScratch();
+  void returnScratch(Scratch_t* scratch);
+
+  const BeamCalGeo& m_BCG;
+  BCPadEnergies::BeamCalSide_t m_side;
+  int m_padsPerBeamCal;
+
+  std::vector<Cluster_t> m_clusters;
+  std::vector<int> m_firstCluster;
+
+  /// clusters of each group of events, before they are joined in m_clusters
+  std::vector< std::vector<Cluster_t> > m_groupClusters;
+  std::vector< std::vector<int> > m_groupFirstCluster;
+
+  /// scratch objects not in use, all of them are owned
+  std::vector<Scratch_t*> m_freeScratch;
+  std::vector<Scratch_t*> m_allScratch;
+  std::mutex m_scratchMutex;
+
+public:
+  BCClusterBatch(const BCClusterBatch&) = delete;
+  BCClusterBatch& operator=(const BCClusterBatch&) = delete;
+
+};
+
+#endif // BCCLUSTERBATCH_HH
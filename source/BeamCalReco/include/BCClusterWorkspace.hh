@@ -0,0 +1,86 @@
+#ifndef BCCLUSTERWORKSPACE_HH
+#define BCCLUSTERWORKSPACE_HH 1
+
+#include <cstddef>
+#include <vector>
+
+class BCPadEnergies;
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Scratch arrays for the tower clustering in BCPadEnergies, indexed by the tower, //
+// i.e. the pad index in the layer, and the pads with the background subtracted.   //
+// Keep one object and pass it for every event so that the clustering does not     //
+// have to allocate memory once the sizes are known                                //
+/////////////////////////////////////////////////////////////////////////////////////
+
+class BCClusterWorkspace {
+
+  friend class BCPadEnergies;
+  friend class BCClusterBatch;
+
+public:
+
+  BCClusterWorkspace():
+    m_padsPerLayer(0),
+    m_towerSize(),
+    m_towerUsed(),
+    m_towerCluster(),
+    m_parent(),
+    m_seedOfRoot(),
+    m_clusterOfRoot(),
+    m_towers(),
+    m_seeds(),
+    m_stack(),
+    m_padIndices(),
+    m_padsForClusters(),
+    m_nClusters(0),
+    m_testPads(NULL)
+  {}
+
+  ~BCClusterWorkspace();
+
+private:
+
+  /// resize for the geometry and reset everything touched by the previous event
+  void reset(int padsPerLayer);
+  /// count the pads in the towers and fill the sorted list of towers with pads
+  void fillTowers(std::vector<int> const& padIndices);
+  /// a copy of the pads in the buffer kept from the last call, it is only allocated
+  /// again if the geometry changed
+  BCPadEnergies& copyTestPads(BCPadEnergies const& pads);
+
+  int m_padsPerLayer;
+
+  /// number of accepted pads in each tower
+  std::vector<int> m_towerSize;
+  /// tower already belongs to a cluster
+  std::vector<bool> m_towerUsed;
+  /// index of the cluster of the tower, -1 if it is not part of a cluster
+  std::vector<int> m_towerCluster;
+  /// union-find forest, the seed tower and the cluster of the roots
+  std::vector<int> m_parent;
+  std::vector<int> m_seedOfRoot;
+  std::vector<int> m_clusterOfRoot;
+
+  /// towers with accepted pads, sorted
+  std::vector<int> m_towers;
+  /// seed tower of each cluster
+  std::vector<int> m_seeds;
+  /// towers still to check for neighbours
+  std::vector<int> m_stack;
+
+  /// accepted pads and the pads making up every cluster
+  std::vector<int> m_padIndices;
+  std::vector< std::vector<int> > m_padsForClusters;
+  int m_nClusters;
+
+  /// the pads of the event with the background subtracted
+  BCPadEnergies* m_testPads;
+
+public:
+  BCClusterWorkspace(const BCClusterWorkspace&) = delete;
+  BCClusterWorkspace& operator=(const BCClusterWorkspace&) = delete;
+
+};
+
+#endif // BCCLUSTERWORKSPACE_HH
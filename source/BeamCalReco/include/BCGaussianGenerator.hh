@@ -0,0 +1,51 @@
+#ifndef BCGAUSSIANGENERATOR_HH
+#define BCGAUSSIANGENERATOR_HH 1
+
+#include <stdint.h>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////
+// Gaussian random numbers for whole arrays of pads. The uniform numbers come from  //
+// the counter based Philox4x32-10 generator, so the sequence only depends on the   //
+// seed, and are generated in batches. They are turned into gaussian numbers with   //
+// the ziggurat method, which mostly needs a table lookup and one multiplication    //
+//////////////////////////////////////////////////////////////////////////////////////
+
+class BCGaussianGenerator {
+
+public:
+
+  BCGaussianGenerator();
+
+  /// Restart the sequence for this seed
+  void setSeed(uint32_t seed);
+
+  /// out[i] = means[i] + sigmas[i] * gaussian random number
+  void fill(double *out, const double *means, const double *sigmas, int n);
+  /// out[i] += sigmas[i] * gaussian random number
+  void add(double *out, const double *sigmas, int n);
+
+  /// One gaussian random number with mean 0 and standard deviation 1
+  double gaus();
+  /// Uniform random number in (0, 1) from the same sequence
+  inline double uniform() { return ( double( next() >> 11 ) + 0.5 ) * ( 1.0 / 9007199254740992.0 ); }
+
+private:
+  /// next 64 random bits
+  inline uint64_t next() {
+    if( m_position == m_buffer.size() ) refill();
+    return m_buffer[m_position++];
+  }
+
+  void refill();
+  /// the rare case of the ziggurat outside of the rectangle of the layer, false if u is rejected
+  bool gausOutside(double u, int layer, double &x);
+
+  uint32_t m_key[2];
+  uint64_t m_counter;
+  std::vector<uint64_t> m_buffer;
+  unsigned int m_position;
+
+};
+
+#endif // BCGAUSSIANGENERATOR_HH
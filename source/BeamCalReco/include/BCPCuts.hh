@@ -23,6 +23,7 @@ public:
     m_startLookingInLayer( 10 ),
     m_NShowerCountingLayers( 3 ),
     m_useConstPadCuts( false ),
+    m_useConnectedTowerClustering( false ),
     m_padSigmaCut( 0.0 )
   {
     m_startingRings.push_back(0);  m_requiredRemainingEnergy.push_back(0.2);  m_requiredClusterEnergy.push_back(3.0);
@@ -50,16 +51,21 @@ public:
     m_startLookingInLayer( startLayer),
     m_NShowerCountingLayers( countingLayers),
     m_useConstPadCuts(usePadCuts),
+    m_useConnectedTowerClustering( false ),
     m_padSigmaCut( sigmaCut )
   {}
 
   bool isPadAboveThreshold(int padRing, double padEnergy) const;
+  /// energy a pad in this ring needs for isPadAboveThreshold, NaN if no pad in the ring passes
+  double getPadThreshold(int padRing) const;
   bool isClusterAboveThreshold(BeamCalCluster const& bcc) const;
   int getMinimumTowerSize() const { return m_minimumTowerSize; }
   int getStartingLayer() const { return m_startLookingInLayer; }
   int getCountingLayers() const { return m_NShowerCountingLayers;}
 
   bool useConstPadCuts() const { return m_useConstPadCuts; }
+  ///Cluster the towers with the connected component (union-find) algorithm, gives the same clusters
+  bool useConnectedTowerClustering() const { return m_useConnectedTowerClustering; }
 
   double getPadSigmaCut() const { return m_padSigmaCut; }
 
@@ -67,6 +73,7 @@ public:
   BCPCuts& setSigmaCut(double cut) { m_padSigmaCut = cut; return *this;}
   BCPCuts& setStartLayer(int layer) { m_startLookingInLayer = layer; return *this;}
   BCPCuts& setMinimumTowerSize( int tSize) { m_minimumTowerSize = tSize; return *this; }
+  BCPCuts& setUseConnectedTowerClustering( bool use ) { m_useConnectedTowerClustering = use; return *this; }
 
   inline float getMinPadEnergy() const { return m_requiredRemainingEnergy[0]; }
 
@@ -86,6 +93,7 @@ private:
   int m_startLookingInLayer;
   int m_NShowerCountingLayers;
   bool m_useConstPadCuts;
+  bool m_useConnectedTowerClustering;
 
   double m_padSigmaCut;
 
@@ -7,10 +7,14 @@
 
 class BeamCalGeo;
 class BeamCalCluster;
+class BCClusterBatch;
+class BCClusterWorkspace;
 class BCPCuts;  
 
 class BCPadEnergies{
 
+  friend class BCClusterBatch;
+
 public:
 
   typedef std::map<int, int> TowerIndexList;
@@ -19,6 +23,20 @@ public:
 
   enum BeamCalSide_t { kUnknown = -1, kLeft = 0 , kRight = 1};
 
+  /// The energy weighted sums over the pads of a cluster, for getClusterFromAcceptedPads
+  /// and BCClusterBatch, so that both average in the same way
+  struct ClusterSums_t {
+    ClusterSums_t(): nPads(0), energy(0.0), ring(0.0), theta(0.0), sinPhi(0.0), cosPhi(0.0) {}
+    void addPad(const BeamCalGeo& geo, int padIndex, double padEnergy);
+    /// averaged phi in degrees, ring and theta in mrad, -9999 without energy; the phi of
+    /// the right side is turned around for global coordinates
+    void getAverages(BeamCalSide_t side, double& phi, double& averageRing, double& averageTheta) const;
+    int nPads;
+    double energy, ring, theta;
+    /// Averaging an azimuthal angle is done via sine and cosine
+    double sinPhi, cosPhi;
+  };
+
 
   BCPadEnergies(const BeamCalGeo& bcg, BeamCalSide_t side = kUnknown);
   BCPadEnergies(const BeamCalGeo* bcg, BeamCalSide_t side = kUnknown);
@@ -50,6 +68,7 @@ public:
   double getTotalEnergy() const;
 
   std::vector<double>* getEnergies();
+  const std::vector<double>* getEnergies() const;
   int getTowerEnergies(int padIndex, std::vector<double> & te) const;
   double getTowerEnergy(int padIndex, int startLayer) const;
  
@@ -59,9 +78,18 @@ public:
   BeamCalCluster lookForNeighbouringClustersOver(const BCPadEnergies &background, const BCPCuts &cuts) const ;
   BeamCalCluster lookForNeighbouringClustersOverWithVeto(const BCPadEnergies &background, const BCPCuts &cuts) const ;
   BeamCalClusterList lookForNeighbouringClustersOverWithVetoAndCheck(const BCPadEnergies &background, const BCPadEnergies &backgroundSigma, const BCPCuts &cuts) const ;
+  BeamCalClusterList lookForNeighbouringClustersOverWithVetoAndCheck(const BCPadEnergies &background, const BCPadEnergies &backgroundSigma, const BCPCuts &cuts,
+								     BCClusterWorkspace &workspace) const ;
 
   BeamCalClusterList lookForNeighbouringClustersOverSigma( const BCPadEnergies &backgroundSigma, const BCPCuts &cuts, bool detailedPrintout = false) const;
+  BeamCalClusterList lookForNeighbouringClustersOverSigma( const BCPadEnergies &backgroundSigma, const BCPCuts &cuts,
+							   BCClusterWorkspace &workspace, bool detailedPrintout = false) const;
+
 
+  /// The pad selections of the clustering, for energies of all pads of the geometry in any array
+  static void selectPadsAboveThresholds(const BeamCalGeo& geo, const double* energies, const BCPCuts& cuts, PadIndexList& myPadIndices);
+  static void selectPadsAboveSigma(const BeamCalGeo& geo, const double* energies, const BCPadEnergies& sigmas, const BCPCuts& cuts,
+				   PadIndexList& myPadIndices);
 
   inline void setSide(BeamCalSide_t side) { m_side = side; }
   inline BeamCalSide_t getSide() const { return m_side; }
@@ -74,18 +102,18 @@ private:
   //Reconstruction functions
   PadIndexList getPadsAboveThresholds(const BCPadEnergies& testPads, const BCPCuts& cuts) const;
   PadIndexList getPadsAboveSigma(const BCPadEnergies& sigmas, const BCPCuts& cuts) const;
+  void getPadsAboveThresholds(const BCPadEnergies& testPads, const BCPCuts& cuts, PadIndexList& myPadIndices) const;
+  void getPadsAboveSigma(const BCPadEnergies& sigmas, const BCPCuts& cuts, PadIndexList& myPadIndices) const;
   BeamCalCluster getClusterFromAcceptedPads(const BCPadEnergies& testPads, const PadIndexList& myPadIndices, const BCPCuts& cuts) const;
-  void clusterNextToNearestNeighbourTowers(const PadIndexList &myPadIndices, const BCPCuts &cuts, BeamCalClusterList &BeamCalClusters, bool DetailedPrintout=false) const;
+
+  //The accepted pads are in the workspace, the towers are numbered by their cluster in the workspace
+  void clusterNextToNearestNeighbourTowers(BCClusterWorkspace &workspace, const BCPCuts &cuts, bool DetailedPrintout=false) const;
+  void clusterConnectedTowers(BCClusterWorkspace &workspace, const BCPCuts &cuts, bool DetailedPrintout=false) const;
+  void createClustersFromTowers(BCClusterWorkspace &workspace, const BCPCuts &cuts, BeamCalClusterList &BeamCalClusters) const;
 
   static TowerIndexList getTowersFromPads( BeamCalGeo const& geo, const PadIndexList& myPadIndices);
   //towerNumber is cellId in Layer i.e. gloadPadID % m_nPadsPerLayer
   static void removeTowerFromPads ( BeamCalGeo const& geo, PadIndexList& myPadIndices, int towerNumber );
-  static void removeTowersFromPads( BeamCalGeo const& geo, PadIndexList& myPadIndices, TowerIndexList towerNumbers);
-
-  static PadIndexList getPadsFromTowers ( BeamCalGeo const& geo,
-					  PadIndexList const& allPads, 
-					  TowerIndexList const& towers);
-
 
   std::string streamPad(int padId) const;
 
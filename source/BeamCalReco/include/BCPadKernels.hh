@@ -0,0 +1,46 @@
+#ifndef BCPadKernels_hh
+#define BCPadKernels_hh 1
+
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Element-wise operations on the pad energies of a BeamCal, used by BCPadEnergies //
+// and the shower fit. The AVX2 versions are used if the CPU supports them,        //
+// otherwise plain loops. Both give identical results, the dot product uses four   //
+// partial sums in either case.                                                    //
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace BCPadKernels {
+
+  enum Implementation_t { kScalar = 0, kAVX2 = 1 };
+
+  /// energies[i] += other[i]
+  void add(double *energies, const double *other, int n);
+  /// energies[i] += other[i], for energies stored in single precision
+  void add(double *energies, const float *other, int n);
+  /// energies[i] -= other[i]
+  void subtract(double *energies, const double *other, int n);
+  /// energies[i] += factor * other[i]
+  void addScaled(double *energies, const double *other, double factor, int n);
+  /// energies[i] *= factor
+  void scale(double *energies, double factor, int n);
+  /// sum of a[i] * b[i]
+  double dot(const double *a, const double *b, int n);
+
+  /// append offset+i to indices for all energies[i] > max(sigmaCut*sigmas[i], minEnergy)
+  void selectAboveSigma(const double *energies, const double *sigmas, double sigmaCut, double minEnergy,
+			int n, int offset, std::vector<int>& indices);
+  /// append offset+i to indices for all energies[i] >= threshold
+  void selectAtLeast(const double *energies, double threshold, int n, int offset, std::vector<int>& indices);
+
+  /// the implementation currently in use
+  Implementation_t getImplementation();
+  /// the best implementation supported by this CPU
+  Implementation_t getBestImplementation();
+  /// use the given implementation, returns false if it is not supported and nothing was changed
+  bool setImplementation(Implementation_t implementation);
+  const char* getImplementationName(Implementation_t implementation);
+
+}
+
+#endif // BCPadKernels_hh
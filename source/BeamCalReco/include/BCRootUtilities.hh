@@ -22,16 +22,19 @@ namespace BCUtil{
 		     );
 
 
+  /// Does not touch the error level if errors are already ignored, so that it can be
+  /// nested inside another IgnoreRootError covering several threads
   class IgnoreRootError {
   public:
-    IgnoreRootError(bool enable=true): orgErrorLevel(gErrorIgnoreLevel) {
-      if( enable ) { gErrorIgnoreLevel=kError+1; }
+    IgnoreRootError(bool enable=true): orgErrorLevel(gErrorIgnoreLevel), changed(enable && gErrorIgnoreLevel <= kError) {
+      if( changed ) { gErrorIgnoreLevel=kError+1; }
     }
     ~IgnoreRootError(){
-      gErrorIgnoreLevel=orgErrorLevel;
+      if( changed ) { gErrorIgnoreLevel=orgErrorLevel; }
     }
   private:
     int orgErrorLevel;
+    bool changed;
   };
 
 }//end namespace
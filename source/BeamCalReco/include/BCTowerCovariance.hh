@@ -0,0 +1,53 @@
+#ifndef BCTOWERCOVARIANCE_HH
+#define BCTOWERCOVARIANCE_HH 1
+
+#include <vector>
+
+class BeamCalGeo;
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Covariance of the tower energies of background samples, updated sample by sample   //
+// with Welford's method. Only pairs of towers closer than a given distance are kept, //
+// so that the covariance of any group of towers inside a shower spot can be looked   //
+// up after the samples are added, without keeping the samples                        //
+////////////////////////////////////////////////////////////////////////////////////////
+
+class BCTowerCovariance {
+
+public:
+
+  /// keep the covariance of all towers whose centres are closer than distance
+  BCTowerCovariance(const BeamCalGeo& bcg, double distance);
+
+  /// energies of all towers of one sample
+  void addSample(const std::vector<double>& towerEnergies);
+
+  inline int getNumberOfSamples() const { return m_nSamples; }
+  inline double getDistance() const { return m_distance; }
+
+  /**
+   * Covariance of the towers in the order given, row by row, divided by the number of
+   * samples minus one like BCBackgroundStatistics::getCovariance. Towers further apart
+   * than the distance are taken as uncorrelated
+   */
+  void getCovariance(const std::vector<int>& towers, std::vector<double>& covariance) const;
+
+private:
+  /// covariance of the tower pair, 0 if it is not kept
+  double getCovariance(int tower1, int tower2) const;
+
+  double m_distance;
+  int m_nSamples;
+
+  /// partners of tower i, including itself, are m_partners[m_firstPartner[i]..m_firstPartner[i+1]), sorted
+  std::vector<int> m_firstPartner;
+  std::vector<int> m_partners;
+  std::vector<double> m_comoments;
+
+  std::vector<double> m_means;
+  /// scratch for the differences to the old means of one sample
+  std::vector<double> m_deltas;
+
+};
+
+#endif // BCTOWERCOVARIANCE_HH
@@ -0,0 +1,40 @@
+#ifndef BCTOWERENERGIES_HH
+#define BCTOWERENERGIES_HH 1
+
+#include <vector>
+
+class BCPadEnergies;
+class BeamCalGeo;
+
+//////////////////////////////////////////////////////////////////////////////////////
+// The pad energies of a BeamCal ordered by tower, i.e. the energies of all layers  //
+// of one tower follow each other. BCPadEnergies keeps all pads of a layer together //
+// so getTowerEnergies has to collect one value per layer, here it is a plain array //
+//////////////////////////////////////////////////////////////////////////////////////
+
+class BCTowerEnergies {
+
+public:
+
+  explicit BCTowerEnergies(const BeamCalGeo& bcg);
+  explicit BCTowerEnergies(const BCPadEnergies& bcp);
+
+  /// Copy the energies from the layer ordered pads
+  void setEnergies(const BCPadEnergies& bcp);
+
+  /// Energies in all layers of the tower, the tower is the pad index in the layer
+  inline const double* getTowerEnergies(int tower) const { return &m_towerEnergies[ tower*m_nLayers ]; }
+  /// Sum of the energies in the tower starting from startLayer
+  double getTowerEnergy(int tower, int startLayer) const;
+
+  inline int getNTowers() const { return m_nTowers; }
+  inline int getNLayers() const { return m_nLayers; }
+
+private:
+  int m_nTowers;
+  int m_nLayers;
+  std::vector<double> m_towerEnergies;
+
+};
+
+#endif // BCTOWERENERGIES_HH
@@ -13,11 +13,12 @@
 
 #include "BCPadEnergies.hh"
 
-class TRandom3;
 class TTree;
 
 class BeamCalGeo;
+class BeamCalBkgContext;
 class BCPCuts;
+class BCTowerCovariance;
 
 using std::vector;
 using std::string;
@@ -60,8 +61,6 @@ class BeamCalBkg {
 
   int m_nBX;
 
-  vector<double> *m_BeamCalDepositsLeft;
-  vector<double> *m_BeamCalDepositsRight;
   BCPadEnergies* m_BeamCalAverageLeft;
   BCPadEnergies* m_BeamCalAverageRight;
 
@@ -71,7 +70,15 @@ class BeamCalBkg {
   vector<double>* m_TowerErrorsLeft;
   vector<double>* m_TowerErrorsRight;
 
-  TRandom3 *m_random3;
+  /// covariance of neighbouring tower energies, only filled by methods which can estimate it
+  BCTowerCovariance* m_TowerCovarianceLeft;
+  BCTowerCovariance* m_TowerCovarianceRight;
+  double m_towerCovarianceDistance;
+  /// measure the tower errors from the tower energies instead of adding the pad errors in quadrature
+  bool m_correlatedTowerErrors;
+
+  /// context of the single threaded interface, created on first use
+  BeamCalBkgContext *m_context;
 
   const BeamCalGeo *m_BCG;
   const BCPCuts *m_bcpCuts;
@@ -79,22 +86,47 @@ class BeamCalBkg {
  public:
   virtual void init(const int n_bx);
   virtual void init(vector<string>& bgfiles, const int n_bx) = 0;
-  void setRandom3Seed(const int seed);
   void setBCPCuts(const BCPCuts *bcpcuts) { m_bcpCuts = bcpcuts; }
+  /**
+   * Estimate the covariance of the tower energies during init, for towers closer than
+   * this distance. 0 switches it off. Has to be called before init
+   */
+  void setTowerCovarianceDistance(double distance) { m_towerCovarianceDistance = distance; }
+  /**
+   * Take the st.dev. of the tower energies of the background samples as the tower errors,
+   * including the correlations between the pads of a tower. Otherwise, and for methods
+   * without samples, the pad errors are added in quadrature. Has to be called before init
+   */
+  void setCorrelatedTowerErrors(bool correlated) { m_correlatedTowerErrors = correlated; }
+
+  /**
+   * New context for getEventBG, owned by the caller. Each thread drawing background
+   * events needs its own context, and has to seed it for every event. Only call after init
+   */
+  virtual BeamCalBkgContext* createContext() const;
+  virtual void getEventBG(BeamCalBkgContext &context, BCPadEnergies &peLeft, BCPadEnergies &peRight) const = 0;
+
+  /// Seed the context used by the single threaded getEventBG
+  void setRandom3Seed(const int seed);
+  void getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight);
 
-  virtual void getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight) = 0;
-  virtual void getAverageBG(BCPadEnergies &peLeft, BCPadEnergies &peRight);
-  virtual void getErrorsBG(BCPadEnergies &peLeft, BCPadEnergies &peRight);
+  virtual void getAverageBG(BCPadEnergies &peLeft, BCPadEnergies &peRight) const;
+  virtual void getErrorsBG(BCPadEnergies &peLeft, BCPadEnergies &peRight) const;
 
-//  commented out for now
-//  virtual int getPadsCovariance(vector<int> &pad_list, vector<double> &covinv, 
-//        const BCPadEnergies::BeamCalSide_t &bc_side) const;
+  /**
+   * Covariance of the tower energies of the towers in pad_list, row by row, estimated
+   * once at init. Towers further apart than the covariance distance are uncorrelated.
+   * Returns the number of elements, or -1 if the background method has no covariance
+   */
+  virtual int getPadsCovariance(const vector<int> &pad_list, vector<double> &covariance,
+        const BCPadEnergies::BeamCalSide_t bc_side) const;
 
   virtual int getTowerErrorsBG(int padIndex, const BCPadEnergies::BeamCalSide_t bc_side, 
-        double &tower_sigma);
+        double &tower_sigma) const;
 
  protected:
   virtual void setTowerErrors(const BCPadEnergies::BeamCalSide_t bc_side);
+  BeamCalBkgContext& getDefaultContext();
 
   public:
   BeamCalBkg(const BeamCalBkg&);
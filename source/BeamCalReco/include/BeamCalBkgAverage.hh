@@ -29,10 +29,16 @@ class BeamCalBkgAverage : public BeamCalBkg {
   BeamCalBkgAverage(const string &bg_method_name, const BeamCalGeo* BCG);
   ~BeamCalBkgAverage();
 
+ private:
+  /// errors scaled to the number of bunch crossings
+  vector<double> m_eventSigmasLeft;
+  vector<double> m_eventSigmasRight;
+
  public:
   void init(vector<string> &bg_files, const int n_bx);
 
-  void getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight);
+  using BeamCalBkg::getEventBG;
+  void getEventBG(BeamCalBkgContext &context, BCPadEnergies &peLeft, BCPadEnergies &peRight) const;
 
  public:
   BeamCalBkgAverage(const BeamCalBkgAverage&);
@@ -0,0 +1,38 @@
+/**
+* @file BeamCalBkgContext.hh
+* @brief Per-thread state for drawing BeamCal background events
+*/
+
+#pragma once
+
+class TRandom3;
+
+class BCGaussianGenerator;
+
+/**
+ * The random number generators used by BeamCalBkg::getEventBG. The averages, errors
+ * and tables of a BeamCalBkg are only read while drawing events, so every thread can
+ * draw events from the same BeamCalBkg with its own context. Contexts are created with
+ * BeamCalBkg::createContext, background methods reading files add their read buffers
+ * and file handles.
+ */
+class BeamCalBkgContext {
+ public:
+  BeamCalBkgContext();
+  virtual ~BeamCalBkgContext();
+
+  /// Seed all generators, the background of an event only depends on this seed
+  void setSeed(const int seed);
+
+  TRandom3& getRandom3() { return *m_random3; }
+  BCGaussianGenerator& getGaussian() { return *m_gaussian; }
+
+ private:
+  TRandom3 *m_random3;
+  BCGaussianGenerator *m_gaussian;
+
+ public:
+  BeamCalBkgContext(const BeamCalBkgContext&);
+  BeamCalBkgContext& operator=(const BeamCalBkgContext&);
+
+};
@@ -28,14 +28,11 @@ class BeamCalBkgGauss : public BeamCalBkg {
   BeamCalBkgGauss(const string &bg_method_name, const BeamCalGeo* BCG);
   ~BeamCalBkgGauss();
 
- private:
-  vector<PadEdepRndPar_t> *m_padParLeft;
-  vector<PadEdepRndPar_t> *m_padParRight;
-
  public:
   void init(vector<string> &bg_files, const int n_bx);
 
-  void getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight);
+  using BeamCalBkg::getEventBG;
+  void getEventBG(BeamCalBkgContext &context, BCPadEnergies &peLeft, BCPadEnergies &peRight) const;
 
  private:
   void readBackgroundPars(TTree *bg_par_tree, const BCPadEnergies::BeamCalSide_t bc_side);
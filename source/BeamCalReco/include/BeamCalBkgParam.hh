@@ -14,7 +14,7 @@
 #include "BeamCalBkg.hh"
 #include "BCPadEnergies.hh"
 
-class TF1;
+class BCBackgroundSampler;
 class TTree;
 
 class BeamCalGeo;
@@ -31,13 +31,15 @@ class BeamCalBkgParam : public BeamCalBkg {
   vector<PadEdepRndPar_t> *m_padParLeft;
   vector<PadEdepRndPar_t> *m_padParRight;
 
-  vector<TF1*> m_unuransLeft;
-  vector<TF1*> m_unuransRight;
+  /// tabulated energy distributions of the pads with a good fit, the others are gaussian
+  BCBackgroundSampler *m_samplerLeft;
+  BCBackgroundSampler *m_samplerRight;
 
  public:
   void init(vector<string> &bg_files, const int n_bx);
 
-  void getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight);
+  using BeamCalBkg::getEventBG;
+  void getEventBG(BeamCalBkgContext &context, BCPadEnergies &peLeft, BCPadEnergies &peRight) const;
 
  private:
   void readBackgroundPars(TTree *bg_par_tree, const BCPadEnergies::BeamCalSide_t bc_side);
@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "BeamCalBkg.hh"
+#include "BeamCalBkgContext.hh"
 #include "BCPadEnergies.hh"
 
 class TChain;
@@ -19,36 +20,118 @@ class TRandom3;
 class TTree;
 
 class BeamCalGeo;
+class BCBackgroundLibrary;
 
 using std::vector;
 using std::string;
 
+/// File handle, read buffers and summation state of one thread for BeamCalBkgPregen
+class BeamCalBkgPregenContext : public BeamCalBkgContext {
+ public:
+  BeamCalBkgPregenContext();
+  ~BeamCalBkgPregenContext();
+
+ private:
+  friend class BeamCalBkgPregen;
+
+  TChain* m_backgroundBX;
+  vector<double> *m_BeamCalDepositsLeft;
+  vector<double> *m_BeamCalDepositsRight;
+  int m_loadedBX;
+
+  /// pool of blocks of pre-summed bunch crossings, the next block to redraw
+  vector<BCPadEnergies*> m_blocksLeft;
+  vector<BCPadEnergies*> m_blocksRight;
+  int m_nextBlock;
+
+  /// blocks or bunch crossings making up the background of the last event, and their sum
+  vector<int> m_eventUnits;
+  BCPadEnergies* m_eventSumLeft;
+  BCPadEnergies* m_eventSumRight;
+  BCPadEnergies* m_scratchLeft;
+  BCPadEnergies* m_scratchRight;
+  int m_eventsSinceFullSum;
+
+ public:
+  BeamCalBkgPregenContext(const BeamCalBkgPregenContext&);
+  BeamCalBkgPregenContext& operator=(const BeamCalBkgPregenContext&);
+
+};
+
 class BeamCalBkgPregen : public BeamCalBkg {
  public:
   BeamCalBkgPregen(const string &bg_method_name, const BeamCalGeo* BCG);
   ~BeamCalBkgPregen();
 
  private:
-  vector<BCPadEnergies*> m_listOfBunchCrossingsLeft;
-  vector<BCPadEnergies*> m_listOfBunchCrossingsRight;
+  /// ROOT files opened by every context
+  vector<string> m_files;
+  int m_nBackgroundBX;
 
-  TChain* m_backgroundBX;
+  /// binary background libraries used instead of the ROOT files, and the first entry in each
+  vector<BCBackgroundLibrary*> m_libraries;
+  vector<int> m_firstBXInLibrary;
 
   int m_numberForAverage;
 
+  int m_bxPerBlock;
+  int m_nBlocks;
+  double m_replaceFraction;
+
  public:
   void init(vector<string> &bg_files, const int n_bx);
+  /// Number of sums of nBX bunch crossings for the average background and its standard deviation, has to be called before init
   void setNumberForAverage(const int nav) { m_numberForAverage = nav; }
 
-  void getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight);
-
-//  commented out for now
-//  int getPadsCovariance(vector<int> &pad_list, vector<double> &covinv, 
-//        const BCPadEnergies::BeamCalSide_t &bc_side) const;
+  /**
+   * Build the background of an event from nBX/bxPerBlock blocks, drawn from a pool of
+   * nBlocks blocks of bxPerBlock pre-summed bunch crossings, instead of summing nBX
+   * bunch crossings. One block of the pool is redrawn for every event. The bunch
+   * crossings in a block are different, but blocks can share bunch crossings, so the
+   * backgrounds of different events are less independent for a smaller pool.
+   * bxPerBlock = 0 switches this off, nBlocks = 0 uses four times the blocks per event.
+   * Has to be called before init.
+   */
+  void setBlockSummation(int bxPerBlock, int nBlocks) { m_bxPerBlock = bxPerBlock; m_nBlocks = nBlocks; }
+  /**
+   * Only replace this fraction of the blocks, or of the bunch crossings without blocks,
+   * of the previous event. Consecutive events share the rest of their background.
+   * 1 draws a new background for every event. Must be in (0,1], below 1 it needs more
+   * bunch crossings (or blocks) than are used for one event, init throws otherwise.
+   */
+  void setReplaceFraction(double fraction) { m_replaceFraction = fraction; }
+
+  /**
+   * Every context opens its own TChain on the ROOT files, reading them from several
+   * threads needs ROOT::EnableThreadSafety(). The libraries are shared. The block pool
+   * and the background kept for the next event belong to the context, so with blocks or
+   * a replace fraction below 1 the background also depends on the earlier events of
+   * the context.
+   */
+  BeamCalBkgContext* createContext() const;
+  using BeamCalBkg::getEventBG;
+  void getEventBG(BeamCalBkgContext &context, BCPadEnergies &peLeft, BCPadEnergies &peRight) const;
 
  private:
-  BCPadEnergies* getBeamCalErrors(const BCPadEnergies *averages, 
-                   const std::vector<BCPadEnergies*> singles );
+  /// context with the TChain opened, without the summation state
+  BeamCalBkgPregenContext* openContext() const;
+  /// fill the block pool and prepare the sums of the context
+  void prepareSummation(BeamCalBkgPregenContext &context) const;
+
+  int getNumberOfBackgroundBX() const { return m_nBackgroundBX; }
+  /// add the energies of background entry bx to both sides
+  void addBackgroundBX(BeamCalBkgPregenContext &context, int bx, BCPadEnergies &peLeft, BCPadEnergies &peRight) const;
+
+  /// blocks or bunch crossings summed for every event
+  int getUnitsPerEvent() const;
+  int getNumberOfUnits() const;
+  void addUnit(BeamCalBkgPregenContext &context, int unit, BCPadEnergies &peLeft, BCPadEnergies &peRight) const;
+  void subtractUnit(BeamCalBkgPregenContext &context, int unit, BCPadEnergies &peLeft, BCPadEnergies &peRight) const;
+
+  void refreshBlock(BeamCalBkgPregenContext &context, int block) const;
+  void drawEventUnits(BeamCalBkgPregenContext &context) const;
+  void replaceEventUnits(BeamCalBkgPregenContext &context, int nReplace) const;
+  void sumEventUnits(BeamCalBkgPregenContext &context) const;
 
  public:
   BeamCalBkgPregen(const BeamCalBkgPregen&);
@@ -3,12 +3,16 @@
 
 class BCPadEnergies;
 
-#include <map>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 class BeamCalCluster{
   
 public:
+  /// global padIndex and energy, sorted by padIndex
+  typedef std::vector< std::pair<int, double> > PadEnergyList;
+
   BeamCalCluster():
     m_energy(0),
     m_padIndexInLayer(-1),
@@ -38,6 +42,8 @@ public:
   inline double getEnergy() const { return m_energy; }
 
   void addPad(int padIndex, double energy);
+  inline void reservePads(int nPads) { m_clusterPads.reserve(nPads); }
+  inline const PadEnergyList& getPads() const { return m_clusterPads; }
   void addPads(const BCPadEnergies& bcp);
   void getBCPad(BCPadEnergies& bcp) const;
 
@@ -50,9 +56,9 @@ private:
   /// layer with energy deposit?
   int m_padIndexInLayer;
   /// global padIndex and energy pad
-  std::map<int, double> m_clusterPads;
+  PadEnergyList m_clusterPads;
   /// global towerIndex and energy in tower
-  std::map<int, double> m_towerEnergies;
+  PadEnergyList m_towerEnergies;
   /// energy weighted azimuthal angle
   double m_averagePhi;//energyWeightedAzimuth
   /// energy weighted ring number
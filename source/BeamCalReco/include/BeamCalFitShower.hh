@@ -8,13 +8,17 @@
 
 #pragma once
 
+#include <iosfwd>
+#include <map>
+#include <string>
 #include <vector>
 #include <utility>
 #include "BCPadEnergies.hh"
+#include "BeamCalPadGeometry.hh"
 
 class BeamCalGeo;
 class BeamCalBkg;
-class BeamCalPadGeometry;
+class BCTowerEnergies;
 
 /**
 * @brief Segment parameters for profile of the calorimeter energy deposition
@@ -25,21 +29,40 @@ typedef struct {
   double totalEdep;
   double bkgEdep;
   double bkgSigma;
-  BeamCalPadGeometry *padGeom;
 } EdepProfile_t;
 
 
 class BeamCalFitShower {
  public:
   /**
-  * @brief Initialises the shower fitter
+  * @brief Initialises the shower fitter for one side of the BeamCal
   *
-  * @param vep profile of energy deposit in the BeamCal as a vector of 
-  * segment parameters.
+  * Keep one fitter for all events: the profile and the spot pads reuse their
+  * memory, so fitting does not allocate once the sizes are known.
   */
-  BeamCalFitShower(std::vector<EdepProfile_t*> &vep, const BCPadEnergies::BeamCalSide_t bc_side);
+  BeamCalFitShower(const BCPadEnergies::BeamCalSide_t bc_side);
   ~BeamCalFitShower(){};
 
+  /**
+  * @brief Starts the profile of energy deposit for a new event
+  *
+  * All nTowers segments must be filled through getTower, none of them is
+  * excluded from the search yet.
+  */
+  void resetProfile(int nTowers);
+  EdepProfile_t& getTower(int tower) { return m_vep[tower]; }
+
+  /**
+  * @brief Fills the profile segments of the towers firstTower..lastTower-1
+  *
+  * The tower chi2 compares the signal with the background average and st.dev. from
+  * the start layer on, the energies are summed over the counting layers, and the
+  * st.dev. of that sum is taken from the background. Separate ranges of towers can
+  * be filled in parallel.
+  */
+  void fillProfile(const BCTowerEnergies& signal, const BCTowerEnergies& average,
+		   const BCTowerEnergies& sigma, int firstTower, int lastTower);
+
   /**
    * @brief Copy constructor for shower fitter
    *
@@ -61,8 +84,8 @@ class BeamCalFitShower {
   * fits shower with 2d Gauss around it, estimates probability 
   * that it is actually a shower, calculates its parameters and returns all that
   *
-  * Independing on the probability, the fitted shower energy 
-  * is subtracted from the profile.
+  * Independing on the probability, the towers of the shower are
+  * excluded from the following searches in the profile.
   *
   * @param theta 
   * @param phi
@@ -73,6 +96,15 @@ class BeamCalFitShower {
   double fitShower(double &theta, double &phi, double &en_shwr, double &chi2);
 
   double operator()(const double *par);
+
+  /**
+  * @brief Derivative of the chi2 by the parameter icoord, for the GradFunctor of the fit
+  *
+  * The chi2 and its derivatives by all parameters are calculated together in one pass
+  * over the spot pads, and kept for the parameters of the last call. Needs the integral
+  * along the pad sides.
+  */
+  double Derivative(const double *par, unsigned int icoord);
   //double showerChi2(double *par);
   
   void setGeometry(const BeamCalGeo *BCG) { m_BCG = BCG; }
@@ -81,41 +113,111 @@ class BeamCalFitShower {
   void setCountingLayers(const int cl) { m_countingLayer = cl; }
   void setEshwrLimit(double elimit) { m_enTowerLimit = elimit; }
   void setTowerChi2Limit(double tchi2lim) { m_towerChi2Limit = tchi2lim;}
+  /**
+  * @brief Precision of the shower integral over the pads in the fit
+  *
+  * 0 integrates in radial shells, otherwise the integral is done along the
+  * pad sides to this fraction of the shower energy, which is faster.
+  */
+  void setIntegrationTolerance(double tolerance) { m_integrationTolerance = tolerance; }
+  /**
+  * @brief Use the analytic gradient of the chi2 in the fit, if the integral is done along the pad sides
+  */
+  void setUseGradient(bool useGradient) { m_useGradient = useGradient; }
+  /**
+  * @brief Use the covariance of the tower energies from the background in the chi2
+  *
+  * The background has to provide it for towers up to getSpotDiameter apart, otherwise,
+  * or if it is singular for the spot pads, the errors are taken as uncorrelated.
+  */
+  void setUseCovariance(bool useCovariance) { m_useCovariance = useCovariance; }
+  /**
+  * @brief Largest distance between the centres of two spot pads
+  */
+  double getSpotDiameter() const { return 2*m_spotRadius*m_rhom; }
+  /**
+  * @brief Stream for the warnings of the fit, if NULL they go to streamlog
+  *
+  * Fitters running in parallel must each have their own stream, which is printed
+  * once they are done.
+  */
+  void setWarnings(std::ostream* warnings) { m_warnings = warnings; }
 
  private:
   void estimateShowerPars(double &rc, double &phic, double &A0, double &sig0);
-  int selectSpotPads(std::vector<int> &pad_ids);
-  int calcCovar();
-  void deleteSpotPads();
+  int selectSpotPads();
+  void addSpotPad(int tower, bool isCentral);
+  bool setSpotCholesky();
+  double spotChi2(std::vector<double> *dChi2dEint);
+  void calcGradient(const double *par);
+  void removeSpotPads();
+  void warn(const std::string& message) const;
 
  private:
-  std::vector<EdepProfile_t*> m_vep;
+  std::vector<EdepProfile_t> m_vep;
   /**
-  * @brief List of profile segments falling into the shower spot
+  * @brief Towers of the profile already belonging to a found shower
   */
-  std::vector<EdepProfile_t*> m_spotPads;
+  std::vector<bool> m_removed;
 
   /**
-  * @brief Inverse covariance matrix for spot pads
+  * @brief Towers of the profile falling into the shower spot, the central one first, and their geometry
   */
-  std::vector<double> m_covInv;
+  std::vector<int> m_spotPads;
+  std::vector<BeamCalPadGeometry> m_spotGeom;
+
+  /**
+  * @brief Tower ids of the spot pads, and the Cholesky factors of their covariance for each set of ids
+  *
+  * The factor L of V = L L^T is stored row by row as lower triangle, with the inverse
+  * on the diagonal. The spot pads repeat from event to event, so that the factors are
+  * kept. An empty factor marks spot pads without a positive definite covariance.
+  */
+  std::vector<int> m_spotIds;
+  std::map< std::vector<int>, std::vector<double> > m_choleskyCache;
+  const std::vector<double> *m_cholesky;
+
+  /**
+  * @brief scratch for the covariance of the spot pads, and the residuals in the chi2
+  */
+  std::vector<double> m_spotCovariance;
+  std::vector<double> m_spotResiduals;
 
   /**
   * @brief integral of gaus-distributed energy in spot pads
   */
   std::vector<double> m_spotEint;
 
+  /**
+  * @brief derivatives of the integrals in the spot pads by the fit parameters, and of the chi2 by the integrals
+  */
+  std::vector<double> m_spotEintGrad;
+  std::vector<double> m_dChi2dEint;
+
+  /**
+  * @brief parameters of the last gradient calculation, and the gradient
+  */
+  double m_gradientPar[4];
+  double m_gradient[4];
+  bool m_gradientValid;
+
   const BeamCalGeo* m_BCG;
   const BeamCalBkg *m_BCbackground;
   const BCPadEnergies::BeamCalSide_t m_BCside;
 
   const double m_rhom;
+  const double m_spotRadius;
   double m_enTowerLimit;
   double m_towerChi2Limit;
+  double m_integrationTolerance;
   int m_startLayer;
   int m_countingLayer;
 
   bool m_flagUncorr;
+  bool m_useGradient;
+  bool m_useCovariance;
+
+  std::ostream* m_warnings;
 };
 
 
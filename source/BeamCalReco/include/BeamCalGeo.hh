@@ -10,6 +10,27 @@ class BeamCalGeo {
 
 public:
 
+  typedef std::vector<int>::const_iterator NeighbourIterator;
+
+  BeamCalGeo(): m_nLocalPads(0),
+		m_ringFirstPad(),
+		m_padLayer(),
+		m_padRing(),
+		m_padLocal(),
+		m_padRMin(),
+		m_padRMax(),
+		m_padPhiMin(),
+		m_padPhiMax(),
+		m_padRMiddle(),
+		m_padPhiMiddle(),
+		m_padPhi(),
+		m_padX(),
+		m_padY(),
+		m_padArea(),
+		m_padTheta(),
+		m_ringTheta(),
+		m_neighbourOffsets(),
+		m_neighbourPads() {}
   virtual ~BeamCalGeo() {};
 
   virtual int getPadsPerBeamCal() const;
@@ -18,11 +39,20 @@ public:
   virtual void getLayerRingPad(int padIndex, int& layer, int& ring, int& pad) const;
   virtual int getPadIndex(int layer, int ring, int pad) const;
   virtual int getLayer(int padIndex) const;
-  int getRing(int padIndex) const;
-  int getLocalPad(int padIndex) const;
+  inline int getRing(int padIndex) const { return m_padRing[ padIndex % m_nLocalPads ]; }
+  inline int getLocalPad(int padIndex) const { return m_padLocal[ padIndex % m_nLocalPads ]; }
 
   bool arePadsNeighbours(int padIndex1, int padIndex2, bool mustBeInSameLayer = false) const;
 
+  /// Range of the pads in a layer (i.e. the towers) which are neighbours of
+  /// padIndex, sorted by increasing index, see arePadsNeighbours
+  inline NeighbourIterator getNeighboursBegin(int padIndex) const {
+    return m_neighbourPads.begin() + m_neighbourOffsets[ padIndex % m_nLocalPads ];
+  }
+  inline NeighbourIterator getNeighboursEnd(int padIndex) const {
+    return m_neighbourPads.begin() + m_neighbourOffsets[ padIndex % m_nLocalPads + 1 ];
+  }
+
   virtual double                getBCInnerRadius()   const = 0;
   virtual double                getBCOuterRadius()   const = 0;
   virtual int                   getBCLayers()        const = 0;
@@ -58,8 +88,19 @@ public:
   double getPadPhi(int ring, int pad) const;
   double getPadPhi(int globalPandIndex) const;
 
+  /// Area of the pad in mm^2
+  double getPadArea(int cylinder, int sector) const;
+  double getPadAreaById(int globalPadIndex) const;
+
 protected:
 
+  /// Fill the pad lookup tables, has to be called at the end of the
+  /// constructor of the derived classes, once the segmentation is known
+  void setPadLookupTables();
+
+  /// Fill the neighbour table, has to be called after setPadLookupTables
+  void setPadNeighbours();
+
   //  virtual void countNumberOfPadsInRing() = 0;
 
   //these are also available from BeamCal Geometry
@@ -73,6 +114,43 @@ protected:
   // std::vector<int> m_PadsBeforeRing;
   // double mradCrossingAngle;
 
+private:
+
+  int  findRing(int localPadIndex) const;
+  void calculatePadExtents(int cylinder, int sector, double *extents) const;
+  double calculatePadPhi(int ring, int pad) const;
+  int  getTableIndex(int cylinder, int sector) const;
+
+  /// Flat lookup tables for the pads in one layer, index is the pad index in the layer
+  int m_nLocalPads;
+  std::vector<int> m_ringFirstPad;
+  /// layer of every pad in the BeamCal, index is the global pad index
+  std::vector<int> m_padLayer;
+  std::vector<int> m_padRing;
+  std::vector<int> m_padLocal;
+  ///extents of the pads in mm and degrees, see getPadExtents
+  std::vector<double> m_padRMin;
+  std::vector<double> m_padRMax;
+  std::vector<double> m_padPhiMin;
+  std::vector<double> m_padPhiMax;
+  std::vector<double> m_padRMiddle;
+  std::vector<double> m_padPhiMiddle;
+  /// phi in degrees as returned by getPadPhi
+  std::vector<double> m_padPhi;
+  /// cartesian coordinates of the pad centres
+  std::vector<double> m_padX;
+  std::vector<double> m_padY;
+  std::vector<double> m_padArea;
+  /// polar angle of the pad centres, index is layer * padsPerLayer + pad index in the layer
+  std::vector<double> m_padTheta;
+  /// polar angle of the ring centres, index is layer * rings + ring
+  std::vector<double> m_ringTheta;
+
+  /// compressed adjacency of the pads in one layer: the neighbours of pad i
+  /// are m_neighbourPads[m_neighbourOffsets[i]] to m_neighbourPads[m_neighbourOffsets[i+1]-1]
+  std::vector<int> m_neighbourOffsets;
+  std::vector<int> m_neighbourPads;
+
 };//Class
 
 
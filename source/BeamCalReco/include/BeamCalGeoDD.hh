@@ -15,10 +15,7 @@ public:
   virtual int getPadsPerBeamCal() const;
   virtual int getPadsPerLayer() const;
   virtual int getLayer(int padIndex) const;
-  virtual int getRing(int padIndex) const;
-  virtual int getLocalPad(int padIndex) const;
 
-  virtual void getLayerRingPad(int padIndex, int& layer, int& ring, int& pad) const;
   virtual int getPadIndex(int layer, int ring, int pad) const;
 
   virtual double                getBCInnerRadius()   const;
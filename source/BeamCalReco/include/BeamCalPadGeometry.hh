@@ -53,6 +53,35 @@ class BeamCalPadGeometry {
   */
   void setLocalCoords(const double &R, const double &Phi);
 
+  /**
+  * @brief Integral of the radial profile A*exp(-r/sigma) over the pad, in shells
+  *
+  * Sums the arc within the pad at the middle of every shell of width dr, times
+  * the Simpson integral of the profile over the shell, out to rmax. Needs
+  * setLocalCoords to be called first.
+  */
+  double integrateShells(double A, double sigma, double dr, double rmax);
+
+  /**
+  * @brief Integral of the radial profile A*exp(-r/sigma), cut at rmax, over the pad
+  *
+  * The pad is split into the triangles between the circle center and its sides.
+  * The radial integral is done in closed form, the one along the sides with adaptive
+  * Gauss-Kronrod quadrature, to an absolute precision of tolerance times the
+  * integral of the profile over the plane. Needs setLocalCoords to be called first.
+  */
+  double integrateEdges(double A, double sigma, double rmax, double tolerance) const;
+
+  /**
+  * @brief integrateEdges, together with the derivatives of the integral
+  *
+  * Gives the derivatives by sigma and by the X and Y coordinate of the circle center,
+  * the latter from the profile along the pad sides. The error estimate covers the
+  * derivatives too, times sigma.
+  */
+  double integrateEdges(double A, double sigma, double rmax, double tolerance,
+			double &dSigma, double &dX, double &dY) const;
+
   double m_R;
   double m_phi;
   double m_dR;
@@ -78,10 +107,15 @@ class BeamCalPadGeometry {
     double a, b;
   } PadSide_t;
 
+  /// adds the integrals of f along all sides, f.A, f.sigma and f.rmax must be set
+  template <class Integrand>
+  void integrateSides(Integrand &f, double tolerance, double *integrals) const;
+
   bool arcOpenClose(PadSide_t &ps, double &xi, double &yi, const double &r0,
          std::pair<double,bool> &ang);
 
-  std::vector<PadSide_t> m_sides;
+  static const int nSides = 4;
+  PadSide_t m_sides[nSides];
 
 };
 
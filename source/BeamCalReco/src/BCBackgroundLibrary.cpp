@@ -0,0 +1,189 @@
+#include "BCBackgroundLibrary.hh"
+#include "BCPadKernels.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <stdint.h>
+
+namespace {
+
+  const char libraryMagic[8] = { 'B', 'C', 'B', 'K', 'G', 'L', 'I', 'B' };
+  const uint32_t libraryVersion = 1;
+  const uint32_t libraryByteOrder = 0x01020304;
+  const long libraryAlignment = 64;
+
+  struct LibraryHeader {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t version;
+    uint32_t elementSize;
+    uint32_t nPads;
+    uint64_t nBunchCrossings;
+    uint64_t dataOffset;
+    char padding[24];
+  };
+
+  long alignedSize(long size) {
+    return ( size + libraryAlignment - 1 ) / libraryAlignment * libraryAlignment;
+  }
+
+  void writePadding(std::ostream& output, long bytes) {
+    const char zeros[libraryAlignment] = { 0 };
+    output.write(zeros, bytes);
+  }
+
+  std::string libraryError(const std::string& fileName, const std::string& reason) {
+    std::stringstream error;
+    error << "BeamCal background library " << fileName << ": " << reason;
+    return error.str();
+  }
+
+}
+
+
+BCBackgroundLibrary::BCBackgroundLibrary(const std::string& fileName):
+  m_fileName(fileName),
+  m_elementType(kDouble),
+  m_nPads(0),
+  m_nBunchCrossings(0),
+  m_arraySize(0),
+  m_dataOffset(0),
+  m_mapping(NULL),
+  m_mappingSize(0)
+{
+  const int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+  if( fileDescriptor < 0 ) {
+    throw std::runtime_error( libraryError(fileName, "cannot open file") );
+  }
+
+  struct stat fileStatus;
+  if( fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size < long(sizeof(LibraryHeader)) ) {
+    close(fileDescriptor);
+    throw std::runtime_error( libraryError(fileName, "file too short") );
+  }
+  m_mappingSize = fileStatus.st_size;
+
+  void* mapping = mmap(NULL, m_mappingSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+  //the mapping stays valid after closing the file
+  close(fileDescriptor);
+  if( mapping == MAP_FAILED ) {
+    throw std::runtime_error( libraryError(fileName, "cannot map file") );
+  }
+  m_mapping = static_cast<const char*>(mapping);
+
+  LibraryHeader header;
+  memcpy(&header, m_mapping, sizeof(LibraryHeader));
+
+  std::string problem;
+  if( memcmp(header.magic, libraryMagic, sizeof(libraryMagic)) != 0 ) {
+    problem = "not a background library";
+  } else if( header.byteOrder != libraryByteOrder ) {
+    problem = "written on a machine with different byte order";
+  } else if( header.version != libraryVersion ) {
+    problem = "unknown version";
+  } else if( header.elementSize != kFloat && header.elementSize != kDouble ) {
+    problem = "unknown element type";
+  } else {
+    m_elementType = ElementType_t(header.elementSize);
+    m_nPads = header.nPads;
+    m_nBunchCrossings = header.nBunchCrossings;
+    m_arraySize = getArraySize(m_elementType, m_nPads);
+    m_dataOffset = header.dataOffset;
+    if( m_dataOffset % libraryAlignment != 0 ||
+	m_dataOffset + 2 * m_arraySize * long(m_nBunchCrossings) > m_mappingSize ) {
+      problem = "file size does not match the header";
+    }
+  }
+
+  if( not problem.empty() ) {
+    munmap(const_cast<char*>(m_mapping), m_mappingSize);
+    throw std::runtime_error( libraryError(fileName, problem) );
+  }
+
+  //every event adds random bunch crossings, so load everything now
+  madvise(const_cast<char*>(m_mapping), m_mappingSize, MADV_WILLNEED);
+
+}
+
+
+BCBackgroundLibrary::~BCBackgroundLibrary() {
+  munmap(const_cast<char*>(m_mapping), m_mappingSize);
+}
+
+
+bool BCBackgroundLibrary::isBackgroundLibrary(const std::string& fileName) {
+  char magic[sizeof(libraryMagic)];
+  std::ifstream input(fileName.c_str(), std::ios::binary);
+  input.read(magic, sizeof(magic));
+  return input.good() && memcmp(magic, libraryMagic, sizeof(libraryMagic)) == 0;
+}
+
+
+void BCBackgroundLibrary::addEnergies(int bunchCrossing, BCPadEnergies::BeamCalSide_t side, BCPadEnergies& energies) const {
+
+  if( bunchCrossing < 0 || bunchCrossing >= m_nBunchCrossings ) {
+    throw std::out_of_range("BCBackgroundLibrary: bunch crossing out of range");
+  }
+  std::vector<double>& padEnergies = *energies.getEnergies();
+  if( int(padEnergies.size()) != m_nPads ) {
+    throw std::out_of_range("BCBackgroundLibrary: number of pads does not match the geometry");
+  }
+
+  const char* array = m_mapping + m_dataOffset + ( 2 * long(bunchCrossing) + ( side == BCPadEnergies::kRight ? 1 : 0 ) ) * m_arraySize;
+  if( m_elementType == kDouble ) {
+    BCPadKernels::add(&padEnergies[0], reinterpret_cast<const double*>(array), m_nPads);
+  } else {
+    BCPadKernels::add(&padEnergies[0], reinterpret_cast<const float*>(array), m_nPads);
+  }
+
+}
+
+
+long BCBackgroundLibrary::getArraySize(ElementType_t elementType, int nPads) {
+  return alignedSize( long(elementType) * nPads );
+}
+
+
+void BCBackgroundLibrary::writeHeader(std::ostream& output, ElementType_t elementType, int nPads, int nBunchCrossings) {
+  LibraryHeader header;
+  memset(&header, 0, sizeof(LibraryHeader));
+  memcpy(header.magic, libraryMagic, sizeof(libraryMagic));
+  header.byteOrder = libraryByteOrder;
+  header.version = libraryVersion;
+  header.elementSize = elementType;
+  header.nPads = nPads;
+  header.nBunchCrossings = nBunchCrossings;
+  header.dataOffset = alignedSize( sizeof(LibraryHeader) );
+  output.write(reinterpret_cast<const char*>(&header), sizeof(LibraryHeader));
+  writePadding(output, header.dataOffset - sizeof(LibraryHeader));
+}
+
+
+void BCBackgroundLibrary::writeBunchCrossing(std::ostream& output, ElementType_t elementType,
+					     const std::vector<double>& left, const std::vector<double>& right) {
+  if( left.size() != right.size() ) {
+    throw std::invalid_argument("BCBackgroundLibrary: different number of pads on the two sides");
+  }
+
+  const std::vector<double>* sides[2] = { &left, &right };
+  const long arraySize = getArraySize(elementType, left.size());
+  for (int i = 0; i < 2; ++i) {
+    const std::vector<double>& energies = *sides[i];
+    if( elementType == kDouble ) {
+      output.write(reinterpret_cast<const char*>(&energies[0]), energies.size() * sizeof(double));
+    } else {
+      const std::vector<float> singles(energies.begin(), energies.end());
+      output.write(reinterpret_cast<const char*>(&singles[0]), singles.size() * sizeof(float));
+    }
+    writePadding(output, arraySize - long(elementType) * energies.size());
+  }
+}
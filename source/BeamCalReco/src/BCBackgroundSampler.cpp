@@ -0,0 +1,123 @@
+#include "BCBackgroundSampler.hh"
+#include "BCGaussianGenerator.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+BCBackgroundSampler::BCBackgroundSampler(int nPads, int nBX):
+  m_nBX(nBX),
+  m_tableOffset(nPads, -1),
+  m_cumulative(),
+  m_guide(),
+  m_minimum(nPads, 0.0),
+  m_binWidth(nPads, 0.0),
+  m_binomialZero(nPads, 1.0),
+  m_binomialRatio(nPads, 0.0),
+  m_binomialFlipped(nPads, false)
+{
+  if( nBX < 1 ) {
+    throw std::out_of_range("BCBackgroundSampler: need at least one bunch crossing");
+  }
+}
+
+
+bool BCBackgroundSampler::setDistribution(int pad, double zeroRate, Density_t density, double *parameters,
+					  double minimum, double maximum, double minimumIntegral) {
+
+  if( pad < 0 || pad >= int(m_tableOffset.size()) ) {
+    throw std::out_of_range("BCBackgroundSampler: pad outside of the BeamCal");
+  }
+  m_tableOffset[pad] = -1;
+  if( not ( maximum > minimum ) ) return false;
+
+  //cumulative integral of the density with the trapezoidal rule, negative values do not count
+  const int nSteps = nBins * nStepsPerBin;
+  const double step = ( maximum - minimum ) / double(nSteps);
+  std::vector<double> cumulative(nSteps+1, 0.0);
+  double x = minimum;
+  double previous = std::max( 0.0, density(&x, parameters) );
+  for (int i = 1; i <= nSteps; ++i) {
+    x = minimum + i * step;
+    const double current = std::max( 0.0, density(&x, parameters) );
+    cumulative[i] = cumulative[i-1] + 0.5 * ( previous + current ) * step;
+    previous = current;
+  }
+  const double integral = cumulative[nSteps];
+  if( not ( integral > minimumIntegral ) ) return false;
+
+  //keep the bin edges only
+  const int offset = m_cumulative.size();
+  m_cumulative.resize( offset + nBins + 1 );
+  for (int bin = 0; bin < nBins; ++bin) {
+    m_cumulative[offset+bin] = cumulative[bin*nStepsPerBin] / integral;
+  }
+  m_cumulative[offset+nBins] = 1.0;
+  m_guide.resize( offset + nBins + 1 );
+  int bin = 0;
+  for (int i = 0; i <= nBins; ++i) {
+    const double u = double(i) / double(nBins);
+    while( bin < nBins - 1 && m_cumulative[offset+bin+1] <= u ) ++bin;
+    m_guide[offset+i] = bin;
+  }
+  m_minimum[pad] = minimum;
+  m_binWidth[pad] = ( maximum - minimum ) / double(nBins);
+  m_tableOffset[pad] = offset;
+
+  //the number of bunch crossings with energy, recursion from the smaller of p and 1-p
+  double p = 1.0 - zeroRate;
+  p = std::min( 1.0, std::max( 0.0, p ) );
+  m_binomialFlipped[pad] = p > 0.5;
+  if( m_binomialFlipped[pad] ) p = 1.0 - p;
+  m_binomialZero[pad] = std::pow( 1.0 - p, m_nBX );
+  m_binomialRatio[pad] = p / ( 1.0 - p );
+
+  return true;
+}
+
+
+int BCBackgroundSampler::drawNonZeroBX(int pad, BCGaussianGenerator& random) const {
+
+  const double ratio = m_binomialRatio[pad];
+  int k = 0;
+
+  if( ratio == 0.0 ) {
+    //nothing to draw
+  } else if( m_binomialZero[pad] > 1e-300 ) {
+    //inversion, walk up the binomial distribution until the uniform number is used up
+    double u = random.uniform();
+    double probability = m_binomialZero[pad];
+    while( u > probability && k < m_nBX ) {
+      u -= probability;
+      probability *= ratio * double( m_nBX - k ) / double( k + 1 );
+      ++k;
+    }
+  } else {
+    //very many bunch crossings, where the probability of zero underflows
+    const double p = ratio / ( 1.0 + ratio );
+    for (int bx = 0; bx < m_nBX; ++bx) {
+      if( random.uniform() < p ) ++k;
+    }
+  }
+
+  return m_binomialFlipped[pad] ? m_nBX - k : k;
+}
+
+
+double BCBackgroundSampler::sample(int pad, BCGaussianGenerator& random) const {
+
+  const float* cumulative = &m_cumulative[ m_tableOffset[pad] ];
+  const unsigned char* guide = &m_guide[ m_tableOffset[pad] ];
+  const int nNonZero = drawNonZeroBX(pad, random);
+
+  double energy = 0.0;
+  for (int bx = 0; bx < nNonZero; ++bx) {
+    //the bin with cumulative[bin] <= u < cumulative[bin+1], flat inside the bin
+    const double u = random.uniform();
+    int bin = guide[ int( u * nBins ) ];
+    while( cumulative[bin+1] <= u ) ++bin;
+    const double fraction = ( u - cumulative[bin] ) / ( cumulative[bin+1] - cumulative[bin] );
+    energy += bin + fraction;
+  }
+  return m_minimum[pad] * nNonZero + m_binWidth[pad] * energy;
+}
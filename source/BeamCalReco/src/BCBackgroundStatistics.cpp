@@ -0,0 +1,148 @@
+#include "BCBackgroundStatistics.hh"
+#include "BCPadEnergies.hh"
+#include "BCTowerCovariance.hh"
+#include "BeamCalGeo.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+BCBackgroundStatistics::BCBackgroundStatistics(const BeamCalGeo& bcg, int startLayer, int nLayers):
+  m_padsPerLayer(bcg.getPadsPerLayer()),
+  m_startLayer(startLayer),
+  m_nLayers(nLayers),
+  m_nSamples(0),
+  m_padSums(bcg.getPadsPerBeamCal(), 0.0),
+  m_padSquares(bcg.getPadsPerBeamCal(), 0.0),
+  m_towerSums(bcg.getPadsPerLayer(), 0.0),
+  m_towerSquares(bcg.getPadsPerLayer(), 0.0),
+  m_totalEnergySum(0.0),
+  m_totalEnergySquares(0.0),
+  m_covariancePads(),
+  m_comoments(),
+  m_towerCovariance(NULL),
+  m_towerEnergies(bcg.getPadsPerLayer(), 0.0),
+  m_deltas()
+{
+  if( startLayer < 0 || ( startLayer + nLayers ) * m_padsPerLayer > bcg.getPadsPerBeamCal() ) {
+    throw std::out_of_range("BCBackgroundStatistics: tower layers outside of the BeamCal");
+  }
+}
+
+
+void BCBackgroundStatistics::setCovariancePads(const std::vector<int>& padIndices) {
+  if( m_nSamples > 0 ) {
+    throw std::logic_error("BCBackgroundStatistics: covariance pads have to be set before the first sample");
+  }
+  for (std::vector<int>::const_iterator it = padIndices.begin(); it != padIndices.end(); ++it) {
+    if( *it < 0 || *it >= int(m_padSums.size()) ) {
+      throw std::out_of_range("BCBackgroundStatistics: covariance pad outside of the BeamCal");
+    }
+  }
+  m_covariancePads = padIndices;
+  m_comoments.assign(padIndices.size()*padIndices.size(), 0.0);
+  m_deltas.assign(padIndices.size(), 0.0);
+}
+
+
+void BCBackgroundStatistics::addSample(const BCPadEnergies& sample) {
+
+  const std::vector<double>& energies = *sample.getEnergies();
+  if( energies.size() != m_padSums.size() ) {
+    throw std::out_of_range("BCBackgroundStatistics: sample has the wrong number of pads");
+  }
+
+  //the means before and after this sample are the sums times these weights
+  const double oldWeight = m_nSamples > 0 ? 1.0 / double(m_nSamples) : 0.0;
+  ++m_nSamples;
+  const double weight = 1.0 / double(m_nSamples);
+
+  //the differences to the old means for the covariance
+  const int nCovariancePads = m_covariancePads.size();
+  for (int i = 0; i < nCovariancePads; ++i) {
+    m_deltas[i] = energies[ m_covariancePads[i] ] - m_padSums[ m_covariancePads[i] ] * oldWeight;
+  }
+
+  const int nPads = m_padSums.size();
+  for (int i = 0; i < nPads; ++i) {
+    const double delta = energies[i] - m_padSums[i] * oldWeight;
+    m_padSums[i] += energies[i];
+    m_padSquares[i] += delta * ( energies[i] - m_padSums[i] * weight );
+  }
+
+  //sum the layers of the towers
+  std::fill(m_towerEnergies.begin(), m_towerEnergies.end(), 0.0);
+  for (int layer = m_startLayer; layer < m_startLayer + m_nLayers; ++layer) {
+    const double* padsInLayer = &energies[ layer*m_padsPerLayer ];
+    for (int tower = 0; tower < m_padsPerLayer; ++tower) {
+      m_towerEnergies[tower] += padsInLayer[tower];
+    }
+  }
+  for (int tower = 0; tower < m_padsPerLayer; ++tower) {
+    const double delta = m_towerEnergies[tower] - m_towerSums[tower] * oldWeight;
+    m_towerSums[tower] += m_towerEnergies[tower];
+    m_towerSquares[tower] += delta * ( m_towerEnergies[tower] - m_towerSums[tower] * weight );
+  }
+  if( m_towerCovariance ) m_towerCovariance->addSample(m_towerEnergies);
+
+  const double totalEnergy = sample.getTotalEnergy();
+  const double delta = totalEnergy - m_totalEnergySum * oldWeight;
+  m_totalEnergySum += totalEnergy;
+  m_totalEnergySquares += delta * ( totalEnergy - m_totalEnergySum * weight );
+
+  //old difference of one pad times the new difference of the other
+  for (int i = 0; i < nCovariancePads; ++i) {
+    double* row = &m_comoments[ i*nCovariancePads ];
+    for (int j = 0; j < nCovariancePads; ++j) {
+      row[j] += m_deltas[i] * ( energies[ m_covariancePads[j] ] - m_padSums[ m_covariancePads[j] ] * weight );
+    }
+  }
+
+}
+
+
+void BCBackgroundStatistics::getMeans(BCPadEnergies& means) const {
+  std::vector<double>& energies = *means.getEnergies();
+  energies.resize(m_padSums.size());
+  for (unsigned int i = 0; i < m_padSums.size(); ++i) {
+    energies[i] = m_nSamples > 0 ? m_padSums[i] / m_nSamples : 0.0;
+  }
+}
+
+
+void BCBackgroundStatistics::getSigmas(BCPadEnergies& sigmas) const {
+  std::vector<double>& energies = *sigmas.getEnergies();
+  energies.resize(m_padSquares.size());
+  for (unsigned int i = 0; i < m_padSquares.size(); ++i) {
+    energies[i] = m_nSamples > 0 ? std::sqrt( m_padSquares[i] / m_nSamples ) : 0.0;
+  }
+}
+
+
+void BCBackgroundStatistics::getTowerSigmas(std::vector<double>& sigmas) const {
+  sigmas.resize(m_towerSquares.size());
+  for (unsigned int tower = 0; tower < m_towerSquares.size(); ++tower) {
+    sigmas[tower] = m_nSamples > 0 ? std::sqrt( m_towerSquares[tower] / m_nSamples ) : 0.0;
+  }
+}
+
+
+double BCBackgroundStatistics::getTotalEnergyMean() const {
+  return m_nSamples > 0 ? m_totalEnergySum / m_nSamples : 0.0;
+}
+
+
+double BCBackgroundStatistics::getTotalEnergySigma() const {
+  return m_nSamples > 0 ? std::sqrt( m_totalEnergySquares / m_nSamples ) : 0.0;
+}
+
+
+void BCBackgroundStatistics::getCovariance(std::vector<double>& covariance) const {
+  if( m_nSamples < 2 ) {
+    throw std::logic_error("BCBackgroundStatistics: need at least two samples for the covariance");
+  }
+  covariance.resize(m_comoments.size());
+  for (unsigned int i = 0; i < m_comoments.size(); ++i) {
+    covariance[i] = m_comoments[i] / double( m_nSamples - 1 );
+  }
+}
@@ -0,0 +1,175 @@
+#include "BCClusterBatch.hh"
+#include "BCPCuts.hh"
+#include "BeamCalGeo.hh"
+#include "TaskPool.hh"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace {
+  /// events handed to a thread at once
+  const int eventsPerGroup = 16;
+}
+
+
+BCClusterBatch::Scratch_t::Scratch_t(const BeamCalGeo& bcg, BCPadEnergies::BeamCalSide_t side):
+  testPads(bcg, side),
+  workspace(),
+  sums()
+{}
+
+
+BCClusterBatch::BCClusterBatch(const BeamCalGeo& bcg, BCPadEnergies::BeamCalSide_t side):
+  m_BCG(bcg),
+  m_side(side),
+  m_padsPerBeamCal(bcg.getPadsPerBeamCal()),
+  m_clusters(),
+  m_firstCluster(1, 0),
+  m_groupClusters(),
+  m_groupFirstCluster(),
+  m_freeScratch(),
+  m_allScratch(),
+  m_scratchMutex()
+{}
+
+
+BCClusterBatch::~BCClusterBatch() {
+  for (std::vector<Scratch_t*>::iterator it = m_allScratch.begin(); it != m_allScratch.end(); ++it) {
+    delete *it;
+  }
+}
+
+
+void BCClusterBatch::lookForNeighbouringClustersOverSigma(const std::vector<double>& energies,
+							  const BCPadEnergies& backgroundSigma,
+							  const BCPCuts& cuts, TaskPool* pool) {
+  reconstruct(energies, NULL, backgroundSigma, cuts, pool);
+}
+
+
+void BCClusterBatch::lookForNeighbouringClustersOverWithVetoAndCheck(const std::vector<double>& energies,
+								     const BCPadEnergies& background,
+								     const BCPadEnergies& backgroundSigma,
+								     const BCPCuts& cuts, TaskPool* pool) {
+  reconstruct(energies, &background, backgroundSigma, cuts, pool);
+}
+
+
+void BCClusterBatch::reconstruct(const std::vector<double>& energies, const BCPadEnergies* background,
+				 const BCPadEnergies& backgroundSigma, const BCPCuts& cuts, TaskPool* pool) {
+
+  if( energies.size() % m_padsPerBeamCal != 0 ) {
+    throw std::out_of_range("BCClusterBatch: energies are not a whole number of events");
+  }
+  const int nEvents = energies.size() / m_padsPerBeamCal;
+  const int nGroups = ( nEvents + eventsPerGroup - 1 ) / eventsPerGroup;
+  if( int(m_groupClusters.size()) < nGroups ) {
+    m_groupClusters.resize(nGroups);
+    m_groupFirstCluster.resize(nGroups);
+  }
+
+  //every group writes only its own clusters, with a scratch object no other thread uses at the time
+  const std::function<void(int)> reconstructGroup = [&](int group) {
+    std::vector<Cluster_t>& clusters = m_groupClusters[group];
+    std::vector<int>& firstCluster = m_groupFirstCluster[group];
+    clusters.clear();
+    firstCluster.clear();
+
+    Scratch_t* scratch = takeScratch();
+    try {
+      for (int event = group*eventsPerGroup; event < std::min(nEvents, (group+1)*eventsPerGroup); ++event) {
+	firstCluster.push_back(clusters.size());
+	reconstructEvent(event, &energies[ event*m_padsPerBeamCal ], background, backgroundSigma, cuts, *scratch, clusters);
+      }
+    } catch (...) {
+      returnScratch(scratch);
+      throw;
+    }
+    returnScratch(scratch);
+  };
+
+  if( pool ) {
+    pool->parallelFor(nGroups, reconstructGroup);
+  } else {
+    for (int group = 0; group < nGroups; ++group) {
+      reconstructGroup(group);
+    }
+  }
+
+  //join the groups in the order of the events
+  m_clusters.clear();
+  m_firstCluster.clear();
+  for (int group = 0; group < nGroups; ++group) {
+    const int offset = m_clusters.size();
+    for (std::vector<int>::const_iterator it = m_groupFirstCluster[group].begin(); it != m_groupFirstCluster[group].end(); ++it) {
+      m_firstCluster.push_back(offset + *it);
+    }
+    m_clusters.insert(m_clusters.end(), m_groupClusters[group].begin(), m_groupClusters[group].end());
+  }
+  m_firstCluster.push_back(m_clusters.size());
+
+}
+
+
+/// The clustering of BCPadEnergies, the sums of getClusterFromAcceptedPads are taken over the pads in the same order
+void BCClusterBatch::reconstructEvent(int event, const double* energies, const BCPadEnergies* background,
+				      const BCPadEnergies& backgroundSigma, const BCPCuts& cuts, Scratch_t& scratch,
+				      std::vector<Cluster_t>& clusters) const {
+
+  //with veto the background is subtracted from a copy
+  const double* testEnergies = energies;
+  if( background ) {
+    scratch.testPads.m_PadEnergies.assign(energies, energies + m_padsPerBeamCal);
+    scratch.testPads.subtractEnergiesWithCheck(*background, backgroundSigma);
+    testEnergies = &scratch.testPads.m_PadEnergies[0];
+  }
+
+  BCClusterWorkspace& workspace = scratch.workspace;
+  workspace.reset(m_BCG.getPadsPerLayer());
+  if( background && cuts.useConstPadCuts() ) {
+    BCPadEnergies::selectPadsAboveThresholds(m_BCG, testEnergies, cuts, workspace.m_padIndices);
+  } else {
+    BCPadEnergies::selectPadsAboveSigma(m_BCG, testEnergies, backgroundSigma, cuts, workspace.m_padIndices);
+  }
+  scratch.testPads.clusterNextToNearestNeighbourTowers(workspace, cuts);
+
+  const int nClusters = workspace.m_nClusters;
+  scratch.sums.assign(nClusters, BCPadEnergies::ClusterSums_t());
+
+  for (BCPadEnergies::PadIndexList::const_iterator it = workspace.m_padIndices.begin(); it != workspace.m_padIndices.end(); ++it) {
+    const int cluster = workspace.m_towerCluster[ *it % workspace.m_padsPerLayer ];
+    if( cluster < 0 ) continue;
+    scratch.sums[cluster].addPad(m_BCG, *it, testEnergies[*it]);
+  }
+
+  for (int cluster = 0; cluster < nClusters; ++cluster) {
+    const BCPadEnergies::ClusterSums_t& sums = scratch.sums[cluster];
+    Cluster_t result;
+    result.event = event;
+    result.seedTower = workspace.m_seeds[cluster];
+    result.nPads = sums.nPads;
+    result.energy = sums.energy;
+    sums.getAverages(m_side, result.phi, result.ring, result.theta);
+    clusters.push_back(result);
+  }
+
+}
+
+
+BCClusterBatch::Scratch_t* BCClusterBatch::takeScratch() {
+  std::lock_guard<std::mutex> lock(m_scratchMutex);
+  if( m_freeScratch.empty() ) {
+    m_allScratch.push_back( new Scratch_t(m_BCG, m_side) );
+    return m_allScratch.back();
+  }
+  Scratch_t* scratch = m_freeScratch.back();
+  m_freeScratch.pop_back();
+  return scratch;
+}
+
+
+void BCClusterBatch::returnScratch(Scratch_t* scratch) {
+  std::lock_guard<std::mutex> lock(m_scratchMutex);
+  m_freeScratch.push_back(scratch);
+}
@@ -0,0 +1,65 @@
+#include "BCClusterWorkspace.hh"
+#include "BCPadEnergies.hh"
+
+#include <algorithm>
+
+BCClusterWorkspace::~BCClusterWorkspace() {
+  delete m_testPads;
+}
+
+
+BCPadEnergies& BCClusterWorkspace::copyTestPads(BCPadEnergies const& pads) {
+  if( m_testPads and &m_testPads->m_BCG == &pads.m_BCG ) {
+    m_testPads->setEnergies(pads);
+    m_testPads->setSide(pads.getSide());
+  } else {
+    delete m_testPads;
+    m_testPads = new BCPadEnergies(pads);
+  }
+  return *m_testPads;
+}
+
+
+void BCClusterWorkspace::reset(int padsPerLayer) {
+
+  if( padsPerLayer != m_padsPerLayer ) {
+    m_padsPerLayer = padsPerLayer;
+    m_towerSize.assign(padsPerLayer, 0);
+    m_towerUsed.assign(padsPerLayer, false);
+    m_towerCluster.assign(padsPerLayer, -1);
+    m_parent.assign(padsPerLayer, -1);
+    m_seedOfRoot.assign(padsPerLayer, -1);
+    m_clusterOfRoot.assign(padsPerLayer, -1);
+  } else {
+    //only the towers of the last event have to be reset
+    for (std::vector<int>::const_iterator it = m_towers.begin(); it != m_towers.end(); ++it) {
+      m_towerSize[*it] = 0;
+      m_towerUsed[*it] = false;
+      m_towerCluster[*it] = -1;
+      m_parent[*it] = -1;
+      m_seedOfRoot[*it] = -1;
+      m_clusterOfRoot[*it] = -1;
+    }
+  }
+
+  m_towers.clear();
+  m_seeds.clear();
+  m_stack.clear();
+  m_padIndices.clear();
+  //keep the capacity of the pad lists, they are only filled when clusters were created from the towers
+  const int nFilled = std::min(m_nClusters, int(m_padsForClusters.size()));
+  for (int cluster = 0; cluster < nFilled; ++cluster) {
+    m_padsForClusters[cluster].clear();
+  }
+  m_nClusters = 0;
+
+}
+
+
+void BCClusterWorkspace::fillTowers(std::vector<int> const& padIndices) {
+  for (std::vector<int>::const_iterator it = padIndices.begin(); it != padIndices.end(); ++it) {
+    const int tower = *it % m_padsPerLayer;
+    if( m_towerSize[tower]++ == 0 ) m_towers.push_back(tower);
+  }
+  std::sort(m_towers.begin(), m_towers.end());
+}
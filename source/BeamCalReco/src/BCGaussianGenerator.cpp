@@ -0,0 +1,181 @@
+#include "BCGaussianGenerator.hh"
+#include "BCPadKernels.hh"
+
+#include <cmath>
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define BCGAUSSIANGENERATOR_WITH_AVX2 1
+#endif
+
+namespace {
+
+  const int philoxBatch = 256;
+
+  /// Philox4x32-10 of Salmon et al., Parallel Random Numbers: As Easy as 1, 2, 3 (2011)
+  /// for the counters counter ... counter+philoxBatch-1, two 64 bit numbers for each counter
+  inline __attribute__((always_inline))
+  void philoxBatchOf(uint64_t counter, const uint32_t key[2], uint64_t *out) {
+    const uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+    const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+
+    uint32_t c0[philoxBatch], c1[philoxBatch], c2[philoxBatch], c3[philoxBatch];
+    for (int i = 0; i < philoxBatch; ++i) {
+      c0[i] = uint32_t(counter + i);
+      c1[i] = uint32_t( (counter + i) >> 32 );
+      c2[i] = 0;
+      c3[i] = 0;
+    }
+
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; ++round) {
+      //the same operations for all counters, so the compiler can vectorise this
+      for (int i = 0; i < philoxBatch; ++i) {
+	const uint64_t product0 = uint64_t(M0) * c0[i];
+	const uint64_t product1 = uint64_t(M1) * c2[i];
+	const uint32_t n0 = uint32_t(product1 >> 32) ^ c1[i] ^ k0;
+	const uint32_t n2 = uint32_t(product0 >> 32) ^ c3[i] ^ k1;
+	c1[i] = uint32_t(product1);
+	c3[i] = uint32_t(product0);
+	c0[i] = n0;
+	c2[i] = n2;
+      }
+      k0 += W0;
+      k1 += W1;
+    }
+
+    for (int i = 0; i < philoxBatch; ++i) {
+      out[2*i]   = ( uint64_t(c1[i]) << 32 ) | c0[i];
+      out[2*i+1] = ( uint64_t(c3[i]) << 32 ) | c2[i];
+    }
+  }
+
+  void philoxBatchScalar(uint64_t counter, const uint32_t key[2], uint64_t *out) {
+    philoxBatchOf(counter, key, out);
+  }
+
+#ifdef BCGAUSSIANGENERATOR_WITH_AVX2
+  /// the same loops, vectorised for eight counters at a time
+  __attribute__((target("avx2")))
+  void philoxBatchAVX2(uint64_t counter, const uint32_t key[2], uint64_t *out) {
+    philoxBatchOf(counter, key, out);
+  }
+#endif
+
+  /// Ziggurat with 128 layers for the normal distribution, following
+  /// Doornik, An Improved Ziggurat Method to Generate Normal Random Samples (2005)
+  struct ZigguratTables {
+    static const int nLayers = 128;
+    double x[nLayers+1];
+    double ratio[nLayers];
+    const double tailStart;
+
+    ZigguratTables(): x(), ratio(), tailStart(3.442619855899) {
+      const double volume = 9.91256303526217e-3;
+      double f = std::exp( -0.5 * tailStart * tailStart );
+      x[0] = volume / f;
+      x[1] = tailStart;
+      x[nLayers] = 0.0;
+      for (int i = 2; i < nLayers; ++i) {
+	x[i] = std::sqrt( -2.0 * std::log( volume / x[i-1] + f ) );
+	f = std::exp( -0.5 * x[i] * x[i] );
+      }
+      for (int i = 0; i < nLayers; ++i) {
+	ratio[i] = x[i+1] / x[i];
+      }
+    }
+  };
+
+  const ZigguratTables& getTables() {
+    static const ZigguratTables tables;
+    return tables;
+  }
+
+}
+
+
+BCGaussianGenerator::BCGaussianGenerator():
+  m_key(),
+  m_counter(0),
+  m_buffer(2*philoxBatch),
+  m_position(0)
+{
+  setSeed(0);
+}
+
+
+void BCGaussianGenerator::setSeed(uint32_t seed) {
+  m_key[0] = seed;
+  m_key[1] = 0x42436172; // "BCar"
+  m_counter = 0;
+  //everything in the buffer belongs to the previous seed
+  m_position = m_buffer.size();
+}
+
+
+void BCGaussianGenerator::refill() {
+#ifdef BCGAUSSIANGENERATOR_WITH_AVX2
+  if( BCPadKernels::getImplementation() == BCPadKernels::kAVX2 ) {
+    philoxBatchAVX2(m_counter, m_key, &m_buffer[0]);
+  } else {
+    philoxBatchScalar(m_counter, m_key, &m_buffer[0]);
+  }
+#else
+  philoxBatchScalar(m_counter, m_key, &m_buffer[0]);
+#endif
+  m_counter += philoxBatch;
+  m_position = 0;
+}
+
+
+double BCGaussianGenerator::gaus() {
+  const ZigguratTables& tables = getTables();
+  for(;;) {
+    //the lowest seven bits select the layer, the highest 53 give a uniform number in (-1, 1)
+    const uint64_t bits = next();
+    const int layer = bits & 0x7F;
+    const double u = ( double( bits >> 11 ) + 0.5 ) * ( 2.0 / 9007199254740992.0 ) - 1.0;
+    if( std::fabs(u) < tables.ratio[layer] ) {
+      return u * tables.x[layer];
+    }
+    double x;
+    if( gausOutside(u, layer, x) ) {
+      return x;
+    }
+  }
+}
+
+
+bool BCGaussianGenerator::gausOutside(double u, int layer, double &x) {
+  const ZigguratTables& tables = getTables();
+
+  //bottom layer, sample from the tail beyond tailStart
+  if( layer == 0 ) {
+    double y;
+    do {
+      x = std::log( uniform() ) / tables.tailStart;
+      y = std::log( uniform() );
+    } while( -2.0 * y < x * x );
+    x = ( u < 0 ) ? x - tables.tailStart : tables.tailStart - x;
+    return true;
+  }
+
+  //wedge between the rectangle and the density
+  x = u * tables.x[layer];
+  const double f0 = std::exp( -0.5 * ( tables.x[layer]   * tables.x[layer]   - x * x ) );
+  const double f1 = std::exp( -0.5 * ( tables.x[layer+1] * tables.x[layer+1] - x * x ) );
+  return f1 + uniform() * ( f0 - f1 ) < 1.0;
+}
+
+
+void BCGaussianGenerator::fill(double *out, const double *means, const double *sigmas, int n) {
+  for (int i = 0; i < n; ++i) {
+    out[i] = means[i] + sigmas[i] * gaus();
+  }
+}
+
+
+void BCGaussianGenerator::add(double *out, const double *sigmas, int n) {
+  for (int i = 0; i < n; ++i) {
+    out[i] += sigmas[i] * gaus();
+  }
+}
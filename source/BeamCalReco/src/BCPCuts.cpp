@@ -1,5 +1,7 @@
 #include "BCPCuts.hh"
 
+#include <limits>
+
 bool BCPCuts::isPadAboveThreshold(int padRing, double padEnergy) const {
   for (int i = int(m_startingRings.size())-1; i >= 0; --i) {
 
@@ -19,6 +21,16 @@ bool BCPCuts::isPadAboveThreshold(int padRing, double padEnergy) const {
 
 }//isPadAboveThreshold
 
+double BCPCuts::getPadThreshold(int padRing) const {
+  for (int i = int(m_startingRings.size())-1; i >= 0; --i) {
+    if( padRing >= m_startingRings[i] ) {
+      return m_requiredRemainingEnergy[i];
+    }
+  }//for all cuts
+  //comparisons with NaN are always false
+  return std::numeric_limits<double>::quiet_NaN();
+}//getPadThreshold
+
 bool BCPCuts::isClusterAboveThreshold(BeamCalCluster const& bcc) const {
   for (int i = int(m_startingRings.size())-1; i >= 0; --i) {
 
@@ -1,4 +1,6 @@
 #include "BCPadEnergies.hh"
+#include "BCClusterWorkspace.hh"
+#include "BCPadKernels.hh"
 #include "BeamCalCluster.hh"
 #include "BCPCuts.hh"
 #include "BeamCalGeo.hh"
@@ -6,6 +8,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -23,6 +26,31 @@ bool value_comparer( const BCPadEnergies::TowerIndexList::value_type &i1, const
   return i1.second<i2.second;
 }
 
+namespace {
+
+  ///Root of the tower in the union-find forest, with path halving
+  int findTowerRoot( std::vector<int>& parent, int tower ) {
+    while( parent[tower] != tower ) {
+      parent[tower] = parent[parent[tower]];
+      tower = parent[tower];
+    }
+    return tower;
+  }
+
+  ///Orders seed towers like repeated max_element on the TowerIndexList: most pads first, lower tower index for equal size
+  class LargerTower {
+  public:
+    explicit LargerTower( std::vector<int> const& towerSize ): m_towerSize(towerSize) {}
+    bool operator()( int tower1, int tower2 ) const {
+      if( m_towerSize[tower1] != m_towerSize[tower2] ) return m_towerSize[tower1] > m_towerSize[tower2];
+      return tower1 < tower2;
+    }
+  private:
+    std::vector<int> const& m_towerSize;
+  };
+
+}
+
 BCPadEnergies::BCPadEnergies(const BeamCalGeo &bcg, BeamCalSide_t side):
   m_PadEnergies(bcg.getPadsPerBeamCal()),
   m_side(side),
@@ -54,6 +82,7 @@ BCPadEnergies::BCPadEnergies(const BCPadEnergies *bcp):
 }
 
 std::vector<double>* BCPadEnergies::getEnergies() { return &m_PadEnergies; }
+const std::vector<double>* BCPadEnergies::getEnergies() const { return &m_PadEnergies; }
 
 
 int BCPadEnergies::getTowerEnergies(int padIndex, std::vector<double> & te) const
@@ -116,12 +145,11 @@ void BCPadEnergies::resetEnergies(){
 }
 
 void BCPadEnergies::scaleEnergies(double factor){
-  for (int i = 0; i < m_BCG.getPadsPerBeamCal();++i) {
-    m_PadEnergies[i] *= factor;
-  }
+  BCPadKernels::scale(&m_PadEnergies[0], factor, m_BCG.getPadsPerBeamCal());
 }//Scale
 
 double BCPadEnergies::getTotalEnergy() const{
+  //summed in order, partial sums would round differently
   double sum(0.0);
   for (int i = 0; i < m_BCG.getPadsPerBeamCal();++i) {
     sum += m_PadEnergies[i];
@@ -153,42 +181,38 @@ void BCPadEnergies::setEnergies(const BCPadEnergies &bcp){
 
 
 void BCPadEnergies::addEnergies(const std::vector<double> &energies){
-  if( (int)energies.size() != m_BCG.getPadsPerBeamCal() ) {
+  const int padsPerBeamCal = m_BCG.getPadsPerBeamCal();
+  if( (int)energies.size() != padsPerBeamCal ) {
     std::stringstream errorMessage;
-    errorMessage << "Energies vector has wrong size! " << energies.size() << " vs. "  <<  m_BCG.getPadsPerBeamCal();
+    errorMessage << "Energies vector has wrong size! " << energies.size() << " vs. "  <<  padsPerBeamCal;
     throw std::out_of_range( errorMessage.str()  );
   }
-  for (int i = 0; i < m_BCG.getPadsPerBeamCal();++i) {
-    m_PadEnergies[i] += energies[i] ;
-  }
+  BCPadKernels::add(&m_PadEnergies[0], &energies[0], padsPerBeamCal);
 }
 
 void BCPadEnergies::addEnergies(const BCPadEnergies &bcp){
-  if( bcp.m_BCG.getPadsPerBeamCal() != m_BCG.getPadsPerBeamCal() ) throw std::out_of_range("BCPadEnergies has wrong size!");
-  for (int i = 0; i < m_BCG.getPadsPerBeamCal();++i) {
-    m_PadEnergies[i] += bcp.m_PadEnergies[i] ;
-  }
+  const int padsPerBeamCal = m_BCG.getPadsPerBeamCal();
+  if( bcp.m_BCG.getPadsPerBeamCal() != padsPerBeamCal ) throw std::out_of_range("BCPadEnergies has wrong size!");
+  BCPadKernels::add(&m_PadEnergies[0], &bcp.m_PadEnergies[0], padsPerBeamCal);
 }
 
 
 
 void BCPadEnergies::subtractEnergies(const std::vector<double> &energies){
-  if( (int)energies.size() != m_BCG.getPadsPerBeamCal() ) {
+  const int padsPerBeamCal = m_BCG.getPadsPerBeamCal();
+  if( (int)energies.size() != padsPerBeamCal ) {
     std::stringstream errorMessage;
-    errorMessage << "Energies vector has wrong size! " << energies.size() << " vs. "  <<  m_BCG.getPadsPerBeamCal();
+    errorMessage << "Energies vector has wrong size! " << energies.size() << " vs. "  <<  padsPerBeamCal;
     throw std::out_of_range( errorMessage.str()  );
   }
-  for (int i = 0; i < m_BCG.getPadsPerBeamCal();++i) {
-    m_PadEnergies[i] -= energies[i] ;
-  }
+  BCPadKernels::subtract(&m_PadEnergies[0], &energies[0], padsPerBeamCal);
 }
 
 
 void BCPadEnergies::subtractEnergies(const BCPadEnergies &bcp){
-  if( bcp.m_BCG.getPadsPerBeamCal() != m_BCG.getPadsPerBeamCal()) throw std::out_of_range("BCPadEnergies has wrong size!");
-  for (int i = 0; i < m_BCG.getPadsPerBeamCal();++i) {
-    m_PadEnergies[i] -= bcp.m_PadEnergies[i] ;
-  }
+  const int padsPerBeamCal = m_BCG.getPadsPerBeamCal();
+  if( bcp.m_BCG.getPadsPerBeamCal() != padsPerBeamCal) throw std::out_of_range("BCPadEnergies has wrong size!");
+  BCPadKernels::subtract(&m_PadEnergies[0], &bcp.m_PadEnergies[0], padsPerBeamCal);
 }
 
 
@@ -201,18 +225,21 @@ void BCPadEnergies::subtractEnergies(const BCPadEnergies &bcp){
  */
 void BCPadEnergies::subtractEnergiesWithCheck(const BCPadEnergies &bcp, const BCPadEnergies &sigma){
   int tooMuchAbove = 0, tooMuchBelow = 0;
-  if( bcp.m_BCG.getPadsPerBeamCal() != m_BCG.getPadsPerBeamCal()) throw std::out_of_range("BCPadEnergies has wrong size!");
-
-  for (int i = 0; i < m_BCG.getPadsPerBeamCal();++i) {
+  const int padsPerBeamCal = m_BCG.getPadsPerBeamCal();
+  if( bcp.m_BCG.getPadsPerBeamCal() != padsPerBeamCal) throw std::out_of_range("BCPadEnergies has wrong size!");
 
-    if( &bcp != &sigma ) {
-      m_PadEnergies[i] -= bcp.m_PadEnergies[i] ;
-    } else {
-      m_PadEnergies[i] -= 0.10 * sigma.m_PadEnergies[i] ;
-    }
+  if( &bcp != &sigma ) {
+    BCPadEnergies::subtractEnergies(bcp);
+  } else {
+    BCPadKernels::addScaled(&m_PadEnergies[0], &sigma.m_PadEnergies[0], -0.10, padsPerBeamCal);
+  }
 
-    if( (m_BCG.getLayer(i) == 10) &&
-	(m_BCG.getRing(i) == 0) ) {
+  //only the pads in the first ring of layer 10 are checked
+  const int padsPerLayer = m_BCG.getPadsPerLayer();
+  for (int layerStart = 0; layerStart < padsPerBeamCal; layerStart += padsPerLayer) {
+    if( m_BCG.getLayer(layerStart) != 10 ) continue;
+    for (int i = layerStart; i < layerStart + padsPerLayer; ++i) {
+      if( m_BCG.getRing(i) != 0 ) continue;
       if ( m_PadEnergies[i] > 0.9 * sigma.m_PadEnergies[i] && sigma.m_PadEnergies[i] > 1e-9 )  {
 	tooMuchAbove++;
       } else if( m_PadEnergies[i] < -0.9 * sigma.m_PadEnergies[i])  {
@@ -234,16 +261,20 @@ void BCPadEnergies::subtractEnergiesWithCheck(const BCPadEnergies &bcp, const BC
  */
 void BCPadEnergies::addEnergiesWithCheck(const BCPadEnergies &bcp, const BCPadEnergies &sigma){
   int tooMuchBelow = 0;
-  if( bcp.m_BCG.getPadsPerBeamCal() != m_BCG.getPadsPerBeamCal()) throw std::out_of_range("BCPadEnergies has wrong size!");
-
-  for (int i = 0; i < m_BCG.getPadsPerBeamCal();++i) {
-
-    m_PadEnergies[i] += 0.10 * bcp.m_PadEnergies[i] ;
-
-    if( (m_BCG.getLayer(i) == 10) &&
-	(m_BCG.getRing(i) == 0) &&
-	( m_PadEnergies[i] < -0.9 * sigma.m_PadEnergies[i]) ) {
-      tooMuchBelow++;
+  const int padsPerBeamCal = m_BCG.getPadsPerBeamCal();
+  if( bcp.m_BCG.getPadsPerBeamCal() != padsPerBeamCal) throw std::out_of_range("BCPadEnergies has wrong size!");
+
+  BCPadKernels::addScaled(&m_PadEnergies[0], &bcp.m_PadEnergies[0], 0.10, padsPerBeamCal);
+
+  //only the pads in the first ring of layer 10 are checked
+  const int padsPerLayer = m_BCG.getPadsPerLayer();
+  for (int layerStart = 0; layerStart < padsPerBeamCal; layerStart += padsPerLayer) {
+    if( m_BCG.getLayer(layerStart) != 10 ) continue;
+    for (int i = layerStart; i < layerStart + padsPerLayer; ++i) {
+      if( (m_BCG.getRing(i) == 0) &&
+	  ( m_PadEnergies[i] < -0.9 * sigma.m_PadEnergies[i]) ) {
+	tooMuchBelow++;
+      }
     }
   }
   //if it is above the limit, do it again
@@ -393,18 +424,33 @@ BeamCalCluster BCPadEnergies::lookForNeighbouringClustersOverWithVeto(const BCPa
 BCPadEnergies::BeamCalClusterList BCPadEnergies::lookForNeighbouringClustersOverWithVetoAndCheck(const BCPadEnergies &background,
 												 const BCPadEnergies &backgroundSigma,
 												 const BCPCuts &cuts) const {
+  BCClusterWorkspace workspace;
+  return lookForNeighbouringClustersOverWithVetoAndCheck(background, backgroundSigma, cuts, workspace);
+} // lookForNeighbouringClustersOverWithVetoAndCheck
+
+
+BCPadEnergies::BeamCalClusterList BCPadEnergies::lookForNeighbouringClustersOverWithVetoAndCheck(const BCPadEnergies &background,
+												 const BCPadEnergies &backgroundSigma,
+												 const BCPCuts &cuts,
+												 BCClusterWorkspace &workspace) const {
   BCPadEnergies::BeamCalClusterList BeamCalClusters;
 
-  //We make a copy, because we might want to apply different clustering on the same pads
-  BCPadEnergies testPads(*this);
+  //We make a copy, because we might want to apply different clustering on the same pads,
+  //into the buffer of the workspace so that nothing is allocated
+  BCPadEnergies& testPads = workspace.copyTestPads(*this);
 //   testPads.subtractEnergies(background);
   testPads.subtractEnergiesWithCheck(background, backgroundSigma);
+
+  workspace.reset(m_BCG.getPadsPerLayer());
   //here cuts are applied on the pads
-  PadIndexList myPadIndices = ( cuts.useConstPadCuts() ) ?
-    getPadsAboveThresholds(testPads, cuts) :
-    testPads.getPadsAboveSigma(backgroundSigma, cuts);
+  if( cuts.useConstPadCuts() ) {
+    getPadsAboveThresholds(testPads, cuts, workspace.m_padIndices);
+  } else {
+    testPads.getPadsAboveSigma(backgroundSigma, cuts, workspace.m_padIndices);
+  }
 
-  testPads.clusterNextToNearestNeighbourTowers(myPadIndices, cuts, BeamCalClusters);
+  testPads.clusterNextToNearestNeighbourTowers(workspace, cuts);
+  testPads.createClustersFromTowers(workspace, cuts, BeamCalClusters);
 
   return BeamCalClusters;
 } // lookForNeighbouringClustersOverWithVetoAndCheck
@@ -414,103 +460,199 @@ BCPadEnergies::BeamCalClusterList BCPadEnergies::lookForNeighbouringClustersOver
 BCPadEnergies::BeamCalClusterList BCPadEnergies::lookForNeighbouringClustersOverSigma( const BCPadEnergies &backgroundSigma,
 										       const BCPCuts &cuts,
 										       bool detailedPrintout) const {
+  BCClusterWorkspace workspace;
+  return lookForNeighbouringClustersOverSigma(backgroundSigma, cuts, workspace, detailedPrintout);
+} // lookForNeighbouringClustersOverSigma
+
+
+BCPadEnergies::BeamCalClusterList BCPadEnergies::lookForNeighbouringClustersOverSigma( const BCPadEnergies &backgroundSigma,
+										       const BCPCuts &cuts,
+										       BCClusterWorkspace &workspace,
+										       bool detailedPrintout) const {
   BCPadEnergies::BeamCalClusterList BeamCalClusters;
 
+  workspace.reset(m_BCG.getPadsPerLayer());
   //here cuts are applied on the pads
-  PadIndexList myPadIndices = getPadsAboveSigma(backgroundSigma, cuts);
+  getPadsAboveSigma(backgroundSigma, cuts, workspace.m_padIndices);
 
-  this->clusterNextToNearestNeighbourTowers(myPadIndices, cuts, BeamCalClusters, detailedPrintout);
+  this->clusterNextToNearestNeighbourTowers(workspace, cuts, detailedPrintout);
+  this->createClustersFromTowers(workspace, cuts, BeamCalClusters);
 
   return BeamCalClusters;
-} // lookForNeighbouringClustersOverWithVetoAndCheck
+} // lookForNeighbouringClustersOverSigma
 
 
-void BCPadEnergies::clusterNextToNearestNeighbourTowers( const BCPadEnergies::PadIndexList &myPadIndices,
-					  const BCPCuts &cuts,
-					  BCPadEnergies::BeamCalClusterList &BeamCalClusters,
-					  bool DetailedPrintout) const {
+/**
+ * Starting from the largest tower, all towers which are connected to it via
+ * neighbouring towers are put into one cluster. This is repeated with the
+ * largest remaining tower until it is smaller than the minimum tower size.
+ */
+void BCPadEnergies::clusterNextToNearestNeighbourTowers( BCClusterWorkspace &workspace,
+							 const BCPCuts &cuts,
+							 bool DetailedPrintout) const {
+
+  if( cuts.useConnectedTowerClustering() ) {
+    this->clusterConnectedTowers(workspace, cuts, DetailedPrintout);
+    return;
+  }
 
-  BCPadEnergies::TowerIndexList allTowersInBeamCal = BCPadEnergies::getTowersFromPads( this->m_BCG, myPadIndices );
-  while( not allTowersInBeamCal.empty() ) {
+  workspace.fillTowers(workspace.m_padIndices);
+  std::vector<int> const& towerSize = workspace.m_towerSize;
+  std::vector<int>& stack = workspace.m_stack;
+
+  while( true ) {
 
     //
     //Compare the largest deposit to the others and check if they are neighbours
     //
-
-    BCPadEnergies::TowerIndexList::iterator largestTower = std::max_element( allTowersInBeamCal.begin(),
-									     allTowersInBeamCal.end(),
-									     value_comparer);
+    int largestTower = -1;
+    for (std::vector<int>::const_iterator it = workspace.m_towers.begin(); it != workspace.m_towers.end(); ++it) {
+      if( workspace.m_towerUsed[*it] ) continue;
+      if( largestTower < 0 || towerSize[largestTower] < towerSize[*it] ) largestTower = *it;
+    }
+    if( largestTower < 0 ) { break; }
 
     if (DetailedPrintout) {
-      std::cout << "Largest Tower PadID " << largestTower->first << " : " << std::setw(3) << largestTower->second
-		<< this->streamPad(largestTower->first)
+      std::cout << "Largest Tower PadID " << largestTower << " : " << std::setw(3) << towerSize[largestTower]
+		<< this->streamPad(largestTower)
 		<< std::endl;
     }
 
     //If the largest element in smaller than the minimal size we wont find anything else
-    if( largestTower->second < cuts.getMinimumTowerSize() ) { return; }
-
-    //We keep all the padIDs making up this tower in here, and we store the neighbors we have to check for additional neighbors
-    BCPadEnergies::TowerIndexList towersInThisCluster, checkNextNeighborsList;
-    towersInThisCluster.insert( *largestTower );
+    if( towerSize[largestTower] < cuts.getMinimumTowerSize() ) { break; }
 
-    do {
+    const int cluster = workspace.m_nClusters++;
+    workspace.m_seeds.push_back(largestTower);
+    workspace.m_towerUsed[largestTower] = true;
+    workspace.m_towerCluster[largestTower] = cluster;
 
-      if( not checkNextNeighborsList.empty() ) {
-	largestTower = checkNextNeighborsList.begin();
-      }
+    //towers still to check for neighbours, the lowest tower index first
+    stack.push_back(largestTower);
+    while( not stack.empty() ) {
+      std::pop_heap(stack.begin(), stack.end(), std::greater<int>());
+      const int tower = stack.back();
+      stack.pop_back();
 
-      //compare largest tower with all other towers
-      for (BCPadEnergies::TowerIndexList::iterator it = allTowersInBeamCal.begin(); it != allTowersInBeamCal.end(); ++it) {
-	if( it->first == largestTower->first ) continue;
+      for (BeamCalGeo::NeighbourIterator nb = this->m_BCG.getNeighboursBegin(tower);
+	   nb != this->m_BCG.getNeighboursEnd(tower); ++nb) {
 
-	//if the tower is already in the list we do nothing
-	if ( towersInThisCluster.find(it->first) != towersInThisCluster.end() ) continue;
+	//only towers with pads, which are not yet in a cluster
+	if( towerSize[*nb] == 0 || workspace.m_towerUsed[*nb] ) continue;
 
-	const bool isNeighbour = this->m_BCG.arePadsNeighbours(largestTower->first, it->first);
-	if ( isNeighbour ) {
-	  if ( DetailedPrintout ) {
-	    std::cout << "Found a neighbor " << std::setw(6) << it->first << " : " << std::setw(3) << it->second
-		      << this->streamPad(it->first)
-		      << std::endl;
-	  }//debug output
+	if ( DetailedPrintout ) {
+	  std::cout << "Found a neighbor " << std::setw(6) << *nb << " : " << std::setw(3) << towerSize[*nb]
+		    << this->streamPad(*nb)
+		    << std::endl;
+	}//debug output
 
-	  towersInThisCluster.insert( *it );
-	  checkNextNeighborsList.insert( *it );
+	workspace.m_towerUsed[*nb] = true;
+	workspace.m_towerCluster[*nb] = cluster;
+	stack.push_back(*nb);
+	std::push_heap(stack.begin(), stack.end(), std::greater<int>());
 
-	} //if they are neighbours
       }// find neighbouring towers/pads
+    }//while there are towers to check
+
+  }//while there are towers
+
+}//clusterNextToNearestNeighbourTowers
+
 
-      //remove the tower we just used from the checkNextNeighborsList
-      checkNextNeighborsList.erase( largestTower->first );
+/**
+ * Same clusters as clusterNextToNearestNeighbourTowers, but the connected
+ * groups of towers are labelled in one pass with union-find over the pad
+ * neighbour table instead of repeatedly searching for the largest tower.
+ * Every cluster is a connected component, seeded by its largest tower; the
+ * components are returned in order of their seed size until a seed is
+ * smaller than the minimum tower size.
+ */
+void BCPadEnergies::clusterConnectedTowers( BCClusterWorkspace &workspace,
+					    const BCPCuts &cuts,
+					    bool DetailedPrintout) const {
+
+  workspace.fillTowers(workspace.m_padIndices);
+  std::vector<int> const& towers = workspace.m_towers;
+  std::vector<int> const& towerSize = workspace.m_towerSize;
+  std::vector<int>& parent = workspace.m_parent;
+
+  //join every tower with its neighbouring towers, the root is the lowest tower index
+  for (std::vector<int>::const_iterator it = towers.begin(); it != towers.end(); ++it) {
+    parent[*it] = *it;
+  }
+  for (std::vector<int>::const_iterator it = towers.begin(); it != towers.end(); ++it) {
+    for (BeamCalGeo::NeighbourIterator nb = this->m_BCG.getNeighboursBegin(*it);
+	 nb != this->m_BCG.getNeighboursEnd(*it); ++nb) {
+      //the neighbour table is symmetric, so every pair only once
+      if( *nb < *it || towerSize[*nb] == 0 ) continue;
+      const int root1 = findTowerRoot(parent, *it);
+      const int root2 = findTowerRoot(parent, *nb);
+      if( root1 < root2 ) {
+	parent[root2] = root1;
+      } else if( root2 < root1 ) {
+	parent[root1] = root2;
+      }
+    }//neighbours
+  }//towers
+
+  //the seed of each component is its largest tower, the lowest index if there are several
+  std::vector<int>& seedOfRoot = workspace.m_seedOfRoot;
+  for (std::vector<int>::const_iterator it = towers.begin(); it != towers.end(); ++it) {
+    const int root = findTowerRoot(parent, *it);
+    if( seedOfRoot[root] < 0 || towerSize[seedOfRoot[root]] < towerSize[*it] ) {
+      seedOfRoot[root] = *it;
+    }
+  }
 
-    } while ( not checkNextNeighborsList.empty() );
+  std::vector<int>& seeds = workspace.m_seeds;
+  for (std::vector<int>::const_iterator it = towers.begin(); it != towers.end(); ++it) {
+    if( parent[*it] == *it ) seeds.push_back(seedOfRoot[*it]);
+  }
+  std::sort(seeds.begin(), seeds.end(), LargerTower(towerSize));
 
-    //Remove the towers from the towerIndexList for the next cluster round
-    for (BCPadEnergies::TowerIndexList::iterator it = towersInThisCluster.begin(); it != towersInThisCluster.end(); ++it) {
-      allTowersInBeamCal.erase(it->first);
+  //number the clusters, the remaining components have too small seeds
+  for (std::vector<int>::const_iterator it = seeds.begin(); it != seeds.end(); ++it) {
+    if (DetailedPrintout) {
+      std::cout << "Largest Tower PadID " << *it << " : " << std::setw(3) << towerSize[*it]
+		<< this->streamPad(*it)
+		<< std::endl;
     }
+    if( towerSize[*it] < cuts.getMinimumTowerSize() ) break;
+    workspace.m_clusterOfRoot[findTowerRoot(parent, *it)] = workspace.m_nClusters++;
+  }
+  seeds.resize(workspace.m_nClusters);
 
-    //Create Cluster from the selected pads
-    BCPadEnergies::PadIndexList padsForThisCluster(BCPadEnergies::getPadsFromTowers( this->m_BCG, myPadIndices, towersInThisCluster ));
-    BeamCalClusters.push_back( this->getClusterFromAcceptedPads( *this, padsForThisCluster, cuts) );
-    BeamCalClusters.back().setPadIndexInLayer(max_element(towersInThisCluster.begin(), towersInThisCluster.end(), value_comparer)->first);
+  for (std::vector<int>::const_iterator it = towers.begin(); it != towers.end(); ++it) {
+    workspace.m_towerCluster[*it] = workspace.m_clusterOfRoot[findTowerRoot(parent, *it)];
+  }
 
-  }//while there are towers
+}//clusterConnectedTowers
 
-}//clusterNextToNearestNeighbourTowers
 
-BCPadEnergies::BCPadEnergies::PadIndexList BCPadEnergies::getPadsAboveThresholds(const BCPadEnergies& testPads, const BCPCuts& cuts) const{
+/// Create Clusters from the pads of the towers in each cluster, the pads keep their order
+void BCPadEnergies::createClustersFromTowers( BCClusterWorkspace &workspace,
+					      const BCPCuts &cuts,
+					      BCPadEnergies::BeamCalClusterList &BeamCalClusters) const {
+
+  const int nClusters = workspace.m_nClusters;
+  if( int(workspace.m_padsForClusters.size()) < nClusters ) {
+    workspace.m_padsForClusters.resize(nClusters);
+  }
+
+  for (BCPadEnergies::PadIndexList::const_iterator it = workspace.m_padIndices.begin(); it != workspace.m_padIndices.end(); ++it) {
+    const int cluster = workspace.m_towerCluster[ *it % workspace.m_padsPerLayer ];
+    if( cluster >= 0 ) workspace.m_padsForClusters[cluster].push_back(*it);
+  }
+
+  for (int cluster = 0; cluster < nClusters; ++cluster) {
+    BeamCalClusters.push_back( this->getClusterFromAcceptedPads( *this, workspace.m_padsForClusters[cluster], cuts) );
+    BeamCalClusters.back().setPadIndexInLayer(workspace.m_seeds[cluster]);
+  }
+
+}//createClustersFromTowers
+
+BCPadEnergies::PadIndexList BCPadEnergies::getPadsAboveThresholds(const BCPadEnergies& testPads, const BCPCuts& cuts) const{
   PadIndexList myPadIndices;
-  for (int k = 0; k < testPads.m_BCG.getPadsPerBeamCal();++k) {
-    if( testPads.m_BCG.getLayer(k) >= cuts.getStartingLayer() ) {
-      double padEnergy(testPads.getEnergy(k));
-      int padRing = testPads.m_BCG.getRing(k);
-      if( cuts.isPadAboveThreshold(padRing, padEnergy) ) {
-	myPadIndices.push_back(k);
-      }
-    }
-  }//all pads
+  getPadsAboveThresholds(testPads, cuts, myPadIndices);
   return myPadIndices;
 }
 
@@ -518,71 +660,118 @@ BCPadEnergies::BCPadEnergies::PadIndexList BCPadEnergies::getPadsAboveThresholds
 BCPadEnergies::PadIndexList BCPadEnergies::getPadsAboveSigma(const BCPadEnergies& sigma,
 							     const BCPCuts& cuts) const {
   PadIndexList myPadIndices;
-  for (int k = 0; k < this->m_BCG.getPadsPerBeamCal();++k) {
-    if( this->m_BCG.getLayer(k) >=  cuts.getStartingLayer() ) {
-      const double padEnergy(this->getEnergy(k));
-      const double padSigma(sigma.getEnergy(k));
-      const double cutValue = std::max(cuts.getPadSigmaCut() * padSigma, double(cuts.getMinPadEnergy()));
-      if( padEnergy > cutValue ) {
-	myPadIndices.push_back(k);
-      }
-    }
-  }//all pads
+  getPadsAboveSigma(sigma, cuts, myPadIndices);
   return myPadIndices;
 }
 
 
+/// Pads are selected layer by layer, and within a layer in groups of pads in the same ring sharing one threshold
+void BCPadEnergies::getPadsAboveThresholds(const BCPadEnergies& testPads, const BCPCuts& cuts, PadIndexList& myPadIndices) const{
+  selectPadsAboveThresholds(testPads.m_BCG, &testPads.m_PadEnergies[0], cuts, myPadIndices);
+}
+
+
+void BCPadEnergies::selectPadsAboveThresholds(const BeamCalGeo& geo, const double* energies, const BCPCuts& cuts,
+					      PadIndexList& myPadIndices) {
+  const int padsPerBeamCal = geo.getPadsPerBeamCal();
+  const int padsPerLayer = geo.getPadsPerLayer();
+  for (int layerStart = 0; layerStart < padsPerBeamCal; layerStart += padsPerLayer) {
+    if( geo.getLayer(layerStart) < cuts.getStartingLayer() ) continue;
+    int first = 0;
+    while( first < padsPerLayer ) {
+      const int padRing = geo.getRing(first);
+      int last = first + 1;
+      while( last < padsPerLayer && geo.getRing(last) == padRing ) { ++last; }
+      BCPadKernels::selectAtLeast(&energies[layerStart + first], cuts.getPadThreshold(padRing),
+				  last - first, layerStart + first, myPadIndices);
+      first = last;
+    }//all rings
+  }//all layers
+}
+
+
+void BCPadEnergies::getPadsAboveSigma(const BCPadEnergies& sigma,
+				      const BCPCuts& cuts,
+				      PadIndexList& myPadIndices) const {
+  selectPadsAboveSigma(m_BCG, &m_PadEnergies[0], sigma, cuts, myPadIndices);
+}
+
+
+void BCPadEnergies::selectPadsAboveSigma(const BeamCalGeo& geo, const double* energies, const BCPadEnergies& sigma,
+					 const BCPCuts& cuts, PadIndexList& myPadIndices) {
+  const int padsPerBeamCal = geo.getPadsPerBeamCal();
+  const int padsPerLayer = geo.getPadsPerLayer();
+  for (int layerStart = 0; layerStart < padsPerBeamCal; layerStart += padsPerLayer) {
+    if( geo.getLayer(layerStart) < cuts.getStartingLayer() ) continue;
+    BCPadKernels::selectAboveSigma(&energies[layerStart], &sigma.m_PadEnergies[layerStart],
+				   cuts.getPadSigmaCut(), double(cuts.getMinPadEnergy()),
+				   padsPerLayer, layerStart, myPadIndices);
+  }//all layers
+}
+
+
 /// Gets a list of padEnergies testPads, and a list of indices which make up the cluster myPadIndices
 /// Sums up all the energy of this cluster, calculates the average position of the cluster
 /// Could be static except for m_BCG, should be m_BCG function
 BeamCalCluster BCPadEnergies::getClusterFromAcceptedPads(const BCPadEnergies& testPads, const PadIndexList& myPadIndices, const BCPCuts& ) const {
   BeamCalCluster BCCluster;
-  double phi(0.0), ringAverage(0.0), totalEnergy(0.0);
-  double thetaAverage(0.0);
-
-  //Averaging an azimuthal angle is done via sine and cosine
-  double sinStore(0.0), cosStore(0.0);
+  ClusterSums_t sums;
 
   //now take all the indices and add them to a cluster
+  BCCluster.reservePads(myPadIndices.size());
   for (PadIndexList::const_iterator it = myPadIndices.begin(); it != myPadIndices.end(); ++it) {
     //Threshold was applied to get the padIndices
     const double energy(testPads.getEnergy(*it));
-    const int ring = m_BCG.getRing(*it);
-    const int layer = m_BCG.getLayer(*it);
-    const double thisPhi = m_BCG.getPadPhi(*it)* M_PI / 180.0; //Degrees to Radian
     BCCluster.addPad(*it, energy);
-    //    phi+= thisPhi*energy;
-    ringAverage += double( ring ) * energy;
-    totalEnergy += energy;
-    sinStore += energy * sin( thisPhi );
-    cosStore += energy * cos( thisPhi );
-    thetaAverage += m_BCG.getThetaFromRing( layer, ring ) * energy;
-
+    sums.addPad(m_BCG, *it, energy);
   }
-  if(totalEnergy > 0.0) {
-    phi =  atan2(sinStore/totalEnergy,  cosStore/totalEnergy) * 180.0 / M_PI ;
-    if(phi < 0) phi += 360;
-    //    phi /= totalEnergy;
-    ringAverage /= totalEnergy;
-    thetaAverage /= totalEnergy;
 
-    BCCluster.setPhi(phi);
-    BCCluster.setRing(ringAverage);
-    //    BCCluster.setTheta( m_BCG.getThetaFromRing( ringAverage ) * 1000 );
-    BCCluster.setTheta( thetaAverage * 1000 );
+  double phi, ringAverage, thetaAverage;
+  sums.getAverages(m_side, phi, ringAverage, thetaAverage);
+  BCCluster.setPhi(phi);
+  BCCluster.setRing(ringAverage);
+  BCCluster.setTheta(thetaAverage);
+
+  return BCCluster;
+}//getClusterFromAcceptedPads
+
+
+void BCPadEnergies::ClusterSums_t::addPad(const BeamCalGeo& geo, int padIndex, double padEnergy) {
+  const int padRing = geo.getRing(padIndex);
+  const int layer = geo.getLayer(padIndex);
+  const double thisPhi = geo.getPadPhi(padIndex)* M_PI / 180.0; //Degrees to Radian
+  ++nPads;
+  ring += double( padRing ) * padEnergy;
+  energy += padEnergy;
+  sinPhi += padEnergy * sin( thisPhi );
+  cosPhi += padEnergy * cos( thisPhi );
+  theta += geo.getThetaFromRing( layer, padRing ) * padEnergy;
+}
+
+
+void BCPadEnergies::ClusterSums_t::getAverages(BeamCalSide_t side, double& phi, double& averageRing, double& averageTheta) const {
+  phi = 0.0;
+  if(energy > 0.0) {
+    phi =  atan2(sinPhi/energy,  cosPhi/energy) * 180.0 / M_PI ;
+    if(phi < 0) phi += 360;
+    averageRing = ring / energy;
+    averageTheta = theta / energy * 1000;
+  } else {
+    averageRing = -9999;
+    averageTheta = -9999;
   }
 
   // correct the reconstructed Phi for the "Right" side
   // beamcal is rotated and phi goes the other way in global coordinates
-  if( m_side == kRight ) {
+  if( side == kRight ) {
     phi = 360 - phi;
     while(phi < 0)   phi += 360;
     while(phi > 360) phi -= 360;
-    BCCluster.setPhi(phi);
+  } else if( energy <= 0.0 ) {
+    //only the left side keeps the phi of an empty cluster unset
+    phi = -9999;
   }
-
-  return BCCluster;
-}//getClusterFromAcceptedPads
+}
 
 BCPadEnergies::TowerIndexList BCPadEnergies::getTowersFromPads( BeamCalGeo const& geo, const PadIndexList& myPadIndices) {
   TowerIndexList myTowerIndices;
@@ -593,34 +782,19 @@ BCPadEnergies::TowerIndexList BCPadEnergies::getTowersFromPads( BeamCalGeo const
 }
 
 void BCPadEnergies::removeTowerFromPads( BeamCalGeo const& geo, BCPadEnergies::PadIndexList& myPadIndices, int towerNumber) {
-  BCPadEnergies::PadIndexList::iterator iter = myPadIndices.begin();
-  while (  iter != myPadIndices.end() )  {
-    if ( ( *iter % geo.getPadsPerLayer() ) == towerNumber ) {
-      iter = myPadIndices.erase( iter );
-    } else {
-      ++iter;
+  const int padsPerLayer = geo.getPadsPerLayer();
+  //move the pads we keep to the front, then cut off the rest
+  BCPadEnergies::PadIndexList::iterator keep = myPadIndices.begin();
+  for (BCPadEnergies::PadIndexList::iterator iter = myPadIndices.begin(); iter != myPadIndices.end(); ++iter) {
+    if ( ( *iter % padsPerLayer ) != towerNumber ) {
+      *keep++ = *iter;
     }
   }
+  myPadIndices.erase( keep, myPadIndices.end() );
   return;
 }
 
 
-void BCPadEnergies::removeTowersFromPads( BeamCalGeo const& geo,
-					  BCPadEnergies::PadIndexList& myPadIndices,
-					  BCPadEnergies::TowerIndexList towerNumbers) {
-
-  BCPadEnergies::TowerIndexList::iterator towerIt = towerNumbers.begin();
-  while ( towerIt != towerNumbers.end() ) {
-    const int towerNumber = towerIt->first;
-    BCPadEnergies::removeTowerFromPads( geo, myPadIndices, towerNumber);
-    ++towerIt;
-  }//all towerIndices
-  return;
-}
-
-
-
-
 std::string BCPadEnergies::streamPad(int padID) const {
   std::stringstream out;
   int  layer, ring, pad;
@@ -630,19 +804,3 @@ std::string BCPadEnergies::streamPad(int padID) const {
       << "  Phi:" << std::setw(10) << this->m_BCG.getPadPhi(ring, pad);
   return out.str();
 }
-
-
-BCPadEnergies::PadIndexList BCPadEnergies::getPadsFromTowers ( BeamCalGeo const& geo,
-							       BCPadEnergies::PadIndexList const&  allPads,
-							       BCPadEnergies::TowerIndexList const& towers) {
-
-  BCPadEnergies::PadIndexList padsInTowers;
-  for (BCPadEnergies::PadIndexList::const_iterator it = allPads.begin(); it != allPads.end(); ++it) {
-    if ( towers.find( (*it) % geo.getPadsPerLayer() ) != towers.end() ) {
-      padsInTowers.push_back( *it );
-    }
-  }//for all pads
-
-  return padsInTowers;
-
-}
@@ -0,0 +1,346 @@
+#include "BCPadKernels.hh"
+
+#include <algorithm>
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define BCPADKERNELS_WITH_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+  ///////////////////////////
+  // Plain loop versions   //
+  ///////////////////////////
+
+  void addScalar(double *energies, const double *other, int n) {
+    for (int i = 0; i < n; ++i) {
+      energies[i] += other[i];
+    }
+  }
+
+  void addSingleScalar(double *energies, const float *other, int n) {
+    for (int i = 0; i < n; ++i) {
+      energies[i] += other[i];
+    }
+  }
+
+  void subtractScalar(double *energies, const double *other, int n) {
+    for (int i = 0; i < n; ++i) {
+      energies[i] -= other[i];
+    }
+  }
+
+  void addScaledScalar(double *energies, const double *other, double factor, int n) {
+    for (int i = 0; i < n; ++i) {
+      energies[i] += factor * other[i];
+    }
+  }
+
+  void scaleScalar(double *energies, double factor, int n) {
+    for (int i = 0; i < n; ++i) {
+      energies[i] *= factor;
+    }
+  }
+
+  //four partial sums, the same order as the AVX2 version
+  double dotScalar(const double *a, const double *b, int n) {
+    double partial[4] = { 0.0, 0.0, 0.0, 0.0 };
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+      partial[0] += a[i] * b[i];
+      partial[1] += a[i+1] * b[i+1];
+      partial[2] += a[i+2] * b[i+2];
+      partial[3] += a[i+3] * b[i+3];
+    }
+    double sum = ( partial[0] + partial[1] ) + ( partial[2] + partial[3] );
+    for (; i < n; ++i) {
+      sum += a[i] * b[i];
+    }
+    return sum;
+  }
+
+  void selectAboveSigmaScalar(const double *energies, const double *sigmas, double sigmaCut, double minEnergy,
+			      int n, int offset, std::vector<int>& indices) {
+    for (int i = 0; i < n; ++i) {
+      if( energies[i] > sigmaCut * sigmas[i] && energies[i] > minEnergy ) {
+	indices.push_back(offset + i);
+      }
+    }
+  }
+
+  void selectAtLeastScalar(const double *energies, double threshold, int n, int offset, std::vector<int>& indices) {
+    for (int i = 0; i < n; ++i) {
+      if( energies[i] >= threshold ) {
+	indices.push_back(offset + i);
+      }
+    }
+  }
+
+#ifdef BCPADKERNELS_WITH_AVX2
+
+  ///////////////////////////
+  // AVX2 versions         //
+  ///////////////////////////
+
+  __attribute__((target("avx2")))
+  void addAVX2(double *energies, const double *other, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+      _mm256_storeu_pd(energies + i, _mm256_add_pd(_mm256_loadu_pd(energies + i), _mm256_loadu_pd(other + i)));
+    }
+    addScalar(energies + i, other + i, n - i);
+  }
+
+  __attribute__((target("avx2")))
+  void addSingleAVX2(double *energies, const float *other, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+      const __m256d converted = _mm256_cvtps_pd(_mm_loadu_ps(other + i));
+      _mm256_storeu_pd(energies + i, _mm256_add_pd(_mm256_loadu_pd(energies + i), converted));
+    }
+    addSingleScalar(energies + i, other + i, n - i);
+  }
+
+  __attribute__((target("avx2")))
+  void subtractAVX2(double *energies, const double *other, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+      _mm256_storeu_pd(energies + i, _mm256_sub_pd(_mm256_loadu_pd(energies + i), _mm256_loadu_pd(other + i)));
+    }
+    subtractScalar(energies + i, other + i, n - i);
+  }
+
+  __attribute__((target("avx2")))
+  void addScaledAVX2(double *energies, const double *other, double factor, int n) {
+    const __m256d vFactor = _mm256_set1_pd(factor);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+      //no fused multiply-add, to give the same result as the plain loop
+      const __m256d scaled = _mm256_mul_pd(vFactor, _mm256_loadu_pd(other + i));
+      _mm256_storeu_pd(energies + i, _mm256_add_pd(_mm256_loadu_pd(energies + i), scaled));
+    }
+    addScaledScalar(energies + i, other + i, factor, n - i);
+  }
+
+  __attribute__((target("avx2")))
+  void scaleAVX2(double *energies, double factor, int n) {
+    const __m256d vFactor = _mm256_set1_pd(factor);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+      _mm256_storeu_pd(energies + i, _mm256_mul_pd(_mm256_loadu_pd(energies + i), vFactor));
+    }
+    scaleScalar(energies + i, factor, n - i);
+  }
+
+  __attribute__((target("avx2")))
+  double dotAVX2(const double *a, const double *b, int n) {
+    __m256d vSum = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+      vSum = _mm256_add_pd(vSum, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    double partial[4];
+    _mm256_storeu_pd(partial, vSum);
+    double sum = ( partial[0] + partial[1] ) + ( partial[2] + partial[3] );
+    for (; i < n; ++i) {
+      sum += a[i] * b[i];
+    }
+    return sum;
+  }
+
+  /// byte shuffles moving the int lanes selected by a 4 bit mask to the front
+  const unsigned char compressShuffle[16][16] __attribute__((aligned(16))) = {
+    {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x00, 0x01, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x04, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x08, 0x09, 0x0a, 0x0b, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x00, 0x01, 0x02, 0x03, 0x08, 0x09, 0x0a, 0x0b, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x80, 0x80, 0x80, 0x80},
+    {0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x00, 0x01, 0x02, 0x03, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x04, 0x05, 0x06, 0x07, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80},
+    {0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x00, 0x01, 0x02, 0x03, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80},
+    {0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80},
+    {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f}
+  };
+
+  /// Store the indices of the lanes in mask at out, returns the number of stored indices
+  __attribute__((target("avx2")))
+  inline int compressStore(int *out, __m128i indices, int mask) {
+    const __m128i shuffle = _mm_load_si128( reinterpret_cast<const __m128i*>(compressShuffle[mask]) );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(indices, shuffle) );
+    return __builtin_popcount(mask);
+  }
+
+  /// pads per block of indices collected on the stack before they are appended, a multiple of four
+  const int selectBlockSize = 64;
+
+  __attribute__((target("avx2")))
+  void selectAboveSigmaAVX2(const double *energies, const double *sigmas, double sigmaCut, double minEnergy,
+			    int n, int offset, std::vector<int>& indices) {
+    //the last full store of four indices of a block still fits, as it starts at most at selectBlockSize-4
+    int block[selectBlockSize];
+
+    const __m256d vSigmaCut = _mm256_set1_pd(sigmaCut);
+    const __m256d vMinEnergy = _mm256_set1_pd(minEnergy);
+    __m128i vIndices = _mm_setr_epi32(offset, offset+1, offset+2, offset+3);
+    const __m128i vFour = _mm_set1_epi32(4);
+    int i = 0;
+    while( i + 4 <= n ) {
+      const int blockEnd = std::min(i + selectBlockSize, n);
+      int count = 0;
+      for (; i + 4 <= blockEnd; i += 4) {
+	const __m256d vEnergies = _mm256_loadu_pd(energies + i);
+	const __m256d vCut = _mm256_mul_pd(vSigmaCut, _mm256_loadu_pd(sigmas + i));
+	const __m256d above = _mm256_and_pd( _mm256_cmp_pd(vEnergies, vCut, _CMP_GT_OQ),
+					     _mm256_cmp_pd(vEnergies, vMinEnergy, _CMP_GT_OQ) );
+	count += compressStore(block + count, vIndices, _mm256_movemask_pd(above));
+	vIndices = _mm_add_epi32(vIndices, vFour);
+      }
+      indices.insert(indices.end(), block, block + count);
+    }
+    selectAboveSigmaScalar(energies + i, sigmas + i, sigmaCut, minEnergy, n - i, offset + i, indices);
+  }
+
+  __attribute__((target("avx2")))
+  void selectAtLeastAVX2(const double *energies, double threshold, int n, int offset, std::vector<int>& indices) {
+    int block[selectBlockSize];
+
+    const __m256d vThreshold = _mm256_set1_pd(threshold);
+    __m128i vIndices = _mm_setr_epi32(offset, offset+1, offset+2, offset+3);
+    const __m128i vFour = _mm_set1_epi32(4);
+    int i = 0;
+    while( i + 4 <= n ) {
+      const int blockEnd = std::min(i + selectBlockSize, n);
+      int count = 0;
+      for (; i + 4 <= blockEnd; i += 4) {
+	const __m256d atLeast = _mm256_cmp_pd(_mm256_loadu_pd(energies + i), vThreshold, _CMP_GE_OQ);
+	count += compressStore(block + count, vIndices, _mm256_movemask_pd(atLeast));
+	vIndices = _mm_add_epi32(vIndices, vFour);
+      }
+      indices.insert(indices.end(), block, block + count);
+    }
+    selectAtLeastScalar(energies + i, threshold, n - i, offset + i, indices);
+  }
+
+#endif // BCPADKERNELS_WITH_AVX2
+
+  ///////////////////////////
+  // Dispatch              //
+  ///////////////////////////
+
+  struct KernelTable {
+    BCPadKernels::Implementation_t implementation;
+    void (*add)(double*, const double*, int);
+    void (*addSingle)(double*, const float*, int);
+    void (*subtract)(double*, const double*, int);
+    void (*addScaled)(double*, const double*, double, int);
+    void (*scale)(double*, double, int);
+    double (*dot)(const double*, const double*, int);
+    void (*selectAboveSigma)(const double*, const double*, double, double, int, int, std::vector<int>&);
+    void (*selectAtLeast)(const double*, double, int, int, std::vector<int>&);
+  };
+
+  const KernelTable scalarKernels = { BCPadKernels::kScalar,
+				      addScalar, addSingleScalar, subtractScalar, addScaledScalar, scaleScalar, dotScalar,
+				      selectAboveSigmaScalar, selectAtLeastScalar };
+#ifdef BCPADKERNELS_WITH_AVX2
+  const KernelTable avx2Kernels = { BCPadKernels::kAVX2,
+				    addAVX2, addSingleAVX2, subtractAVX2, addScaledAVX2, scaleAVX2, dotAVX2,
+				    selectAboveSigmaAVX2, selectAtLeastAVX2 };
+#endif
+
+  bool isSupported(BCPadKernels::Implementation_t implementation) {
+    switch( implementation ) {
+    case BCPadKernels::kScalar:
+      return true;
+    case BCPadKernels::kAVX2:
+#ifdef BCPADKERNELS_WITH_AVX2
+      return __builtin_cpu_supports("avx2");
+#else
+      return false;
+#endif
+    }
+    return false;
+  }
+
+  const KernelTable* getTable(BCPadKernels::Implementation_t implementation) {
+#ifdef BCPADKERNELS_WITH_AVX2
+    if( implementation == BCPadKernels::kAVX2 ) return &avx2Kernels;
+#endif
+    (void) implementation;
+    return &scalarKernels;
+  }
+
+  /// kernels in use, chosen when first needed
+  const KernelTable*& currentKernels() {
+    static const KernelTable* kernels = getTable( BCPadKernels::getBestImplementation() );
+    return kernels;
+  }
+
+}
+
+
+namespace BCPadKernels {
+
+  void add(double *energies, const double *other, int n) {
+    currentKernels()->add(energies, other, n);
+  }
+
+  void add(double *energies, const float *other, int n) {
+    currentKernels()->addSingle(energies, other, n);
+  }
+
+  void subtract(double *energies, const double *other, int n) {
+    currentKernels()->subtract(energies, other, n);
+  }
+
+  void addScaled(double *energies, const double *other, double factor, int n) {
+    currentKernels()->addScaled(energies, other, factor, n);
+  }
+
+  void scale(double *energies, double factor, int n) {
+    currentKernels()->scale(energies, factor, n);
+  }
+
+  double dot(const double *a, const double *b, int n) {
+    return currentKernels()->dot(a, b, n);
+  }
+
+  void selectAboveSigma(const double *energies, const double *sigmas, double sigmaCut, double minEnergy,
+			int n, int offset, std::vector<int>& indices) {
+    currentKernels()->selectAboveSigma(energies, sigmas, sigmaCut, minEnergy, n, offset, indices);
+  }
+
+  void selectAtLeast(const double *energies, double threshold, int n, int offset, std::vector<int>& indices) {
+    currentKernels()->selectAtLeast(energies, threshold, n, offset, indices);
+  }
+
+  Implementation_t getImplementation() {
+    return currentKernels()->implementation;
+  }
+
+  Implementation_t getBestImplementation() {
+    return isSupported(kAVX2) ? kAVX2 : kScalar;
+  }
+
+  bool setImplementation(Implementation_t implementation) {
+    if( not isSupported(implementation) ) return false;
+    currentKernels() = getTable(implementation);
+    return true;
+  }
+
+  const char* getImplementationName(Implementation_t implementation) {
+    switch( implementation ) {
+    case kScalar: return "Scalar";
+    case kAVX2:   return "AVX2";
+    }
+    return "Unknown";
+  }
+
+}
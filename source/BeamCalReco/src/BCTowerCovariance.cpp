@@ -0,0 +1,79 @@
+#include "BCTowerCovariance.hh"
+#include "BeamCalGeo.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+BCTowerCovariance::BCTowerCovariance(const BeamCalGeo& bcg, double distance):
+  m_distance(distance),
+  m_nSamples(0),
+  m_firstPartner(bcg.getPadsPerLayer()+1, 0),
+  m_partners(),
+  m_comoments(),
+  m_means(bcg.getPadsPerLayer(), 0.0),
+  m_deltas(bcg.getPadsPerLayer(), 0.0)
+{
+  const int nTowers = bcg.getPadsPerLayer();
+  for (int tower = 0; tower < nTowers; ++tower) {
+    m_firstPartner[tower] = m_partners.size();
+    for (int partner = 0; partner < nTowers; ++partner) {
+      if( partner == tower || bcg.getPadsDistance(tower, partner) < distance ) {
+	m_partners.push_back(partner);
+      }
+    }
+  }
+  m_firstPartner[nTowers] = m_partners.size();
+  m_comoments.assign(m_partners.size(), 0.0);
+}
+
+
+void BCTowerCovariance::addSample(const std::vector<double>& towerEnergies) {
+
+  if( towerEnergies.size() != m_means.size() ) {
+    throw std::out_of_range("BCTowerCovariance: sample has the wrong number of towers");
+  }
+
+  ++m_nSamples;
+  const double weight = 1.0 / double(m_nSamples);
+
+  const int nTowers = m_means.size();
+  for (int tower = 0; tower < nTowers; ++tower) {
+    m_deltas[tower] = towerEnergies[tower] - m_means[tower];
+    m_means[tower] += m_deltas[tower] * weight;
+  }
+
+  //old difference of one tower times the new difference of the other
+  for (int tower = 0; tower < nTowers; ++tower) {
+    for (int pair = m_firstPartner[tower]; pair < m_firstPartner[tower+1]; ++pair) {
+      const int partner = m_partners[pair];
+      m_comoments[pair] += m_deltas[tower] * ( towerEnergies[partner] - m_means[partner] );
+    }
+  }
+
+}
+
+
+double BCTowerCovariance::getCovariance(int tower1, int tower2) const {
+  if( tower1 < 0 || tower1 >= int(m_means.size()) || tower2 < 0 || tower2 >= int(m_means.size()) ) {
+    throw std::out_of_range("BCTowerCovariance: tower outside of the BeamCal");
+  }
+  const std::vector<int>::const_iterator begin = m_partners.begin() + m_firstPartner[tower1];
+  const std::vector<int>::const_iterator end = m_partners.begin() + m_firstPartner[tower1+1];
+  const std::vector<int>::const_iterator partner = std::lower_bound(begin, end, tower2);
+  if( partner == end || *partner != tower2 ) return 0.0;
+  return m_comoments[ partner - m_partners.begin() ] / double(m_nSamples - 1);
+}
+
+
+void BCTowerCovariance::getCovariance(const std::vector<int>& towers, std::vector<double>& covariance) const {
+  if( m_nSamples < 2 ) {
+    throw std::logic_error("BCTowerCovariance: need at least two samples for the covariance");
+  }
+  const int nTowers = towers.size();
+  covariance.resize(nTowers*nTowers);
+  for (int i = 0; i < nTowers; ++i) {
+    for (int j = i; j < nTowers; ++j) {
+      covariance[i*nTowers+j] = covariance[j*nTowers+i] = getCovariance(towers[i], towers[j]);
+    }
+  }
+}
@@ -0,0 +1,50 @@
+#include "BCTowerEnergies.hh"
+#include "BCPadEnergies.hh"
+#include "BeamCalGeo.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+BCTowerEnergies::BCTowerEnergies(const BeamCalGeo& bcg):
+  m_nTowers(bcg.getPadsPerLayer()),
+  m_nLayers(bcg.getPadsPerBeamCal()/bcg.getPadsPerLayer()),
+  m_towerEnergies(bcg.getPadsPerBeamCal())
+{
+}
+
+BCTowerEnergies::BCTowerEnergies(const BCPadEnergies& bcp):
+  m_nTowers(bcp.m_BCG.getPadsPerLayer()),
+  m_nLayers(bcp.m_BCG.getPadsPerBeamCal()/bcp.m_BCG.getPadsPerLayer()),
+  m_towerEnergies(bcp.m_BCG.getPadsPerBeamCal())
+{
+  setEnergies(bcp);
+}
+
+
+void BCTowerEnergies::setEnergies(const BCPadEnergies& bcp) {
+  const std::vector<double>& padEnergies = *bcp.getEnergies();
+  if( int(padEnergies.size()) != m_nTowers*m_nLayers ) throw std::out_of_range("BCTowerEnergies has wrong size!");
+
+  //transpose in blocks of towers, so that the towers written to stay in the cache
+  const int blockSize = 64;
+  for (int firstTower = 0; firstTower < m_nTowers; firstTower += blockSize) {
+    const int lastTower = std::min(firstTower + blockSize, m_nTowers);
+    for (int layer = 0; layer < m_nLayers; ++layer) {
+      const double* padsInLayer = &padEnergies[ layer*m_nTowers ];
+      for (int tower = firstTower; tower < lastTower; ++tower) {
+	m_towerEnergies[ tower*m_nLayers + layer ] = padsInLayer[tower];
+      }
+    }//layers
+  }//tower blocks
+
+}
+
+
+double BCTowerEnergies::getTowerEnergy(int tower, int startLayer) const {
+  const double* energies = getTowerEnergies(tower);
+  double te(0.);
+  for (int layer = std::max(startLayer, 0); layer < m_nLayers; ++layer) {
+    te += energies[layer];
+  }
+  return te;
+}
@@ -11,10 +11,12 @@
 *
 */
 #include "BeamCalBkg.hh"
+#include "BeamCalBkgContext.hh"
 #include "BeamCalGeoCached.hh"
 #include "BCPadEnergies.hh"
 #include "BCPCuts.hh"
 #include "BCRootUtilities.hh"
+#include "BCTowerCovariance.hh"
 
 
 // ----- include for verbosity dependent logging ---------
@@ -48,15 +50,17 @@ BeamCalBkg::BeamCalBkg(const string& bg_method_name,
                      const BeamCalGeo *BCG) : 
                                            m_bgMethod(kPregenerated),
 					   m_nBX(0),
-                                           m_BeamCalDepositsLeft(NULL),
-                                           m_BeamCalDepositsRight(NULL),
                                            m_BeamCalAverageLeft(NULL),
                                            m_BeamCalAverageRight(NULL),
                                            m_BeamCalErrorsLeft(NULL),
                                            m_BeamCalErrorsRight(NULL),
 					   m_TowerErrorsLeft(NULL),
 					   m_TowerErrorsRight(NULL),
-                                           m_random3(NULL),
+					   m_TowerCovarianceLeft(NULL),
+					   m_TowerCovarianceRight(NULL),
+					   m_towerCovarianceDistance(0.0),
+					   m_correlatedTowerErrors(false),
+                                           m_context(NULL),
                                            m_BCG(BCG),
                                            m_bcpCuts(NULL)
 {
@@ -66,24 +70,23 @@ BeamCalBkg::BeamCalBkg(const string& bg_method_name,
 
 BeamCalBkg::~BeamCalBkg()
 {
-  delete m_random3;
+  delete m_context;
 
   delete m_BeamCalAverageLeft;
   delete m_BeamCalAverageRight;
 
-  delete m_BeamCalDepositsLeft;
-  delete m_BeamCalDepositsRight;
-  
   delete m_BeamCalErrorsLeft;
   delete m_BeamCalErrorsRight;
 
   delete m_TowerErrorsLeft;
   delete m_TowerErrorsRight;
+
+  delete m_TowerCovarianceLeft;
+  delete m_TowerCovarianceRight;
 }
 
 void BeamCalBkg::init(const int n_bx)
 {
-  m_random3 = new TRandom3();
   m_nBX = n_bx;
 
   m_TowerErrorsLeft  =  new vector<double>;
@@ -125,20 +128,20 @@ void BeamCalBkg::setTowerErrors(const BCPadEnergies::BeamCalSide_t bc_side)
 
 } // setTowerErrors
 
-void BeamCalBkg::getAverageBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
+void BeamCalBkg::getAverageBG(BCPadEnergies &peLeft, BCPadEnergies &peRight) const
 {
   peLeft.setEnergies(*m_BeamCalAverageLeft);
   peRight.setEnergies(*m_BeamCalAverageRight);
 }
 
-void BeamCalBkg::getErrorsBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
+void BeamCalBkg::getErrorsBG(BCPadEnergies &peLeft, BCPadEnergies &peRight) const
 {
   peLeft.setEnergies(*m_BeamCalErrorsLeft);
   peRight.setEnergies(*m_BeamCalErrorsRight);
 }
 
 int BeamCalBkg::getTowerErrorsBG(int padIndex, 
-      const BCPadEnergies::BeamCalSide_t bc_side, double &tower_sigma)
+      const BCPadEnergies::BeamCalSide_t bc_side, double &tower_sigma) const
 {
   tower_sigma = (BCPadEnergies::kLeft == bc_side ? m_TowerErrorsLeft->at(padIndex) 
     : m_TowerErrorsRight->at(padIndex));
@@ -146,8 +149,35 @@ int BeamCalBkg::getTowerErrorsBG(int padIndex,
   return tower_sigma;
 }
 
+int BeamCalBkg::getPadsCovariance(const vector<int> &pad_list, vector<double> &covariance,
+      const BCPadEnergies::BeamCalSide_t bc_side) const
+{
+  const BCTowerCovariance* towerCovariance = (BCPadEnergies::kLeft == bc_side
+    ? m_TowerCovarianceLeft : m_TowerCovarianceRight);
+  if ( not towerCovariance ) return -1;
+
+  towerCovariance->getCovariance(pad_list, covariance);
+  return covariance.size();
+}
+
+
+BeamCalBkgContext* BeamCalBkg::createContext() const
+{
+  return new BeamCalBkgContext();
+}
+
+BeamCalBkgContext& BeamCalBkg::getDefaultContext()
+{
+  if( not m_context ) m_context = createContext();
+  return *m_context;
+}
 
 void BeamCalBkg::setRandom3Seed(int seed)
 { 
-  m_random3->SetSeed(seed); 
+  getDefaultContext().setSeed(seed);
+}
+
+void BeamCalBkg::getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
+{
+  getEventBG(getDefaultContext(), peLeft, peRight);
 }
@@ -12,6 +12,9 @@
 #include "BeamCalBkgAverage.hh"
 #include "BeamCalGeoCached.hh"
 #include "BCPadEnergies.hh"
+#include "BeamCalBkgContext.hh"
+#include "BCGaussianGenerator.hh"
+#include "BCPadKernels.hh"
 #include "BCRootUtilities.hh"
 
 
@@ -43,7 +46,9 @@ using std::map;
 using marlin::Global;
 
 BeamCalBkgAverage::BeamCalBkgAverage(const string& bg_method_name, 
-                     const BeamCalGeo *BCG) : BeamCalBkg(bg_method_name, BCG)
+                     const BeamCalGeo *BCG) : BeamCalBkg(bg_method_name, BCG),
+					   m_eventSigmasLeft(),
+					   m_eventSigmasRight()
 {}
 
 BeamCalBkgAverage::~BeamCalBkgAverage()
@@ -69,17 +74,22 @@ void BeamCalBkgAverage::init(vector<string> &bg_files, const int n_bx)
   // calculate st.dev. of tower energies
   this->BeamCalBkg::setTowerErrors(BCPadEnergies::kLeft);
   this->BeamCalBkg::setTowerErrors(BCPadEnergies::kRight);
+
+  // generate at once with sigma = dE*sqrts(m_nBX)
+  const int nBCpads = m_BCG->getPadsPerBeamCal();
+  const double rd_coef = sqrt(m_nBX);
+  m_eventSigmasLeft.assign(nBCpads, 0.0);
+  m_eventSigmasRight.assign(nBCpads, 0.0);
+  BCPadKernels::addScaled(&m_eventSigmasLeft[0], &(*m_BeamCalErrorsLeft->getEnergies())[0], rd_coef, nBCpads);
+  BCPadKernels::addScaled(&m_eventSigmasRight[0], &(*m_BeamCalErrorsRight->getEnergies())[0], rd_coef, nBCpads);
 }
 
 
-void BeamCalBkgAverage::getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
+void BeamCalBkgAverage::getEventBG(BeamCalBkgContext &context, BCPadEnergies &peLeft, BCPadEnergies &peRight) const
 {
   const int nBCpads = m_BCG->getPadsPerBeamCal();
 
-  // generate at once with sigma = dE*sqrts(m_nBX)
-  const double rd_coef = sqrt(m_nBX);
-  for (int i = 0; i < nBCpads ;++i) { //Add gaussian randomisation of background to each cell
-    peRight.addEnergy(i, m_random3->Gaus(0.0, rd_coef*m_BeamCalErrorsRight->getEnergy(i)));
-    peLeft.addEnergy(i, m_random3->Gaus(0.0, rd_coef*m_BeamCalErrorsLeft->getEnergy(i)));
-  }//for all pads
+  //Add gaussian randomisation of background to each cell
+  context.getGaussian().add(&(*peRight.getEnergies())[0], &m_eventSigmasRight[0], nBCpads);
+  context.getGaussian().add(&(*peLeft.getEnergies())[0], &m_eventSigmasLeft[0], nBCpads);
 } // getEventBG
@@ -0,0 +1,25 @@
+/**
+* @file BeamCalBkgContext.cpp
+* @brief Implementation for BeamCalBkgContext methods
+*/
+#include "BeamCalBkgContext.hh"
+#include "BCGaussianGenerator.hh"
+
+#include <TRandom3.h>
+
+BeamCalBkgContext::BeamCalBkgContext() :
+  m_random3(new TRandom3()),
+  m_gaussian(new BCGaussianGenerator())
+{}
+
+BeamCalBkgContext::~BeamCalBkgContext()
+{
+  delete m_random3;
+  delete m_gaussian;
+}
+
+void BeamCalBkgContext::setSeed(const int seed)
+{
+  m_random3->SetSeed(seed);
+  m_gaussian->setSeed(seed);
+}
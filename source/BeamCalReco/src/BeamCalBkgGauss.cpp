@@ -11,6 +11,8 @@
 #include "BeamCalBkgGauss.hh"
 #include "BeamCalGeoCached.hh"
 #include "BCPadEnergies.hh"
+#include "BeamCalBkgContext.hh"
+#include "BCGaussianGenerator.hh"
 #include "BCRootUtilities.hh"
 
 
@@ -41,16 +43,11 @@ using std::map;
 using marlin::Global;
 
 BeamCalBkgGauss::BeamCalBkgGauss(const string& bg_method_name, 
-                     const BeamCalGeo *BCG) : BeamCalBkg(bg_method_name, BCG),
-					   m_padParLeft(NULL),
-					   m_padParRight(NULL)
+                     const BeamCalGeo *BCG) : BeamCalBkg(bg_method_name, BCG)
 {}
 
-BeamCalBkgGauss::~BeamCalBkgGauss() {
-  delete m_padParLeft;
-  delete m_padParRight;
-
-}
+BeamCalBkgGauss::~BeamCalBkgGauss()
+{}
 
 void BeamCalBkgGauss::init(vector<string> &bg_files, const int n_bx)
 {
@@ -82,10 +79,6 @@ void BeamCalBkgGauss::init(vector<string> &bg_files, const int n_bx)
   }
 
 
-  const int nBCpads = m_BCG->getPadsPerBeamCal();
-  m_padParLeft  = new vector<PadEdepRndPar_t>(nBCpads); 
-  m_padParRight = new vector<PadEdepRndPar_t>(nBCpads); 
-
   m_BeamCalAverageLeft  =  new BCPadEnergies(m_BCG);
   m_BeamCalAverageRight =  new BCPadEnergies(m_BCG);
   m_BeamCalErrorsLeft   =  new BCPadEnergies(m_BCG);
@@ -104,34 +97,18 @@ void BeamCalBkgGauss::init(vector<string> &bg_files, const int n_bx)
 }
 
 
-void BeamCalBkgGauss::getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
+void BeamCalBkgGauss::getEventBG(BeamCalBkgContext &context, BCPadEnergies &peLeft, BCPadEnergies &peRight) const
 {
   const int nBCpads = m_BCG->getPadsPerBeamCal();
-  vector<double> vedep(nBCpads, 0.);
-
-  for (int ip=0; ip< nBCpads; ip++){
-    // Parameters of energy deposition in a pad:
-    PadEdepRndPar_t pep = m_padParLeft->at(ip);
 
-    // generating fluctiations at once with stdev*sqrt(nBX)
-    // otherwise the time to generate each event grows too much
-    //vedep.at(ip) = m_random3->Gaus(0., pep.stdev*sqrt(m_nBX));
-    vedep.at(ip) = m_random3->Gaus(pep.mean*m_nBX, pep.stdev*sqrt(m_nBX));
-  }
-
-  peLeft.setEnergies(vedep);
-
-  for (int ip=0; ip< nBCpads; ip++){
-    // Parameters of energy deposition in a pad:
-    PadEdepRndPar_t pep = m_padParRight->at(ip);
+  // generating fluctiations at once with stdev*sqrt(nBX) around mean*nBX,
+  // otherwise the time to generate each event grows too much,
+  // these are the averages and errors filled in readBackgroundPars
+  context.getGaussian().fill(&(*peLeft.getEnergies())[0], &(*m_BeamCalAverageLeft->getEnergies())[0],
+		   &(*m_BeamCalErrorsLeft->getEnergies())[0], nBCpads);
 
-    // generating fluctiations at once with stdev*sqrt(nBX)
-    // otherwise the time to generate each event grows too much
-    //vedep.at(ip) = m_random3->Gaus(0., pep.stdev*sqrt(m_nBX));
-    vedep.at(ip) = m_random3->Gaus(pep.mean*m_nBX, pep.stdev*sqrt(m_nBX));
-  }
-
-  peRight.setEnergies(vedep);
+  context.getGaussian().fill(&(*peRight.getEnergies())[0], &(*m_BeamCalAverageRight->getEnergies())[0],
+		   &(*m_BeamCalErrorsRight->getEnergies())[0], nBCpads);
 
   streamlog_out(DEBUG) << "BeamCalBkgGauss: total energy generated with gaussian method for "
 		       << "Left and Right BeamCal = " << peLeft.getTotalEnergy() << "\t" 
@@ -183,9 +160,6 @@ void BeamCalBkgGauss::readBackgroundPars(TTree *bg_par_tree, const BCPadEnergies
     pad_par.mean      = br_cont_map[side_name+"mean"]->at(ip);
     pad_par.stdev     = br_cont_map[side_name+"stdev"]->at(ip);
 
-    if (BCPadEnergies::kLeft == bc_side )  m_padParLeft->at(ip) = pad_par;
-    else m_padParRight->at(ip) = pad_par;
-
     pad_sigma->push_back(pad_par.stdev*sqrt(m_nBX));
     pad_mean->push_back(pad_par.mean*m_nBX);
   }
@@ -9,6 +9,9 @@
 
 #include "BeamCalBkg.hh"
 #include "BeamCalBkgParam.hh"
+#include "BCBackgroundSampler.hh"
+#include "BeamCalBkgContext.hh"
+#include "BCGaussianGenerator.hh"
 #include "BeamCalGeoCached.hh"
 #include "BCPadEnergies.hh"
 #include "BCRootUtilities.hh"
@@ -25,12 +28,10 @@
 #include <TMatrixD.h>
 #include <TTree.h>
 #include <TFile.h>
-#include <TF1.h>
 #include <TRandom3.h>
 #include <TUnuran.h>
 #include <TUnuranContDist.h>
 #include <TMath.h>
-#include <RVersion.h>
 
 #include <algorithm>
 #include <iomanip>
@@ -48,21 +49,14 @@ BeamCalBkgParam::BeamCalBkgParam(const string& bg_method_name,
                      const BeamCalGeo *BCG) : BeamCalBkg(bg_method_name, BCG),
 					   m_padParLeft(NULL),
 					   m_padParRight(NULL),
-					   m_unuransLeft(vector<TF1*>()),
-					   m_unuransRight(vector<TF1*>())
+					   m_samplerLeft(NULL),
+					   m_samplerRight(NULL)
 {}
 
 BeamCalBkgParam::~BeamCalBkgParam()
 {
-  vector<TF1*>::iterator iun = m_unuransLeft.begin();
-  for (;iun!=m_unuransLeft.end(); iun++){
-    delete *iun;
-  }
-
-  iun = m_unuransRight.begin();
-  for (;iun!=m_unuransRight.end(); iun++){
-    delete *iun;
-  }
+  delete m_samplerLeft;
+  delete m_samplerRight;
 
   delete m_padParLeft;
   delete m_padParRight;
@@ -102,6 +96,8 @@ void BeamCalBkgParam::init(vector<string> &bg_files, const int n_bx)
   const int nBCpads = m_BCG->getPadsPerBeamCal();
   m_padParLeft  = new vector<PadEdepRndPar_t>(nBCpads); 
   m_padParRight = new vector<PadEdepRndPar_t>(nBCpads); 
+  m_samplerLeft  = new BCBackgroundSampler(nBCpads, m_nBX);
+  m_samplerRight = new BCBackgroundSampler(nBCpads, m_nBX);
 
   m_BeamCalAverageLeft  =  new BCPadEnergies(m_BCG);
   m_BeamCalAverageRight =  new BCPadEnergies(m_BCG);
@@ -124,57 +120,29 @@ void BeamCalBkgParam::init(vector<string> &bg_files, const int n_bx)
 }
 
 
-void BeamCalBkgParam::getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
+void BeamCalBkgParam::getEventBG(BeamCalBkgContext &context, BCPadEnergies &peLeft, BCPadEnergies &peRight) const
 {
-  BCUtil::IgnoreRootError ire( not streamlog::out.write< streamlog::DEBUG0 >() );
-
   const int nBCpads = m_BCG->getPadsPerBeamCal();
-  vector<double> vedep(nBCpads, 0.);
 
-  for (int ip=0; ip< nBCpads; ip++){
-    // Parameters of energy deposition in a pad:
-    PadEdepRndPar_t pep = m_padParLeft->at(ip);
-
-    		//std::cout << ip<< "\t" <<m_unuransLeft.at(ip) << std::endl;
-    if (m_unuransLeft.at(ip)){
-      for (int ibx=0; ibx<m_nBX; ibx++){
-        // check if zero
-        if (m_random3->Uniform(1.) < pep.zero_rate ) continue ; // == {vedep.at(ip)+=0.};
-	// add value
-        vedep.at(ip) += m_unuransLeft.at(ip)->GetRandom();
+  for (int side = 0; side < 2; ++side) {
+    const BCBackgroundSampler& sampler = ( side == 0 ? *m_samplerLeft : *m_samplerRight );
+    const vector<double>& means  = *( side == 0 ? m_BeamCalAverageLeft : m_BeamCalAverageRight )->getEnergies();
+    const vector<double>& sigmas = *( side == 0 ? m_BeamCalErrorsLeft  : m_BeamCalErrorsRight  )->getEnergies();
+    vector<double>& vedep = *( side == 0 ? peLeft : peRight ).getEnergies();
+    vedep.resize(nBCpads);
+
+    for (int ip=0; ip< nBCpads; ip++){
+      if (sampler.hasDistribution(ip)){
+	// sum over the bunch crossings from the tabulated distribution
+	vedep[ip] = sampler.sample(ip, context.getGaussian());
+      } else  {
+	// if there is no distribution, than it's just gaus
+	// generating fluctuations at once with stdev*sqrt(nBX)
+	vedep[ip] = means[ip] + sigmas[ip] * context.getGaussian().gaus();
       }
-    } else  {
-      // if unuran is null, than it's just gaus
-      // generating fluctuations at once with stdev*sqrt(nBX)
-      // otherwise the time to generate each event grows too much
-      vedep.at(ip) = m_random3->Gaus(pep.mean*m_nBX, pep.stdev*sqrt(m_nBX));
     }
   }
 
-  peLeft.setEnergies(vedep);
-  std::fill(vedep.begin(), vedep.end(), 0.);
-
-  for (int ip=0; ip< nBCpads; ip++){
-    // Parameters of energy deposition in a pad:
-    PadEdepRndPar_t pep = m_padParRight->at(ip);
-
-    if (m_unuransRight.at(ip)){
-      for (int ibx=0; ibx<m_nBX; ibx++){
-        // check if zero
-        if (m_random3->Uniform(1.) < pep.zero_rate ) continue ; // == {vedep.at(ip)+=0.};
-	// add value
-        vedep.at(ip) += m_unuransRight.at(ip)->GetRandom();
-      }
-    } else  {
-      // if unuran is null, than it's just gaus
-      // generating fluctiations at once with stdev*sqrt(nBX)
-      // otherwise the time to generate each event grows too much
-      vedep.at(ip) = m_random3->Gaus(pep.mean*m_nBX, pep.stdev*sqrt(m_nBX));
-    }
-  }
-
-  peRight.setEnergies(vedep);
-
   streamlog_out(DEBUG) << "BeamCalBkgParam: total energy generated with parametrised method for "
 		       << "Left and Right BeamCal = " << peLeft.getTotalEnergy() << "\t" 
 		       << peRight.getTotalEnergy() << std::endl;
@@ -280,44 +248,20 @@ double gausOverX(double *x, double* p) {
 
 int BeamCalBkgParam::setBkgDistr(const BCPadEnergies::BeamCalSide_t bc_side)
 {
-  //this in highest debug level only
-  BCUtil::IgnoreRootError ire( not streamlog::out.write< streamlog::DEBUG0 >() );
-
   streamlog_out( MESSAGE0 ) << "Creating Background Distributions: " << bc_side << std::endl;
 
   const int nBCpads = m_BCG->getPadsPerBeamCal();
-  vector<TF1*> &vunr = (BCPadEnergies::kLeft == bc_side ? m_unuransLeft : m_unuransRight);
+  BCBackgroundSampler &sampler = (BCPadEnergies::kLeft == bc_side ? *m_samplerLeft : *m_samplerRight);
 
   for (int ip=0; ip< nBCpads; ip++){
     // Parameters of energy deposition in a pad:
     PadEdepRndPar_t pep = (BCPadEnergies::kLeft == bc_side ? 
                            m_padParLeft->at(ip) : m_padParRight->at(ip));
-    vunr.push_back(NULL);
-    //TF1 *func_pad_edep = new TF1("fedep", "gaus(0)/x", pep.minm, pep.maxm);
-    // if chi2 is good enough we want to initialise our unuran randomiser
+    // if chi2 is good enough we tabulate the gaus/x distribution of a single bunch crossing
     if (pep.chi2 <= 200. && pep.par1 >= 2*pep.par2) {
-      TF1 *func_pad_edep = new TF1("fedep", gausOverX, pep.minm, pep.maxm, 3);
-      func_pad_edep->SetParameters(pep.par0, pep.par1, pep.par2);
-		/*
-    		std::cout << ip << "\t" 
-		          << pep.mean << "\t" << pep.stdev<< "\t" 
-			  << pep.par0 << "\t" <<  pep.par1 << "\t" 
-			  <<  pep.par2 << "\t" << pep.chi2 << std::endl;
-			  */
-
       double funcparam[3] ={pep.par0, pep.par1, pep.par2};
-
-#if ROOT_VERSION_CODE < ROOT_VERSION(6, 0, 0)
-      double integral = func_pad_edep->Integral(pep.minm, pep.maxm, funcparam, 0.0001);
-#else
-      func_pad_edep->SetParameters(funcparam);
-      double integral = func_pad_edep->Integral(pep.minm, pep.maxm, 0.0001);
-#endif
-      if (integral > 0.001) {
-	vunr.back() = func_pad_edep;
-      } else {
+      if (not sampler.setDistribution(ip, pep.zero_rate, gausOverX, funcparam, pep.minm, pep.maxm, 0.001)) {
 	streamlog_out( DEBUG1 ) << "Failed to create gaus/x background distribution for this pad: " << ip << std::endl;
-	delete func_pad_edep;
       }
     }
   }
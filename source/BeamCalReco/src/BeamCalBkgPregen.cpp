@@ -11,8 +11,13 @@
 */
 #include "BeamCalBkg.hh"
 #include "BeamCalBkgPregen.hh"
+#include "BeamCalBkgContext.hh"
 #include "BeamCalGeoCached.hh"
 #include "BCPadEnergies.hh"
+#include "BCBackgroundLibrary.hh"
+#include "BCBackgroundStatistics.hh"
+#include "BCTowerCovariance.hh"
+#include "BCPCuts.hh"
 #include "BCRootUtilities.hh"
 
 
@@ -32,6 +37,7 @@
 #include <TRandom3.h>
 
 #include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <map>
@@ -43,13 +49,52 @@ using std::map;
 
 using marlin::Global;
 
+BeamCalBkgPregenContext::BeamCalBkgPregenContext()
+  :BeamCalBkgContext(),
+   m_backgroundBX(NULL),
+   m_BeamCalDepositsLeft(NULL),
+   m_BeamCalDepositsRight(NULL),
+   m_loadedBX(-1),
+   m_blocksLeft(),
+   m_blocksRight(),
+   m_nextBlock(0),
+   m_eventUnits(),
+   m_eventSumLeft(NULL),
+   m_eventSumRight(NULL),
+   m_scratchLeft(NULL),
+   m_scratchRight(NULL),
+   m_eventsSinceFullSum(0)
+{}
+
+BeamCalBkgPregenContext::~BeamCalBkgPregenContext()
+{
+  delete m_backgroundBX;
+  delete m_BeamCalDepositsLeft;
+  delete m_BeamCalDepositsRight;
+
+  for (unsigned int block = 0; block < m_blocksLeft.size(); ++block) {
+    delete m_blocksLeft[block];
+    delete m_blocksRight[block];
+  }
+
+  delete m_eventSumLeft;
+  delete m_eventSumRight;
+  delete m_scratchLeft;
+  delete m_scratchRight;
+}
+
+
 BeamCalBkgPregen::BeamCalBkgPregen(const string& bg_method_name, 
                      const BeamCalGeo *BCG) 
 		 :BeamCalBkg(bg_method_name, BCG), 
-		  m_listOfBunchCrossingsLeft(vector<BCPadEnergies*>()),
-		  m_listOfBunchCrossingsRight(vector<BCPadEnergies*>()),
-		  m_backgroundBX(NULL),
-		  m_numberForAverage(1)
+		  m_files(),
+		  m_nBackgroundBX(0),
+		  m_libraries(),
+		  m_firstBXInLibrary(),
+		  m_numberForAverage(10),
+		  m_bxPerBlock(0),
+		  m_nBlocks(0),
+		  m_replaceFraction(1.0)
 {
   streamlog_out(MESSAGE) << "Initialising BeamCal background with \""
 			 << bg_method_name << "\" method" << std::endl;
@@ -57,223 +102,382 @@ BeamCalBkgPregen::BeamCalBkgPregen(const string& bg_method_name,
 
 BeamCalBkgPregen::~BeamCalBkgPregen()
 {
-  delete m_backgroundBX;
-
-  vector<BCPadEnergies*>::iterator it_pe = m_listOfBunchCrossingsRight.begin();
-  for(; it_pe != m_listOfBunchCrossingsRight.end(); it_pe++)
-    delete *it_pe;
-
-  it_pe = m_listOfBunchCrossingsLeft.begin();
-  for(; it_pe != m_listOfBunchCrossingsLeft.end(); it_pe++)
-    delete *it_pe;
+  for (vector<BCBackgroundLibrary*>::iterator it = m_libraries.begin(); it != m_libraries.end(); ++it)
+    delete *it;
 }
 
 void BeamCalBkgPregen::init(vector<string> &bg_files, const int n_bx)
 {
   this->BeamCalBkg::init(n_bx);
 
-  m_numberForAverage = 10;
-
-  //Open the Files given as the list into a TChain...
-  m_backgroundBX = new TChain("bcTree");
-
   //mix up the files, because the random numbers are ordered to avoid repeating
   std::random_shuffle(bg_files.begin(), bg_files.end());
 
-  for (std::vector<std::string>::iterator file = bg_files.begin(); file != bg_files.end(); ++file) {
-    streamlog_out(DEBUG1) << *file << std::endl;
-    m_backgroundBX->Add(TString(*file));
-  }
-
-  //Ready the energy deposit vectors for the tree
-  m_BeamCalDepositsLeft=NULL;
-  m_BeamCalDepositsRight=NULL;
-
-  m_backgroundBX->SetBranchAddress("vec_left" , &m_BeamCalDepositsLeft);
-  m_backgroundBX->SetBranchAddress("vec_right", &m_BeamCalDepositsRight);
-
-  streamlog_out(DEBUG2) << "We have " << m_backgroundBX->GetEntries() << " background BXs" << std::endl;
-
   //Create an Average BeamCal, needed to setup the BCPadEnergies
   m_BCG = new BeamCalGeoCached(marlin::Global::GEAR);
 
-  m_BeamCalAverageLeft  =  new BCPadEnergies(m_BCG);
-  m_BeamCalAverageRight =  new BCPadEnergies(m_BCG);
-
-  // Create the average BCPadEnergies objects used to subtract average backgrounds
-  m_listOfBunchCrossingsRight.clear();
-  m_listOfBunchCrossingsLeft.clear();
+  //Binary libraries written by ConvertBeamCalBackground are mapped into memory,
+  //otherwise every context opens the ROOT Files given as the list into a TChain...
+  if( not bg_files.empty() && BCBackgroundLibrary::isBackgroundLibrary(bg_files.front()) ) {
+    int nBX = 0;
+    for (std::vector<std::string>::iterator file = bg_files.begin(); file != bg_files.end(); ++file) {
+      streamlog_out(DEBUG1) << *file << std::endl;
+      BCBackgroundLibrary* library = new BCBackgroundLibrary(*file);
+      m_libraries.push_back(library);
+      m_firstBXInLibrary.push_back(nBX);
+      if( library->getPadsPerBeamCal() != m_BCG->getPadsPerBeamCal() ) {
+	streamlog_out(ERROR) << "Background library " << *file << " has " << library->getPadsPerBeamCal()
+			     << " pads, the BeamCal has " << m_BCG->getPadsPerBeamCal() << std::endl;
+	throw std::runtime_error( "BeamCal background library does not match the geometry");
+      }
+      nBX += library->getNumberOfBunchCrossings();
+    }
+    m_nBackgroundBX = nBX;
+  } else {
+    for (std::vector<std::string>::iterator file = bg_files.begin(); file != bg_files.end(); ++file) {
+      streamlog_out(DEBUG1) << *file << std::endl;
+    }
+    m_files = bg_files;
+  }
 
-  for (int i = 0; i < 10; ++i) {
-    m_listOfBunchCrossingsLeft.push_back( new BCPadEnergies(m_BCG) );
-    m_listOfBunchCrossingsRight.push_back( new BCPadEnergies(m_BCG) );
+  //the context for the single threaded interface, also used for the average
+  BeamCalBkgPregenContext* context = openContext();
+  m_context = context;
+  if( m_libraries.empty() ) {
+    m_nBackgroundBX = context->m_backgroundBX->GetEntries();
   }
 
+  streamlog_out(DEBUG2) << "We have " << getNumberOfBackgroundBX() << " background BXs" << std::endl;
+
   std::set<int> randomNumbers;
-  const unsigned int nBackgroundBX = m_backgroundBX->GetEntries();
+  const unsigned int nBackgroundBX = getNumberOfBackgroundBX();
 
   //Check that we have
-  if( int(nBackgroundBX) < m_nBX*10 ) {
+  if( int(nBackgroundBX) < m_nBX*m_numberForAverage ) {
     streamlog_out(ERROR) << "There are not enough BeamCal " \
      " Background files to calculate a proper average!" << std::endl;
     throw std::runtime_error( "Not enough BeamCal Background bunch crossings available");
   }
 
+  if( m_bxPerBlock > 0 ) {
+    if( m_nBX % m_bxPerBlock != 0 ) {
+      streamlog_out(ERROR) << "The " << m_nBX << " BXs per event cannot be split into blocks of "
+			   << m_bxPerBlock << " BXs" << std::endl;
+      throw std::runtime_error( "Number of BeamCal background BXs is not a multiple of the block size");
+    }
+    if( m_nBlocks <= 0 ) m_nBlocks = 4 * getUnitsPerEvent();
+  }
+
+  if( m_replaceFraction <= 0.0 || m_replaceFraction > 1.0 ) {
+    streamlog_out(ERROR) << "The fraction of the background replaced for every event must be in (0,1], not "
+			 << m_replaceFraction << std::endl;
+    throw std::runtime_error( "Invalid fraction of the BeamCal background to replace");
+  }
+
+  //otherwise there is nothing left to replace a block or bunch crossing of the event with
+  if( ( m_bxPerBlock > 0 || m_replaceFraction < 1.0 ) && getNumberOfUnits() <= getUnitsPerEvent() ) {
+    streamlog_out(ERROR) << "Need more than " << getUnitsPerEvent()
+			 << ( m_bxPerBlock > 0 ? " blocks of background BXs, not " : " background BXs, not " )
+			 << getNumberOfUnits() << std::endl;
+    throw std::runtime_error( "Not enough blocks or bunch crossings of BeamCal background to replace");
+  }
+
   //we use a set so no duplication occurs
   while( int(randomNumbers.size()) < m_nBX*m_numberForAverage ){//do it ten times as often
-    randomNumbers.insert( int(m_random3->Uniform(0, nBackgroundBX)) );
+    randomNumbers.insert( int(context->getRandom3().Uniform(0, nBackgroundBX)) );
+  }
+
+  //Sum up m_nBX BXs at a time and only keep the statistics of the sums
+  const int startLayer = m_bcpCuts->getStartingLayer();
+  const int countingLayers = m_bcpCuts->getCountingLayers();
+  BCBackgroundStatistics statisticsLeft(*m_BCG, startLayer, countingLayers);
+  BCBackgroundStatistics statisticsRight(*m_BCG, startLayer, countingLayers);
+  BCPadEnergies sampleLeft(m_BCG), sampleRight(m_BCG);
+  if( m_towerCovarianceDistance > 0.0 ) {
+    m_TowerCovarianceLeft  = new BCTowerCovariance(*m_BCG, m_towerCovarianceDistance);
+    m_TowerCovarianceRight = new BCTowerCovariance(*m_BCG, m_towerCovarianceDistance);
+    statisticsLeft.setTowerCovariance(m_TowerCovarianceLeft);
+    statisticsRight.setTowerCovariance(m_TowerCovarianceRight);
   }
 
   int counter = 0;
 
   for (std::set<int>::iterator it = randomNumbers.begin(); it != randomNumbers.end();++it) {
     streamlog_out(DEBUG1) << std::setw(5) << *it << std::flush;
-    m_backgroundBX->GetEntry(*it);
-    m_BeamCalAverageLeft->addEnergies(*m_BeamCalDepositsLeft);
-    m_BeamCalAverageRight->addEnergies(*m_BeamCalDepositsRight);
-    m_listOfBunchCrossingsLeft.at(counter/m_nBX)-> addEnergies(*m_BeamCalDepositsLeft);
-    m_listOfBunchCrossingsRight.at(counter/m_nBX)-> addEnergies(*m_BeamCalDepositsRight);
-    ++counter;
+    addBackgroundBX(*context, *it, sampleLeft, sampleRight);
+    if( ++counter % m_nBX == 0 ) {
+      statisticsLeft.addSample(sampleLeft);
+      statisticsRight.addSample(sampleRight);
+      sampleLeft.resetEnergies();
+      sampleRight.resetEnergies();
+    }
   }
 
-  //Now divide by ten, to get the average distributions...
-  m_BeamCalAverageLeft ->scaleEnergies(1./double(m_numberForAverage));
-  m_BeamCalAverageRight->scaleEnergies(1./double(m_numberForAverage));
-  Double_t totalEnergyMean = m_BeamCalAverageLeft->getTotalEnergy();
-  Double_t varEn(0.0);
-  for (int l = 0; l < m_numberForAverage;++l) {
-    varEn += (m_listOfBunchCrossingsRight[l]->getTotalEnergy() - totalEnergyMean) * (m_listOfBunchCrossingsRight[l]->getTotalEnergy() - totalEnergyMean);
-  }//histograms
-  varEn /= double(m_numberForAverage);
-  varEn = sqrt(varEn);
-  streamlog_out(MESSAGE4) << "Total Energy " << totalEnergyMean << " +- "
-			  << varEn << " GeV/" << m_nBX <<"BX" << std::endl;
-
-  // m_h3BeamCalAverageLeft = bc.getBeamCalHistogram("AverageLeft");
-  // m_h3BeamCalAverageRight = bc.getBeamCalHistogram("AverageRight");
-
-  //And now calculate the error for every bin....
-  m_BeamCalErrorsLeft  = getBeamCalErrors(m_BeamCalAverageLeft,  m_listOfBunchCrossingsLeft);
-  m_BeamCalErrorsRight = getBeamCalErrors(m_BeamCalAverageRight, m_listOfBunchCrossingsRight);
+  streamlog_out(MESSAGE4) << "Total Energy " << statisticsRight.getTotalEnergyMean() << " +- "
+			  << statisticsRight.getTotalEnergySigma() << " GeV/" << m_nBX <<"BX" << std::endl;
+
+  //the average distributions and the error for every bin....
+  m_BeamCalAverageLeft  =  new BCPadEnergies(m_BCG);
+  m_BeamCalAverageRight =  new BCPadEnergies(m_BCG);
+  statisticsLeft.getMeans(*m_BeamCalAverageLeft);
+  statisticsRight.getMeans(*m_BeamCalAverageRight);
+
+  m_BeamCalErrorsLeft  =  new BCPadEnergies(m_BCG);
+  m_BeamCalErrorsRight =  new BCPadEnergies(m_BCG);
+  statisticsLeft.getSigmas(*m_BeamCalErrorsLeft);
+  statisticsRight.getSigmas(*m_BeamCalErrorsRight);
 
   //Add one sigma to the averages -- > just do it once here
   //m_BeamCalAverageLeft ->addEnergies( m_BeamCalErrorsLeft );
   //m_BeamCalAverageRight->addEnergies( m_BeamCalErrorsRight);
 
-  // calculate st.dev. of tower energies
-  this->setTowerErrors(BCPadEnergies::kLeft);
-  this->setTowerErrors(BCPadEnergies::kRight);
+  // st.dev. of tower energies, optionally including the correlations between the pads
+  if( m_correlatedTowerErrors ) {
+    statisticsLeft.getTowerSigmas(*m_TowerErrorsLeft);
+    statisticsRight.getTowerSigmas(*m_TowerErrorsRight);
+  } else {
+    this->BeamCalBkg::setTowerErrors(BCPadEnergies::kLeft);
+    this->BeamCalBkg::setTowerErrors(BCPadEnergies::kRight);
+  }
+  if( m_TowerCovarianceLeft ) {
+    streamlog_out(MESSAGE) << "Covariance of the tower energies closer than " << m_towerCovarianceDistance
+			   << " mm from " << m_TowerCovarianceLeft->getNumberOfSamples() << " samples" << std::endl;
+  }
 
   streamlog_out(DEBUG1) << std::endl;
 
-  /*
-  for (int i = 0; i < m_numberForAverage;++i) {
-    delete m_listOfBunchCrossingsLeft[i];
-    delete m_listOfBunchCrossingsRight[i];
+  //Prepare the summation for the optional background reuse
+  prepareSummation(*context);
+  if( m_bxPerBlock > 0 ) {
+    streamlog_out(MESSAGE) << "Summing background from " << getUnitsPerEvent() << " out of " << m_nBlocks
+			   << " blocks of " << m_bxPerBlock << " BXs" << std::endl;
+  }
+  if( m_bxPerBlock > 0 || m_replaceFraction < 1.0 ) {
+    streamlog_out(MESSAGE) << "Replacing " << m_replaceFraction * 100 << "% of the background for every event"
+			   << std::endl;
   }
-  */
 }
 
 
-/// Calculate the one sigma errors for the given selected background bunch crossings
-BCPadEnergies* BeamCalBkgPregen::getBeamCalErrors(const BCPadEnergies *averages, const std::vector<BCPadEnergies*> singles) {
-
-  BCPadEnergies * BCPErrors = new BCPadEnergies(m_BCG);
-  for (int i = 0; i < m_BCG->getPadsPerBeamCal()  ;++i) {
-    Double_t mean(averages->getEnergy(i));
-    Double_t variance(0);
-    Double_t nHistos(m_numberForAverage);
-    for (int l = 0; l < nHistos;++l) {
-      Double_t energy( singles[l]->getEnergy(i) );
-      variance += ( energy - mean ) * ( energy - mean );
-    }//histograms
-    variance /= nHistos;
-    variance = sqrt(variance);
-    BCPErrors->setEnergy(i, variance);
+BeamCalBkgContext* BeamCalBkgPregen::createContext() const
+{
+  BeamCalBkgPregenContext* context = openContext();
+  prepareSummation(*context);
+  return context;
+}
 
-  }//for all pads
 
-  return BCPErrors;
+BeamCalBkgPregenContext* BeamCalBkgPregen::openContext() const
+{
+  BeamCalBkgPregenContext* context = new BeamCalBkgPregenContext();
+  if( m_libraries.empty() ) {
+    context->m_backgroundBX = new TChain("bcTree");
+    for (std::vector<std::string>::const_iterator file = m_files.begin(); file != m_files.end(); ++file) {
+      context->m_backgroundBX->Add(TString(*file));
+    }
 
-}//getBeamCalErrors
+    //Ready the energy deposit vectors for the tree
+    context->m_backgroundBX->SetBranchAddress("vec_left" , &context->m_BeamCalDepositsLeft);
+    context->m_backgroundBX->SetBranchAddress("vec_right", &context->m_BeamCalDepositsRight);
+  }
+  return context;
+}
 
 
-/*
-int BeamCalBkgPregen::getPadsCovariance(vector<int> &pad_list, vector<double> &covinv, 
-      const BCPadEnergies::BeamCalSide_t &bc_side) const
+void BeamCalBkgPregen::prepareSummation(BeamCalBkgPregenContext &context) const
 {
-  // local copy of bunchcrossings
-  const vector<BCPadEnergies*> bxl = (BCPadEnergies::kLeft == bc_side 
-    ? m_listOfBunchCrossingsLeft : m_listOfBunchCrossingsRight );
-  
-  // average Edep
-  BCPadEnergies * pe_aver = (BCPadEnergies::kLeft == bc_side 
-    ? m_BeamCalAverageLeft : m_BeamCalAverageRight );
-
-  // number of elements
-  const int nm = pad_list.size();
-
-  // new covariance matrix, to be inverted and deleted
-  double *ma = new double [nm*nm];
-
-  vector<double> te_aver;
-  for (int i = 0; i<nm; i++){
-    te_aver.push_back(pe_aver->getTowerEnergy(pad_list[i],m_startLayer));
-  }
-
-  for (int i = 0; i<nm; i++){
-    for (int j = 0; j<nm; j++){
-      ma[i*nm+j] = 0.;
-      // loop over averaged entries to calculate covariance
-      for (int ibx = 0; ibx < m_numberForAverage; ibx++){
-      
-        ma[i*nm+j] += (bxl.at(ibx)->getTowerEnergy(pad_list[i], m_startLayer) - te_aver[i])
-	         *(bxl.at(ibx)->getTowerEnergy(pad_list[j],m_startLayer) - te_aver[j])
-		 /(m_numberForAverage-1);
-      }
+  if( m_bxPerBlock <= 0 && m_replaceFraction >= 1.0 ) return;
+
+  context.m_eventSumLeft  = new BCPadEnergies(m_BCG);
+  context.m_eventSumRight = new BCPadEnergies(m_BCG);
+  context.m_scratchLeft   = new BCPadEnergies(m_BCG);
+  context.m_scratchRight  = new BCPadEnergies(m_BCG);
+
+  if( m_bxPerBlock > 0 ) {
+    for (int block = 0; block < m_nBlocks; ++block) {
+      context.m_blocksLeft.push_back( new BCPadEnergies(m_BCG) );
+      context.m_blocksRight.push_back( new BCPadEnergies(m_BCG) );
+      refreshBlock(context, block);
     }
   }
+}
 
-  double det(0.);
-  TMatrixD *mtx= new TMatrixD(nm, nm, ma); 
-  TMatrixD mtxi(mtx->InvertFast(&det));
-  if ( 0. == det) {
-    streamlog_out(WARNING5) << "Unable to calculate inverse of covariance matrix" \
-         " for requested pads" << std::endl;;
-
-    delete mtx;
 
-    return -1;
-  }
+void BeamCalBkgPregen::getEventBG(BeamCalBkgContext &bgContext, BCPadEnergies &peLeft, BCPadEnergies &peRight) const
+{
+  BeamCalBkgPregenContext &context = dynamic_cast<BeamCalBkgPregenContext&>(bgContext);
 
-  double *mtxarr = mtxi.GetMatrixArray();
-  covinv.assign(mtxarr, mtxarr+nm*nm);
+  if( context.m_eventSumLeft ) {
+    //redraw the oldest block of the pool
+    if( m_bxPerBlock > 0 ) {
+      refreshBlock(context, context.m_nextBlock);
+      context.m_nextBlock = ( context.m_nextBlock + 1 ) % m_nBlocks;
+    }
 
-  delete mtx;
-  delete ma;
+    const int nReplace = int( ceil( m_replaceFraction * getUnitsPerEvent() ) );
+    if( context.m_eventUnits.empty() || nReplace >= getUnitsPerEvent() ) {
+      drawEventUnits(context);
+    } else {
+      replaceEventUnits(context, nReplace);
+    }
 
-  return covinv.size();
-}
-*/
+    peRight.addEnergies(*context.m_eventSumRight);
+    peLeft.addEnergies(*context.m_eventSumLeft);
+    return;
+  }
 
-void BeamCalBkgPregen::getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
-{
   ////////////////////////////////////////////////////////
   // Prepare the randomly chosen Background BeamCals... //
   ////////////////////////////////////////////////////////
   std::set<int> randomNumbers;
-  unsigned int nBackgroundBX = m_backgroundBX->GetEntries();
+  unsigned int nBackgroundBX = getNumberOfBackgroundBX();
   while( int(randomNumbers.size()) < m_nBX ){
-    randomNumbers.insert( int(m_random3->Uniform(0, nBackgroundBX)) );
+    randomNumbers.insert( int(context.getRandom3().Uniform(0, nBackgroundBX)) );
   }
 
   ////////////////////////
   // Sum them all up... //
   ////////////////////////
   for (std::set<int>::iterator it = randomNumbers.begin(); it != randomNumbers.end();++it) {
-    m_backgroundBX->GetEntry(*it);
-    peRight.addEnergies(*m_BeamCalDepositsRight);
-    peLeft.addEnergies(*m_BeamCalDepositsLeft);
+    addBackgroundBX(context, *it, peLeft, peRight);
+  }
+
+}
+
+
+void BeamCalBkgPregen::addBackgroundBX(BeamCalBkgPregenContext &context, int bx,
+				       BCPadEnergies &peLeft, BCPadEnergies &peRight) const
+{
+  if( m_libraries.empty() ) {
+    //the same entry is added to the average and one of the groups in init
+    if( bx != context.m_loadedBX ) {
+      context.m_backgroundBX->GetEntry(bx);
+      context.m_loadedBX = bx;
+    }
+    peRight.addEnergies(*context.m_BeamCalDepositsRight);
+    peLeft.addEnergies(*context.m_BeamCalDepositsLeft);
+    return;
+  }
+
+  //find the last library starting at or before bx
+  const int library = std::upper_bound(m_firstBXInLibrary.begin(), m_firstBXInLibrary.end(), bx)
+    - m_firstBXInLibrary.begin() - 1;
+  const int bxInLibrary = bx - m_firstBXInLibrary[library];
+  m_libraries[library]->addEnergies(bxInLibrary, BCPadEnergies::kRight, peRight);
+  m_libraries[library]->addEnergies(bxInLibrary, BCPadEnergies::kLeft, peLeft);
+}
+
+
+int BeamCalBkgPregen::getUnitsPerEvent() const
+{
+  return m_bxPerBlock > 0 ? m_nBX / m_bxPerBlock : m_nBX;
+}
+
+
+int BeamCalBkgPregen::getNumberOfUnits() const
+{
+  return m_bxPerBlock > 0 ? m_nBlocks : getNumberOfBackgroundBX();
+}
+
+
+void BeamCalBkgPregen::addUnit(BeamCalBkgPregenContext &context, int unit,
+			       BCPadEnergies &peLeft, BCPadEnergies &peRight) const
+{
+  if( m_bxPerBlock > 0 ) {
+    peRight.addEnergies(*context.m_blocksRight[unit]);
+    peLeft.addEnergies(*context.m_blocksLeft[unit]);
+  } else {
+    addBackgroundBX(context, unit, peLeft, peRight);
+  }
+}
+
+
+void BeamCalBkgPregen::subtractUnit(BeamCalBkgPregenContext &context, int unit,
+				    BCPadEnergies &peLeft, BCPadEnergies &peRight) const
+{
+  if( m_bxPerBlock > 0 ) {
+    peRight.subtractEnergies(*context.m_blocksRight[unit]);
+    peLeft.subtractEnergies(*context.m_blocksLeft[unit]);
+  } else {
+    context.m_scratchRight->resetEnergies();
+    context.m_scratchLeft->resetEnergies();
+    addBackgroundBX(context, unit, *context.m_scratchLeft, *context.m_scratchRight);
+    peRight.subtractEnergies(*context.m_scratchRight);
+    peLeft.subtractEnergies(*context.m_scratchLeft);
+  }
+}
+
+
+/// Draw new bunch crossings for the block, keeps the sum of the event up to date if the block is used
+void BeamCalBkgPregen::refreshBlock(BeamCalBkgPregenContext &context, int block) const
+{
+  vector<int> &eventUnits = context.m_eventUnits;
+  const bool inEvent = std::find(eventUnits.begin(), eventUnits.end(), block) != eventUnits.end();
+  if( inEvent ) subtractUnit(context, block, *context.m_eventSumLeft, *context.m_eventSumRight);
+
+  std::set<int> randomNumbers;
+  const unsigned int nBackgroundBX = getNumberOfBackgroundBX();
+  while( int(randomNumbers.size()) < m_bxPerBlock ){
+    randomNumbers.insert( int(context.getRandom3().Uniform(0, nBackgroundBX)) );
+  }
+
+  context.m_blocksRight[block]->resetEnergies();
+  context.m_blocksLeft[block]->resetEnergies();
+  for (std::set<int>::iterator it = randomNumbers.begin(); it != randomNumbers.end();++it) {
+    addBackgroundBX(context, *it, *context.m_blocksLeft[block], *context.m_blocksRight[block]);
+  }
+
+  if( inEvent ) addUnit(context, block, *context.m_eventSumLeft, *context.m_eventSumRight);
+}
+
+
+/// Draw all blocks or bunch crossings of the event
+void BeamCalBkgPregen::drawEventUnits(BeamCalBkgPregenContext &context) const
+{
+  std::set<int> randomNumbers;
+  const unsigned int nUnits = getNumberOfUnits();
+  while( int(randomNumbers.size()) < getUnitsPerEvent() ){
+    randomNumbers.insert( int(context.getRandom3().Uniform(0, nUnits)) );
+  }
+  context.m_eventUnits.assign(randomNumbers.begin(), randomNumbers.end());
+  sumEventUnits(context);
+}
+
+
+/// Replace nReplace of the blocks or bunch crossings of the previous event by ones not yet used in it
+void BeamCalBkgPregen::replaceEventUnits(BeamCalBkgPregenContext &context, int nReplace) const
+{
+  vector<int> &eventUnits = context.m_eventUnits;
+  std::set<int> positions;
+  while( int(positions.size()) < nReplace ){
+    positions.insert( int(context.getRandom3().Uniform(0, eventUnits.size())) );
   }
 
+  const unsigned int nUnits = getNumberOfUnits();
+  for (std::set<int>::iterator it = positions.begin(); it != positions.end();++it) {
+    int newUnit = -1;
+    do {
+      newUnit = int(context.getRandom3().Uniform(0, nUnits));
+    } while( std::find(eventUnits.begin(), eventUnits.end(), newUnit) != eventUnits.end() );
+
+    subtractUnit(context, eventUnits[*it], *context.m_eventSumLeft, *context.m_eventSumRight);
+    addUnit(context, newUnit, *context.m_eventSumLeft, *context.m_eventSumRight);
+    eventUnits[*it] = newUnit;
+  }
+
+  //sum from scratch now and then, so that the rounding errors do not add up
+  if( ++context.m_eventsSinceFullSum >= 100 ) {
+    sumEventUnits(context);
+  }
+}
+
+
+void BeamCalBkgPregen::sumEventUnits(BeamCalBkgPregenContext &context) const
+{
+  context.m_eventSumRight->resetEnergies();
+  context.m_eventSumLeft->resetEnergies();
+  for (vector<int>::iterator it = context.m_eventUnits.begin(); it != context.m_eventUnits.end(); ++it) {
+    addUnit(context, *it, *context.m_eventSumLeft, *context.m_eventSumRight);
+  }
+  context.m_eventsSinceFullSum = 0;
 }
@@ -1,18 +1,35 @@
 #include "BeamCalCluster.hh"
 #include "BCPadEnergies.hh"
 
+#include <algorithm>
 #include <iomanip>
 
+namespace {
+  bool padIndexLess(const BeamCalCluster::PadEnergyList::value_type& pad, int padIndex) {
+    return pad.first < padIndex;
+  }
+}
+
 //void BeamCalCluster::addPads(const BCPadEnergies& /*bcp*/){}
 
 void BeamCalCluster::addPad(int padIndex, double energy) {
-  m_clusterPads[padIndex] += energy; //if not existing, create new entry in map, using default c'tor for double, i.e. 0.0
   m_energy += energy;
+  //pads are usually added in order of their index
+  if( m_clusterPads.empty() || m_clusterPads.back().first < padIndex ) {
+    m_clusterPads.push_back( std::make_pair(padIndex, energy) );
+    return;
+  }
+  PadEnergyList::iterator it = std::lower_bound(m_clusterPads.begin(), m_clusterPads.end(), padIndex, padIndexLess);
+  if( it->first == padIndex ) {
+    it->second += energy;
+  } else {
+    m_clusterPads.insert( it, std::make_pair(padIndex, energy) );
+  }
 }
 
 ///Add energies in pads from THIS to rhs bcp object
 void BeamCalCluster::getBCPad(BCPadEnergies& bcp) const {
-  for (std::map<int , double>::const_iterator it = m_clusterPads.begin(); it != m_clusterPads.end(); ++it) {
+  for (PadEnergyList::const_iterator it = m_clusterPads.begin(); it != m_clusterPads.end(); ++it) {
     bcp.addEnergy(it->first, it->second);
   }
 }//getBCPad
@@ -11,16 +11,23 @@
 #include "BeamCalPadGeometry.hh"
 #include "BeamCalGeoCached.hh"
 #include "BCRootUtilities.hh"
+#include "BCPadKernels.hh"
+#include "BCTowerEnergies.hh"
 
 // ROOT
 #include "TMath.h"
 #include "Minuit2/Minuit2Minimizer.h"
 #include "Math/Functor.h"
 
+// ----- include for verbosity dependent logging ---------
+#include <streamlog/loglevels.h>
+#include <streamlog/streamlog.h>
+
 #include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <numeric>
+#include <sstream>
 #include <cmath>
 
 using std::vector;
@@ -30,21 +37,36 @@ using std::pair;
 //                    BeamCalFitShower methods                     //
 //=================================================================//
 
-BeamCalFitShower::BeamCalFitShower(vector<EdepProfile_t*> &vep, 
-		    const BCPadEnergies::BeamCalSide_t bc_side) :
-                                  m_vep(vep),
-				  m_spotPads(vector<EdepProfile_t*>()),
-				  m_covInv(vector<double>()),
+BeamCalFitShower::BeamCalFitShower(const BCPadEnergies::BeamCalSide_t bc_side) :
+                                  m_vep(vector<EdepProfile_t>()),
+				  m_removed(vector<bool>()),
+				  m_spotPads(vector<int>()),
+				  m_spotGeom(vector<BeamCalPadGeometry>()),
+				  m_spotIds(vector<int>()),
+				  m_choleskyCache(),
+				  m_cholesky(NULL),
+				  m_spotCovariance(vector<double>()),
+				  m_spotResiduals(vector<double>()),
 				  m_spotEint(vector<double>()),
+				  m_spotEintGrad(vector<double>()),
+				  m_dChi2dEint(vector<double>()),
+				  m_gradientPar(),
+				  m_gradient(),
+				  m_gradientValid(false),
 				  m_BCG(NULL),
 				  m_BCbackground(NULL),
 				  m_BCside(bc_side),
 				  m_rhom(9.3),
+				  m_spotRadius(1.8),
 				  m_enTowerLimit(0.),
 				  m_towerChi2Limit(1.),
+				  m_integrationTolerance(0.),
 				  m_startLayer(1),
 				  m_countingLayer(1),
-				  m_flagUncorr(false)
+				  m_flagUncorr(false),
+				  m_useGradient(true),
+				  m_useCovariance(false),
+				  m_warnings(NULL)
 {
   // hardcode now, make better later
   // m_rhom = 9.3; // Moliere radius (rho_M)
@@ -53,24 +75,41 @@ BeamCalFitShower::BeamCalFitShower(vector<EdepProfile_t*> &vep,
 
 BeamCalFitShower::BeamCalFitShower(const BeamCalFitShower& fs)
 		 : m_vep(fs.m_vep),
+		   m_removed(fs.m_removed),
 		   m_spotPads(fs.m_spotPads),
-		   m_covInv(fs.m_covInv),
+		   m_spotGeom(fs.m_spotGeom),
+		   m_spotIds(fs.m_spotIds),
+		   m_choleskyCache(fs.m_choleskyCache),
+		   m_cholesky(NULL),
+		   m_spotCovariance(),
+		   m_spotResiduals(),
 		   m_spotEint(fs.m_spotEint),
+		   m_spotEintGrad(),
+		   m_dChi2dEint(),
+		   m_gradientPar(),
+		   m_gradient(),
+		   m_gradientValid(false),
 		   m_BCG(fs.m_BCG),
 		   m_BCbackground(fs.m_BCbackground),
 		   m_BCside(fs.m_BCside),
 		   m_rhom(fs.m_rhom),
+		   m_spotRadius(fs.m_spotRadius),
 		   m_enTowerLimit(fs.m_enTowerLimit),
 		   m_towerChi2Limit(fs.m_towerChi2Limit),
+		   m_integrationTolerance(fs.m_integrationTolerance),
 		   m_startLayer(fs.m_startLayer),
 		   m_countingLayer(fs.m_countingLayer),
-		   m_flagUncorr(fs.m_flagUncorr)
+		   m_flagUncorr(fs.m_flagUncorr),
+		   m_useGradient(fs.m_useGradient),
+		   m_useCovariance(fs.m_useCovariance),
+		   m_warnings(fs.m_warnings)
 {}
 
 BeamCalFitShower&
 BeamCalFitShower::operator=(const BeamCalFitShower&fs)
 {
   m_vep = fs.m_vep;
+  m_removed = fs.m_removed;
   m_BCG = fs.m_BCG;
   m_BCbackground = fs.m_BCbackground;
 
@@ -79,29 +118,74 @@ BeamCalFitShower::operator=(const BeamCalFitShower&fs)
   return *this;
 }
 
+void BeamCalFitShower::warn(const std::string& message) const
+{
+  if ( m_warnings ) {
+    *m_warnings << message << std::endl;
+  } else {
+    streamlog_out(WARNING) << message << std::endl;
+  }
+}
+
+void BeamCalFitShower::resetProfile(int nTowers)
+{
+  m_vep.resize(nTowers);
+  m_removed.assign(nTowers, false);
+}
+
+void BeamCalFitShower::fillProfile(const BCTowerEnergies& signal, const BCTowerEnergies& average,
+				   const BCTowerEnergies& sigma, int firstTower, int lastTower)
+{
+  const int nLayers = m_BCG->getBCLayers();
+  const int lastCountingLayer = m_startLayer+m_countingLayer;
+
+  for (int it = firstTower; it < lastTower; it++){
+    // get tower energies, average, sigma
+    const double* te_signal = signal.getTowerEnergies(it);
+    const double* te_bg = average.getTowerEnergies(it);
+    const double* te_sigma = sigma.getTowerEnergies(it);
+
+    double tot_te_sigma(0.); // st.dev. for sum of the energies in the tower
+    m_BCbackground->getTowerErrorsBG(it, m_BCside, tot_te_sigma);
+
+    // calculate chi2 for this tower in all layers starting from defined
+    double chi2(0.);
+    for (int il = m_startLayer; il< nLayers; il++){
+      const double pull = (te_signal[il] - te_bg[il])/te_sigma[il];
+      chi2 += pull*pull;
+    }
+
+    // sums of signal and background in the counting layers of this tower
+    double te_signal_sum(0.), te_bg_sum(0.);
+    for (int il = m_startLayer; il< lastCountingLayer; il++){
+      te_signal_sum += te_signal[il];
+      te_bg_sum += te_bg[il];
+    }
+
+    // fill element of energy deposition profile
+    EdepProfile_t &ep = m_vep[it];
+    ep.id = it;
+    ep.towerChi2 = chi2;
+    ep.totalEdep = te_signal_sum;
+    ep.bkgEdep = te_bg_sum;
+    ep.bkgSigma = tot_te_sigma;
+  }
+}
+
 double BeamCalFitShower::fitShower(double &theta, double &phi, double &en_shwr, double &chi2)
 {
   BCUtil::IgnoreRootError ire{};
 
   // select spot pads around most likely shower
-  m_spotPads.clear();
-  vector<int> pad_list;
-  if ( this->selectSpotPads(pad_list) < 0 ){
-    this->deleteSpotPads();
+  if ( this->selectSpotPads() < 0 ){
+    this->removeSpotPads();
 
     theta = 0., phi = 0., en_shwr = 0., chi2 = 0.;
     return -1.;
   }
 
-  // calculate inverse covariance matrix for spot pads
-  /*
-  if ( m_BCbackground->getPadsCovariance(pad_list, m_covInv, m_BCside) < 0 ){
-    std::cout << "Falling back to uncorrelated errors in chi2 definition.\n";
-    m_flagUncorr = true;
-  }
-  */
-  // not using covariance for now
-  m_flagUncorr = true;
+  // factorise the covariance matrix of the spot pads, if it is used
+  m_flagUncorr = !( m_useCovariance && this->setSpotCholesky() );
 
   // fit the shower
   ROOT::Minuit2::Minuit2Minimizer minuit ( ROOT::Minuit2::kMigrad );
@@ -111,16 +195,23 @@ double BeamCalFitShower::fitShower(double &theta, double &phi, double &en_shwr,
   minuit.SetTolerance(0.1);
   //minuit.SetPrintLevel(3);
  
+  // the functors call this fitter, so that it is not copied with its profile
   const int npar = 4;
-  ROOT::Math::Functor f(*this,npar); 
-  //ROOT::Math::Functor f(&BeamCalFitShower::showerChi2,npar); 
+  ROOT::Math::Functor f(this, &BeamCalFitShower::operator(), npar);
+  ROOT::Math::GradFunctor gf(this, &BeamCalFitShower::operator(), &BeamCalFitShower::Derivative, npar);
+  m_gradientValid = false;
  
-  minuit.SetFunction(f);
+  // the analytic gradient needs the integral along the pad sides
+  if ( m_integrationTolerance > 0. && m_useGradient ) {
+    minuit.SetFunction(gf);
+  } else {
+    minuit.SetFunction(f);
+  }
 
-  double R0 = m_spotPads.at(0)->padGeom->m_R;
-  double dR0 = m_spotPads.at(0)->padGeom->m_dR;
-  double phi0 = m_spotPads.at(0)->padGeom->m_phi;
-  double dphi0 = m_spotPads.at(0)->padGeom->m_dphi;
+  double R0 = m_spotGeom.at(0).m_R;
+  double dR0 = m_spotGeom.at(0).m_dR;
+  double phi0 = m_spotGeom.at(0).m_phi;
+  double dphi0 = m_spotGeom.at(0).m_dphi;
 
   // estimate initial fit parameters
   double R_shr_center(0.), phi_shr_center(0.);
@@ -142,13 +233,13 @@ double BeamCalFitShower::fitShower(double &theta, double &phi, double &en_shwr,
   /*
   std::cout << minuit.Status() << std::endl;
   if ( minuit.Status()> 1 ) {
-    this->deleteSpotPads();
+    this->removeSpotPads();
     m_flagUncorr = false;
 
     return -1;
   }
   if ( chi2/m_spotPads.size() < 0.1 ) {
-    this->deleteSpotPads();
+    this->removeSpotPads();
     m_flagUncorr = false;
 
     return -1;
@@ -169,7 +260,7 @@ double BeamCalFitShower::fitShower(double &theta, double &phi, double &en_shwr,
   */
 
   // call our chi2 function to calculate energies corresponding to minimum
-  (*this)(result);  // wat?
+  (*this)(result);
 
   theta = result[0]/m_BCG->getLayerZDistanceToIP(m_startLayer)*1000.;
   phi = result[1]/M_PI*180.;
@@ -179,10 +270,10 @@ double BeamCalFitShower::fitShower(double &theta, double &phi, double &en_shwr,
   en_shwr = accumulate(m_spotEint.begin(), m_spotEint.end(), 0.0);
 
 		/*
-  		vector<EdepProfile_t*>::iterator it_sp;
+  		vector<int>::iterator it_sp;
   		std::cout << "SPOTPADS edp:\t" ;
   		for ( it_sp = m_spotPads.begin() ;it_sp!=m_spotPads.end(); it_sp++){
-  		  std::cout << (*it_sp)->totalEdep - (*it_sp)->bkgEdep<< "\t"  ;
+  		  std::cout << m_vep[*it_sp].totalEdep - m_vep[*it_sp].bkgEdep<< "\t"  ;
   		}
   		std::cout  << std::endl;
   		
@@ -195,7 +286,7 @@ double BeamCalFitShower::fitShower(double &theta, double &phi, double &en_shwr,
   		std::cout << "chi2 fit:\t"<< chi2 << "\t" ;
 		*/
 
-  this->deleteSpotPads();
+  this->removeSpotPads();
   m_flagUncorr = false;
 
   // calculate probability that this is our shower
@@ -203,21 +294,29 @@ double BeamCalFitShower::fitShower(double &theta, double &phi, double &en_shwr,
   return prob;
 }
 
-int BeamCalFitShower::selectSpotPads(vector<int> &pad_ids)
+int BeamCalFitShower::selectSpotPads()
 {
-  const double DEGRAD = M_PI/180.;
+  m_spotPads.clear();
+  m_spotGeom.clear();
+  m_spotIds.clear();
+
+  // the first tower left in the profile is only the starting point of the search
+  const int nTowers = m_vep.size();
+  int first = 0;
+  while ( first < nTowers && m_removed[first] ) first++;
+  if ( first == nTowers ) return -1;
 
   // find tower with largest tower chi2, provided it is > 5000.
-  vector<EdepProfile_t*>::iterator it_center = m_vep.begin();
-  //double max_en = (*it_center)->en;
-  double max_chi2 = (*it_center)->towerChi2;
-
-  vector<EdepProfile_t*>::iterator it_ep = m_vep.begin();
-  for (;it_ep!=m_vep.end(); it_ep++){
-    double tower_chi2 = (*it_ep)->towerChi2;
-    double en_tower = (*it_ep)->totalEdep - (*it_ep)->bkgEdep;
+  int center = first;
+  //double max_en = m_vep[center].en;
+  double max_chi2 = m_vep[center].towerChi2;
+
+  for (int it = first; it < nTowers; it++){
+    if ( m_removed[it] ) continue;
+    double tower_chi2 = m_vep[it].towerChi2;
+    double en_tower = m_vep[it].totalEdep - m_vep[it].bkgEdep;
     if ( tower_chi2 > m_towerChi2Limit && en_tower > 0.7*m_enTowerLimit && max_chi2 < tower_chi2 ){
-      it_center = it_ep;
+      center = it;
       max_chi2 = tower_chi2;
       //max_en = en_tower;
     }
@@ -225,41 +324,28 @@ int BeamCalFitShower::selectSpotPads(vector<int> &pad_ids)
     //std::cout << max_en<< "\t" << std::endl;
 
   // no pads with high enough chi2 found:
-  if ( it_center == m_vep.begin() ) return -1;
+  if ( center == first ) return -1;
 
   // create entry for central pad
-  double pext[6]; // tsk-tsk-tsk
-  m_BCG->getPadExtentsById((*it_center)->id, pext);
-  double dphi = pext[3]-pext[2];
-  if (dphi < 0 ) dphi+= 360.; // in case pad extents over the -X axis
-  (*it_center)->padGeom = new BeamCalPadGeometry(pext[4], pext[5]*DEGRAD, 
-    pext[1]-pext[0], dphi*DEGRAD);
-  (*it_center)->padGeom->m_isCentral = true;
-  m_spotPads.push_back(*it_center);
-  pad_ids.push_back((*it_center)->id);
+  this->addSpotPad(center, true);
 
   // collect pads within some Moliere radii of the maximum
-  for ( it_ep = m_vep.begin() ;it_ep!=m_vep.end(); it_ep++){
-    double pad_dist = m_BCG->getPadsDistance((*it_center)->id, (*it_ep)->id);
-    double en_tower = (*it_ep)->totalEdep - (*it_ep)->bkgEdep;
-    if ( pad_dist < 1.8*m_rhom && pad_dist > 0.01 && 
-        en_tower > 0.1*m_enTowerLimit && en_tower > (*it_ep)->bkgSigma) {
+  for (int it = 0; it < nTowers; it++){
+    if ( m_removed[it] ) continue;
+    double pad_dist = m_BCG->getPadsDistance(m_vep[center].id, m_vep[it].id);
+    double en_tower = m_vep[it].totalEdep - m_vep[it].bkgEdep;
+    if ( pad_dist < m_spotRadius*m_rhom && pad_dist > 0.01 && 
+        en_tower > 0.1*m_enTowerLimit && en_tower > m_vep[it].bkgSigma) {
       // if the pad is in the spot, assign its geometry too
-      m_BCG->getPadExtentsById((*it_ep)->id, pext);
-      dphi = pext[3]-pext[2];
-      if (dphi < 0 ) dphi+= 360.; // in case pad extents over the -X axis
-      (*it_ep)->padGeom = new BeamCalPadGeometry(pext[4], pext[5]*DEGRAD, pext[1]-pext[0], dphi*DEGRAD);
-      (*it_ep)->padGeom->m_isCentral = false;
-      m_spotPads.push_back(*it_ep);
-      pad_ids.push_back((*it_ep)->id);
+      this->addSpotPad(it, false);
     }
   }
 
 		/*
-  		vector<EdepProfile_t*>::iterator it_sp;
+  		vector<int>::iterator it_sp;
   		std::cout << "SPOTPADS sig:\t0.\t" ;
   		for ( it_sp = m_spotPads.begin() ;it_sp!=m_spotPads.end(); it_sp++){
-  		  std::cout << (*it_sp)->bkgSigma<< "\t"  ;
+  		  std::cout << m_vep[*it_sp].bkgSigma<< "\t"  ;
   		}
   		std::cout  << std::endl;
 		*/
@@ -268,6 +354,63 @@ int BeamCalFitShower::selectSpotPads(vector<int> &pad_ids)
   return m_spotPads.size();
 }
 
+void BeamCalFitShower::addSpotPad(int tower, bool isCentral)
+{
+  const double DEGRAD = M_PI/180.;
+
+  double pext[6]; // tsk-tsk-tsk
+  m_BCG->getPadExtentsById(m_vep[tower].id, pext);
+  double dphi = pext[3]-pext[2];
+  if (dphi < 0 ) dphi+= 360.; // in case pad extents over the -X axis
+  m_spotGeom.push_back(BeamCalPadGeometry(pext[4], pext[5]*DEGRAD, pext[1]-pext[0], dphi*DEGRAD));
+  m_spotGeom.back().m_isCentral = isCentral;
+  m_spotPads.push_back(tower);
+  m_spotIds.push_back(m_vep[tower].id);
+}
+
+bool BeamCalFitShower::setSpotCholesky()
+{
+  m_cholesky = NULL;
+  if ( !m_BCbackground ) return false;
+
+  std::map< vector<int>, vector<double> >::iterator it_ch = m_choleskyCache.find(m_spotIds);
+  if ( it_ch == m_choleskyCache.end() ) {
+    // keep at most 10000 sets of spot pads, starting over when full
+    if ( m_choleskyCache.size() >= 10000 ) m_choleskyCache.clear();
+    it_ch = m_choleskyCache.insert(std::make_pair(m_spotIds, vector<double>())).first;
+
+    const int np = m_spotIds.size();
+    if ( m_BCbackground->getPadsCovariance(m_spotIds, m_spotCovariance, m_BCside) < 0 ) return false;
+
+    // Cholesky decomposition, row by row into the lower triangle
+    vector<double> &chol = it_ch->second;
+    chol.assign(np*(np+1)/2, 0.);
+    for (int i = 0; i < np; i++){
+      double *row_i = &chol[i*(i+1)/2];
+      for (int j = 0; j <= i; j++){
+        const double *row_j = &chol[j*(j+1)/2];
+        const double c = m_spotCovariance[i*np+j] - BCPadKernels::dot(row_i, row_j, j);
+        if ( j < i ) {
+          row_i[j] = c*row_j[j];
+        } else if ( c > 1e-10*m_spotCovariance[i*np+i] && c > 0. ) {
+          row_i[i] = 1./sqrt(c);
+        } else {
+          std::ostringstream message;
+          message << "BeamCalFitShower: covariance matrix of " << np << " spot pads is singular, "
+                  << "falling back to uncorrelated errors in chi2 definition.";
+          warn(message.str());
+          chol.clear();
+          return false;
+        }
+      }
+    }
+  }
+
+  if ( it_ch->second.empty() ) return false;
+  m_cholesky = &it_ch->second;
+  return true;
+}
+
 //double BeamCalFitShower::showerChi2(double *par)
 // this is strangest thing I've ever coded
 double BeamCalFitShower::operator()(const double *par)
@@ -275,64 +418,106 @@ double BeamCalFitShower::operator()(const double *par)
   const int np = m_spotPads.size();
   m_spotEint.assign(np,0.);
 
-  vector<EdepProfile_t*>::iterator it_ep = m_spotPads.begin();
-  for (;it_ep != m_spotPads.end(); it_ep++){
-    (*it_ep)->padGeom->setLocalCoords(par[0], par[1]);
+  vector<BeamCalPadGeometry>::iterator it_pg = m_spotGeom.begin();
+  for (;it_pg != m_spotGeom.end(); it_pg++){
+    it_pg->setLocalCoords(par[0], par[1]);
   }
 
-  double dr(0.05*m_rhom);
-  double ra(0), rb(dr);
-  double rmax(3*m_rhom);
-  double ga = par[2];
-  //double ga = par[2]*TMath::Gaus(0.,0.,par[3]);
-  double gm(0.), gb(0.);
-  // simpson integration steps
-  while (rb<rmax){
-    double rm = (ra+rb)/2.;
-    gm=par[2]*exp(-rm/par[3]);
-    gb=par[2]*exp(-rb/par[3]);
-    /*
-    gm=par[2]*TMath::Gaus(rm,0.,par[3]);
-    gb=par[2]*TMath::Gaus(rb,0.,par[3]);
-    */
-    // loop over spot pads
-    for (it_ep = m_spotPads.begin();it_ep != m_spotPads.end(); it_ep++){
-      // approximate arc at the central point
-      double arc = (*it_ep)->padGeom->getArcWithin(rm);
-      		//std::cout <<"arc="<< "\t" << arc<< "\n";
-      m_spotEint.at(it_ep - m_spotPads.begin()) += 
-        arc*dr/6.*(ga+4*gm+gb);
-      //m_spotEint.at(it_ep - m_spotPads.begin()) += 
-      //  arc*dr;
+  // integrate the shower profile over the spot pads
+  for (it_pg = m_spotGeom.begin();it_pg != m_spotGeom.end(); it_pg++){
+    if ( m_integrationTolerance > 0. ) {
+      m_spotEint.at(it_pg - m_spotGeom.begin()) =
+        it_pg->integrateEdges(par[2], par[3], 3*m_rhom, m_integrationTolerance);
+    } else {
+      m_spotEint.at(it_pg - m_spotGeom.begin()) =
+        it_pg->integrateShells(par[2], par[3], 0.05*m_rhom, 3*m_rhom);
     }
-    		// std::cout  << std::endl;
-    ga = gb;
-    ra = rb;
-    rb += dr;
   }
-  
+
+  return this->spotChi2(NULL);
+}
+
+double BeamCalFitShower::Derivative(const double *par, unsigned int icoord)
+{
+  if ( !m_gradientValid || !std::equal(par, par+4, m_gradientPar) ) {
+    this->calcGradient(par);
+  }
+  return m_gradient[icoord];
+}
+
+void BeamCalFitShower::calcGradient(const double *par)
+{
+  const int np = m_spotPads.size();
+  m_spotEint.assign(np,0.);
+  m_spotEintGrad.assign(4*np,0.);
+
+  // integrals for unit amplitude, which they are proportional to
+  const double cosPhi = cos(par[1]), sinPhi = sin(par[1]);
+  for (int i = 0; i < np; i++){
+    BeamCalPadGeometry &padGeom = m_spotGeom[i];
+    padGeom.setLocalCoords(par[0], par[1]);
+    double dSigma(0.), dX(0.), dY(0.);
+    const double eint = padGeom.integrateEdges(1., par[3], 3*m_rhom, m_integrationTolerance, dSigma, dX, dY);
+    m_spotEint[i] = par[2]*eint;
+    m_spotEintGrad[4*i]   = par[2]*(dX*cosPhi + dY*sinPhi);
+    m_spotEintGrad[4*i+1] = par[2]*par[0]*(dY*cosPhi - dX*sinPhi);
+    m_spotEintGrad[4*i+2] = eint;
+    m_spotEintGrad[4*i+3] = par[2]*dSigma;
+  }
+
+  this->spotChi2(&m_dChi2dEint);
+
+  for (int k = 0; k < 4; k++){
+    m_gradient[k] = 0.;
+    for (int i = 0; i < np; i++){
+      m_gradient[k] += m_dChi2dEint[i]*m_spotEintGrad[4*i+k];
+    }
+  }
+  std::copy(par, par+4, m_gradientPar);
+  m_gradientValid = true;
+}
+
+double BeamCalFitShower::spotChi2(vector<double> *dChi2dEint)
+{
+  const int np = m_spotPads.size();
+  if ( dChi2dEint ) dChi2dEint->assign(np,0.);
+
   // calculate chi2 for integral and actual deposition
   // this piece implements convolution with covariance matrix:
-  // chi2 = (Edep-Eint)^T x V x (Edep-Eint)
+  // chi2 = (Edep-Eint)^T x V^-1 x (Edep-Eint)
   // where Edep is a linear algebra vector of energy depositions in spot pads,
   // Eint is the same of energy integral,
-  // V is the covariance matrix for the spot pads
+  // V = L x L^T is the covariance matrix for the spot pads,
+  // so that chi2 = z^T x z with L x z = Edep-Eint
+  // and, if asked for, its derivatives by Eint, -2 x L^-T x z
   double chi2 = 0.;
   if ( !m_flagUncorr ) {
+    const vector<double> &chol = *m_cholesky;
+    m_spotResiduals.resize(np);
+    double *z = &m_spotResiduals[0];
+    // forward substitution
     for ( int i = 0 ; i < np; i++){
-      double ExV(0.);
-      for ( int j = 0 ; j < np; j++){
-        double d_Ej = m_spotPads[j]->totalEdep - m_spotPads[j]->bkgEdep - m_spotEint[j];
-        ExV += d_Ej*m_covInv[j*np+i];
-        //std::cout <<m_spotPads[i]->id<< "\t" <<m_spotPads[j]->id<< "\t" << m_covInv[j*np+i] << std::endl;
+      const EdepProfile_t &ep_i = m_vep[m_spotPads[i]];
+      const double *row_i = &chol[i*(i+1)/2];
+      z[i] = (ep_i.totalEdep - ep_i.bkgEdep - m_spotEint[i] - BCPadKernels::dot(row_i, z, i))*row_i[i];
+    }
+    chi2 = BCPadKernels::dot(z, z, np);
+    // backward substitution with the transposed factor, column by column, overwrites z
+    if ( dChi2dEint ) {
+      for ( int j = np-1 ; j >= 0; j--){
+        const double *row_j = &chol[j*(j+1)/2];
+        z[j] *= row_j[j];
+        BCPadKernels::addScaled(z, row_j, -z[j], j);
+        (*dChi2dEint)[j] = -2.*z[j];
       }
-      //std::cout <<  std::endl;
-      double d_Ei = m_spotPads[i]->totalEdep - m_spotPads[i]->bkgEdep - m_spotEint[i];
-      chi2 += ExV*d_Ei;
     }
   } else {
-    for (it_ep = m_spotPads.begin();it_ep != m_spotPads.end(); it_ep++){
-      chi2 += pow(((*it_ep)->totalEdep - (*it_ep)->bkgEdep - m_spotEint.at(it_ep-m_spotPads.begin()))/(*it_ep)->bkgSigma,2);
+    for ( int i = 0 ; i < np; i++){
+      const EdepProfile_t &ep = m_vep[m_spotPads[i]];
+      chi2 += pow((ep.totalEdep - ep.bkgEdep - m_spotEint.at(i))/ep.bkgSigma,2);
+      if ( dChi2dEint ) {
+        (*dChi2dEint)[i] = -2.*(ep.totalEdep - ep.bkgEdep - m_spotEint.at(i))/pow(ep.bkgSigma,2);
+      }
     }
   }
 
@@ -351,21 +536,12 @@ double BeamCalFitShower::operator()(const double *par)
 }
 
   
-void BeamCalFitShower::deleteSpotPads()
+void BeamCalFitShower::removeSpotPads()
 {
-  // delete pad geometries from spot pads
-  vector<EdepProfile_t*>::iterator it_sp;
-  for ( it_sp = m_spotPads.begin() ;it_sp!=m_spotPads.end(); it_sp++){
-    delete (*it_sp)->padGeom;
-  }
- 
   // exclude towers of the found shower from next search
-  vector<EdepProfile_t*>::iterator it_ep = m_vep.end()-1;
-  for (;it_ep >= m_vep.begin(); it_ep--){
-    for (it_sp = m_spotPads.begin();it_sp != m_spotPads.end(); it_sp++){
-      if ( (*it_ep)->id == (*it_sp)->id )
-	it_ep = m_vep.erase(it_ep);
-    }
+  vector<int>::iterator it_sp = m_spotPads.begin();
+  for (;it_sp != m_spotPads.end(); it_sp++){
+    m_removed[*it_sp] = true;
   }
 }
 
@@ -375,19 +551,19 @@ void BeamCalFitShower::estimateShowerPars(double &rc, double &phic, double &A0,
   rc = 0.;
   phic = 0.;
   double logesum(0.);
-  vector<EdepProfile_t*>::iterator it_ep = m_spotPads.begin();
-  for (it_ep = m_spotPads.begin();it_ep != m_spotPads.end(); it_ep++){
-    double esh = log((*it_ep)->totalEdep - (*it_ep)->bkgEdep);
-    rc +=  esh * (*it_ep)->padGeom->m_R;
-    phic += esh * (*it_ep)->padGeom->m_phi;
+  const int np = m_spotPads.size();
+  for (int i = 0; i < np; i++){
+    double esh = log(m_vep[m_spotPads[i]].totalEdep - m_vep[m_spotPads[i]].bkgEdep);
+    rc +=  esh * m_spotGeom[i].m_R;
+    phic += esh * m_spotGeom[i].m_phi;
     logesum += esh;
   }
 
   if (0. == logesum ){
-    std::cout << "Warning in BeamCalFitShower: unable to estimate shower center, \n" 
-              << "will use hottest pad center coordinates as a fit starting point." << std::endl;
-    rc = m_spotPads.at(0)->padGeom->m_R;
-    phic = m_spotPads.at(0)->padGeom->m_phi;
+    warn("BeamCalFitShower: unable to estimate shower center, "
+         "will use hottest pad center coordinates as a fit starting point.");
+    rc = m_spotGeom.at(0).m_R;
+    phic = m_spotGeom.at(0).m_phi;
   } else {
     rc /= logesum;
     phic /= logesum;
@@ -399,12 +575,12 @@ void BeamCalFitShower::estimateShowerPars(double &rc, double &phic, double &A0,
   //std::cout << 25.6359 *m_BCG->getLayerZDistanceToIP(m_startLayer)/1000. << std::endl;
 
   double esum(0.);
-  for (it_ep = m_spotPads.begin();it_ep != m_spotPads.end(); it_ep++){
-    esum+=(*it_ep)->totalEdep - (*it_ep)->bkgEdep;
+  for (int i = 0; i < np; i++){
+    esum+=m_vep[m_spotPads[i]].totalEdep - m_vep[m_spotPads[i]].bkgEdep;
   }
 
-  EdepProfile_t* epc = m_spotPads.at(0); // central pad profile
-  double delt = 0.5*epc->padGeom->m_dR;
+  const EdepProfile_t &epc = m_vep[m_spotPads.at(0)]; // central pad profile
+  double delt = 0.5*m_spotGeom.at(0).m_dR;
   sig0 = 0.2*m_rhom;
-  A0 = 0.2*2.*M_PI*(epc->totalEdep - epc->bkgEdep)/m_rhom/(1-exp(-delt/m_rhom)) ;
+  A0 = 0.2*2.*M_PI*(epc.totalEdep - epc.bkgEdep)/m_rhom/(1-exp(-delt/m_rhom)) ;
 }
@@ -8,6 +8,21 @@
 
 //Return the double[6] pointer with innerRadius, Outerradius, Phi1 and Phi2, middle radius, middle phi
 void BeamCalGeo::getPadExtents(int cylinder, int sector, double *extents) const {
+  const int index = getTableIndex(cylinder, sector);
+  if( index < 0 ) {
+    calculatePadExtents(cylinder, sector, extents);
+    return;
+  }
+  extents[0] = m_padRMin[index];
+  extents[1] = m_padRMax[index];
+  extents[2] = m_padPhiMin[index];
+  extents[3] = m_padPhiMax[index];
+  extents[4] = m_padRMiddle[index];
+  extents[5] = m_padPhiMiddle[index];
+}
+
+//Calculates the extents from the segmentation, used to fill the lookup tables
+void BeamCalGeo::calculatePadExtents(int cylinder, int sector, double *extents) const {
 
   const double RADTODEG = 180./M_PI;
 
@@ -69,28 +84,54 @@ void BeamCalGeo::getPadExtents(int cylinder, int sector, double *extents) const
   //   extents[5] += 360.0;
   // }
 
-}//GetPadExtents
+}//calculatePadExtents
+
+
+/// Index of the pad in the lookup tables, -1 if the pad is not in the tables
+int BeamCalGeo::getTableIndex(int cylinder, int sector) const {
+  if( cylinder < 0 || int(m_ringFirstPad.size()) - 1 <= cylinder || sector < 0 ) return -1;
+  const int index = m_ringFirstPad[cylinder] + sector;
+  if( m_ringFirstPad[cylinder+1] <= index ) return -1;
+  return index;
+}
 
 
 double BeamCalGeo::getPadMiddlePhi(int cylinder, int sector) const {
+  const int index = getTableIndex(cylinder, sector);
+  if( index >= 0 ) return m_padPhiMiddle[index];
   double extents[6];
-  getPadExtents(cylinder, sector, extents);
-  // if( cylinder == 6 && sector == 15 ) {
-  //   std::cout << __func__  << "  " << extents[5] - 180 << std::endl;
-  // }
+  calculatePadExtents(cylinder, sector, extents);
   return extents[5];
 }
 
 double BeamCalGeo::getPadMiddleR(int cylinder, int sector) const {
+  const int index = getTableIndex(cylinder, sector);
+  if( index >= 0 ) return m_padRMiddle[index];
   double extents[6];
-  getPadExtents(cylinder, sector, extents);
+  calculatePadExtents(cylinder, sector, extents);
   return extents[4];
 }
 
 double BeamCalGeo::getPadMiddleTheta(int layer, int cylinder, int sector) const {
+  const int index = getTableIndex(cylinder, sector);
+  if( index >= 0 && 0 <= layer && layer*m_nLocalPads < int(m_padTheta.size()) ) {
+    return m_padTheta[ layer*m_nLocalPads + index ];
+  }
+  return atan(getPadMiddleR(cylinder, sector)/getLayerZDistanceToIP(layer));
+}
+
+double BeamCalGeo::getPadArea(int cylinder, int sector) const {
+  const int index = getTableIndex(cylinder, sector);
+  if( index >= 0 ) return m_padArea[index];
   double extents[6];
-  getPadExtents(cylinder, sector, extents);
-  return atan(extents[4]/getLayerZDistanceToIP(layer));
+  calculatePadExtents(cylinder, sector, extents);
+  double deltaPhi = extents[3] - extents[2];
+  if( deltaPhi < 0 ) deltaPhi += 360.0;
+  return 0.5 * ( extents[1]*extents[1] - extents[0]*extents[0] ) * deltaPhi * M_PI / 180.0;
+}
+
+double BeamCalGeo::getPadAreaById(int globalPadIndex) const {
+  return m_padArea[ globalPadIndex % m_nLocalPads ];
 }
 
 /**
@@ -104,6 +145,10 @@ double BeamCalGeo::getThetaFromRing(int layer, double averageRing) const  {
 }
 
 double BeamCalGeo::getThetaFromRing(int layer, int ring) const  {
+  const int nRings = int(m_ringFirstPad.size()) - 1;
+  if( 0 <= ring && ring < nRings && 0 <= layer && layer*nRings < int(m_ringTheta.size()) ) {
+    return m_ringTheta[ layer*nRings + ring ];
+  }
   const double radius = (getRadSegmentation()[ring+1]+getRadSegmentation()[ring])*0.5;
   return atan( radius / getLayerZDistanceToIP(layer) );
 }
@@ -113,8 +158,14 @@ double BeamCalGeo::getThetaFromRing(int ring) const  {
   return atan( radius / getBCZDistanceToIP() );
 }
 
-//ARG
 double BeamCalGeo::getPadPhi(int ring, int pad) const {
+  const int index = getTableIndex(ring, pad);
+  if( index >= 0 ) return m_padPhi[index];
+  return calculatePadPhi(ring, pad);
+}
+
+//ARG
+double BeamCalGeo::calculatePadPhi(int ring, int pad) const {
   const double RadToDeg = 180.0 / M_PI;
   double phi = 0;
   if( ring < getFirstFullRing()) {
@@ -137,9 +188,7 @@ double BeamCalGeo::getPadPhi(int ring, int pad) const {
 }
 
 double BeamCalGeo::getPadPhi(int globalPandIndex) const {
-  int layer, ring, pad;
-  getLayerRingPad(globalPandIndex, layer, ring, pad);
-  return getPadPhi(ring, pad);
+  return m_padPhi[ globalPandIndex % m_nLocalPads ];
 }
 
 
@@ -237,6 +286,45 @@ bool BeamCalGeo::arePadsNeighbours(int globalPadIndex1, int globalPadIndex2, boo
 }
 
 
+/**
+ * Only pads in the same or in adjacent rings can be neighbours, so the pads
+ * are first sorted into their rings and only those are checked with
+ * arePadsNeighbours. The layer does not matter for neighbours in different
+ * layers, so one table for the pads in the first layer serves all towers
+ */
+void BeamCalGeo::setPadNeighbours() {
+  const int padsPerLayer = getPadsPerLayer();
+  const int nRings = getBCRings();
+
+  std::vector< std::vector<int> > padsInRings(nRings);
+  std::vector<int> ringOfPad(padsPerLayer, -1);
+  for (int pad = 0; pad < padsPerLayer; ++pad) {
+    const int ring = getRing(pad);
+    if( ring < 0 || nRings <= ring ) continue;
+    ringOfPad[pad] = ring;
+    padsInRings[ring].push_back(pad);
+  }
+
+  m_neighbourOffsets.assign(padsPerLayer+1, 0);
+  m_neighbourPads.clear();
+  for (int pad = 0; pad < padsPerLayer; ++pad) {
+    const int ring = ringOfPad[pad];
+    if( ring >= 0 ) {
+      for (int otherRing = std::max(0, ring-1); otherRing <= std::min(nRings-1, ring+1); ++otherRing) {
+	for (std::vector<int>::const_iterator it = padsInRings[otherRing].begin(); it != padsInRings[otherRing].end(); ++it) {
+	  if( *it != pad && arePadsNeighbours(pad, *it) ) {
+	    m_neighbourPads.push_back(*it);
+	  }
+	}//pads in the ring
+      }//rings
+      std::sort(m_neighbourPads.begin()+m_neighbourOffsets[pad], m_neighbourPads.end());
+    }
+    m_neighbourOffsets[pad+1] = m_neighbourPads.size();
+  }//all pads in the layer
+
+}//setPadNeighbours
+
+
 int BeamCalGeo::getPadsInRing( int ring ) const {
     if ( ring < getFirstFullRing() ) {
       return getNSegments()[ring] * getSymmetryFold();
@@ -288,13 +376,11 @@ int BeamCalGeo::getPadIndex(int layer, int ring, int pad) const {
 
 void BeamCalGeo::getLayerRingPad(int padIndex, int& layer, int& ring, int& pad) const{
 
-  //how often does nPadsPerLayer fit into padIndex;
-  //layer starts at 1!
-  layer = getLayer(padIndex);// ( padIndex / getPadsPerLayer() ) + 1;
-  ring = getRing(padIndex);
-
-  const int ringIndex(padIndex % getPadsPerLayer());
-  pad = ringIndex - getPadsBeforeRing(ring);
+  //layer starts at 1 for GEAR, 0 for DD4hep, see getLayer
+  layer = m_padLayer[padIndex];
+  const int localIndex(padIndex % m_nLocalPads);
+  ring = m_padRing[localIndex];
+  pad = m_padLocal[localIndex];
 
 #ifdef DEBUG
   if (padIndex != this->getPadIndex(layer, ring, pad) ) {
@@ -310,21 +396,15 @@ void BeamCalGeo::getLayerRingPad(int padIndex, int& layer, int& ring, int& pad)
 
 }//getLayerRingPad
 
-int BeamCalGeo::getRing(int padIndex) const {
-  int ringIndex = padIndex % getPadsPerLayer();
+/// Find the ring for the pad index in the layer, only used to fill the lookup tables
+int BeamCalGeo::findRing(int localPadIndex) const {
   int ring = 0;
-  while ( getPadsBeforeRing( ring ) <= ringIndex) { ++ring; }
+  while ( getPadsBeforeRing( ring ) <= localPadIndex) { ++ring; }
   // std::vector<int>::const_iterator element =  std::upper_bound(m_PadsBeforeRing.begin()+1, m_PadsBeforeRing.end(),
   // 							       padIndex % getPadsPerLayer());
   return ring - 1 ;
 }
 
-int BeamCalGeo::getLocalPad(int padIndex) const {
-  int layer, ring, pad;
-  getLayerRingPad(padIndex, layer, ring, pad);
-  return pad;
-}
-
 
 int BeamCalGeo::getLayer(int padIndex) const {
   //layer starts at 1
@@ -345,22 +425,97 @@ int BeamCalGeo::getLayer(int padIndex) const {
 }
 
 void BeamCalGeo::getPadExtentsById(int globalPadIndex, double *extents) const {
-  int layer=0, ring=0, pad=0;
-  getLayerRingPad( globalPadIndex, layer, ring, pad);
-  this->getPadExtents(ring, pad, extents);
+  const int index = globalPadIndex % m_nLocalPads;
+  extents[0] = m_padRMin[index];
+  extents[1] = m_padRMax[index];
+  extents[2] = m_padPhiMin[index];
+  extents[3] = m_padPhiMax[index];
+  extents[4] = m_padRMiddle[index];
+  extents[5] = m_padPhiMiddle[index];
 }
 
 
 double BeamCalGeo::getPadsDistance(int padIndex1, int padIndex2) const {
-  const double DEGRAD=M_PI/180.;
-  static double e1[6], e2[6];
-  static int prev_pi1(-1), prev_pi2(-1);
-  if ( padIndex1 != prev_pi1) getPadExtentsById(padIndex1, e1), prev_pi1 = padIndex1;
-  if ( padIndex2 != prev_pi2) getPadExtentsById(padIndex2, e2), prev_pi2 = padIndex2;
-  //std::cout << padIndex1 << "\t" << padIndex2 << "\t" << e2[4] << "\t" << e2[5] << std::endl;
-
-  double dx = e1[4]*cos(e1[5]*DEGRAD) - e2[4]*cos(e2[5]*DEGRAD);
-  double dy = e1[4]*sin(e1[5]*DEGRAD) - e2[4]*sin(e2[5]*DEGRAD);
-  double d = sqrt(dx*dx+dy*dy);
-  return d;
+  const int index1 = padIndex1 % m_nLocalPads;
+  const int index2 = padIndex2 % m_nLocalPads;
+  const double dx = m_padX[index1] - m_padX[index2];
+  const double dy = m_padY[index1] - m_padY[index2];
+  return sqrt(dx*dx+dy*dy);
 }
+
+
+/**
+ * Everything which only depends on the segmentation is calculated once here
+ * and the accessors only read from the tables. Uses the virtual functions of
+ * the derived classes, so that the layer numbering of GEAR and DD4hep is kept
+ */
+void BeamCalGeo::setPadLookupTables() {
+  const double DEGRAD = M_PI/180.;
+  const int padsPerLayer = getPadsPerLayer();
+  const int padsPerBeamCal = getPadsPerBeamCal();
+  const int nRings = getBCRings();
+  const int nLayers = getBCLayers();
+
+  m_nLocalPads = padsPerLayer;
+
+  m_ringFirstPad.resize(nRings+1);
+  for (int ring = 0; ring <= nRings; ++ring) {
+    m_ringFirstPad[ring] = getPadsBeforeRing(ring);
+  }
+
+  m_padRing.assign(padsPerLayer, -1);
+  m_padLocal.assign(padsPerLayer, -1);
+  m_padRMin.assign(padsPerLayer, 0.0);
+  m_padRMax.assign(padsPerLayer, 0.0);
+  m_padPhiMin.assign(padsPerLayer, 0.0);
+  m_padPhiMax.assign(padsPerLayer, 0.0);
+  m_padRMiddle.assign(padsPerLayer, 0.0);
+  m_padPhiMiddle.assign(padsPerLayer, 0.0);
+  m_padPhi.assign(padsPerLayer, 0.0);
+  m_padX.assign(padsPerLayer, 0.0);
+  m_padY.assign(padsPerLayer, 0.0);
+  m_padArea.assign(padsPerLayer, 0.0);
+
+  for (int index = 0; index < padsPerLayer; ++index) {
+    const int ring = findRing(index);
+    const int pad = index - getPadsBeforeRing(ring);
+    m_padRing[index] = ring;
+    m_padLocal[index] = pad;
+    if( ring < 0 || nRings <= ring ) continue;
+
+    double extents[6];
+    calculatePadExtents(ring, pad, extents);
+    m_padRMin[index]      = extents[0];
+    m_padRMax[index]      = extents[1];
+    m_padPhiMin[index]    = extents[2];
+    m_padPhiMax[index]    = extents[3];
+    m_padRMiddle[index]   = extents[4];
+    m_padPhiMiddle[index] = extents[5];
+    m_padPhi[index]       = calculatePadPhi(ring, pad);
+    m_padX[index]         = extents[4]*cos(extents[5]*DEGRAD);
+    m_padY[index]         = extents[4]*sin(extents[5]*DEGRAD);
+
+    double deltaPhi = extents[3] - extents[2];
+    if( deltaPhi < 0 ) deltaPhi += 360.0; // pads extending over the -X axis
+    m_padArea[index] = 0.5 * ( extents[1]*extents[1] - extents[0]*extents[0] ) * deltaPhi * DEGRAD;
+  }//all pads in a layer
+
+  m_padLayer.resize(padsPerBeamCal);
+  for (int padIndex = 0; padIndex < padsPerBeamCal; ++padIndex) {
+    m_padLayer[padIndex] = getLayer(padIndex);
+  }
+
+  m_padTheta.resize(nLayers*padsPerLayer);
+  m_ringTheta.resize(nLayers*nRings);
+  for (int layer = 0; layer < nLayers; ++layer) {
+    const double layerZ = getLayerZDistanceToIP(layer);
+    for (int index = 0; index < padsPerLayer; ++index) {
+      m_padTheta[ layer*padsPerLayer + index ] = atan( m_padRMiddle[index] / layerZ );
+    }
+    for (int ring = 0; ring < nRings; ++ring) {
+      const double radius = (getRadSegmentation()[ring+1]+getRadSegmentation()[ring])*0.5;
+      m_ringTheta[ layer*nRings + ring ] = atan( radius / layerZ );
+    }
+  }//all layers
+
+}//setPadLookupTables
@@ -59,6 +59,9 @@ BeamCalGeoCached::BeamCalGeoCached(gear::GearMgr* gearMgr): m_BCPs(gearMgr->getB
   setPadsPerLayer();
   setPadsPerBeamCal();
 
+  setPadLookupTables();
+  setPadNeighbours();
+
 }
 
 //Wrappers around Gear Interface:
@@ -106,6 +106,9 @@ BeamCalGeoDD::BeamCalGeoDD(dd4hep::Detector const& theDetector): m_BeamCal(theDe
   setPadsPerLayer();
   setPadsPerBeamCal();
 
+  setPadLookupTables();
+  setPadNeighbours();
+
 }
 
 int BeamCalGeoDD::getPadIndex(int layer, int ring, int pad) const {
@@ -120,30 +123,6 @@ int BeamCalGeoDD::getPadIndex(int layer, int ring, int pad) const {
 }
 
 
-void BeamCalGeoDD::getLayerRingPad(int padIndex, int& layer, int& ring, int& pad) const{
-
-  //how often does nPadsPerLayer fit into padIndex;
-  //layer starts at 0!
-  layer = getLayer(padIndex);// ( padIndex / getPadsPerLayer() ) + 1;
-  ring = getRing(padIndex);
-
-  const int ringIndex(padIndex % getPadsPerLayer());
-  pad = ringIndex - getPadsBeforeRing(ring);
-
-#ifdef DEBUG
-  if (padIndex != this->getPadIndex(layer, ring, pad) ) {
-    std::stringstream error;
-    error << "PadIndex "
-          << std::setw(7) << padIndex
-          << std::setw(7) << this->getPadIndex(layer, ring, pad);
-    throw std::logic_error(error.str());
-  }
-#endif
-
-  return;
-
-}//getLayerRingPad
-
 //Wrappers around DD4hep Interface:
 inline double                BeamCalGeoDD::getBCInnerRadius() const { 
   return m_innerRadius;
@@ -242,18 +221,6 @@ int BeamCalGeoDD::getPadsPerLayer() const {
   return m_padsPerLayer;
 }
 
-int BeamCalGeoDD::getRing(int padIndex) const {
-  std::vector<int>::const_iterator element =  std::upper_bound(m_padsBeforeRing.begin()+1, m_padsBeforeRing.end(),
-							       padIndex % m_padsPerLayer);
-  return element - m_padsBeforeRing.begin() - 1 ;
-}
-
-int BeamCalGeoDD::getLocalPad(int padIndex) const {
-  int layer, ring, pad;
-  getLayerRingPad(padIndex, layer, ring, pad);
-  return pad;
-}
-
 int BeamCalGeoDD::getLayer(int padIndex) const {
   //layer starts at 0
   return padIndex / m_padsPerLayer ;
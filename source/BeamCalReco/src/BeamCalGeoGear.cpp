@@ -12,6 +12,8 @@
 #include <cmath>
 
 BeamCalGeoGear::BeamCalGeoGear(gear::GearMgr* gearMgr): m_BCPs(gearMgr->getBeamCalParameters()) {
+  setPadLookupTables();
+  setPadNeighbours();
 }
 
 //Wrappers around Gear Interface:
@@ -18,6 +18,101 @@
 using std::vector;
 using std::pair;
 
+namespace {
+
+  /**
+  * Integrand along a pad side x(t) = x1 + t*(x2-x1), t in [0, 1], for the triangle between
+  * the circle center and the side: the radial integral of A*exp(-r/sigma)*r out to |x(t)|,
+  * times dtheta/dt = cross(x1, x2)/|x(t)|^2
+  */
+  struct SideIntegrand {
+    enum { nValues = 1 };
+    double x1, y1, dx, dy, cross;
+    double A, sigma, rmax;
+
+    void operator()(double t, double *values) const {
+      const double x = x1 + t*dx, y = y1 + t*dy;
+      const double r2 = x*x + y*y;
+      const double rho = std::min(sqrt(r2), rmax)/sigma;
+      values[0] = A*sigma*sigma*( 1. - exp(-rho)*(1. + rho) )*cross/r2;
+    }
+  };
+
+  /**
+  * The same integrand, together with sigma times its derivative by sigma, and sigma times
+  * the profile A*exp(-r/sigma) along the side times the side normal (dy, -dx). Integrated
+  * around the pad the last two give the derivative of the integral by the circle center,
+  * with the opposite sign. The factor sigma gives all values the same scale for the error estimate.
+  */
+  struct SideGradientIntegrand {
+    enum { nValues = 4 };
+    double x1, y1, dx, dy, cross;
+    double A, sigma, rmax;
+
+    void operator()(double t, double *values) const {
+      const double x = x1 + t*dx, y = y1 + t*dy;
+      const double r2 = x*x + y*y;
+      const double r = sqrt(r2);
+      const double rho = std::min(r, rmax)/sigma;
+      const double expRho = exp(-rho);
+      const double radial = cross != 0. ? A*sigma*sigma*cross/r2 : 0.;
+      values[0] = radial*( 1. - expRho*(1. + rho) );
+      values[1] = radial*( 2.*( 1. - expRho*(1. + rho) ) - rho*rho*expRho );
+      const double profile = r < rmax ? A*sigma*expRho : 0.;
+      values[2] = profile*dy;
+      values[3] = -profile*dx;
+    }
+  };
+
+  /// seven point Gauss-Kronrod rule on [a, b], error estimated from the embedded three point Gauss rule
+  template <class Integrand>
+  double gaussKronrod7(const Integrand &f, double a, double b, double *integrals)
+  {
+    static const double nodes[4] = { 0.9604912687080203, 0.7745966692414834, 0.4342437493468026, 0. };
+    static const double kronrod[4] = { 0.1046562260264673, 0.2684880898683334, 0.4013974147759622,
+				       0.4509165386584741 };
+    static const double gauss[2] = { 0.5555555555555556, 0.8888888888888888 };
+
+    const int n = Integrand::nValues;
+    const double half = 0.5*(b-a), middle = 0.5*(a+b);
+    double values[7][n];
+    for (int i = 0; i < 3; i++){
+      f(middle - half*nodes[i], values[2*i]);
+      f(middle + half*nodes[i], values[2*i+1]);
+    }
+    f(middle, values[6]);
+
+    double error(0.);
+    for (int k = 0; k < n; k++){
+      double kronrodSum = kronrod[3]*values[6][k];
+      for (int i = 0; i < 3; i++){
+	kronrodSum += kronrod[i]*(values[2*i][k] + values[2*i+1][k]);
+      }
+      const double gaussSum = gauss[0]*(values[2][k] + values[3][k]) + gauss[1]*values[6][k];
+
+      error = std::max(error, fabs(kronrodSum - gaussSum)*half);
+      integrals[k] = kronrodSum*half;
+    }
+    return error;
+  }
+
+  /// split the interval until the error estimate is within the tolerance
+  template <class Integrand>
+  void adaptiveGaussKronrod(const Integrand &f, double a, double b, double tolerance, int depth,
+			    double *integrals)
+  {
+    const int n = Integrand::nValues;
+    const double error = gaussKronrod7(f, a, b, integrals);
+    if ( depth <= 0 || error <= tolerance ) return;
+    const double middle = 0.5*(a+b);
+    double left[n], right[n];
+    adaptiveGaussKronrod(f, a, middle, 0.5*tolerance, depth-1, left);
+    adaptiveGaussKronrod(f, middle, b, 0.5*tolerance, depth-1, right);
+    for (int k = 0; k < n; k++) integrals[k] = left[k] + right[k];
+  }
+
+}
+
 //=================================================================//
 //                      BeamCalPadGeometry methods                        //
 //=================================================================//
@@ -30,12 +125,8 @@ BeamCalPadGeometry::BeamCalPadGeometry(double R, double phi, double dR,  double
 			 m_pcX(0.),
 			 m_pcY(0.),
 		         m_isCentral(false),
-			 m_sides(vector<PadSide_t>())
+			 m_sides()
 {
-  m_sides.clear();
-  m_sides.assign(4, PadSide_t());
-
-  //for (int iside = 0; iside <4 ; iside++) m_sides.push_back(new PadSide_t);
 }
 
 BeamCalPadGeometry::~BeamCalPadGeometry()
@@ -62,14 +153,14 @@ void BeamCalPadGeometry::setLocalCoords(const double &R, const double &Phi)
       double x = r*cos(phi) - R*cos(Phi);
       double y = r*sin(phi) - R*sin(Phi);
       // assign them to the ends of pad sides
-      m_sides.at(iside).x1 = x;
-      m_sides.at(iside).y1 = y;
+      m_sides[iside].x1 = x;
+      m_sides[iside].y1 = y;
       if (iside == 0){
-        m_sides.at(m_sides.size()-1).x2 = x;
-        m_sides.at(m_sides.size()-1).y2 = y;
+        m_sides[nSides-1].x2 = x;
+        m_sides[nSides-1].y2 = y;
       } else {
-        m_sides.at(iside-1).x2 = x;
-        m_sides.at(iside-1).y2 = y;
+        m_sides[iside-1].x2 = x;
+        m_sides[iside-1].y2 = y;
       }
 
       iside++;
@@ -77,8 +168,8 @@ void BeamCalPadGeometry::setLocalCoords(const double &R, const double &Phi)
   }
   
   // calculate line parameters y = a*x + b for every side
-  vector<PadSide_t>::iterator it_ps = m_sides.begin();
-  for (;it_ps != m_sides.end(); it_ps++){
+  PadSide_t *it_ps = m_sides;
+  for (;it_ps != m_sides + nSides; it_ps++){
     if ( fabs(it_ps->x1 - it_ps->x2 ) < 1.e-10)  it_ps->x1+= 1.e-8;
     if ( fabs(it_ps->y1 - it_ps->y2 ) < 1.e-10)  it_ps->y1+= 1.e-8;
     double x1 = it_ps->x1, y1 = it_ps->y1;
@@ -96,14 +187,15 @@ void BeamCalPadGeometry::setLocalCoords(const double &R, const double &Phi)
 
 double BeamCalPadGeometry::getArcWithin(const double &r0)
 {
-  // intersections with pad sides
-  vector< pair<double, bool> > isects;
+  // intersections with pad sides, at most two for every side
+  pair<double, bool> isects[2*nSides];
+  int nIsects = 0;
   //std::cout << "---------------------" << std::endl;
   double r_vertex_min(1000.);
 
   // loop over pad sides
-  vector<PadSide_t>::iterator it_ps = m_sides.begin();
-  for (;it_ps != m_sides.end(); it_ps++){
+  PadSide_t *it_ps = m_sides;
+  for (;it_ps != m_sides + nSides; it_ps++){
     // line parameters
     PadSide_t ps = *it_ps;
     double a = ps.a, b = ps.b;
@@ -128,23 +220,23 @@ double BeamCalPadGeometry::getArcWithin(const double &r0)
     yi2 = a*xi2+b;
 
     pair<double, bool> ang;
-    if (arcOpenClose(ps, xi1, yi1, r0, ang)) isects.push_back(ang);
+    if (arcOpenClose(ps, xi1, yi1, r0, ang)) isects[nIsects++] = ang;
     //std::cout << a<< "\t" <<b<< "\t" <<det << "\t" <<xi1<< "\t" <<yi1<< "\t" << ang.first << "\t" <<ang.second<< std::endl;
-    if (arcOpenClose(ps, xi2, yi2, r0, ang)) isects.push_back(ang);
+    if (arcOpenClose(ps, xi2, yi2, r0, ang)) isects[nIsects++] = ang;
     //std::cout << a<< "\t" <<b<< "\t" <<det << "\t" <<xi2<< "\t" <<yi2<< "\t" << ang.first << "\t" <<ang.second<< std::endl;
   }
 
-  if ( 0 == isects.size() )
+  if ( 0 == nIsects )
     if ( m_isCentral && r0 < r_vertex_min ) return 2.*M_PI*r0;
-  if ( 0 == isects.size() ) return 0.;
+  if ( 0 == nIsects ) return 0.;
 
   // every pad must have even number of intersections
-  if ( 0 != isects.size() % 2 ) {
+  if ( 0 != nIsects % 2 ) {
     std::cout << "Warning in BeamCalFitShower: pad shower integration algorithm misbehaved." << std::endl;
     
     
     /*
-    for (it_ps = m_sides.begin();it_ps != m_sides.end(); it_ps++){
+    for (it_ps = m_sides;it_ps != m_sides + nSides; it_ps++){
       PadSide_t ps = *it_ps;
       std::cout << ps.x1<< "\t" <<ps.y1<< "\t" <<ps.x2<< "\t" <<ps.y2<< "\t" <<ps.a<< "\t" <<ps.b<< "\t" <<r0 << std::endl;
     }
@@ -162,19 +254,21 @@ double BeamCalPadGeometry::getArcWithin(const double &r0)
 
   // sort intersections and, if necessary,
   // shift so that first element is the arc opening 
-  vector<pair<double, bool> > isects_srt;
-  std::sort(isects.begin(), isects.end());
-  if (isects.begin()->second != true ) {
-    isects_srt.assign(isects.begin()+1, isects.end());
-    isects_srt.push_back(*isects.begin());
-    isects.assign(isects_srt.begin(),isects_srt.end());
+  for (int i = 1; i < nIsects; i++){
+    const pair<double, bool> isect = isects[i];
+    int j = i;
+    for (; j > 0 && isect < isects[j-1]; j--) isects[j] = isects[j-1];
+    isects[j] = isect;
+  }
+  if (isects[0].second != true ) {
+    std::rotate(isects, isects + 1, isects + nIsects);
   }
 
   // calculate total arc length within the pad
   double tot_arc(0.);
   double phi_open(0.);
-  vector<pair<double,bool> >::iterator it_is = isects.begin();
-  for (; it_is!=isects.end(); it_is++){
+  pair<double,bool> *it_is = isects;
+  for (; it_is!=isects + nIsects; it_is++){
     if(it_is->second) phi_open = it_is->first;
     double dphi = it_is->first - phi_open;
     // deal with case when arc opens at pasitive phi, and closes at negative
@@ -186,6 +280,105 @@ double BeamCalPadGeometry::getArcWithin(const double &r0)
 
 }
 
+double BeamCalPadGeometry::integrateShells(double A, double sigma, double dr, double rmax)
+{
+  double integral(0.);
+  double ra(0), rb(dr);
+  double ga = A;
+  double gm(0.), gb(0.);
+  // simpson integration steps
+  while (rb<rmax){
+    double rm = (ra+rb)/2.;
+    gm=A*exp(-rm/sigma);
+    gb=A*exp(-rb/sigma);
+    // approximate arc at the central point
+    integral += getArcWithin(rm)*dr/6.*(ga+4*gm+gb);
+    ga = gb;
+    ra = rb;
+    rb += dr;
+  }
+  return integral;
+}
+
+double BeamCalPadGeometry::integrateEdges(double A, double sigma, double rmax, double tolerance) const
+{
+  SideIntegrand f;
+  f.A = A;
+  f.sigma = sigma;
+  f.rmax = rmax;
+
+  double integral(0.);
+  integrateSides(f, tolerance, &integral);
+
+  // triangles on the far side of the center count negative, the orientation of the pad is arbitrary
+  return fabs(integral);
+}
+
+double BeamCalPadGeometry::integrateEdges(double A, double sigma, double rmax, double tolerance,
+					  double &dSigma, double &dX, double &dY) const
+{
+  SideGradientIntegrand f;
+  f.A = A;
+  f.sigma = sigma;
+  f.rmax = rmax;
+
+  double integrals[4] = { 0., 0., 0., 0. };
+  integrateSides(f, tolerance, integrals);
+
+  // the orientation of the pad gives the sign of the triangles and of the side normals,
+  // moving the circle center by d is the same as moving the pad by -d
+  const double orientation = integrals[0] < 0. ? -1. : 1.;
+  dSigma = orientation*integrals[1]/sigma;
+  dX = -orientation*integrals[2]/sigma;
+  dY = -orientation*integrals[3]/sigma;
+  return orientation*integrals[0];
+}
+
+template <class Integrand>
+void BeamCalPadGeometry::integrateSides(Integrand &f, double tolerance, double *integrals) const
+{
+  const int n = Integrand::nValues;
+  const double rmax = f.rmax;
+
+  // the integral over the plane is 2*pi*A*sigma^2, split the tolerance between the sides
+  const double sideTolerance = 0.5*M_PI*tolerance*f.A*f.sigma*f.sigma;
+
+  const PadSide_t *it_ps = m_sides;
+  for (;it_ps != m_sides + nSides; it_ps++){
+    f.x1 = it_ps->x1;
+    f.y1 = it_ps->y1;
+    f.dx = it_ps->x2 - it_ps->x1;
+    f.dy = it_ps->y2 - it_ps->y1;
+    f.cross = it_ps->x1*it_ps->y2 - it_ps->y1*it_ps->x2;
+    // the side points to the center and the triangle is empty, it still has a normal
+    if ( fabs(f.cross) < 1.e-12 ) {
+      if ( n == 1 ) continue;
+      f.cross = 0.;
+    }
+
+    // split the side where it is closest to the center, where the integrand peaks,
+    // and where it crosses rmax, where the integrand has a kink
+    double breaks[5] = { 0., 1., 1., 1., 1. };
+    int nBreaks = 2;
+    const double a = f.dx*f.dx + f.dy*f.dy;
+    const double b = f.x1*f.dx + f.y1*f.dy;
+    if ( -b > 0. && -b < a ) breaks[nBreaks++] = -b/a;
+    const double det = b*b - a*(f.x1*f.x1 + f.y1*f.y1 - rmax*rmax);
+    if ( det > 0. ) {
+      const double t1 = (-b - sqrt(det))/a, t2 = (-b + sqrt(det))/a;
+      if ( t1 > 0. && t1 < 1. ) breaks[nBreaks++] = t1;
+      if ( t2 > 0. && t2 < 1. ) breaks[nBreaks++] = t2;
+    }
+    std::sort(breaks, breaks + nBreaks);
+
+    for (int i = 0; i+1 < nBreaks; i++){
+      double parts[n];
+      adaptiveGaussKronrod(f, breaks[i], breaks[i+1], sideTolerance*(breaks[i+1] - breaks[i]), 12, parts);
+      for (int k = 0; k < n; k++) integrals[k] += parts[k];
+    }
+  }
+}
+
 bool BeamCalPadGeometry::arcOpenClose(PadSide_t &ps, double &xi, 
                                double &yi,const double &r0, pair<double,bool> &ang)
 {
@@ -73,9 +73,16 @@ class GlobalMethodsClass {
     COA
   }; 
   
+  // hits positions weighting methods, the names are only used for the WeightingMethod parameter
+  enum WeightingMethod_t {
+    LogMethod,
+    EnergyMethod
+  };
+
   static std::string GetParameterName ( Parameter_t par );
+  static WeightingMethod_t GetWeightingMethod ( std::string const& methodName );
+  static std::string GetWeightingMethodName ( WeightingMethod_t method );
 
-  typedef std::string                           WeightingMethod_t;
   typedef std::map < Parameter_t, int >         ParametersInt;
   typedef std::map < Parameter_t, double >      ParametersDouble;
   typedef std::map < Parameter_t, std::string > ParametersString;
@@ -88,8 +95,6 @@ class GlobalMethodsClass {
   virtual ~GlobalMethodsClass();
  
   void SetConstants( marlin::Processor* procPTR );
-  static WeightingMethod_t LogMethod;
-  static WeightingMethod_t EnergyMethod;
   static double EnergyCalibrationFactor;
 
   double _backwardRotationPhi;
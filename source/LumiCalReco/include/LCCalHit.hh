@@ -0,0 +1,49 @@
+#ifndef LCCalHit_hh
+#define LCCalHit_hh 1
+
+#include "GlobalMethodsClass.h"
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// A LumiCal hit as used by the clustering: the cellId and its fields, the energy and  //
+// the position in the local frame of the arm. Hits are plain values, stored by arm    //
+// in vectors owned by LumiCalClustererClass which are reused in every event, and are //
+// referred to by pointer everywhere else                                              //
+/////////////////////////////////////////////////////////////////////////////////////////
+
+class LCCalHit {
+
+public:
+  LCCalHit(int cellIdHit, int armHit, int layerHit, int rHit, int phiHit, float engyHit, const float* pos):
+    cellId(cellIdHit), arm(armHit), layer(layerHit), cellR(rHit), cellPhi(phiHit), cellIdHitZ(0), energy(engyHit)
+  {
+    position[0] = pos[0];
+    position[1] = pos[1];
+    position[2] = pos[2];
+  }
+
+  /// the arm, layer, R and phi indices are taken from the cellId
+  LCCalHit(int cellIdHit, float engyHit, const float* pos, int cellIdZ):
+    cellId(cellIdHit), arm(0), layer(0), cellR(0), cellPhi(0), cellIdHitZ(cellIdZ), energy(engyHit)
+  {
+    GlobalMethodsClass::CellIdZPR(cellId, layer, cellPhi, cellR, arm);
+    arm = ( arm == 0 ) ? -1 : 1;
+    position[0] = pos[0];
+    position[1] = pos[1];
+    position[2] = pos[2];
+  }
+
+  inline int getCellId() const { return cellId; }
+  inline float getEnergy() const { return energy; }
+  inline const float* getPosition() const { return position; }
+
+  int cellId;
+  int arm, layer, cellR, cellPhi;
+  /// for the hits of the projection layer: the layer of the hit the projection cell was created from
+  int cellIdHitZ;
+  /// single precision like in the LCIO hits, so that the clustering results do not change
+  float energy;
+  float position[3];
+
+};
+
+#endif // LCCalHit_hh
@@ -0,0 +1,73 @@
+#ifndef LCCellGrid_hh
+#define LCCellGrid_hh 1
+
+#include <cstddef>
+#include <vector>
+
+class LCCalHit;
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// The cal hits of one layer of one LumiCal arm in a dense R x phi grid, indexed       //
+// directly by the R and phi fields of the cellId, together with the Id of the cluster //
+// each cell belongs to. The filled cells are kept in a list, so that clearing the     //
+// grid only visits those, and so that the hits can be looped over in increasing       //
+// cellId order, the same order as in a std::map < int , LCCalHit* >                  //
+/////////////////////////////////////////////////////////////////////////////////////////
+
+class LCCellGrid {
+
+public:
+  LCCellGrid();
+
+  /// allocate the grid for the number of cells in R and phi, all cells are empty afterwards
+  void setSize(int cellRMax, int cellPhiMax);
+
+  /// put the hit in its cell, replacing the previous one. Throws std::out_of_range
+  /// if the R or phi index of the cellId is outside of the grid
+  void insert(int cellId, LCCalHit* calHit);
+  /// remove the hit and the cluster Id of the cell
+  void erase(int cellId);
+  /// remove all hits and cluster Ids
+  void clear();
+
+  /// the hit in the cell, or NULL if the cell is empty or outside of the grid
+  inline LCCalHit* find(int cellId) const {
+    return inside(cellId) ? m_hits[index(cellId)] : NULL;
+  }
+  /// the hit in the cell, throws std::out_of_range if the cell is empty
+  LCCalHit* at(int cellId) const;
+
+  /// Id of the cluster the hit in the cell belongs to, zero if it was not assigned
+  inline int& clusterId(int cellId) { return m_clusterIds[index(cellId)]; }
+  inline int clusterId(int cellId) const { return m_clusterIds[index(cellId)]; }
+
+  /// cellId of the highest energy near neighbor the hit is connected to, used by initialClusterBuild
+  inline int& connectedNeighbor(int cellId) { return m_connectedNeighbors[index(cellId)]; }
+  /// cellIds of the hits which are connected to the hit in the cell, used by initialClusterBuild
+  std::vector<int>& connectedToMe(int cellId);
+
+  /// the cellIds of all hits in increasing order
+  std::vector<int> const& cellIds() const;
+
+  inline int size() const { return m_size; }
+  inline bool empty() const { return m_size == 0; }
+
+private:
+  /// position in the grid from the R (bits 0-9) and phi (bits 10-19) fields of the cellId
+  inline int index(int cellId) const { return ((cellId >> 10) & 0x3FF) * m_cellRMax + (cellId & 0x3FF); }
+  inline bool inside(int cellId) const { return (cellId & 0x3FF) < m_cellRMax and ((cellId >> 10) & 0x3FF) < m_cellPhiMax; }
+
+  int m_cellRMax, m_cellPhiMax;
+  int m_size;
+  std::vector<LCCalHit*> m_hits;
+  std::vector<int> m_clusterIds;
+  std::vector<int> m_connectedNeighbors;
+  std::vector< std::vector<int> > m_connectedToMe;
+
+  /// cellIds of the filled cells, sorted and stripped of erased cells on demand
+  mutable std::vector<int> m_cellIds;
+  mutable bool m_sorted;
+
+};
+
+#endif // LCCellGrid_hh
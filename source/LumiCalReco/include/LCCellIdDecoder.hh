@@ -0,0 +1,57 @@
+#ifndef LCCellIdDecoder_hh
+#define LCCellIdDecoder_hh 1
+
+#include <EVENT/SimCalorimeterHit.h>
+#include <lcio.h>
+
+#include <string>
+
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// The arm, R, phi and layer fields of the LumiCal cellID, with offsets, masks and     //
+// signs resolved once from the CellIDEncoding of the collection, so that decoding a   //
+// hit needs no look up of the fields by name                                          //
+/////////////////////////////////////////////////////////////////////////////////////////
+
+class LCCellIdDecoder {
+
+public:
+  LCCellIdDecoder();
+
+  /// resolve the fields of the Mokka ("S-1","I","J","K") or the DD4hep ("barrel","r","phi","layer")
+  /// encoding, nothing is done if the encoding did not change. Throws if a field is missing
+  void setEncoding(std::string const& encoding, bool useDD4hep);
+
+  /// the values of the arm, R, phi and layer fields, as given by UTIL::CellIDDecoder
+  inline void decode(EVENT::SimCalorimeterHit const* hit, int& arm, int& cellR, int& cellPhi, int& layer) const {
+    const lcio::long64 cellId = lcio::long64( hit->getCellID0() & 0xffffffff ) | ( lcio::long64( hit->getCellID1() ) << 32 );
+    arm     = m_arm.value(cellId);
+    cellR   = m_cellR.value(cellId);
+    cellPhi = m_cellPhi.value(cellId);
+    layer   = m_layer.value(cellId);
+  }
+
+private:
+  struct Field {
+    Field(): offset(0), width(0), mask(0), isSigned(false) {}
+
+    /// the field is cut out unsigned, like UTIL::BitFieldValue, so that a field reaching
+    /// the highest bit is not sign extended by the shift before its own sign is applied
+    inline int value(lcio::long64 cellId) const {
+      const lcio::ulong64 val = ( lcio::ulong64( cellId ) & mask ) >> offset;
+      if( isSigned and ( val & ( 1ULL << ( width - 1 ) ) ) ) return int( lcio::long64( val ) - ( 1LL << width ) );
+      return int(val);
+    }
+
+    unsigned offset, width;
+    lcio::ulong64 mask;
+    bool isSigned;
+  };
+
+  std::string m_encoding;
+  bool m_useDD4hep;
+  Field m_arm, m_cellR, m_cellPhi, m_layer;
+
+};
+
+#endif // LCCellIdDecoder_hh
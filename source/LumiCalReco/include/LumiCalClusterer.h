@@ -18,12 +18,15 @@
 #include "Global.hh"
 
 #include "GlobalMethodsClass.h"
+#include "LCCalHit.hh"
+#include "LCCellGrid.hh"
+#include "LCCellIdDecoder.hh"
 #include "LCCluster.hh"
 #include "VirtualCluster.hh"
 #include "ProjectionInfo.hh"
+#include "StageTimers.hh"
 
 #include <IMPL/SimCalorimeterHitImpl.h>
-#include <UTIL/CellIDDecoder.h>
 
 #include <streamlog/loglevels.h>
 #include <streamlog/streamlog.h>
@@ -37,18 +40,16 @@ namespace EVENT {
   class LCEvent;
 }
 
-namespace IMPL{
-  class CalorimeterHitImpl;
-}
+class TaskPool;
 
 
 class LumiCalClustererClass {
 
-  typedef std::vector <IMPL::CalorimeterHitImpl*> VecCalHit;
+  typedef std::vector <LCCalHit*> VecCalHit;
   typedef std::vector < double >                  VDouble;
   typedef std::vector < int >                     VInt;
 
-  typedef std::map < int , IMPL::CalorimeterHitImpl* >  MapIntCalHit;
+  typedef std::map < int , LCCalHit* >  MapIntCalHit;
   typedef std::map < int , LCCluster >                  MapIntLCCluster;
 
   typedef std::map < int , VecCalHit >                  MapIntVCalHit;
@@ -65,6 +66,7 @@ class LumiCalClustererClass {
   typedef std::map < int , int >                        MapIntInt;
 
   typedef std::map < int , MapIntCalHit > MapIntMapIntCalHit;
+  typedef std::map < int , std::vector < LCCalHit > > MapIntVCalHitArena;
 
 
   typedef std::vector < MapIntCalHit >         VMapIntCalHit;
@@ -72,6 +74,7 @@ class LumiCalClustererClass {
   typedef std::vector < MapIntLCCluster >      VMapIntLCCluster;
   typedef std::vector < MapIntVInt >           VMapIntVInt;
   typedef std::vector < MapIntVirtualCluster > VMapIntVirtualCluster;
+  typedef std::vector < LCCellGrid >           VCellGrid;
 
   typedef std::vector < VDouble >              VVDouble;
 
@@ -79,6 +82,7 @@ public:
 
   // Constructor
   LumiCalClustererClass( std::string const& lumiNameNow ) ;
+  ~LumiCalClustererClass();
 
   // initialization routine - Called at the begining of the job.
   void init( GlobalMethodsClass const& gmc );
@@ -86,6 +90,9 @@ public:
   /// set the cutOnFiducialVolume flag
   void setCutOnFiducialVolume( bool cutFlag ) { _cutOnFiducialVolume = cutFlag; }
 
+  /// cluster the two arms in parallel if nThreads > 1, the clusters are the same for any number of threads
+  void setNumberOfThreads( int nThreads );
+
   // main actions in each event -Called for every event - the working horse.
   int processEvent( EVENT::LCEvent * evt ) ;
 
@@ -95,6 +102,9 @@ public:
 
   void setLumiCollectionName(std::string const& lumiNameNow) { _lumiName = lumiNameNow; }
 
+  /// times of the steps of processEvent, disabled unless enabled by the processor
+  StageTimers& getStageTimers() { return _stageTimers; }
+
 protected:
 
   LumiCalClustererClass(LumiCalClustererClass const& rhs);
@@ -125,19 +135,47 @@ protected:
   MapIntInt    _numHitsInArm;
   //  VInt _armsToCluster;
 
-  std::unique_ptr<CellIDDecoder<SimCalorimeterHit>> _mydecoder{};
+  LCCellIdDecoder _cellIdDecoder;
 
   GlobalMethodsClass _gmc;
   bool _useDD4hep;
   bool _cutOnFiducialVolume=false;
 
-  // global to local rotations mtx elements
-  std::map < int , std::map< std::string, double> > RotMat;
+  StageTimers _stageTimers;
+  int _getCalHitsStage, _buildClustersStage, _clusterMergerStage, _fiducialVolumeCutsStage, _energyCorrectionsStage;
+  int _hitsCounter, _clustersCounter;
+
+  // hits of each layer, and of the projection layer at _maxLayerToAnalyse, reused in every event,
+  // for the arm -1 at index 0 and the arm +1 at index 1 so that the arms can be clustered in parallel
+  VCellGrid _cellGrids[2], _smallEngyCellGrids[2];
+
+  // the hits of the event for each arm, reused in every event so that the storage is kept
+  MapIntVCalHitArena _calHitsArena;
+
+  // global to local rotation around the y-axis, for the arm -1 at index 0 and the arm +1 at index 1
+  struct ArmRotation { double cosAngle, sinAngle; };
+  ArmRotation _armRotation[2];
+  // _totEngyArm and _numHitsInArm of the arm -1 at index 0 and of the arm +1 at index 1,
+  // read while clustering as the maps must not be touched from the threads of the arms
+  double _armTotEngy[2];
+  int    _armNumHits[2];
+
+  // runs the two arms in parallel, NULL if they are clustered one after the other
+  TaskPool* _taskPool;
 
   // methods:
   int	getCalHits( EVENT::LCEvent * evt,
 		    MapIntMapIntVCalHit & calHits );
 
+  /// buildClusters, clusterMerger, fiducialVolumeCuts and energyCorrections of one arm,
+  /// only writes to the arguments and the per-arm members of the arm
+  void	clusterArm(	MapIntVCalHit const& calHits,
+			MapIntCalHit & calHitsCellIdGlobal,
+			MapIntVInt & superClusterIdToCellId,
+			MapIntVDouble & superClusterIdToCellEngy,
+			MapIntLCCluster & superClusterCM,
+			const int detectorArm);
+
 
   int	buildClusters(	MapIntVCalHit const& calHits,
 			MapIntCalHit & calHitsCellIdGlobal,
@@ -146,33 +184,29 @@ protected:
 			MapIntLCCluster & superClusterCM, 
 			const int detectorArm);
 
-  int	initialClusterBuild( MapIntCalHit const& calHitsCellId,
-			     MapIntInt			  & cellIdToClusterId,
+  int	initialClusterBuild( LCCellGrid & calHitsCellId,
 			     MapIntVInt	  & clusterIdToCellId,
 			     MapIntLCCluster & clusterCM,
 			     VInt const& controlVar );
 
-  int	initialLowEngyClusterBuild( MapIntCalHit const& calHitsSmallEngyCellId,
-				    MapIntCalHit & calHitsCellId,
-				    MapIntInt			 & cellIdToClusterId,
+  int	initialLowEngyClusterBuild( LCCellGrid const& calHitsSmallEngyCellId,
+				    LCCellGrid & calHitsCellId,
 				    MapIntVInt		 & clusterIdToCellId,
 				    MapIntLCCluster	 & clusterCM );
 
 
-  int	virtualCMClusterBuild( MapIntCalHit const&	  calHitsCellId,
-			       MapIntInt	&			 cellIdToClusterId,
+  int	virtualCMClusterBuild( LCCellGrid & calHitsCellId,
 			       MapIntVInt & clusterIdToCellId,
 			       MapIntLCCluster		& clusterCM,
 			       MapIntVirtualCluster const& virtualClusterCM );
 
-  int	virtualCMPeakLayersFix(	MapIntCalHit const&	calHitsCellId,
-				MapIntInt				& cellIdToClusterId,
+  int	virtualCMPeakLayersFix(	LCCellGrid & calHitsCellId,
 				MapIntVInt		& clusterIdToCellId,
 				MapIntLCCluster		& clusterCM,
 				MapIntVirtualCluster virtualClusterCM );
 
   int	buildSuperClusters ( MapIntCalHit & calHitsCellIdGlobal,
-			     VMapIntCalHit const&	calHitsCellId,
+			     VCellGrid const&	calHitsCellId,
 			     VMapIntVInt const&	clusterIdToCellId,
 			     VMapIntLCCluster const&	clusterCM,
 			     VMapIntVirtualCluster const& virtualClusterCM,
@@ -182,10 +216,9 @@ protected:
 
   int	engyInMoliereCorrections ( MapIntCalHit const& calHitsCellIdGlobal,
 				   MapIntVCalHit const& calHits,
-				   VMapIntCalHit const& calHitsCellIdLayer,
+				   LCCellGrid & calHitsCellIdProjection,
 				   VMapIntVInt & clusterIdToCellId,
 				   VMapIntLCCluster & clusterCM,
-				   VMapIntInt & cellIdToClusterId,
 				   MapIntInt & cellIdToSuperClusterId,
 				   MapIntVInt & superClusterIdToCellId,
 				   MapIntLCCluster & superClusterCM,
@@ -197,7 +230,8 @@ protected:
   void	energyCorrections (	MapIntVInt & superClusterIdToCellId,
 				MapIntVDouble & superClusterIdToCellEngy,
 				MapIntLCCluster & superClusterCM,
-				MapIntCalHit const& calHitsCellIdGlobal ) ;
+				MapIntCalHit const& calHitsCellIdGlobal,
+				const int detectorArm ) ;
 
 
   void	clusterMerger (	      MapIntVDouble & clusterIdToCellEngy,
@@ -219,18 +253,14 @@ protected:
   int	getNeighborId( int	cellId,
 		       int	neighborIndex );
 
-  double	posWeight( IMPL::CalorimeterHitImpl const* calHit ,
+  double	posWeight( LCCalHit const* calHit ,
 			   GlobalMethodsClass::WeightingMethod_t method );
 
-  double	posWeightTrueCluster( IMPL::CalorimeterHitImpl const* calHit,
-				      double			cellEngy,
-				      GlobalMethodsClass::WeightingMethod_t method );
-
-  double	posWeight( IMPL::CalorimeterHitImpl const* calHit,
+  double	posWeight( LCCalHit const* calHit,
 			   double		totEngy,
 			   GlobalMethodsClass::WeightingMethod_t method );
 
-  double	posWeight( IMPL::CalorimeterHitImpl const* calHit,
+  double	posWeight( LCCalHit const* calHit,
 			   double		totEngy,
 			   GlobalMethodsClass::WeightingMethod_t method,
 			   double		logWeightConstNow );
@@ -242,8 +272,10 @@ protected:
   double	thetaPhiCell( int	cellId,
 			      GlobalMethodsClass::Coordinate_t	output );
 
+  /// CalHits is MapIntCalHit or LCCellGrid
+  template <class CalHits>
   LCCluster calculateEngyPosCM( VInt const& cellIdV,
-				MapIntCalHit const& calHitsCellId,
+				CalHits const& calHitsCellId,
 				GlobalMethodsClass::WeightingMethod_t method );
 
   void	calculateEngyPosCM_EngyV( VInt const& cellIdV,
@@ -253,13 +285,13 @@ protected:
 				  int clusterId,
 				  GlobalMethodsClass::WeightingMethod_t method );
 
-  void	updateEngyPosCM( IMPL::CalorimeterHitImpl	* calHit,
+  void	updateEngyPosCM( LCCalHit	* calHit,
 			 LCCluster & clusterCM );
 
   int	checkClusterMergeCM( int clusterId1,
 			     int clusterId2,
 			     MapIntVInt const& clusterIdToCellId,
-			     MapIntCalHit const& calHitsCellId,
+			     LCCellGrid const& calHitsCellId,
 			     double				distanceAroundCM,
 			     double				percentOfEngyAroungCM,
 			     GlobalMethodsClass::WeightingMethod_t method );
@@ -278,6 +310,11 @@ protected:
 					  LCCluster const&	clusterCM,
 					  double  moliereFraction );
 
+  double	getEngyInMoliereFraction( LCCellGrid const& calHitsCellId,
+					  VInt const& clusterIdToCellId,
+					  LCCluster const&	clusterCM,
+					  double  moliereFraction );
+
   double	getEngyInMoliereFraction( MapIntCalHit	const& calHitsCellId,
 					  VInt const& clusterIdToCellId,
 					  LCCluster const& clusterCM,
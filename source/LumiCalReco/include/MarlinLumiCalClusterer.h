@@ -80,6 +80,10 @@ typedef std::map < int , std::vector<int> >  MapIntVInt;
     GlobalMethodsClass	gmc;
     LumiCalClustererClass	LumiCalClusterer;
     bool _cutOnFiducialVolume=false;
+    bool _timeStages=false;
+    std::string _stageTimesFileName="";
+    int _createCollectionsStage=0;
+    int _nThreads=1;
 
     void TryMarlinLumiCalClusterer(EVENT::LCEvent * evt);
 
@@ -1,15 +1,13 @@
 #ifndef ProjectionInfo_hh
 #define ProjectionInfo_hh 1
 
-namespace IMPL {
-  class CalorimeterHitImpl;
-}
+class LCCalHit;
 
 class ProjectionInfo {
 
 public:
   ProjectionInfo ();
-  ProjectionInfo ( IMPL::CalorimeterHitImpl const* calHit, int cellIdHitZ);
+  ProjectionInfo ( LCCalHit const* calHit, int cellIdHitZ);
 
   const double* getPosition() const { return position; }
 
@@ -1,7 +1,7 @@
 #ifndef SortingFunctions_hh
 #define SortingFunctions_hh 1
 
-#include <IMPL/CalorimeterHitImpl.h>
+#include "LCCalHit.hh"
 
 #include <vector>
 
@@ -30,12 +30,12 @@ inline bool clusterCMEnergyCmpAsc( std::vector<double> a, std::vector<double> b
    sorting of hits with respect to their energies
    -------------------------------------------------------------------------- */
 //in descending order (highest energy is first)
-inline bool HitEnergyCmpDesc( IMPL::CalorimeterHitImpl* a, IMPL::CalorimeterHitImpl* b ) {
+inline bool HitEnergyCmpDesc( LCCalHit* a, LCCalHit* b ) {
   return a->getEnergy() > b->getEnergy();
 }
 
 //in ascending order (lowest energy is first)
-inline bool HitEnergyCmpAsc( IMPL::CalorimeterHitImpl* a, IMPL::CalorimeterHitImpl* b ) {
+inline bool HitEnergyCmpAsc( LCCalHit* a, LCCalHit* b ) {
   return a->getEnergy() < b->getEnergy();
 }
 
@@ -29,6 +29,7 @@ using streamlog::MESSAGE;
 #include <cstdlib>
 #include <iostream>
 #include <iomanip>
+#include <stdexcept>
 
 // utility copied from marlin 
 template <class T>
@@ -37,8 +38,6 @@ bool convert(std::string input, T &value) {
  return ( ! (stream >> std::setbase(0) >> value).fail() ) && stream.eof();
 }
 
-GlobalMethodsClass::WeightingMethod_t GlobalMethodsClass::LogMethod = "LogMethod";
-GlobalMethodsClass::WeightingMethod_t GlobalMethodsClass::EnergyMethod = "EnergyMethod";
 double GlobalMethodsClass::EnergyCalibrationFactor = 0.0105;
 
 GlobalMethodsClass :: GlobalMethodsClass() :
@@ -316,6 +315,26 @@ std::string GlobalMethodsClass::GetParameterName ( Parameter_t par ){
 }
 
 
+GlobalMethodsClass::WeightingMethod_t GlobalMethodsClass::GetWeightingMethod( std::string const& methodName ) {
+
+  if( methodName == "LogMethod" ) return LogMethod;
+  if( methodName == "EnergyMethod" ) return EnergyMethod;
+
+  throw std::runtime_error( "Unknown WeightingMethod \"" + methodName + "\", use LogMethod or EnergyMethod" );
+}
+
+
+std::string GlobalMethodsClass::GetWeightingMethodName( WeightingMethod_t method ) {
+
+  switch (method) {
+  case LogMethod:                        return "LogMethod";
+  case EnergyMethod:                     return "EnergyMethod";
+  default: return "Unknown WeightingMethod";
+  }
+
+}
+
+
 void GlobalMethodsClass::PrintAllParameters() const {
   streamlog_out(MESSAGE) << "------------------------------------------------------------------" << std::endl;
   streamlog_out(MESSAGE) << "********* LumiCalReco Parameters set in GlobalMethodClass ********" << std::endl;
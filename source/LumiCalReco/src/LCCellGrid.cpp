@@ -0,0 +1,107 @@
+#include "LCCellGrid.hh"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+
+LCCellGrid::LCCellGrid():
+  m_cellRMax(0),
+  m_cellPhiMax(0),
+  m_size(0),
+  m_hits(),
+  m_clusterIds(),
+  m_connectedNeighbors(),
+  m_connectedToMe(),
+  m_cellIds(),
+  m_sorted(true)
+{}
+
+
+void LCCellGrid::setSize(int cellRMax, int cellPhiMax) {
+  m_cellRMax = cellRMax;
+  m_cellPhiMax = cellPhiMax;
+  const int numCells = cellRMax * cellPhiMax;
+  m_hits.assign(numCells, NULL);
+  m_clusterIds.assign(numCells, 0);
+  m_connectedNeighbors.assign(numCells, 0);
+  m_connectedToMe.clear();
+  m_cellIds.clear();
+  m_size = 0;
+  m_sorted = true;
+}
+
+
+void LCCellGrid::insert(int cellId, LCCalHit* calHit) {
+  if( not inside(cellId) ) {
+    std::stringstream error;
+    error << "LCCellGrid: cell R " << (cellId & 0x3FF) << " phi " << ((cellId >> 10) & 0x3FF) << " of cellId " << cellId
+	  << " is outside of the grid of " << m_cellRMax << " x " << m_cellPhiMax << " cells";
+    throw std::out_of_range(error.str());
+  }
+
+  LCCalHit*& cell = m_hits[index(cellId)];
+  if( cell == NULL ) {
+    m_cellIds.push_back(cellId);
+    m_sorted = false;
+    ++m_size;
+  }
+  cell = calHit;
+}
+
+
+void LCCellGrid::erase(int cellId) {
+  const int cellIndex = index(cellId);
+  if( m_hits[cellIndex] == NULL ) return;
+  m_hits[cellIndex] = NULL;
+  m_clusterIds[cellIndex] = 0;
+  m_sorted = false;
+  --m_size;
+}
+
+
+void LCCellGrid::clear() {
+  for (std::vector<int>::const_iterator it = m_cellIds.begin(); it != m_cellIds.end(); ++it) {
+    const int cellIndex = index(*it);
+    m_hits[cellIndex] = NULL;
+    m_clusterIds[cellIndex] = 0;
+  }
+  m_cellIds.clear();
+  m_size = 0;
+  m_sorted = true;
+}
+
+
+LCCalHit* LCCellGrid::at(int cellId) const {
+  LCCalHit* calHit = find(cellId);
+  if( calHit == NULL ) {
+    std::stringstream error;
+    error << "LCCellGrid: no hit in cellId " << cellId;
+    throw std::out_of_range(error.str());
+  }
+  return calHit;
+}
+
+
+std::vector<int>& LCCellGrid::connectedToMe(int cellId) {
+  if( m_connectedToMe.empty() ) {
+    m_connectedToMe.resize(m_hits.size());
+  }
+  return m_connectedToMe[index(cellId)];
+}
+
+
+std::vector<int> const& LCCellGrid::cellIds() const {
+  if( not m_sorted ) {
+    // erased cells are dropped here, cells erased and filled again are listed twice
+    std::sort(m_cellIds.begin(), m_cellIds.end());
+    m_cellIds.erase(std::unique(m_cellIds.begin(), m_cellIds.end()), m_cellIds.end());
+    std::vector<int>::iterator last = m_cellIds.begin();
+    for (std::vector<int>::const_iterator it = m_cellIds.begin(); it != m_cellIds.end(); ++it) {
+      if( m_hits[index(*it)] != NULL ) *last++ = *it;
+    }
+    m_cellIds.erase(last, m_cellIds.end());
+    m_sorted = true;
+  }
+  return m_cellIds;
+}
@@ -0,0 +1,37 @@
+#include "LCCellIdDecoder.hh"
+
+#include <UTIL/BitField64.h>
+
+
+LCCellIdDecoder::LCCellIdDecoder():
+  m_encoding(),
+  m_useDD4hep(false),
+  m_arm(),
+  m_cellR(),
+  m_cellPhi(),
+  m_layer()
+{}
+
+
+void LCCellIdDecoder::setEncoding(std::string const& encoding, bool useDD4hep) {
+  if( encoding == m_encoding and useDD4hep == m_useDD4hep and not m_encoding.empty() ) return;
+
+  const UTIL::BitField64 bitField( encoding );
+  const char* names[4] = { "S-1", "I", "J", "K" };
+  if( useDD4hep ) {
+    names[0] = "barrel";
+    names[1] = "r";
+    names[2] = "phi";
+    names[3] = "layer";
+  }
+  Field* fields[4] = { &m_arm, &m_cellR, &m_cellPhi, &m_layer };
+  for (int i = 0; i < 4; ++i) {
+    fields[i]->offset   = bitField[ names[i] ].offset();
+    fields[i]->width    = bitField[ names[i] ].width();
+    fields[i]->mask     = bitField[ names[i] ].mask();
+    fields[i]->isSigned = bitField[ names[i] ].isSigned();
+  }
+
+  m_encoding = encoding;
+  m_useDD4hep = useDD4hep;
+}
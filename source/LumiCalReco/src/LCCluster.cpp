@@ -9,7 +9,7 @@ LCCluster::LCCluster():
   _position(),
   _energy(0.0),
   _weight(0.0),
-  _method("LogMethod"),
+  _method(GlobalMethodsClass::LogMethod),
   _theta(0.0),
   _phi(0.0)
 {
@@ -22,7 +22,7 @@ LCCluster::LCCluster( const VirtualCluster& vc ):
   _position(),
   _energy(0.0),
   _weight(0.0),
-  _method("LogMethod"),
+  _method(GlobalMethodsClass::LogMethod),
   _theta(0.0),
   _phi(0.0)
 {
@@ -53,14 +53,14 @@ void LCCluster::clear() {
   _position[1] = 0.0;
   _position[2] = 0.0;
   _weight = 0.0;
-  _method = "";
+  _method = GlobalMethodsClass::LogMethod;
   _theta = 0.0;
   _phi = 0.0;
 }
 
 std::ostream& operator<<(std::ostream & o, const LCCluster& rhs) {
   o << "  Energy "              << std::setw(10) << rhs._energy
-    << "  Method "              << std::setw(4)  << rhs._method
+    << "  Method "              << std::setw(4)  << GlobalMethodsClass::GetWeightingMethodName(rhs._method)
     << "  Weight "              << std::setw(10) << rhs._weight
     << "  pos(x,y,z) =  ( "
     << std::setw(10) << rhs._position[0] << " , "
@@ -7,9 +7,9 @@
    - SOME DESCRIPTION HERE ......
    ============================================================================ */
 #include "LumiCalClusterer.h"
+#include "TaskPool.hh"
 
-#include <IMPL/CalorimeterHitImpl.h>
-
+#include <TROOT.h>
 
 namespace EVENT{
   class LCEvent;
@@ -21,6 +21,8 @@ namespace EVENT{
 #include <cmath>
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <functional>
 
 
 
@@ -45,19 +47,48 @@ LumiCalClustererClass::LumiCalClustererClass(std::string const& lumiNameNow):
   _nNearNeighbor (6),
   _cellRMax(0), _cellPhiMax (0),
   _middleEnergyHitBoundFrac(0.01),
-  _methodCM("LogMethod"),
+  _methodCM(GlobalMethodsClass::LogMethod),
   _moliereRadius(),
   _thetaContainmentBounds(),
   _minSeparationDistance(), _minClusterEngyGeV(), _minClusterEngySignal(),
   _totEngyArm(),
   _numHitsInArm(),
-  _mydecoder(),
+  _cellIdDecoder(),
   _gmc(),
   _useDD4hep(false),
-  RotMat()
+  _stageTimers(),
+  _getCalHitsStage(_stageTimers.addStage("getCalHits")),
+  _buildClustersStage(_stageTimers.addStage("buildClusters")),
+  _clusterMergerStage(_stageTimers.addStage("clusterMerger")),
+  _fiducialVolumeCutsStage(_stageTimers.addStage("fiducialVolumeCuts")),
+  _energyCorrectionsStage(_stageTimers.addStage("energyCorrections")),
+  _hitsCounter(_stageTimers.addCounter("hits")),
+  _clustersCounter(_stageTimers.addCounter("clusters per arm")),
+  _cellGrids(),
+  _smallEngyCellGrids(),
+  _calHitsArena(),
+  _armRotation(),
+  _armTotEngy(),
+  _armNumHits(),
+  _taskPool(NULL)
 {
 }
 
+LumiCalClustererClass::~LumiCalClustererClass() {
+  delete _taskPool;
+}
+
+void LumiCalClustererClass::setNumberOfThreads( int nThreads ) {
+  delete _taskPool;
+  _taskPool = NULL;
+  // the two arms are clustered in different threads, and buildClusters and
+  // energyCorrections create their temporary histograms in them
+  if( nThreads > 1 ) {
+    ROOT::EnableThreadSafety();
+    _taskPool = new TaskPool(std::min(nThreads, 2));
+  }
+}
+
 
 
 /* ============================================================================
@@ -73,7 +104,7 @@ void LumiCalClustererClass::init( GlobalMethodsClass const& gmc ){
   _armsToCluster.push_back(-1);
   _armsToCluster.push_back(1);
      -------------------------------------------------------------------------- */
-  _methodCM				= gmc.GlobalParamS.at(GlobalMethodsClass::WeightingMethod); // GlobalMethodsClass::LogMethod
+  _methodCM				= GlobalMethodsClass::GetWeightingMethod( gmc.GlobalParamS.at(GlobalMethodsClass::WeightingMethod) ); // GlobalMethodsClass::LogMethod
   _clusterMinNumHits			= gmc.GlobalParamI.at(GlobalMethodsClass::ClusterMinNumHits); // = 15
   _hitMinEnergy				= gmc.GlobalParamD.at(GlobalMethodsClass::MinHitEnergy); // = 5e-6
   _zLayerThickness			= gmc.GlobalParamD.at(GlobalMethodsClass::ZLayerThickness); // = 4.5
@@ -81,10 +112,10 @@ void LumiCalClustererClass::init( GlobalMethodsClass const& gmc ){
   _elementsPercentInShowerPeakLayer	= gmc.GlobalParamD.at(GlobalMethodsClass::ElementsPercentInShowerPeakLayer); // = 0.03  //APS 0.04;
   _nNearNeighbor			= gmc.GlobalParamI.at(GlobalMethodsClass::NumOfNearNeighbor); // = 6; // number of near neighbors to consider
   _beamCrossingAngle                    = gmc.GlobalParamD.at(GlobalMethodsClass::BeamCrossingAngle)/2.;
-  RotMat[-1]["cos"]                     = cos( - _beamCrossingAngle );
-  RotMat[-1]["sin"]                     = sin( - _beamCrossingAngle );
-  RotMat[ 1]["cos"]                     = cos( _beamCrossingAngle );
-  RotMat[ 1]["sin"]                     = sin( _beamCrossingAngle );
+  _armRotation[0].cosAngle              = cos( - _beamCrossingAngle );
+  _armRotation[0].sinAngle              = sin( - _beamCrossingAngle );
+  _armRotation[1].cosAngle              = cos( _beamCrossingAngle );
+  _armRotation[1].sinAngle              = sin( _beamCrossingAngle );
 
   // the minimal energy to take into account in the initial clustering pass is
   // defined as _middleEnergyHitBoundFrac of the minimal energy that is taken into
@@ -120,6 +151,18 @@ void LumiCalClustererClass::init( GlobalMethodsClass const& gmc ){
 
   _useDD4hep = gmc.isUsingDD4hep();
 
+  // one grid per layer plus one for the projection layer built in engyInMoliereCorrections
+  for (int armIndex = 0; armIndex < 2; ++armIndex) {
+    _cellGrids[armIndex].assign(_maxLayerToAnalyse+1, LCCellGrid());
+    _smallEngyCellGrids[armIndex].assign(_maxLayerToAnalyse, LCCellGrid());
+    for (VCellGrid::iterator it = _cellGrids[armIndex].begin(); it != _cellGrids[armIndex].end(); ++it) {
+      it->setSize(_cellRMax, _cellPhiMax);
+    }
+    for (VCellGrid::iterator it = _smallEngyCellGrids[armIndex].begin(); it != _smallEngyCellGrids[armIndex].end(); ++it) {
+      it->setSize(_cellRMax, _cellPhiMax);
+    }
+  }
+
   /* --------------------------------------------------------------------------
      Print out Parameters
      -------------------------------------------------------------------------- */
@@ -134,7 +177,7 @@ void LumiCalClustererClass::init( GlobalMethodsClass const& gmc ){
 			 << " _rMax: "			            << _rMax				 << std::endl
 			 << " _rCellLength [mm]: "		    << _rCellLength			 << std::endl
 			 << " _phiCellLength [rad]:"		    << _phiCellLength			 << std::endl
-			 << " _methodCM: "			    << _methodCM			 << std::endl
+			 << " _methodCM: "			    << GlobalMethodsClass::GetWeightingMethodName(_methodCM) << std::endl
 			 << " _logWeightConst: "		    << _logWeightConst			 << std::endl
 			 << " _elementsPercentInShowerPeakLayer: "  << _elementsPercentInShowerPeakLayer << std::endl
 			 << " _moliereRadius: "		            << _moliereRadius			 << std::endl
@@ -178,10 +221,17 @@ int LumiCalClustererClass::processEvent( EVENT::LCEvent * evt ) {
 
   /* --------------------------------------------------------------------------
      Loop over all hits in the LCCollection and write the hits into std::vectors
-     of IMPL::CalorimeterHitImpl. Hits are split in two std::vectors, one for each arm
+     of LCCalHit. Hits are split in two std::vectors, one for each arm
      of LumiCal.
      -------------------------------------------------------------------------- */
+  StageTimers::Scope getCalHitsTimer(_stageTimers, _getCalHitsStage);
   if ( !getCalHits(evt , calHits) ) return NOK;
+  getCalHitsTimer.stop();
+  _stageTimers.count(_hitsCounter, _numHitsInArm[-1] + _numHitsInArm[1]);
+  _armTotEngy[0] = _totEngyArm[-1];
+  _armTotEngy[1] = _totEngyArm[1];
+  _armNumHits[0] = _numHitsInArm[-1];
+  _armNumHits[1] = _numHitsInArm[1];
 
 
   /* --------------------------------------------------------------------------
@@ -190,65 +240,32 @@ int LumiCalClustererClass::processEvent( EVENT::LCEvent * evt ) {
   const int numArmsToCluster = _armsToCluster.size();
     int armNow = _armsToCluster[armToClusterNow];
  */
+  // the map entries of both arms are created here, the arms only use their own entries
   for(int armNow = -1; armNow < 2; armNow += 2) {
-#if _GENERAL_CLUSTERER_DEBUG == 1
-    streamlog_out( DEBUG ) << std::endl
-	      << "ARM = " << armNow << " : " << std::endl << std::endl;
-#endif
-    /* --------------------------------------------------------------------------
-       Construct clusters for each arm
-       -------------------------------------------------------------------------- */
-#if _CLUSTER_BUILD_DEBUG == 1
-    streamlog_out(DEBUG2) << "\tRun LumiCalClustererClass::buildClusters()" << std::endl;
-    streamlog_out(DEBUG2) << "\tEnergy deposit: "<< _totEngyArm[-1] << "\t" << _totEngyArm[1] <<"\n"
-			  << "\tNumber of hits: "<< _numHitsInArm[-1] << "\t" << _numHitsInArm[1] << "\n\n";
-#endif
-
-    buildClusters( calHits[armNow],
-		   calHitsCellIdGlobal[armNow],
-		   _superClusterIdToCellId[armNow],
-		   _superClusterIdToCellEngy[armNow],
-		   superClusterCM[armNow],
-		   armNow);
-
-
-    /* --------------------------------------------------------------------------
-       Merge superClusters according the minDistance nad minEngy rules
-       -------------------------------------------------------------------------- */
-#if _GENERAL_CLUSTERER_DEBUG == 1
-    streamlog_out( DEBUG ) << "\tRun LumiCalClustererClass::clusterMerger()" << std::endl;
-#endif
-
-    clusterMerger(		_superClusterIdToCellEngy[armNow],
-				_superClusterIdToCellId[armNow],
-				superClusterCM[armNow],
-				calHitsCellIdGlobal[armNow] );
-
-
-    /* --------------------------------------------------------------------------
-       Perform fiducial volume cuts
-       -------------------------------------------------------------------------- */
-    fiducialVolumeCuts(		_superClusterIdToCellId[armNow],
-				_superClusterIdToCellEngy[armNow],
-				superClusterCM[armNow] );
-
-
-    /* --------------------------------------------------------------------------
-       Perform energy correction for inter-mixed superClusters
-       -------------------------------------------------------------------------- */
-#if _CLUSTER_MIXING_ENERGY_CORRECTIONS == 1
-    if(superClusterCM[armNow].size() == 2) {
-#if _GENERAL_CLUSTERER_DEBUG == 1
-      streamlog_out( DEBUG ) << "\tRun LumiCalClustererClass::energyCorrections()" << std::endl;
-#endif
-
-      energyCorrections( _superClusterIdToCellId[armNow],
-			 _superClusterIdToCellEngy[armNow],
-			 superClusterCM[armNow],
-			 calHitsCellIdGlobal[armNow] );
-     }
-#endif
+    calHits[armNow];
+    calHitsCellIdGlobal[armNow];
+    _superClusterIdToCellId[armNow];
+    _superClusterIdToCellEngy[armNow];
+    superClusterCM[armNow];
+  }
 
+  // cluster the arms, at the same time if there is a thread pool. Debug output of the
+  // two arms would be mixed, so the arms are clustered one after the other in that case
+  const std::function<void(int)> clusterArmTask = [&](int armIndex) {
+    const int armNow = ( armIndex == 0 ) ? -1 : 1;
+    clusterArm( calHits.at(armNow),
+		calHitsCellIdGlobal.at(armNow),
+		_superClusterIdToCellId.at(armNow),
+		_superClusterIdToCellEngy.at(armNow),
+		superClusterCM.at(armNow),
+		armNow );
+  };
+  if( _taskPool and not streamlog::out.write< streamlog::DEBUG9 >() ) {
+    _taskPool->parallelFor(2, clusterArmTask);
+  } else {
+    for(int armIndex = 0; armIndex < 2; ++armIndex) {
+      clusterArmTask(armIndex);
+    }
   }
 
 
@@ -288,15 +305,88 @@ int LumiCalClustererClass::processEvent( EVENT::LCEvent * evt ) {
 
 }
 
-void LumiCalClustererClass::cleanCalHits( MapIntMapIntVCalHit & calHits ) {
-  for (MapIntMapIntVCalHit::iterator it = calHits.begin(); it != calHits.end(); ++it) {
-    MapIntVCalHit& mapVecHits = it->second;
-    for (MapIntVCalHit::iterator it2 = mapVecHits.begin(); it2 != mapVecHits.end(); ++it2) {
-      VecCalHit& vecHits = it2->second;
-      for (VecCalHit::iterator it3 = vecHits.begin(); it3 != vecHits.end(); ++it3) {
-	delete (*it3);
-      }
-    }
+/* ============================================================================
+   clustering of one arm, called for both arms by processEvent
+   ========================================================================= */
+void LumiCalClustererClass::clusterArm( MapIntVCalHit const& calHits,
+					MapIntCalHit & calHitsCellIdGlobal,
+					MapIntVInt & superClusterIdToCellId,
+					MapIntVDouble & superClusterIdToCellEngy,
+					MapIntLCCluster & superClusterCM,
+					const int detectorArm ) {
+#if _GENERAL_CLUSTERER_DEBUG == 1
+  streamlog_out( DEBUG ) << std::endl
+			 << "ARM = " << detectorArm << " : " << std::endl << std::endl;
+#endif
+  /* --------------------------------------------------------------------------
+     Construct clusters for each arm
+     -------------------------------------------------------------------------- */
+#if _CLUSTER_BUILD_DEBUG == 1
+  streamlog_out(DEBUG2) << "\tRun LumiCalClustererClass::buildClusters()" << std::endl;
+  streamlog_out(DEBUG2) << "\tEnergy deposit: "<< _armTotEngy[0] << "\t" << _armTotEngy[1] <<"\n"
+			<< "\tNumber of hits: "<< _armNumHits[0] << "\t" << _armNumHits[1] << "\n\n";
+#endif
+
+  StageTimers::Scope buildClustersTimer(_stageTimers, _buildClustersStage);
+  buildClusters( calHits,
+		 calHitsCellIdGlobal,
+		 superClusterIdToCellId,
+		 superClusterIdToCellEngy,
+		 superClusterCM,
+		 detectorArm);
+  buildClustersTimer.stop();
+
+
+  /* --------------------------------------------------------------------------
+     Merge superClusters according the minDistance nad minEngy rules
+     -------------------------------------------------------------------------- */
+#if _GENERAL_CLUSTERER_DEBUG == 1
+  streamlog_out( DEBUG ) << "\tRun LumiCalClustererClass::clusterMerger()" << std::endl;
+#endif
+
+  StageTimers::Scope clusterMergerTimer(_stageTimers, _clusterMergerStage);
+  clusterMerger(	superClusterIdToCellEngy,
+			superClusterIdToCellId,
+			superClusterCM,
+			calHitsCellIdGlobal );
+  clusterMergerTimer.stop();
+
+
+  /* --------------------------------------------------------------------------
+     Perform fiducial volume cuts
+     -------------------------------------------------------------------------- */
+  StageTimers::Scope fiducialVolumeCutsTimer(_stageTimers, _fiducialVolumeCutsStage);
+  fiducialVolumeCuts(	superClusterIdToCellId,
+			superClusterIdToCellEngy,
+			superClusterCM );
+  fiducialVolumeCutsTimer.stop();
+
+
+  /* --------------------------------------------------------------------------
+     Perform energy correction for inter-mixed superClusters
+     -------------------------------------------------------------------------- */
+#if _CLUSTER_MIXING_ENERGY_CORRECTIONS == 1
+  if(superClusterCM.size() == 2) {
+#if _GENERAL_CLUSTERER_DEBUG == 1
+    streamlog_out( DEBUG ) << "\tRun LumiCalClustererClass::energyCorrections()" << std::endl;
+#endif
+
+    StageTimers::Scope timer(_stageTimers, _energyCorrectionsStage);
+    energyCorrections( superClusterIdToCellId,
+		       superClusterIdToCellEngy,
+		       superClusterCM,
+		       calHitsCellIdGlobal,
+		       detectorArm );
   }
+#endif
+
+  _stageTimers.count(_clustersCounter, superClusterCM.size());
+}
+
+void LumiCalClustererClass::cleanCalHits( MapIntMapIntVCalHit & calHits ) {
   calHits.clear();
+  // the hits are owned by the arenas, clearing them keeps their capacity for the next event
+  for (MapIntVCalHitArena::iterator it = _calHitsArena.begin(); it != _calHitsArena.end(); ++it) {
+    it->second.clear();
+  }
 }
@@ -4,8 +4,6 @@
 #include "Distance2D.hh"
 using LCHelper::distance2D;
 
-//LCIO
-#include <IMPL/CalorimeterHitImpl.h>
 // stdlib
 #include <algorithm>
 #include <cassert>
@@ -20,91 +18,95 @@ using LCHelper::distance2D;
 
 
 
-/* --------------------------------------------------------------------------
-   calculate weight for cluster CM according to different methods
-   -------------------------------------------------------------------------- */
-double LumiCalClustererClass::posWeight( IMPL::CalorimeterHitImpl const* calHit , GlobalMethodsClass::WeightingMethod_t method) {
+namespace {
 
-  double posWeightHit = -1.;
+  /* --------------------------------------------------------------------------
+     weight of a hit for the cluster CM, with the weighting method resolved at
+     compile time. The log weight takes the energy fraction engyHit / totEngy,
+     so that the weights do not change with the rounding of a precomputed log
+     -------------------------------------------------------------------------- */
+  template <GlobalMethodsClass::WeightingMethod_t Method>
+  inline double methodWeight( double engyHit, double totEngy, double logWeightConst ) {
+    if( Method == GlobalMethodsClass::EnergyMethod ) return engyHit;
+
+    // ???????? DECIDE/FIX - improve the log weight constants ????????
+    const double posWeightHit = log(engyHit / totEngy) + logWeightConst;
+    return ( posWeightHit < 0 ) ? 0. : posWeightHit;
+  }
 
-  if( method == GlobalMethodsClass::EnergyMethod ) {
- 
-      return ( calHit->getEnergy() ) ;
+  /* --------------------------------------------------------------------------
+     energy and weighted CM of the hits in cellIdV for one weighting method,
+     using cellEngyV instead of the hit energies if it is given. armTotEngy is
+     the total energy of the arm -1 at index 0 and of the arm +1 at index 1.
+     Returns false, with the position left at zero, if the sum of weights is
+     not positive
+     -------------------------------------------------------------------------- */
+  template <GlobalMethodsClass::WeightingMethod_t Method, class CalHits>
+  bool engyPosCM( std::vector<int> const& cellIdV, double const* cellEngyV, CalHits const& calHitsCellId,
+		  double const* armTotEngy, double logWeightConst, LCCluster & clusterCM ) {
+
+    double totEngy(0.0), xHit(0.0), yHit(0.0), zHit(0.0), thetaHit(0.0), weightSum(0.0);
+    const size_t numHits = cellIdV.size();
+    for (size_t k = 0; k < numHits; ++k) {
+      const LCCalHit* calHit = calHitsCellId.at(cellIdV[k]);
+      const float* position = calHit->getPosition();
+      const double engyHit = cellEngyV ? cellEngyV[k] : calHit->getEnergy();
+      const double weightHit = methodWeight<Method>( engyHit, armTotEngy[ ( position[2] < 0 ) ? 0 : 1 ], logWeightConst );
+      weightSum += weightHit;
 
-  }else if (method == GlobalMethodsClass::LogMethod)  {            // ???????? DECIDE/FIX - improve the log weight constants ????????
+      xHit      += position[0] * weightHit;
+      yHit      += position[1] * weightHit;
+      zHit      += position[2] * weightHit;
+      totEngy   += engyHit;
+    }
 
-    int	detectorArm = ((calHit->getPosition()[2] < 0) ? -1 : 1 );
-    posWeightHit = log(calHit->getEnergy() / _totEngyArm[detectorArm]) + _logWeightConst;
-    if(posWeightHit < 0) posWeightHit = 0. ;
-    return posWeightHit;
+    const bool positiveWeights = ( weightSum > 0. );
+    if( positiveWeights ) {
+      xHit     /= weightSum;   yHit   /= weightSum; zHit /= weightSum;
+      thetaHit  = atan( sqrt( xHit*xHit + yHit*yHit)/fabs( zHit ));
+    } else {
+      xHit = yHit = zHit = 0.;
+    }
 
+    clusterCM = LCCluster(totEngy, xHit, yHit, zHit, weightSum, Method, thetaHit, 0.0);
+    return positiveWeights;
   }
-  return posWeightHit;
+
 }
 
 /* --------------------------------------------------------------------------
    calculate weight for cluster CM according to different methods
    -------------------------------------------------------------------------- */
-double LumiCalClustererClass::posWeightTrueCluster(IMPL::CalorimeterHitImpl const* calHit , double cellEngy, GlobalMethodsClass::WeightingMethod_t method) {
-
-  double	posWeightHit = 0.;
-  int	detectorArm = ((calHit->getPosition()[2] < 0) ? -1 : 1 );
-
-  if(method == GlobalMethodsClass::EnergyMethod) posWeightHit = cellEngy;
-
-
-  // ???????? DECIDE/FIX - improve the log weight constants ????????
-  if(method == GlobalMethodsClass::LogMethod) {
-    posWeightHit = log(cellEngy / _totEngyArm[detectorArm]) + _logWeightConst;
+double LumiCalClustererClass::posWeight( LCCalHit const* calHit , GlobalMethodsClass::WeightingMethod_t method) {
 
-    if(posWeightHit < 0) posWeightHit = 0. ;
+  const double totEngy = _armTotEngy[ ( calHit->getPosition()[2] < 0 ) ? 0 : 1 ];
+  if( method == GlobalMethodsClass::LogMethod ) {
+    return methodWeight<GlobalMethodsClass::LogMethod>( calHit->getEnergy(), totEngy, _logWeightConst );
   }
-
-  return posWeightHit;
+  return methodWeight<GlobalMethodsClass::EnergyMethod>( calHit->getEnergy(), totEngy, _logWeightConst );
 }
 
 /* --------------------------------------------------------------------------
    calculate weight for cluster CM according to different methods
    - overloaded version with a given energy normalization
    -------------------------------------------------------------------------- */
-double LumiCalClustererClass::posWeight(IMPL::CalorimeterHitImpl const* calHit, double totEngy,
+double LumiCalClustererClass::posWeight(LCCalHit const* calHit, double totEngy,
 					GlobalMethodsClass::WeightingMethod_t method) {
 
-  double	posWeightHit = 0.;
-
-  if(method == GlobalMethodsClass::EnergyMethod) posWeightHit = calHit->getEnergy();
-
-
-  // ???????? DECIDE/FIX - improve the log weight constants ????????
-  if(method == GlobalMethodsClass::LogMethod) {
-    posWeightHit = log(calHit->getEnergy() / totEngy) + _logWeightConst;
-
-    if(posWeightHit < 0) posWeightHit = 0. ;
-  }
-
-  return posWeightHit;
+  return posWeight( calHit, totEngy, method, _logWeightConst );
 }
 
 /* --------------------------------------------------------------------------
    calculate weight for cluster CM according to different methods
    - overloaded version with a given energy normalization and a logWeightConst
    -------------------------------------------------------------------------- */
-double LumiCalClustererClass::posWeight(IMPL::CalorimeterHitImpl const* calHit, double totEngy,
+double LumiCalClustererClass::posWeight(LCCalHit const* calHit, double totEngy,
 					GlobalMethodsClass::WeightingMethod_t method, double logWeightConstNow) {
 
-  double	posWeightHit = 0.;
-
-  if(method == GlobalMethodsClass::EnergyMethod ) posWeightHit = calHit->getEnergy();
-
-
-  // ???????? DECIDE/FIX - improve the log weight constants ????????
-  if(method == GlobalMethodsClass::LogMethod ) {
-    posWeightHit = log(calHit->getEnergy() / totEngy) + logWeightConstNow;
-
-    if(posWeightHit < 0) posWeightHit = 0. ;
+  if( method == GlobalMethodsClass::LogMethod ) {
+    return methodWeight<GlobalMethodsClass::LogMethod>( calHit->getEnergy(), totEngy, logWeightConstNow );
   }
-
-  return posWeightHit;
+  return methodWeight<GlobalMethodsClass::EnergyMethod>( calHit->getEnergy(), totEngy, logWeightConstNow );
 }
 
 /* --------------------------------------------------------------------------
@@ -160,42 +162,26 @@ int LumiCalClustererClass::getNeighborId(int cellId, int neighborIndex) {
    compute center of mass of each cluster
    (3). calculate the map clusterCM from scratch
    -------------------------------------------------------------------------- */
+template <class CalHits>
 LCCluster LumiCalClustererClass::calculateEngyPosCM( VInt const& cellIdV,
-                                                     MapIntCalHit const& calHitsCellId,
+                                                     CalHits const& calHitsCellId,
                                                      GlobalMethodsClass::WeightingMethod_t method) {
 
-  double totEngy(0.0), xHit(0.0), yHit(0.0), zHit(0.0), thetaHit(0.0), weightSum(0.0);
-  int loopFlag = 1;
-  while(loopFlag == 1) {
-    for (VInt::const_iterator it = cellIdV.begin(); it != cellIdV.end(); ++it) {
-      const IMPL::CalorimeterHitImpl* calHit = calHitsCellId.at(*it);
-      const double weightHit = posWeight(calHit,method);
-      weightSum += weightHit;
-
-      const float* position = calHit->getPosition();
-
-      xHit      += position[0] * weightHit;
-      yHit      += position[1] * weightHit;
-      zHit      += position[2] * weightHit;
-      totEngy   += calHit->getEnergy();
-
-    }
-    if(weightSum > 0.) {
-      xHit     /= weightSum;   yHit   /= weightSum; zHit /= weightSum;
-      thetaHit  = atan( sqrt( xHit*xHit + yHit*yHit)/fabs( zHit ));
-      loopFlag = 0;
-
-    } else {
-      // initialize counters and recalculate with the Energy-weights method
-      method = GlobalMethodsClass::EnergyMethod;
-      totEngy = xHit = yHit = zHit = thetaHit = weightSum = 0.;
-    }
+  LCCluster clusterCM;
+  if( method == GlobalMethodsClass::LogMethod
+      and engyPosCM<GlobalMethodsClass::LogMethod>( cellIdV, NULL, calHitsCellId, _armTotEngy, _logWeightConst, clusterCM ) ) {
+    return clusterCM;
   }
-
-  return LCCluster(totEngy, xHit, yHit, zHit, weightSum, method, thetaHit, 0.0);
+  // recalculate with the Energy-weights method if none of the log weights is positive
+  engyPosCM<GlobalMethodsClass::EnergyMethod>( cellIdV, NULL, calHitsCellId, _armTotEngy, _logWeightConst, clusterCM );
+  return clusterCM;
 
 }
 
+// the hits of a layer are in an LCCellGrid, those of the whole arm in a map
+template LCCluster LumiCalClustererClass::calculateEngyPosCM( VInt const&, MapIntCalHit const&, GlobalMethodsClass::WeightingMethod_t );
+template LCCluster LumiCalClustererClass::calculateEngyPosCM( VInt const&, LCCellGrid const&, GlobalMethodsClass::WeightingMethod_t );
+
 
 /* --------------------------------------------------------------------------
    compute center of mass of each cluster
@@ -207,36 +193,13 @@ void LumiCalClustererClass::calculateEngyPosCM_EngyV( VInt const& cellIdV,
                                                       MapIntLCCluster & clusterCM, int clusterId,
                                                       GlobalMethodsClass::WeightingMethod_t method) {
 
-  double totEngy(0.0), xHit(0.0), yHit(0.0), zHit(0.0), thetaHit(0.0), weightSum(0.0);
-  int loopFlag = 1;
-  while(loopFlag == 1) {
-    for (VInt::const_iterator it = cellIdV.begin(); it != cellIdV.end(); ++it) {
-      const int k = it - cellIdV.begin();
-      const IMPL::CalorimeterHitImpl * calHit = calHitsCellId.at(*it);
-      const double weightHit = posWeightTrueCluster(calHit,cellEngyV[k],method);
-      weightSum += weightHit;
-      const float* position = calHit->getPosition();
-
-      xHit      += position[0] * weightHit;
-      yHit      += position[1] * weightHit;
-      zHit      += position[2] * weightHit;
-      totEngy   += cellEngyV[k];
-    }
-    if(weightSum > 0) {
-      xHit     /= weightSum;   yHit   /= weightSum; zHit /= weightSum;
-      thetaHit  = atan( sqrt( xHit*xHit + yHit*yHit)/fabs( zHit ));
-      //      thetaHit /= weightSum;
-      loopFlag = 0;
-
-    } else {
-      // initialize counters and recalculate with the Energy-weights method
-      method = GlobalMethodsClass::EnergyMethod;
-      totEngy = xHit = yHit = zHit = thetaHit = weightSum = 0.;
-    }
+  LCCluster & thisClusterCM = clusterCM[clusterId];
+  if( method == GlobalMethodsClass::LogMethod
+      and engyPosCM<GlobalMethodsClass::LogMethod>( cellIdV, cellEngyV.data(), calHitsCellId, _armTotEngy, _logWeightConst, thisClusterCM ) ) {
+    return;
   }
-
-  clusterCM[clusterId] = LCCluster(totEngy, xHit, yHit, zHit,
-				   weightSum, method, thetaHit, 0.0);
+  // recalculate with the Energy-weights method if none of the log weights is positive
+  engyPosCM<GlobalMethodsClass::EnergyMethod>( cellIdV, cellEngyV.data(), calHitsCellId, _armTotEngy, _logWeightConst, thisClusterCM );
 
 }
 
@@ -244,7 +207,7 @@ void LumiCalClustererClass::calculateEngyPosCM_EngyV( VInt const& cellIdV,
    compute center of mass of each cluster
    (2). update the map clusterCM with the new cal hit
    -------------------------------------------------------------------------- */
-void LumiCalClustererClass::updateEngyPosCM(IMPL::CalorimeterHitImpl* calHit, LCCluster & clusterCM) {
+void LumiCalClustererClass::updateEngyPosCM(LCCalHit* calHit, LCCluster & clusterCM) {
 
   double	engyHit = (double)calHit->getEnergy();
   GlobalMethodsClass::WeightingMethod_t method =  clusterCM.getMethod();
@@ -281,7 +244,7 @@ void LumiCalClustererClass::updateEngyPosCM(IMPL::CalorimeterHitImpl* calHit, LC
    -------------------------------------------------------------------------- */
 int LumiCalClustererClass::checkClusterMergeCM(  int clusterId1, int clusterId2,
 						 MapIntVInt const& clusterIdToCellId,
-						 MapIntCalHit const& calHitsCellId,
+						 LCCellGrid const& calHitsCellId,
 						 double distanceAroundCM, double percentOfEngyAroungCM,
 						 GlobalMethodsClass::WeightingMethod_t method ){
 
@@ -310,7 +273,7 @@ int LumiCalClustererClass::checkClusterMergeCM(  int clusterId1, int clusterId2,
   for( VInt::iterator cellIt = cellIdV.begin();
        cellIt != cellIdV.end();
        ++cellIt ) {
-    const IMPL::CalorimeterHitImpl *hit = calHitsCellId.at(*cellIt);
+    const LCCalHit *hit = calHitsCellId.at(*cellIt);
     const double distanceCM = distance2D(CM1,hit->getPosition());
     if(distanceCM < distanceAroundCM) {
       double engyHit = hit->getEnergy();
@@ -339,7 +302,29 @@ double LumiCalClustererClass::getEngyInMoliereFraction(	MapIntCalHit  const& cal
   for(MapIntCalHit::const_iterator calHitsCellIdIterator = calHitsCellId.begin();
       calHitsCellIdIterator != calHitsCellId.end();
       ++calHitsCellIdIterator) {
-    const IMPL::CalorimeterHitImpl * calHit = calHitsCellIdIterator->second;
+    const LCCalHit * calHit = calHitsCellIdIterator->second;
+    const double distanceCM = distance2D(clusterCM.getPosition(),calHit->getPosition());
+    if(distanceCM < distanceToScan)
+      engyAroundCM += calHit->getEnergy();
+  }
+
+  return engyAroundCM;
+
+}
+
+
+// overloaded for the hits of a single layer
+double LumiCalClustererClass::getEngyInMoliereFraction(	LCCellGrid const& calHitsCellId,
+							VInt const&, //clusterIdToCellId,
+							LCCluster const& clusterCM,
+							double moliereFraction   ){
+
+  const double distanceToScan = _moliereRadius * moliereFraction;
+  double engyAroundCM = 0.0;
+
+  std::vector<int> const& cellIds = calHitsCellId.cellIds();
+  for(VInt::const_iterator cellIt = cellIds.begin(); cellIt != cellIds.end(); ++cellIt) {
+    const LCCalHit * calHit = calHitsCellId.find(*cellIt);
     const double distanceCM = distance2D(clusterCM.getPosition(),calHit->getPosition());
     if(distanceCM < distanceToScan)
       engyAroundCM += calHit->getEnergy();
@@ -363,7 +348,7 @@ double LumiCalClustererClass::getEngyInMoliereFraction( MapIntCalHit  const& cal
   for(MapIntCalHit::const_iterator calHitsCellIdIterator = calHitsCellId.begin();
       calHitsCellIdIterator != calHitsCellId.end();
       ++calHitsCellIdIterator) {
-    const IMPL::CalorimeterHitImpl * calHit = calHitsCellIdIterator->second;
+    const LCCalHit * calHit = calHitsCellIdIterator->second;
     const double distanceCM = distance2D(clusterCM.getPosition(),calHit->getPosition());
 
     const int cellIdHit = calHitsCellIdIterator->first;
@@ -395,7 +380,7 @@ void LumiCalClustererClass::getThetaPhiZCluster( MapIntCalHit  const& calHitsCel
     for( VInt::const_iterator cellIt = clusterIdToCellId.begin();
 	 cellIt != clusterIdToCellId.end();
 	 ++cellIt ) {
-      const IMPL::CalorimeterHitImpl* hit = calHitsCellId.at(*cellIt);
+      const LCCalHit* hit = calHitsCellId.at(*cellIt);
       //(BP) posWeight returns always weight >= 0.
       const double weightHit = posWeight(hit, totEngy, method, (_logWeightConst + logWeightConstFactor) );
       if(weightHit > 0){
@@ -476,7 +461,7 @@ double LumiCalClustererClass::getMoliereRadius( MapIntCalHit const& calHitsCellI
        ++cellIt ){
     const int cellIdHit = *cellIt;
     const int hitNow = cellIt - clusterIdToCellId.begin();
-    const IMPL::CalorimeterHitImpl * thisHit = calHitsCellId.at(cellIdHit);
+    const LCCalHit * thisHit = calHitsCellId.at(cellIdHit);
     double CM2[2] = {thisHit->getPosition()[0], thisHit->getPosition()[1]};
 
 #if _IMPROVE_PROFILE_LAYER_POS == 1
@@ -485,7 +470,7 @@ double LumiCalClustererClass::getMoliereRadius( MapIntCalHit const& calHitsCellI
     // projection hits have an incoded layer number of (_maxLayerToAnalyse + 1)
     // the original hit's layer number is stored in (the previously unused) CellID1
     if(layerHit == (_maxLayerToAnalyse + 1))
-      layerHit = thisHit->getCellID1();
+      layerHit = thisHit->cellIdHitZ;
 
     if(layerHit != layerMiddle) {
       double	tngPhiHit = CM2[1] / CM2[0];
@@ -544,7 +529,7 @@ double LumiCalClustererClass::getDistanceAroundCMWithEnergyPercent( LCCluster co
        ++cellIt) {
 
     const int clusterId = cellIt - clusterIdToCellId.begin();
-    IMPL::CalorimeterHitImpl *thisHit = calHitsCellId.at(*cellIt);
+    LCCalHit *thisHit = calHitsCellId.at(*cellIt);
 
     clusterHitsEngyPos[clusterId][0] = thisHit->getEnergy();
     clusterHitsEngyPos[clusterId][1] = distance2D(clusterCM.getPosition(),thisHit->getPosition());
@@ -9,15 +9,19 @@ using LCHelper::distance2D;
 #include <TF1.h>
 #include <TH1F.h>
 #include <TString.h>
-// LCIO
-#include <IMPL/CalorimeterHitImpl.h>
 // stdlib
 #include <algorithm>
 #include <iomanip>
 #include <map>
+#include <mutex>
+#include <sstream>
 #include <stdexcept>
 #include <vector>
 
+namespace {
+  // TH1F::Fit goes through the global minimizer of ROOT, which is not reentrant
+  std::mutex lineFitMutex;
+}
 
 
 /* =========================================================================
@@ -28,7 +32,7 @@ using LCHelper::distance2D;
    - SOME DESCRIPTION ......
    ============================================================================ */
 
-int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::CalorimeterHitImpl*> > const& calHits,
+int LumiCalClustererClass::buildClusters( std::map < int , std::vector <LCCalHit*> > const& calHits,
 					  MapIntCalHit & calHitsCellIdGlobal,
 					  MapIntVInt & superClusterIdToCellId,
 					  MapIntVDouble & superClusterIdToCellEngy,
@@ -39,9 +43,12 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
   double maxEngyLayer;
   int numSuperClusters;
 
-  std::vector < std::map <int , IMPL::CalorimeterHitImpl* > > calHitsCellId(_maxLayerToAnalyse), calHitsSmallEngyCellId(_maxLayerToAnalyse);
-
-  std::vector < std::map < int , int > >        cellIdToClusterId(_maxLayerToAnalyse+1);
+  // the hits of each layer, the cluster Id of each hit is stored in the same grid
+  const int armIndex = ( detectorArm < 0 ) ? 0 : 1;
+  VCellGrid & calHitsCellId = _cellGrids[armIndex];
+  VCellGrid & calHitsSmallEngyCellId = _smallEngyCellGrids[armIndex];
+  for (VCellGrid::iterator it = calHitsCellId.begin(); it != calHitsCellId.end(); ++it) it->clear();
+  for (VCellGrid::iterator it = calHitsSmallEngyCellId.begin(); it != calHitsSmallEngyCellId.end(); ++it) it->clear();
 
   std::vector < std::map < int , std::vector<int> > >   clusterIdToCellId(_maxLayerToAnalyse+1);
 
@@ -78,7 +85,7 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
   if(detectorArm < 0) detectorArmName = "negative detector arm";
   streamlog_out(DEBUG3) << "************************ buildClusters Arm "<< detectorArm <<" *****************************************\n";
   streamlog_out(DEBUG3) << "\tTotal " << detectorArmName << " energy =  "
-                        << _totEngyArm[detectorArm] << std::endl << std::endl;
+                        << _armTotEngy[armIndex] << std::endl << std::endl;
 #endif
 
 
@@ -88,8 +95,8 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
         flag the layers that make the cut. 
      -------------------------------------------------------------------------- */
 
-  const double middleEnergyHitBound = exp(-1*_logWeightConst) * _totEngyArm[detectorArm] * _middleEnergyHitBoundFrac;
-  const int minNumElementsInShowerPeakLayer = int( _numHitsInArm[detectorArm] * _elementsPercentInShowerPeakLayer);
+  const double middleEnergyHitBound = exp(-1*_logWeightConst) * _armTotEngy[armIndex] * _middleEnergyHitBoundFrac;
+  const int minNumElementsInShowerPeakLayer = int( _armNumHits[armIndex] * _elementsPercentInShowerPeakLayer);
 
 #if _CLUSTER_BUILD_DEBUG == 1
   for (MapIntVCalHit::const_iterator calHitsIt = calHits.begin(); calHitsIt!=calHits.end(); ++calHitsIt) {
@@ -117,7 +124,7 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
       streamlog_out(DEBUG3) <<"\t"<< layerNow <<"\t nhits("<< numHitsInLayer <<")\n";
 #endif
     for(size_t j=0; j<numHitsInLayer; j++){
-      int       cellIdHit = (int)calHitsIt->second[j]->getCellID0();
+      int       cellIdHit = (int)calHitsIt->second[j]->getCellId();
       double    cellEngy = (double)calHitsIt->second[j]->getEnergy();
       if( cellEngy >= _hitMinEnergy ){
 #if _CLUSTER_MIDDLE_RANGE_ENGY_HITS == 1
@@ -126,16 +133,16 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
 	 */
 	if( isShowerPeakLayer[layerNow]) {
 	  if(cellEngy <= middleEnergyHitBound ){
-	    calHitsSmallEngyCellId[layerNow][cellIdHit] = calHitsIt->second[j];
+	    calHitsSmallEngyCellId[layerNow].insert(cellIdHit, calHitsIt->second[j]);
 	  }else{
-	    calHitsCellId[layerNow][cellIdHit] = calHitsIt->second[j];
+	    calHitsCellId[layerNow].insert(cellIdHit, calHitsIt->second[j]);
 	  }
 	}else{
-	  calHitsCellId[layerNow][cellIdHit] = calHitsIt->second[j];
+	  calHitsCellId[layerNow].insert(cellIdHit, calHitsIt->second[j]);
 	}
 #else
 	// all hits assigned to one set
-	calHitsCellId[layerNow][cellIdHit] = calHitsIt->second[j];
+	calHitsCellId[layerNow].insert(cellIdHit, calHitsIt->second[j]);
 #endif
       }
     }
@@ -151,7 +158,7 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
   for (MapIntVCalHit::const_iterator calHitsIt = calHits.begin(); calHitsIt!=calHits.end(); ++calHitsIt) {
     //  for(int layerNow = 0; layerNow < _maxLayerToAnalyse; layerNow++) {
     for(size_t j=0; j<calHitsIt->second.size(); j++){
-      int       cellIdHit = (int)calHitsIt->second[j]->getCellID0();
+      int       cellIdHit = (int)calHitsIt->second[j]->getCellId();
       double    cellEngy = (double)calHitsIt->second[j]->getEnergy();
       const int layerNow = calHitsIt->first;
       if(cellEngy < _hitMinEnergy) continue;
@@ -189,11 +196,10 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
       // 
 #if _CLUSTER_BUILD_DEBUG == 1
       streamlog_out(DEBUG3) << "\t layer " << layerNow <<std::endl;
-      int numCells = calHitsCellId[layerNow].size();
-      std::map <int , IMPL::CalorimeterHitImpl* >::iterator calHitsCellIdIterator = calHitsCellId[layerNow].begin();
-      for(int cellNow = 0; cellNow < numCells; cellNow++, calHitsCellIdIterator++){
-	int cellId = calHitsCellIdIterator->first;
-	const IMPL::CalorimeterHitImpl* calHit = calHitsCellIdIterator->second;
+      std::vector<int> const& cellIds = calHitsCellId[layerNow].cellIds();
+      for(size_t cellNow = 0; cellNow < cellIds.size(); cellNow++){
+	int cellId = cellIds[cellNow];
+	const LCCalHit* calHit = calHitsCellId[layerNow].at(cellId);
 	const float* pos = calHit->getPosition();
 	streamlog_out(DEBUG3) << "\t\t CellId, pos(x,y,z), signal energy [MeV]: "
 			      << cellId << "\t ("
@@ -206,8 +212,7 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
       }
       streamlog_out(DEBUG3) <<std::endl;
 #endif
-      initialClusterBuild( calHitsCellId[layerNow],          // <--
-			   cellIdToClusterId[layerNow],      // -->
+      initialClusterBuild( calHitsCellId[layerNow],          // <->
 			   clusterIdToCellId[layerNow],      // -->
 			   clusterCM[layerNow],              // -->
 			   initialClusterControlVar );       // <--
@@ -216,7 +221,6 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
       // cluster the low energy hits
       initialLowEngyClusterBuild( calHitsSmallEngyCellId[layerNow],
 				  calHitsCellId[layerNow],
-				  cellIdToClusterId[layerNow],
 				  clusterIdToCellId[layerNow],
 				  clusterCM[layerNow]) ;
 #endif
@@ -388,7 +392,10 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
   streamlog_out(DEBUG3) <<  "Fit Param should be this size: " <<  engyPosCMLayer.size()  << std::endl;
 #endif
 
-  TF1 fitFunc("fitFunc",[](double* x, double* p){ return p[0] + p[1]*x[0]; },-3000,-2000, 2);
+  // the names are per arm, as the arms may be clustered at the same time
+  const std::string armName = ( detectorArm < 0 ) ? "_ArmM" : "_ArmP";
+  const std::string fitFuncName = "fitFunc" + armName;
+  TF1 fitFunc(fitFuncName.c_str(),[](double* x, double* p){ return p[0] + p[1]*x[0]; },-3000,-2000, 2);
 
   //  for(size_t clusterNow=0; clusterNow < engyPosCMLayer.size(); clusterNow++, engyPosCMLayerIterator++) {
   for(engyPosCMLayerIterator = engyPosCMLayer.begin(); engyPosCMLayerIterator != engyPosCMLayer.end(); engyPosCMLayerIterator++) {
@@ -412,10 +419,10 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
     std::string hisName = "_xLineFitCM_Cluster";
     std::stringstream clusterNum;
     clusterNum << clusterNow;
-    hisName += clusterNum.str();
+    hisName += clusterNum.str() + armName;
     xLineFitCM[clusterNow] = TH1F(  hisName.c_str(),hisName.c_str(),_maxLayerToAnalyse*10,0,_maxLayerToAnalyse);
 
-    hisName = "_yLineFitCM_Cluster"; hisName += clusterNum.str();
+    hisName = "_yLineFitCM_Cluster"; hisName += clusterNum.str() + armName;
     yLineFitCM[clusterNow] = TH1F(  hisName.c_str(),hisName.c_str(),_maxLayerToAnalyse*10,0,_maxLayerToAnalyse);
 
 
@@ -468,8 +475,10 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
 #endif
     }
 
-    // fit a straight line for each histogram, and store the fit results
-    xLineFitCM[clusterNow].Fit("fitFunc","+CQ0");
+    // fit a straight line for each histogram, and store the fit results; the arms
+    // may be clustered at the same time, so only one of them fits at a time
+    std::unique_lock<std::mutex> fitLock(lineFitMutex);
+    xLineFitCM[clusterNow].Fit(&fitFunc,"+CQ0");
     fitParamX.push_back(std::vector<double>(2,0.0));
     fitParamX.back()[0] = fitFunc.GetParameter(0);
     fitParamX.back()[1] = fitFunc.GetParameter(1);
@@ -480,7 +489,7 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
                           << " \t,\t " << fitFunc.GetParameter(1) << " (+-) " << fitFunc.GetParError(1) <<std::endl;
 #endif
 
-    yLineFitCM[clusterNow] . Fit("fitFunc","+CQ0");
+    yLineFitCM[clusterNow] . Fit(&fitFunc,"+CQ0");
     fitParamY.push_back(std::vector<double>(2,0.0));
     fitParamY.back()[0] = fitFunc.GetParameter(0);
     fitParamY.back()[1] = fitFunc.GetParameter(1);
@@ -490,6 +499,7 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
                           << fitFunc.GetParameter(0) << " (+-) " << fitFunc.GetParError(0)
                           << " \t,\t " << fitFunc.GetParameter(1) << " (+-) " << fitFunc.GetParError(1) <<std::endl <<std::endl;
 #endif
+    fitLock.unlock();
 
     // cleanUp
     layerToPosX.clear();  layerToPosY.clear();  layerToEngy.clear();
@@ -544,7 +554,6 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
     if(isShowerPeakLayer[layerNow] == 0) {
       try {
       virtualCMClusterBuild( calHitsCellId[layerNow],
-			     cellIdToClusterId[layerNow],
 			     clusterIdToCellId[layerNow],
 			     clusterCM[layerNow],
 			     virtualClusterCM[layerNow] );
@@ -570,7 +579,6 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
 #endif
 
 	virtualCMPeakLayersFix( calHitsCellId[layerNow],
-				cellIdToClusterId[layerNow],
 				clusterIdToCellId[layerNow],
 				clusterCM[layerNow],
 				virtualClusterCM[layerNow] );
@@ -621,10 +629,9 @@ int LumiCalClustererClass::buildClusters( std::map < int , std::vector <IMPL::Ca
 
   int engyInMoliereFlag = engyInMoliereCorrections( calHitsCellIdGlobal,
 						    calHits,
-						    calHitsCellId,
+						    calHitsCellId[_maxLayerToAnalyse],
 						    (clusterIdToCellId),
 						    (clusterCM),
-						    (cellIdToClusterId),
 						    (cellIdToSuperClusterId),
 						    (superClusterIdToCellId),
 						    superClusterCM,
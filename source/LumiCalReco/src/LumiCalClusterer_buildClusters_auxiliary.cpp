@@ -7,8 +7,6 @@
 #include "Distance2D.hh"
 using LCHelper::distance2D;
 
-//LCIO
-#include <IMPL/CalorimeterHitImpl.h>
 // Stdlib
 #include <map>
 #include <vector>
@@ -27,8 +25,7 @@ using LCHelper::distance2D;
    - SOME DESCRIPTION ......
    ============================================================================ */
 
-int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::CalorimeterHitImpl* > const& calHitsCellId,
-						std::map < int , int > & cellIdToClusterId,
+int LumiCalClustererClass::initialClusterBuild(	LCCellGrid & calHitsCellId,
 						std::map < int , std::vector<int> > & clusterIdToCellId,
 						std::map < int , LCCluster > & clusterCM,
 						std::vector < int > const& controlVar  ) {
@@ -82,8 +79,7 @@ int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::Calorimet
   /* --------------------------------------------------------------------------
      maps for................
      -------------------------------------------------------------------------- */
-  // map param: (1). cellId of cal hit , (2). Id of cluster the cal hit belongs to
-  // std::map < int , int >		cellIdToClusterId;
+  // the Id of the cluster each cal hit belongs to is stored in calHitsCellId.clusterId(cellId)
 
   // map param: (1). Id of cluster the cal hit belongs to , (2). std::vector of cellIds of cal hit
   // std::map < int , std::vector<int> >		clusterIdToCellId;
@@ -97,26 +93,22 @@ int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::Calorimet
   int	clusterId = 0 ;
 
   /* --------------------------------------------------------------------------
-     maps for storing for each cal hit the highest-energy near neighbor, and for
-     each cal hit to keep track of the other cal hits for which it is the highest
-     energy nearest neighbor.
+     for each cal hit the grid stores the highest-energy near neighbor
+     (connectedNeighbor), and keeps track of the other cal hits for which it is
+     the highest energy nearest neighbor (connectedToMe).
      -------------------------------------------------------------------------- */
-  // map param: (1). cellId of cal hit , (2). cellId of highest energy near neighbor
-  std::map <int , int >	isConnectedToNeighbor ;
-  // map param: (1). cellId of cal hit , (2). cellIds of neighbors which are connected to the cal hit
-  std::map <int , std::vector <int> >	neighborsConectedToMe ;
-
   // copy hits in this layer to a cal hit std::vector
-  std::vector <IMPL::CalorimeterHitImpl*>	calHitsLayer ;
+  std::vector <LCCalHit*>	calHitsLayer ;
+  std::vector <int> const& cellIdsLayer = calHitsCellId.cellIds();
+  calHitsLayer.reserve( cellIdsLayer.size() );
 
-  std::map <int , IMPL::CalorimeterHitImpl* > :: const_iterator calHitsCellIdIterator= calHitsCellId.begin(),
-    calHitsEnd = calHitsCellId.end();
-  for(; calHitsCellIdIterator != calHitsEnd; ++calHitsCellIdIterator){
-    const int cellIdHit = (int)(*calHitsCellIdIterator).first;
-    calHitsLayer.push_back( calHitsCellIdIterator->second );
+  for(std::vector <int>::const_iterator cellIt = cellIdsLayer.begin(); cellIt != cellIdsLayer.end(); ++cellIt){
+    const int cellIdHit = *cellIt;
+    calHitsLayer.push_back( calHitsCellId.find(cellIdHit) );
     // initialization
-    isConnectedToNeighbor[cellIdHit] = 0;
-    cellIdToClusterId[cellIdHit] = 0;
+    calHitsCellId.connectedNeighbor(cellIdHit) = 0;
+    calHitsCellId.connectedToMe(cellIdHit).clear();
+    calHitsCellId.clusterId(cellIdHit) = 0;
   }
 
   // sort acording to energy in ascending order (lowest energy is first)
@@ -127,11 +119,11 @@ int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::Calorimet
      -------------------------------------------------------------------------- */
   for(int j=0; j<(int)calHitsLayer.size(); j++) {
 
-    int cellIdHit  = (int)calHitsLayer[j]->getCellID0();
+    int cellIdHit  = (int)calHitsLayer[j]->getCellId();
     const double engyCalHit   = calHitsLayer[j]->getEnergy();
 
     // go on to next cal hit if this hit has already been registered
-    if(isConnectedToNeighbor[cellIdHit] != 0) continue;
+    if(calHitsCellId.connectedNeighbor(cellIdHit) != 0) continue;
 
     double maxEngyNeighbor = 0.;
 
@@ -140,36 +132,29 @@ int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::Calorimet
       // find cellId of neighbor
       const int cellIdNeighbor = getNeighborId(cellIdHit, neighborIndex);
       if(cellIdNeighbor == 0) continue;
-      try {
-	// if the neighbor has a cal hit...
-	std::map <int , IMPL::CalorimeterHitImpl* > :: const_iterator neighborIt =
-	  calHitsCellId.find(cellIdNeighbor);
-	if( neighborIt != calHitsCellId.end() ) {
-	  IMPL::CalorimeterHitImpl* neighbor = neighborIt->second;
-
-	  //if(tmpFlag==1) cout << "neighbor " << cellIdNeighbor
-	  //	<< " " << neighborIndex <<endl;
-	  double engyNeighbor = neighbor->getEnergy();
-
-	  //if(tmpFlag==1) cout << "\tmax/me/neighbor \t"<<maxEngyNeighbor <<"\t"
-	  //	<< engyCalHit<< "\t"<<engyNeighbor <<endl;
-	  if((maxEngyNeighbor < engyNeighbor) && (engyNeighbor >= engyCalHit)) {
-	    // register the neighbor at the cal hit
-	    isConnectedToNeighbor[cellIdHit] = cellIdNeighbor;
-	    // update highest-energy counter
-	    maxEngyNeighbor = engyNeighbor;
-	  }
-	}//if
-      } catch (std::out_of_range & e) {
-	streamlog_out( ERROR ) << "Out of range " << cellIdNeighbor
-			       << " in calHitsCellId:" <<  std::endl;
-      }
+      // if the neighbor has a cal hit...
+      const LCCalHit* neighbor = calHitsCellId.find(cellIdNeighbor);
+      if( neighbor ) {
+
+	//if(tmpFlag==1) cout << "neighbor " << cellIdNeighbor
+	//	<< " " << neighborIndex <<endl;
+	double engyNeighbor = neighbor->getEnergy();
+
+	//if(tmpFlag==1) cout << "\tmax/me/neighbor \t"<<maxEngyNeighbor <<"\t"
+	//	<< engyCalHit<< "\t"<<engyNeighbor <<endl;
+	if((maxEngyNeighbor < engyNeighbor) && (engyNeighbor >= engyCalHit)) {
+	  // register the neighbor at the cal hit
+	  calHitsCellId.connectedNeighbor(cellIdHit) = cellIdNeighbor;
+	  // update highest-energy counter
+	  maxEngyNeighbor = engyNeighbor;
+	}
+      }//if
 
     }//For all neighbor
 
     if(maxEngyNeighbor > 0) {
       // check if the neighbor has already been registered
-      const int cellIdNeighbor = isConnectedToNeighbor[cellIdHit];
+      const int cellIdNeighbor = calHitsCellId.connectedNeighbor(cellIdHit);
       // modify the conditional control variable
 
       //APS: Does this make sense: When the possible
@@ -178,9 +163,9 @@ int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::Calorimet
       // if(isConnectedToNeighbor[cellIdNeighbor] != 0) neighborFound = true;
 
       // register the cal hit at the neighbor
-      neighborsConectedToMe[cellIdNeighbor].push_back(cellIdHit);
+      calHitsCellId.connectedToMe(cellIdNeighbor).push_back(cellIdHit);
       // in the next iteration work with the cal hit's highest-energy near neighbor
-      cellIdHit = isConnectedToNeighbor[cellIdHit];
+      cellIdHit = calHitsCellId.connectedNeighbor(cellIdHit);
     }
 
   }//for all hits in layer
@@ -196,25 +181,26 @@ int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::Calorimet
 
     std::vector <int> neighborFoundId ;
 
-    int cellIdHit  = (int)calHitsLayer[j]->getCellID0();
+    int cellIdHit  = (int)calHitsLayer[j]->getCellId();
 
     // if the cal hit has already been registered in a cluster continue to the next one
-    if(cellIdToClusterId[cellIdHit] > 0) continue;
+    if(calHitsCellId.clusterId(cellIdHit) > 0) continue;
 
     // add the hit to a new cluster
     clusterId++;
-    cellIdToClusterId[cellIdHit] = clusterId;
+    calHitsCellId.clusterId(cellIdHit) = clusterId;
     clusterIdToCellId[clusterId].push_back(cellIdHit);
 
     bool neighborFound = true ;
     while(neighborFound == true) {
       // get the Ids of the connected neighbor
-      const int nNeighborsConectedToMe = (int)neighborsConectedToMe[cellIdHit].size();
+      std::vector <int> & neighborsConectedToMe = calHitsCellId.connectedToMe(cellIdHit);
+      const int nNeighborsConectedToMe = (int)neighborsConectedToMe.size();
       for(int k=0; k<nNeighborsConectedToMe; k++) {
 
 	// register the neighbor in the cluster
-	const int cellIdNeighbor = neighborsConectedToMe[cellIdHit][k];
-	cellIdToClusterId[cellIdNeighbor] = clusterId ;
+	const int cellIdNeighbor = neighborsConectedToMe[k];
+	calHitsCellId.clusterId(cellIdNeighbor) = clusterId ;
 	clusterIdToCellId[clusterId].push_back(cellIdNeighbor);
 
 	// store the connected cal hit Id - it will be registered in a cluster next...
@@ -223,7 +209,7 @@ int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::Calorimet
 
       // in case of a loop in connections, make sure that if a cell has already been
       // considered, then it wont be reanalyzed again...
-      neighborsConectedToMe[cellIdHit].clear();
+      neighborsConectedToMe.clear();
 
       // every neighbor found is taken off from the neighborFoundId std::vector
       // once this std::vector is empty, end the while(neighborFound == 1) loop
@@ -236,21 +222,15 @@ int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::Calorimet
       }
     }
   }
-  // cleanUp
-  isConnectedToNeighbor.clear(); neighborsConectedToMe.clear();
-
   /* --------------------------------------------------------------------------
      merge clusters that have one hit only to the nearest cluster which is
      a near neighbor (choose the neighbor with the highest energy).
      -------------------------------------------------------------------------- */
   if(mergeOneHitClusters == 1) {
-    // go over all cellIds which have been registered in a cluster (first parameter of cellIdToClusterId).
-    std::map < int , int > :: iterator
-      cellIdToClusterIdIterator = cellIdToClusterId.begin(),
-      cEnd = cellIdToClusterId.end();
-    for(; cellIdToClusterIdIterator != cEnd; ++cellIdToClusterIdIterator) {
-      const int cellIdHit = (int)(*cellIdToClusterIdIterator).first; // cellId of cal hit
-      const int clusterIdHit = (int)(*cellIdToClusterIdIterator).second; // cluster Id of cal hit
+    // go over all cellIds which have been registered in a cluster
+    for(std::vector <int>::const_iterator cellIt = cellIdsLayer.begin(); cellIt != cellIdsLayer.end(); ++cellIt) {
+      const int cellIdHit = *cellIt; // cellId of cal hit
+      const int clusterIdHit = calHitsCellId.clusterId(cellIdHit); // cluster Id of cal hit
 
       if(clusterIdToCellId[clusterIdHit].size() == 1) {
 	int	maxEngyNeighborId = 0;
@@ -263,8 +243,9 @@ int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::Calorimet
 	  if(cellIdNeighbor == 0) continue;
 
 	  // if the neighbor has a cal hit...
-	  if( calHitsCellId.find(cellIdNeighbor) != calHitsCellId.end() ) {
-	    double engyNeighbor = calHitsCellId.at(cellIdNeighbor)->getEnergy();
+	  const LCCalHit* neighbor = calHitsCellId.find(cellIdNeighbor);
+	  if( neighbor ) {
+	    double engyNeighbor = neighbor->getEnergy();
 
 	    // find the neighbor with the highest energy
 	    if(maxEngyNeighbor < engyNeighbor) {
@@ -279,8 +260,8 @@ int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::Calorimet
 
 	if(maxEngyNeighbor > 0) {
 	  // connect to the neighbor with the highest energy
-	  int clusterIdNeighbor = cellIdToClusterId[maxEngyNeighborId];
-	  cellIdToClusterId[cellIdHit] = clusterIdNeighbor;
+	  int clusterIdNeighbor = calHitsCellId.clusterId(maxEngyNeighborId);
+	  calHitsCellId.clusterId(cellIdHit) = clusterIdNeighbor;
 	  clusterIdToCellId[clusterIdNeighbor].push_back(cellIdHit);
 
 	  // cleanUp the discarded cluster
@@ -379,7 +360,7 @@ int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::Calorimet
 	  // add hit from clusterIdToCellId with clusterId to one with maxWDClusterId
 	  const int cellIdHit = clusterIdToCellId[clusterId1][j];
 	  clusterIdToCellId[clusterId2].push_back(cellIdHit);
-	  cellIdToClusterId[cellIdHit] = clusterId2;
+	  calHitsCellId.clusterId(cellIdHit) = clusterId2;
 
 	  //  update the totalEnergy counter and CM position of the cluster
 	  updateEngyPosCM(calHitsCellId.at(cellIdHit), clusterCM[clusterId2]);
@@ -480,7 +461,7 @@ int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::Calorimet
 	  // add hit from clusterIdToCellId with clusterId to one with maxWDClusterId
 	  const int cellIdHit = clusterIdToCellId[clusterId1][j];
 	  clusterIdToCellId[clusterId2].push_back(cellIdHit);
-	  cellIdToClusterId[cellIdHit] = clusterId2;
+	  calHitsCellId.clusterId(cellIdHit) = clusterId2;
 
 	  //  update the totalEnergy counter and CM position of the cluster
 	  updateEngyPosCM(calHitsCellId.at(cellIdHit), clusterCM[clusterId2]);
@@ -562,7 +543,7 @@ int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::Calorimet
 	  // add hit from clusterIdToCellId with clusterId to one with maxWDClusterId
 	  const int cellIdHit = clusterIdToCellId[clusterId1][k];
 	  clusterIdToCellId[clusterId2].push_back(cellIdHit);
-	  cellIdToClusterId[cellIdHit] = clusterId2;
+	  calHitsCellId.clusterId(cellIdHit) = clusterId2;
 
 	  //  update the totalEnergy counter and CM position of the cluster
 	  updateEngyPosCM(calHitsCellId.at(cellIdHit), clusterCM[clusterId2]);
@@ -587,22 +568,21 @@ int LumiCalClustererClass::initialClusterBuild(	std::map < int , IMPL::Calorimet
    -     merge the unclustered cal hits with the existing clusters
    ============================================================================ */
 
-int LumiCalClustererClass::initialLowEngyClusterBuild( std::map < int , IMPL::CalorimeterHitImpl* > const& calHitsSmallEngyCellId,
-						       std::map < int , IMPL::CalorimeterHitImpl* >	& calHitsCellId,
-						       std::map < int , int >			& cellIdToClusterId,
+int LumiCalClustererClass::initialLowEngyClusterBuild( LCCellGrid const& calHitsSmallEngyCellId,
+						       LCCellGrid & calHitsCellId,
 						       std::map < int , std::vector<int> >		& clusterIdToCellId,
 						       std::map < int , LCCluster > & clusterCM ) {
 
   /* --------------------------------------------------------------------------
      merge the unclustered cal hits with the existing clusters
      -------------------------------------------------------------------------- */
-  std::map < int , IMPL::CalorimeterHitImpl* > :: const_iterator calHitsCellIdIterator = calHitsSmallEngyCellId.begin();
-  for(; calHitsCellIdIterator != calHitsSmallEngyCellId.end(); ++calHitsCellIdIterator){
-    const int cellIdHit = calHitsCellIdIterator->first;
+  std::vector <int> const& smallEngyCellIds = calHitsSmallEngyCellId.cellIds();
+  for(std::vector <int>::const_iterator cellIt = smallEngyCellIds.begin(); cellIt != smallEngyCellIds.end(); ++cellIt){
+    const int cellIdHit = *cellIt;
 
     // add the small energy hits that have now been clustred to the cal hit list at calHitsCellId
-    IMPL::CalorimeterHitImpl* thisHit = calHitsCellIdIterator->second;
-    calHitsCellId[cellIdHit] = thisHit;
+    LCCalHit* thisHit = calHitsSmallEngyCellId.find(cellIdHit);
+    calHitsCellId.insert(cellIdHit, thisHit);
     // position of the cal hit
     double CM1[2] = { thisHit -> getPosition()[0], thisHit -> getPosition()[1]};
 
@@ -629,9 +609,9 @@ int LumiCalClustererClass::initialLowEngyClusterBuild( std::map < int , IMPL::Ca
     if(closestCluster != weightedDistanceV.end()){
       // add the hit to the chosen cluster
       clusterIdToCellId[closestCluster->first].push_back(cellIdHit);
-      cellIdToClusterId[cellIdHit] = closestCluster->first;
+      calHitsCellId.clusterId(cellIdHit) = closestCluster->first;
       //  update the totalEnergy counter and CM position of the cluster
-      updateEngyPosCM(calHitsCellId[cellIdHit], clusterCM[closestCluster->first]);
+      updateEngyPosCM(thisHit, clusterCM[closestCluster->first]);
     }
 
 
@@ -651,8 +631,7 @@ int LumiCalClustererClass::initialLowEngyClusterBuild( std::map < int , IMPL::Ca
    --------------------------------
    - SOME DESCRIPTION ......
    ============================================================================ */
-int LumiCalClustererClass::virtualCMClusterBuild( std::map < int , IMPL::CalorimeterHitImpl* >	const& calHitsCellId,
-						  std::map < int , int >			& cellIdToClusterId,
+int LumiCalClustererClass::virtualCMClusterBuild( LCCellGrid & calHitsCellId,
 						  std::map < int , std::vector<int> >		& clusterIdToCellId,
 						  std::map < int , LCCluster >	& clusterCM,
 						  std::map < int , VirtualCluster >	const& virtualClusterCM ) {
@@ -666,10 +645,11 @@ int LumiCalClustererClass::virtualCMClusterBuild( std::map < int , IMPL::Calorim
   /* --------------------------------------------------------------------------
      form clusters by gathering hits inside the virtual cluster radius
      -------------------------------------------------------------------------- */
-  for( std::map < int , IMPL::CalorimeterHitImpl* > :: const_iterator calHitsCellIdIterator = calHitsCellId.begin();
-       calHitsCellIdIterator != calHitsCellId.end(); ++calHitsCellIdIterator) {
+  std::vector <int> const& cellIdsLayer = calHitsCellId.cellIds();
+  for( std::vector <int>::const_iterator cellIt = cellIdsLayer.begin(); cellIt != cellIdsLayer.end(); ++cellIt) {
 
-    const IMPL::CalorimeterHitImpl *thisHit = calHitsCellIdIterator->second;
+    const int cellIdHit = *cellIt;
+    const LCCalHit *thisHit = calHitsCellId.find(cellIdHit);
     double CM1[2] = { thisHit->getPosition()[0], thisHit->getPosition()[1] };
 
     // compute the distance of the cal hit from the virtual cluster CMs, and keep score of
@@ -701,8 +681,8 @@ int LumiCalClustererClass::virtualCMClusterBuild( std::map < int , IMPL::Calorim
     // create clusters from the hits which made the cut, and keep score of those which didnt
     if( closestCluster != weightedDistanceV.end() ){
       // add the hit to the chosen cluster
-      clusterIdToCellId[closestCluster->first].push_back(calHitsCellIdIterator->first);
-      cellIdToClusterId[calHitsCellIdIterator->first] = closestCluster->first;
+      clusterIdToCellId[closestCluster->first].push_back(cellIdHit);
+      calHitsCellId.clusterId(cellIdHit) = closestCluster->first;
 
 #if _VIRTUALCLUSTER_BUILD_DEBUG == 1
       std::cout	<< "\tnum possible -  " << weightedDistanceV.size()
@@ -710,7 +690,7 @@ int LumiCalClustererClass::virtualCMClusterBuild( std::map < int , IMPL::Calorim
 #endif
 
     } else	{
-      unClusteredCellId.push_back( calHitsCellIdIterator->first );
+      unClusteredCellId.push_back( cellIdHit );
 
 #if _VIRTUALCLUSTER_BUILD_DEBUG == 1
       cout	<<  "\tno cluster is within range ..." << coutDefault << endl << endl;
@@ -756,7 +736,7 @@ int LumiCalClustererClass::virtualCMClusterBuild( std::map < int , IMPL::Calorim
     std::map < int , double > weightedDistanceV;
 
     // position of the cal hit
-    const IMPL::CalorimeterHitImpl *thisHit = calHitsCellId.at(cellIdHit);
+    LCCalHit *thisHit = calHitsCellId.at(cellIdHit);
     double CM1[2] = { thisHit->getPosition()[0], thisHit->getPosition()[1] };
 
     // compute weight for the cal hit and each cluster
@@ -776,9 +756,9 @@ int LumiCalClustererClass::virtualCMClusterBuild( std::map < int , IMPL::Calorim
     if( closestCluster != weightedDistanceV.end() ){
       // add the hit to the chosen cluster
       clusterIdToCellId[closestCluster->first].push_back(cellIdHit);
-      cellIdToClusterId[cellIdHit] = closestCluster->first;
+      calHitsCellId.clusterId(cellIdHit) = closestCluster->first;
       //  update the totalEnergy counter and CM position of the cluster
-      updateEngyPosCM(calHitsCellId.at(cellIdHit), clusterCM[closestCluster->first]);
+      updateEngyPosCM(thisHit, clusterCM[closestCluster->first]);
     }
   }//for all unclustered hits
 
@@ -795,8 +775,7 @@ int LumiCalClustererClass::virtualCMClusterBuild( std::map < int , IMPL::Calorim
    --------------------------------
    - SOME DESCRIPTION ......
    ============================================================================ */
-int LumiCalClustererClass::virtualCMPeakLayersFix( std::map < int , IMPL::CalorimeterHitImpl* > const& calHitsCellId,
-						   std::map < int , int > & cellIdToClusterId,
+int LumiCalClustererClass::virtualCMPeakLayersFix( LCCellGrid & calHitsCellId,
 						   std::map < int , std::vector<int> > & clusterIdToCellId,
 						   std::map < int , LCCluster > & clusterCM,
 						   std::map < int , VirtualCluster > virtualClusterCM ) {
@@ -890,14 +869,13 @@ int LumiCalClustererClass::virtualCMPeakLayersFix( std::map < int , IMPL::Calori
      go over all of the hits, and change the cluster id of the hits inside
      the empty virtual clusters to that of the virtual cluster
      -------------------------------------------------------------------------- */
-  
-  for(  MapIntCalHit::const_iterator calHitsCellIdIterator = calHitsCellId.begin();
-      calHitsCellIdIterator != calHitsCellId.end(); ++calHitsCellIdIterator) {
+  std::vector <int> const& cellIdsLayer = calHitsCellId.cellIds();
+  for( std::vector <int>::const_iterator cellIt = cellIdsLayer.begin(); cellIt != cellIdsLayer.end(); ++cellIt) {
 
     std::map < int , double > weightedDistanceV;
 
     // compute the distance of the cal hit from the virtual cluster CMs
-    const IMPL::CalorimeterHitImpl *thisHit = calHitsCellIdIterator->second;
+    const LCCalHit *thisHit = calHitsCellId.find(*cellIt);
 
     for(std::map < int , VirtualCluster > :: const_iterator virtualClusterCMIterator = virtualClusterCM.begin();
 	virtualClusterCMIterator != virtualClusterCM.end(); ++virtualClusterCMIterator ) {
@@ -923,8 +901,8 @@ int LumiCalClustererClass::virtualCMPeakLayersFix( std::map < int , IMPL::Calori
 #endif
 
     // add the hit to the chosen cluster
-    clusterIdToCellId[closestCluster->first].push_back(calHitsCellIdIterator->first);
-    cellIdToClusterId[calHitsCellIdIterator->first] = closestCluster->first;
+    clusterIdToCellId[closestCluster->first].push_back(*cellIt);
+    calHitsCellId.clusterId(*cellIt) = closestCluster->first;
   }
 
 
@@ -937,10 +915,9 @@ int LumiCalClustererClass::virtualCMPeakLayersFix( std::map < int , IMPL::Calori
     clusterIdToCellIdIterator->second.clear();
   }
 
-  for( MapIntCalHit::const_iterator calHitsCellIdIterator = calHitsCellId.begin();
-       calHitsCellIdIterator != calHitsCellId.end(); ++calHitsCellIdIterator){
-    const int cellIdHit = calHitsCellIdIterator->first;
-    const int clusterId = cellIdToClusterId[cellIdHit];
+  for( std::vector <int>::const_iterator cellIt = cellIdsLayer.begin(); cellIt != cellIdsLayer.end(); ++cellIt){
+    const int cellIdHit = *cellIt;
+    const int clusterId = calHitsCellId.clusterId(cellIdHit);
     clusterIdToCellId[clusterId].push_back(cellIdHit);
   }
 
@@ -973,8 +950,8 @@ int LumiCalClustererClass::virtualCMPeakLayersFix( std::map < int , IMPL::Calori
    - SOME DESCRIPTION ......
    ============================================================================ */
 
-int LumiCalClustererClass::buildSuperClusters ( std::map <int , IMPL::CalorimeterHitImpl* > & calHitsCellIdGlobal,
-						std::vector < std::map < int , IMPL::CalorimeterHitImpl* > > const& calHitsCellIdLayer,
+int LumiCalClustererClass::buildSuperClusters ( std::map <int , LCCalHit* > & calHitsCellIdGlobal,
+						std::vector < LCCellGrid > const& calHitsCellIdLayer,
 						std::vector < std::map < int , std::vector<int> > > const& clusterIdToCellId,
 						std::vector < std::map < int , LCCluster > > const& clusterCM,
 						std::vector < std::map < int , VirtualCluster > > const& virtualClusterCM,
@@ -1084,7 +1061,7 @@ int LumiCalClustererClass::buildSuperClusters ( std::map <int , IMPL::Calorimete
 	std::map < int , double > weightedDistanceV;
 
 	// position of the cal hit
-	IMPL::CalorimeterHitImpl* thisHit = calHitsCellIdLayer.at(layerNow).at(cellIdHit);
+	LCCalHit* thisHit = calHitsCellIdLayer.at(layerNow).at(cellIdHit);
 	double CM1[2] = { thisHit->getPosition()[0], thisHit->getPosition()[1] };
 
 #if _VIRTUALCLUSTER_BUILD_DEBUG == 1
@@ -1122,10 +1099,10 @@ int LumiCalClustererClass::buildSuperClusters ( std::map <int , IMPL::Calorimete
     }
 
     // write all the layer cal hits from calHitsCellIdLayer to the global calHitsCellId map
-    MapIntCalHit const& layerHits = calHitsCellIdLayer.at(layerNow);
-    for( MapIntCalHit::const_iterator calHitsCellIdIterator = layerHits.begin();
-	 calHitsCellIdIterator != layerHits.end(); ++calHitsCellIdIterator){
-      calHitsCellIdGlobal[calHitsCellIdIterator->first] = calHitsCellIdIterator->second;
+    LCCellGrid const& layerHits = calHitsCellIdLayer.at(layerNow);
+    std::vector <int> const& cellIdsLayer = layerHits.cellIds();
+    for( std::vector <int>::const_iterator cellIt = cellIdsLayer.begin(); cellIt != cellIdsLayer.end(); ++cellIt){
+      calHitsCellIdGlobal[*cellIt] = layerHits.find(*cellIt);
     }
   }
 
@@ -1174,11 +1151,10 @@ int LumiCalClustererClass::buildSuperClusters ( std::map <int , IMPL::Calorimete
    - SOME DESCRIPTION ......
    ============================================================================ */
 int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHitsCellIdGlobal,
-                                                      std::map < int,std::vector <IMPL::CalorimeterHitImpl*> > const& calHits,
-                                                      std::vector < MapIntCalHit > const& ,//   calHitsCellIdLayer,
+                                                      std::map < int,std::vector <LCCalHit*> > const& calHits,
+                                                      LCCellGrid & calHitsCellIdProjection,
                                                       std::vector < MapIntVInt > & clusterIdToCellId,
                                                       std::vector < MapIntLCCluster > & clusterCM,
-                                                      std::vector < std::map < int , int > > & cellIdToClusterId,
                                                       std::map < int , int > & cellIdToSuperClusterId,
                                                       MapIntVInt & superClusterIdToCellId,
                                                       MapIntLCCluster & superClusterCM,
@@ -1194,7 +1170,9 @@ int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHit
   double baseEngyPercentInMol = 0.9;
 
   // general variables
-  MapIntCalHit calHitsCellIdProjection, calHitsCellIdProjectionFull;
+  MapIntCalHit calHitsCellIdProjectionFull;
+  // storage of the projection hits, reserved up front so that the pointers in the grid and the map stay valid
+  std::vector < LCCalHit > projectionHits, projectionHitsFull;
 
   int rejectFlag;
   double superClusterMolRatio = 0., superClusterMolRatio_Tmp = 0., projectionClusterMolRatio = 0.;
@@ -1289,14 +1267,14 @@ int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHit
     /* --------------------------------------------------------------------------
        sum up the energy for each Phi/R cell for all Z layers
        -------------------------------------------------------------------------- */
-    std::map < int , std::vector <IMPL::CalorimeterHitImpl*> >::const_iterator calHitsIt = calHits.begin(),
+    std::map < int , std::vector <LCCalHit*> >::const_iterator calHitsIt = calHits.begin(),
       calHitsEnd = calHits.end();
     for (; calHitsIt != calHitsEnd; ++calHitsIt) {
-      std::pair < int , std::vector < IMPL::CalorimeterHitImpl*> > const& layerHits = (*calHitsIt);
+      std::pair < int , std::vector < LCCalHit*> > const& layerHits = (*calHitsIt);
       const int numElementsInLayer = (int)layerHits.second.size();
       for(int j=0; j<numElementsInLayer; j++){
-	IMPL::CalorimeterHitImpl const* thisCalHit = layerHits.second.at(j);
-	const int cellIdHit = (int)thisCalHit->getCellID0();
+	LCCalHit const* thisCalHit = layerHits.second.at(j);
+	const int cellIdHit = (int)thisCalHit->getCellId();
 
 	double cellEngy = (double)thisCalHit->getEnergy();
 	///APS: This encoding needs to be fixed, now using
@@ -1333,6 +1311,7 @@ int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHit
     /* --------------------------------------------------------------------------
        input the results into new cal hit objects
        -------------------------------------------------------------------------- */
+    projectionHits.reserve(calHitsProjection.size());
     for( MapIntProjectionInfo::const_iterator calHitsProjectionIterator = calHitsProjection.begin();
 	 calHitsProjectionIterator != calHitsProjection.end(); ++calHitsProjectionIterator ){
       const int cellIdProjection = calHitsProjectionIterator->first;
@@ -1342,13 +1321,9 @@ int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHit
 				 (float)projection.getPosition()[1], 
 				 (float)projection.getPosition()[2]};
       const int cellIdHitZ = projection.cellIdHitZ;
-      IMPL::CalorimeterHitImpl *calHitNew = new IMPL::CalorimeterHitImpl();
-      calHitNew -> setCellID0(cellIdProjection);
-      calHitNew -> setCellID1(cellIdHitZ);
-      calHitNew -> setEnergy(engyCellProjection);
-      calHitNew -> setPosition(hitPosV);
+      projectionHits.push_back( LCCalHit( cellIdProjection, engyCellProjection, hitPosV, cellIdHitZ ) );
 
-      calHitsCellIdProjection[cellIdProjection] = calHitNew;
+      calHitsCellIdProjection.insert(cellIdProjection, &projectionHits.back());
     }
 
     /* --------------------------------------------------------------------------
@@ -1361,7 +1336,6 @@ int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHit
     initialClusterControlVar[3] = 1;  // forceMergeSmallToLargeClusters
 
     initialClusterBuild( calHitsCellIdProjection,
-			 cellIdToClusterId[_maxLayerToAnalyse],
 			 clusterIdToCellId[_maxLayerToAnalyse],
 			 clusterCM[_maxLayerToAnalyse],
 			 initialClusterControlVar   );
@@ -1419,10 +1393,10 @@ int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHit
 
       // remove hits that are of low energy
       std::vector <int> idsToErase;
-      for( MapIntCalHit::const_iterator calHitsCellIdIterator = calHitsCellIdProjection.begin(); 
-	   calHitsCellIdIterator != calHitsCellIdProjection.end(); ++calHitsCellIdIterator ){
-	int cellIdProjection = calHitsCellIdIterator->first;
-	double engyHit = (double)calHitsCellIdIterator->second->getEnergy();
+      std::vector <int> const& cellIdsProjection = calHitsCellIdProjection.cellIds();
+      for( std::vector <int>::const_iterator cellIt = cellIdsProjection.begin(); cellIt != cellIdsProjection.end(); ++cellIt ){
+	int cellIdProjection = *cellIt;
+	double engyHit = (double)calHitsCellIdProjection.find(cellIdProjection)->getEnergy();
 	if(engyHit < middleEnergyHitBound * engyHitBoundMultiply)
 	  idsToErase.push_back(cellIdProjection);
       }
@@ -1439,9 +1413,7 @@ int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHit
       for(int hitNow = 0; hitNow < numIdsToErase; hitNow++){
 	int idsToEraseNow = idsToErase[hitNow];
 
-	// cleanUp dynamicly allocated memory
-	delete calHitsCellIdProjection[idsToEraseNow];
-	// erase entry from map
+	// erase entry from the grid
 	calHitsCellIdProjection.erase(idsToEraseNow);
       }
 
@@ -1449,8 +1421,7 @@ int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHit
       /* --------------------------------------------------------------------------
 	 build clusters out of the projection hits
 	 -------------------------------------------------------------------------- */
-      // clean up the clustering results from the previous run
-      cellIdToClusterId[_maxLayerToAnalyse].clear();
+      // clean up the clustering results from the previous run, the cluster Ids in the grid are reset by initialClusterBuild
       clusterIdToCellId[_maxLayerToAnalyse].clear();
       clusterCM[_maxLayerToAnalyse].clear();
 
@@ -1461,7 +1432,6 @@ int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHit
       initialClusterControlVar[3] = 1;  // forceMergeSmallToLargeClusters
 
       initialClusterBuild( calHitsCellIdProjection,
-                           cellIdToClusterId[_maxLayerToAnalyse],
                            clusterIdToCellId[_maxLayerToAnalyse],
                            clusterCM[_maxLayerToAnalyse],
                            initialClusterControlVar );
@@ -1493,6 +1463,7 @@ int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHit
        energy cal hits, these need to be re-registered so as to calculate the
        total energy around the CM within _moliereRadius.
        -------------------------------------------------------------------------- */
+    projectionHitsFull.reserve(calHitsProjectionFull.size());
     for( MapIntProjectionInfo:: const_iterator calHitsProjectionIterator = calHitsProjectionFull.begin();
 	  calHitsProjectionIterator != calHitsProjectionFull.end(); ++calHitsProjectionIterator ){
       const int cellIdProjection = calHitsProjectionIterator->first;
@@ -1502,13 +1473,9 @@ int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHit
 				 (float)projection.getPosition()[2]};
       const int cellIdHitZ = projection.cellIdHitZ;
 
-      IMPL::CalorimeterHitImpl *calHitNew = new IMPL::CalorimeterHitImpl();
-      calHitNew -> setCellID0(cellIdProjection);
-      calHitNew -> setCellID1(cellIdHitZ);
-      calHitNew -> setEnergy(projection.energy);
-      calHitNew -> setPosition(hitPosV);
+      projectionHitsFull.push_back( LCCalHit( cellIdProjection, projection.energy, hitPosV, cellIdHitZ ) );
 
-      calHitsCellIdProjectionFull[cellIdProjection] = calHitNew;
+      calHitsCellIdProjectionFull[cellIdProjection] = &projectionHitsFull.back();
       // a flag map for avoiding double counting of clustered cells
       projectionFlag[cellIdProjection] = 0;
     }
@@ -1564,12 +1531,12 @@ int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHit
 
 
     // create new clusters around the projection CMs
-    for(std::map < int , IMPL::CalorimeterHitImpl* > :: const_iterator calHitsCellIdIterator = calHitsCellIdGlobal.begin();
+    for(std::map < int , LCCalHit* > :: const_iterator calHitsCellIdIterator = calHitsCellIdGlobal.begin();
 	calHitsCellIdIterator != calHitsCellIdGlobal.end(); ++calHitsCellIdIterator) {
       const int cellIdHit = calHitsCellIdIterator->first;
 
       std::map < int , double > weightedDistanceV;
-      const IMPL::CalorimeterHitImpl * thisHit = calHitsCellIdIterator->second;
+      const LCCalHit * thisHit = calHitsCellIdIterator->second;
 
       for( MapIntLCCluster::iterator clusterCMIterator = clusterCM[_maxLayerToAnalyse].begin();
 	   clusterCMIterator != clusterCM[_maxLayerToAnalyse].end(); ++clusterCMIterator) {
@@ -1690,7 +1657,7 @@ int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHit
 	const int cellIdHit = cellIds[hitNow];
 
 	std::map < int , double > weightedDistanceV;
-	const IMPL::CalorimeterHitImpl * thisHit = calHitsCellIdGlobal.at(cellIdHit);
+	const LCCalHit * thisHit = calHitsCellIdGlobal.at(cellIdHit);
 
 	int numSuperClustersGood = superClusterAccepted.size();
 	for(int superClusterNowGood = 0; superClusterNowGood < numSuperClustersGood; superClusterNowGood++) {
@@ -1762,15 +1729,8 @@ int LumiCalClustererClass::engyInMoliereCorrections ( MapIntCalHit const& calHit
   }
 
 
-  // cleanUp dynamically allocated memory
-  for( MapIntCalHit::const_iterator calHitsCellIdIterator = calHitsCellIdProjection.begin(); 
-      calHitsCellIdIterator != calHitsCellIdProjection.end(); ++calHitsCellIdIterator ) {
-    delete calHitsCellIdIterator->second;
-  }
-  for( MapIntCalHit::const_iterator calHitsCellIdIterator = calHitsCellIdProjectionFull.begin();
-      calHitsCellIdIterator != calHitsCellIdProjectionFull.end(); ++calHitsCellIdIterator) {
-    delete calHitsCellIdIterator->second;
-  }
+  // the projection hits go out of scope, remove them from the grid
+  calHitsCellIdProjection.clear();
 
   /* --------------------------------------------------------------------------
      re-compute total energy and center of mass of each superCluster (just in case...)
@@ -7,18 +7,12 @@
 #include <algorithm>
 #include <iostream>
 #include <iomanip>
-//Forward Declaration
-namespace IMPL{
-  class CalorimeterHitImpl;
-}
-
-
 
 
 void LumiCalClustererClass::clusterMerger(	std::map < int , std::vector<double> >		& clusterIdToCellEngy,
 						std::map < int , std::vector<int> >		& clusterIdToCellId,
 						std::map < int , LCCluster > & clusterCM,
-						std::map < int , IMPL::CalorimeterHitImpl* >	calHitsCellIdGlobal ){
+						std::map < int , LCCalHit* >	calHitsCellIdGlobal ){
 
 
   int clusterId, clusterId1, clusterId2;
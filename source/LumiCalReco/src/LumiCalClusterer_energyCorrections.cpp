@@ -4,21 +4,17 @@
 using LCHelper::distance2D;
 //Root
 #include <TH1F.h>
-//LCIO
-#include <IMPL/CalorimeterHitImpl.h>
 // stdlib
 #include <map>
+#include <string>
 #include <vector>
 #include <cmath>
-//Forward Declarations
-namespace IMPL{
-  class CalorimeterHitImpl;
-}
 
 void LumiCalClustererClass::energyCorrections (	std::map < int , std::vector<int> >	     & superClusterIdToCellId,
 						std::map < int , std::vector<double> >	     & superClusterIdToCellEngy,
 						std::map < int , LCCluster >		& superClusterCM,
-						std::map < int , IMPL::CalorimeterHitImpl* > const& calHitsCellIdGlobal ) {
+						std::map < int , LCCalHit* > const& calHitsCellIdGlobal,
+						const int detectorArm ) {
 
   std::map < int , std::vector<int> > :: iterator	superClusterIdToCellIdIterator;
 
@@ -43,14 +39,16 @@ void LumiCalClustererClass::energyCorrections (	std::map < int , std::vector<int
   numBins1 = int(hisRange1[1]-hisRange1[0]);// 1 mm bin width
 
 
-  // internal temporary histograms that are not to be written out
-  hisName = "leftSideLargeHis";
+  // internal temporary histograms that are not to be written out, named per arm
+  // as the arms may be clustered at the same time
+  const std::string armName = ( detectorArm < 0 ) ? "_ArmM" : "_ArmP";
+  hisName = "leftSideLargeHis" + armName;
   TH1F leftSideLargeHisH(hisName.c_str(),hisName.c_str(),numBins1,hisRange1[0],hisRange1[1]);
 
-  hisName = "rightSideSmallHis";
+  hisName = "rightSideSmallHis" + armName;
   TH1F rightSideSmallHisH(hisName.c_str(),hisName.c_str(),numBins1,hisRange1[0],hisRange1[1]);
 
-  hisName = "correctionRatio";
+  hisName = "correctionRatio" + armName;
   TH1F correctionRatioH(hisName.c_str(),hisName.c_str(),numBins1,hisRange1[0],hisRange1[1]);
 
 
@@ -105,7 +103,7 @@ void LumiCalClustererClass::energyCorrections (	std::map < int , std::vector<int
     for(int hitNow = 0; hitNow < numElementsInCluster; hitNow++){
       cellIdHit = superClusterIdToCellId[superClusterId][hitNow];
 
-      const IMPL::CalorimeterHitImpl* thisHit = calHitsCellIdGlobal.at(cellIdHit);
+      const LCCalHit* thisHit = calHitsCellIdGlobal.at(cellIdHit);
       double pos3[2] = { thisHit -> getPosition()[0],
 			 thisHit -> getPosition()[1]};
 
@@ -168,7 +166,7 @@ void LumiCalClustererClass::energyCorrections (	std::map < int , std::vector<int
     for(int hitNow = 0; hitNow < numElementsInSuperCluster; hitNow++){
       cellIdHit = superClusterIdToCellId[superClusterId][hitNow];
 
-      const IMPL::CalorimeterHitImpl* thisHit = calHitsCellIdGlobal.at(cellIdHit);
+      const LCCalHit* thisHit = calHitsCellIdGlobal.at(cellIdHit);
       double pos3[2] = { thisHit -> getPosition()[0],
 			 thisHit -> getPosition()[1]};
 
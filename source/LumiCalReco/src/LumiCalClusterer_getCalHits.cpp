@@ -6,9 +6,8 @@
 #include <Exceptions.h>
 #include <EVENT/LCCollection.h>
 #include <EVENT/LCEvent.h>
-#include <IMPL/SimCalorimeterHitImpl.h>
-#include <IMPL/CalorimeterHitImpl.h>
-#include <UTIL/CellIDDecoder.h>
+#include <EVENT/LCIO.h>
+#include <EVENT/SimCalorimeterHit.h>
 // Stdlib
 #include <map>
 #include <vector>
@@ -18,7 +17,7 @@
 
 /* --------------------------------------------------------------------------
    Loop over al hits in the LCCollection and write the hits into vectors
-   of CalorimeterHitImpl. Hits are split in two vectors, one for each arm
+   of LCCalHit. Hits are split in two vectors, one for each arm
    of LumiCal.
    -------------------------------------------------------------------------- */
 int LumiCalClustererClass::getCalHits(	EVENT::LCEvent * evt,
@@ -40,19 +39,20 @@ int LumiCalClustererClass::getCalHits(	EVENT::LCEvent * evt,
   streamlog_out( MESSAGE4 ) << std::endl  << "Getting hit information .... event: "<< evt->getEventNumber() << std::endl;
 #endif
 
-    if (not _mydecoder) {
-      _mydecoder = std::unique_ptr< CellIDDecoder<SimCalorimeterHit> >( new CellIDDecoder<SimCalorimeterHit>(col) );
-    }
     const int nHitsCol = col->getNumberOfElements();
     if ( nHitsCol < _clusterMinNumHits ) return 0;
 
+    _cellIdDecoder.setEncoding( col->getParameters().getStringVal( EVENT::LCIO::CellIDEncoding ), _useDD4hep );
+
+    cleanCalHits( calHits );
+
+    // used by the DD4hep geometry, where the LumiCal is (or not, if we fix it) rotated by pi around Z for negative side
+    const int backwardRotationPhiCells = int(_gmc._backwardRotationPhi/(2.0*M_PI)*_cellPhiMax+0.5);
+
     for (int i=0; i<nHitsCol; ++i) {
-      
-      int arm(0), layer(0);
-      int rCell(0), phiCell(0);
 
       // get the hit from the LCCollection with index i
-      IMPL::SimCalorimeterHitImpl * calHitIn = static_cast<IMPL::SimCalorimeterHitImpl*> (col->getElementAt(i));
+      EVENT::SimCalorimeterHit const* calHitIn = static_cast<EVENT::SimCalorimeterHit const*> (col->getElementAt(i));
 
       const double engyHit = (double)calHitIn -> getEnergy();
 
@@ -62,15 +62,14 @@ int LumiCalClustererClass::getCalHits(	EVENT::LCEvent * evt,
       // versions, so the z must be extracted from the cellId instead ... ????????
       /// APS: Can be taken from the position of the calohit, when it is stored
 
-      // get parameters from the input IMPL::CalorimeterHitImpl
-     
+      // get parameters from the input IMPL::SimCalorimeterHitImpl
+      int arm(0), layer(0);
+      int rCell(0), phiCell(0);
+      _cellIdDecoder.decode( calHitIn, arm, rCell, phiCell, layer );
 
       //using Mokka simulated files
       if( not _useDD4hep ) {
-	arm     = (*_mydecoder)( calHitIn )["S-1"]; // from 0
-	rCell   = (*_mydecoder)( calHitIn )["I"]; // from 0
-	phiCell = (*_mydecoder)( calHitIn )["J"]; // from 0
-	layer   = (*_mydecoder)( calHitIn )["K"]; // counts from 1
+	// arm from 0, rCell and phiCell from 0, layer counts from 1
 	// detector layer  - count layers from zero and not from one
 	layer -= 1 ;
 	// determine the side (arm) of the hit -> (+,-)1
@@ -84,31 +83,26 @@ int LumiCalClustererClass::getCalHits(	EVENT::LCEvent * evt,
 	}
 
       } else {
-	arm =(*_mydecoder)( calHitIn )["barrel"]; // from 1 and 2
+	// arm from 1 and 2, phiCell goes from -phiMax/2 to +phiMax/2, layer counts from 0
 	if( arm == 2 ) arm = -1;
-	phiCell = (*_mydecoder)( calHitIn )["phi"]; // goes from -phiMax/2 to +phiMax/2
 
 	if( arm < 0 ) {
 	  //for rotation around the X-axis, so that the phiCell increases counter-clockwise for z<0
 	  if( phiCell > 0) phiCell =  int(_cellPhiMax/2) - phiCell;
 	  if( phiCell < 0) phiCell = -int(_cellPhiMax/2) - phiCell;
-	  //LumiCall is (or not, if we fix it) rotated by pi around Z for negative side
-	  phiCell += int(_gmc._backwardRotationPhi/(2.0*M_PI)*_cellPhiMax+0.5);
+	  phiCell += backwardRotationPhiCells;
 	}
 
 	if(phiCell >= _cellPhiMax) phiCell -= _cellPhiMax;
 	if(phiCell < 0 ) phiCell += _cellPhiMax; // need to put into positive range only
-	rCell = (*_mydecoder)( calHitIn )["r"];
-	layer = (*_mydecoder)( calHitIn )["layer"]; // counts from 0
       }
 
-      //Calculate internal cellID
-      int cellId = GlobalMethodsClass::CellIdZPR(layer, phiCell, rCell, arm);
-
       // skip this hit if the following conditions are met
       if(layer >= _maxLayerToAnalyse || layer < 0 )	continue;
 
-      
+      //Calculate internal cellID
+      const int cellId = GlobalMethodsClass::CellIdZPR(layer, phiCell, rCell, arm);
+
       /*(BP) it is not safe - in case non-zero crossing angle
             - phi sectors numbering order changes on -ve side
             - in some models there is layers relative phi offset  
@@ -126,40 +120,46 @@ int LumiCalClustererClass::getCalHits(	EVENT::LCEvent * evt,
       // write x,y,z to an array
       float hitPosV[3] = {xHit, yHit, zHit};
       */
-      const float* Pos = calHitIn->getPosition();
-      float locPos[3] = {0.0, 0.0, 0.0};
-      locPos[0] =  Pos[0]*RotMat[arm]["cos"] - Pos[2]*RotMat[arm]["sin"];
-      locPos[1] =  Pos[1];
-      locPos[2] =  Pos[0]*RotMat[arm]["sin"] + Pos[2]*RotMat[arm]["cos"];
+      // the global position is rotated to the local frame of the arm once all hits are read
+
+      // store the hit in the arena of its detector arm, and sum the total
+      // collected energy at either arm
+      _calHitsArena[arm].push_back( LCCalHit( cellId, arm, layer, rCell, phiCell, engyHit, calHitIn->getPosition() ) );
+      _numHitsInArm[arm]++;
+      _totEngyArm[arm] += engyHit;
+    }//for all simHits
+
+    // rotate the hits of each arm to the local frame, and register them by layer.
+    // The arenas are complete, so the pointers into them stay valid until the next event
+    for (MapIntVCalHitArena::iterator armIt = _calHitsArena.begin(); armIt != _calHitsArena.end(); ++armIt) {
+      ArmRotation const& rotation = _armRotation[ ( armIt->first < 0 ) ? 0 : 1 ];
+      const double cosAngle = rotation.cosAngle, sinAngle = rotation.sinAngle;
+      std::vector < LCCalHit > & arenaHits = armIt->second;
+      for (std::vector < LCCalHit >::iterator hitIt = arenaHits.begin(); hitIt != arenaHits.end(); ++hitIt) {
+	float* pos = hitIt->position;
+	const double xHit = pos[0], zHit = pos[2];
+	pos[0] = xHit*cosAngle - zHit*sinAngle;
+	pos[2] = xHit*sinAngle + zHit*cosAngle;
+      }
+
+      for (std::vector < LCCalHit >::iterator hitIt = arenaHits.begin(); hitIt != arenaHits.end(); ++hitIt) {
+	calHits[hitIt->arm][hitIt->layer].push_back( &(*hitIt) );
 
 #if _GENERAL_CLUSTERER_DEBUG == 1
         streamlog_out(DEBUG2) << std::scientific << std::setprecision(3);
 
         streamlog_out(DEBUG2) << "\t Arm, CellId, Pos(x,y,z), hit energy [MeV]: "
-                              << std::setw(5) << arm
+                              << std::setw(5) << hitIt->arm
                               << std::setw(13)
-                              << cellId << "\t ("
-                              << std::setw(13) << locPos[0] << ", "
-                              << std::setw(13) << locPos[1] << ", "
-                              << std::setw(13) << locPos[2] << "), "
-                              << 1000.*engyHit
+                              << hitIt->cellId << "\t ("
+                              << std::setw(13) << hitIt->position[0] << ", "
+                              << std::setw(13) << hitIt->position[1] << ", "
+                              << std::setw(13) << hitIt->position[2] << "), "
+                              << 1000.*hitIt->energy
                               <<std::endl;
-#endif    
-     // 
-      // create a new IMPL::CalorimeterHitImpl
-      IMPL::CalorimeterHitImpl *calHitNew = new IMPL::CalorimeterHitImpl();
-
-      // write the parameters to the new IMPL::CalorimeterHitImpl
-      calHitNew -> setCellID0(cellId);
-      calHitNew -> setEnergy(engyHit);
-      calHitNew -> setPosition(locPos);
-
-      // add the IMPL::CalorimeterHitImpl to a vector according to the detector
-      // arm, and sum the total collected energy at either arm
-      calHits[arm][layer].push_back( calHitNew );
-      _numHitsInArm[arm]++;
-      _totEngyArm[arm] += engyHit;
-    }//for all simHits
+#endif
+      }
+    }
 
 #if _GENERAL_CLUSTERER_DEBUG == 1
     streamlog_out( MESSAGE4 ) << std::endl  << "Energy deposit: "<< _totEngyArm[-1] << "\t" << _totEngyArm[1] <<"\n"
@@ -64,6 +64,7 @@ std::map < int , double > snbx;
 
       if ( !LumiCalClusterer.processEvent(evt) ) return;
 
+      StageTimers::Scope timer(LumiCalClusterer.getStageTimers(), _createCollectionsStage);
       LCCollectionVec* LCalClusterCol = new LCCollectionVec(LCIO::CLUSTER);
       LCCollectionVec* LCalRPCol = new LCCollectionVec(LCIO::RECONSTRUCTEDPARTICLE);
 
@@ -139,6 +140,7 @@ std::map < int , double > snbx;
 	delete LCalClusterCol;
 	delete LCalRPCol;
       }
+      timer.stop();
  
 
 // (BP) this is optional
@@ -1,7 +1,5 @@
 #include "ProjectionInfo.hh"
-
-//LCIO
-#include <IMPL/CalorimeterHitImpl.h>
+#include "LCCalHit.hh"
 
 
 ProjectionInfo::ProjectionInfo (): energy (0.0), cellIdHitZ(0), newObject(true) {
@@ -11,7 +9,7 @@ ProjectionInfo::ProjectionInfo (): energy (0.0), cellIdHitZ(0), newObject(true)
 }
 
 
-ProjectionInfo::ProjectionInfo ( IMPL::CalorimeterHitImpl const* calHit, int cellIdZ):
+ProjectionInfo::ProjectionInfo ( LCCalHit const* calHit, int cellIdZ):
   energy ( calHit->getEnergy() ), cellIdHitZ(cellIdZ), newObject(false){
   position[0] = calHit->getPosition()[0];
   position[1] = calHit->getPosition()[1];
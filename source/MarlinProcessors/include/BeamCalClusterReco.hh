@@ -1,6 +1,8 @@
 #ifndef BeamCalClusterReco_h
 #define BeamCalClusterReco_h 1
 
+#include <functional>
+#include <iosfwd>
 #include <string>
 #include <vector>
 
@@ -14,12 +16,17 @@ class TH1;
 class TRandom3;
 class TString;
 
+class BCClusterWorkspace;
 class BCPCuts;
 class BCPadEnergies;
 class BCRecoObject;
+class BCTowerEnergies;
 class BeamCal;
+class BeamCalFitShower;
 class BeamCalGeo;
 class BeamCalBkg;
+class StageTimers;
+class TaskPool;
 
 class BeamCalClusterReco : public marlin::Processor {
   
@@ -77,6 +84,10 @@ class BeamCalClusterReco : public marlin::Processor {
   int m_nEvt ;
   int m_specialEvent;
   int m_nBXtoOverlay;
+  int m_nBXPerBlock;
+  int m_nBlocks;
+  int m_nBackgroundSamples;
+  int m_nThreads;
   int m_eventSide;
   int m_minimumTowerSize;
   int m_startLookingInLayer;
@@ -84,10 +95,16 @@ class BeamCalClusterReco : public marlin::Processor {
 
   bool m_usePadCuts;
   bool m_useChi2Selection;
+  bool m_useConnectedTowerClustering;
   bool m_createEfficienyFile;
+  bool m_showerFitCovariance;
+  bool m_correlatedTowerErrors;
+  bool m_timeStages;
 
+  double m_bxReplaceFraction;
   double m_sigmaCut;
   double m_TowerChi2ndfLimit;
+  double m_showerFitTolerance;
   double m_calibrationFactor;
 
   std::vector<float> m_startingRings;
@@ -98,7 +115,19 @@ class BeamCalClusterReco : public marlin::Processor {
 
   BeamCalGeo *m_BCG;
   BCPCuts* m_bcpCuts;
+  BCClusterWorkspace *m_clusterWorkspaceLeft, *m_clusterWorkspaceRight;
+  BeamCalFitShower *m_showerFitterLeft, *m_showerFitterRight;
+  /// the event energies ordered by tower for the tower chi2, refilled every event
+  BCTowerEnergies *m_towerSignalLeft, *m_towerSignalRight;
+  /// average and st.dev. of the background ordered by tower, they do not change after init
+  BCTowerEnergies *m_towerAveragesLeft, *m_towerAveragesRight, *m_towerErrorsLeft, *m_towerErrorsRight;
   BeamCalBkg *m_BCbackground;
+  /// threads for the two sides and chunks of towers of one event, NULL runs everything in order
+  TaskPool *m_taskPool;
+  /// times of the steps of the reconstruction and counts of hits and clusters, filled if m_timeStages
+  StageTimers *m_stageTimers;
+  int m_hitDecodingStage, m_backgroundStage, m_clusteringStage, m_towerChi2Stage, m_showerFitStage, m_createCollectionsStage;
+  int m_hitsCounter, m_clustersCounter, m_particlesCounter;
 
   TEfficiency *m_totalEfficiency, *m_thetaEfficieny, *m_phiEfficiency, *m_twoDEfficiency;
   TEfficiency *m_phiFake, *m_thetaFake;
@@ -116,8 +145,13 @@ private:
 				int maxLayer, double maxDeposit, double depositedEnergy,
 				const std::vector<BCRecoObject*> & RecoedObjects) const;
 
-  std::vector<BCRecoObject*> FindClusters(const BCPadEnergies& signalPads, const BCPadEnergies& backgroundPads, const BCPadEnergies& backgroundSigma, const TString& title);
-  std::vector<BCRecoObject*> FindClustersChi2(const BCPadEnergies& signalPads, const BCPadEnergies& backgroundPads, const BCPadEnergies& backgroundSigma, const TString& title);
+  /// The sides can run in different threads, so the messages are written to the messages stream, if it is given
+  std::vector<BCRecoObject*> FindClusters(const BCPadEnergies& signalPads, const BCPadEnergies& backgroundPads, const BCPadEnergies& backgroundSigma, const TString& title, std::ostream* messages);
+  /// Compares the tower energies with the average and st.dev. of the background, which are taken from m_BCbackground
+  std::vector<BCRecoObject*> FindClustersChi2(const BCPadEnergies& signalPads, const TString& title, std::ostream* messages);
+
+  /// call task(i) for i = 0..nTasks-1, in the task pool if there is one
+  void runTasks(int nTasks, const std::function<void(int)>& task);
 
   void DrawElectronMarkers ( const std::vector<BCRecoObject*> & RecoedObjects ) const;
   void DrawLineMarkers ( const std::vector<BCRecoObject*> & RecoedObjects ) const;
@@ -125,6 +159,7 @@ private:
   std::string m_BCalClusterColName;
   std::string m_BCalRPColName;
   std::string m_EfficiencyFileName;
+  std::string m_stageTimesFileName;
 
   BeamCalClusterReco(const BeamCalClusterReco&);
   BeamCalClusterReco& operator=(const BeamCalClusterReco&);
@@ -1,9 +1,11 @@
 #include "BeamCalClusterReco.hh"
 #include "ProcessorUtilities.hh"
 
+#include "BCClusterWorkspace.hh"
 #include "BCPCuts.hh"
 #include "BCPadEnergies.hh"
 #include "BCRecoObject.hh"
+#include "BCTowerEnergies.hh"
 #include "BeamCal.hh"
 #include "BeamCalCluster.hh"
 #include "BCUtilities.hh"
@@ -14,6 +16,9 @@
 #include "BeamCalBkgGauss.hh"
 #include "BeamCalBkgAverage.hh"
 #include "BeamCalFitShower.hh"
+#include "BCRootUtilities.hh"
+#include "StageTimers.hh"
+#include "TaskPool.hh"
 
 //LCIO
 #include <EVENT/LCCollection.h>
@@ -44,13 +49,16 @@
 #include <TPaveText.h>
 #include <TProfile.h>
 #include <TRandom3.h>
+#include <TROOT.h>
 #include <TStyle.h>
 #include <TMarker.h>
 
 //STDLIB
+#include <algorithm>
 #include <numeric>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <utility>
 //#include <set>
 
@@ -83,22 +91,53 @@ BeamCalClusterReco::BeamCalClusterReco() : Processor("BeamCalClusterReco"),
                                            m_nEvt(0),
                                            m_specialEvent(-1),
                                            m_nBXtoOverlay(0),
+                                           m_nBXPerBlock(0),
+                                           m_nBlocks(0),
+                                           m_nBackgroundSamples(10),
+                                           m_nThreads(1),
                                            m_eventSide(-1),
                                            m_minimumTowerSize(0),
                                            m_startLookingInLayer(0),
                                            m_NShowerCountingLayers(0),
                                            m_usePadCuts(true),
 					   m_useChi2Selection(false),
+                                           m_useConnectedTowerClustering(false),
                                            m_createEfficienyFile(false),
+                                           m_showerFitCovariance(false),
+                                           m_correlatedTowerErrors(false),
+                                           m_timeStages(false),
+                                           m_bxReplaceFraction(1.0),
                                            m_sigmaCut(1.0),
                                            m_TowerChi2ndfLimit(5.0),
+                                           m_showerFitTolerance(0.0),
                                            m_calibrationFactor(1.0),
                                            m_startingRings(),
                                            m_requiredRemainingEnergy(),
                                            m_requiredClusterEnergy(),
                                            m_BCG(NULL),
                                            m_bcpCuts(NULL),
+                                           m_clusterWorkspaceLeft(NULL),
+                                           m_clusterWorkspaceRight(NULL),
+                                           m_showerFitterLeft(NULL),
+                                           m_showerFitterRight(NULL),
+                                           m_towerSignalLeft(NULL),
+                                           m_towerSignalRight(NULL),
+                                           m_towerAveragesLeft(NULL),
+                                           m_towerAveragesRight(NULL),
+                                           m_towerErrorsLeft(NULL),
+                                           m_towerErrorsRight(NULL),
 					   m_BCbackground(NULL),
+                                           m_taskPool(NULL),
+                                           m_stageTimers(NULL),
+                                           m_hitDecodingStage(0),
+                                           m_backgroundStage(0),
+                                           m_clusteringStage(0),
+                                           m_towerChi2Stage(0),
+                                           m_showerFitStage(0),
+                                           m_createCollectionsStage(0),
+                                           m_hitsCounter(0),
+                                           m_clustersCounter(0),
+                                           m_particlesCounter(0),
                                            m_totalEfficiency(NULL),
                                            m_thetaEfficieny(NULL),
                                            m_phiEfficiency(NULL),
@@ -111,6 +150,7 @@ BeamCalClusterReco::BeamCalClusterReco() : Processor("BeamCalClusterReco"),
                                            m_BCalClusterColName(""),
                                            m_BCalRPColName(""),
                                            m_EfficiencyFileName(""),
+                                           m_stageTimesFileName(""),
                                            m_usingDD4HEP(false)
 {
 
@@ -153,7 +193,7 @@ registerProcessorParameter ("BackgroundMethod",
 std::vector<std::string> defaultFile;
 defaultFile.push_back("BeamCal.root");
 registerProcessorParameter ("InputFileBackgrounds",
-			      "Root Inputfile(s)",
+			      "Root Inputfile(s), for Pregenerated also background libraries from ConvertBeamCalBackground",
 			      m_files,
 			      defaultFile ) ;
 
@@ -162,6 +202,26 @@ registerProcessorParameter ("NumberOfBX",
 			      m_nBXtoOverlay,
 			      int(1) ) ;
 
+registerProcessorParameter ("NumberOfBXPerBlock",
+			      "Pregenerated only: sum the background from blocks of this many pre-summed Bunch Crossings, NumberOfBX must be a multiple of it, 0 to add every Bunch Crossing",
+			      m_nBXPerBlock,
+			      int(0) ) ;
+
+registerProcessorParameter ("NumberOfBlocks",
+			      "Pregenerated only: number of blocks in the pool, one is redrawn for every event. 0 uses four times the blocks per event",
+			      m_nBlocks,
+			      int(0) ) ;
+
+registerProcessorParameter ("NumberOfBackgroundSamples",
+			      "Pregenerated only: number of sums of NumberOfBX Bunch Crossings used for the average background and its standard deviation",
+			      m_nBackgroundSamples,
+			      int(10) ) ;
+
+registerProcessorParameter ("BXReplaceFraction",
+			      "Pregenerated only: fraction of the Bunch Crossings or blocks of the previous event replaced for the next event, 1 draws all of them again",
+			      m_bxReplaceFraction,
+			      double(1.0) ) ;
+
 std::vector<float> startingRing, padCut, clusterCut;
 startingRing.push_back(0.0);  padCut.push_back(0.5);  clusterCut.push_back(3.0);
 startingRing.push_back(1.0);  padCut.push_back(0.3);  clusterCut.push_back(2.0);
@@ -217,12 +277,41 @@ registerProcessorParameter ("UseChi2Selection",
 			      m_useChi2Selection,
 			      false ) ;
 
+registerProcessorParameter ("UseConnectedTowerClustering",
+			      "Find the connected towers with the union-find algorithm, gives the same clusters as the default algorithm",
+			      m_useConnectedTowerClustering,
+			      false ) ;
+
 registerProcessorParameter ("TowerChi2ndfLimit",
 			      "Limit on square norm of tower energy chi2/ndf, where chi2 = (E_dep - E_bg)^2/sig^2. \
 			      Reasonable value for pregenerated bkg is 5., for parametrised is 2.",
 			      m_TowerChi2ndfLimit,
 			      double(5.0) ) ;
 
+registerProcessorParameter ("ShowerFitTolerance",
+			      "Precision of the shower integral over the pads in the chi2 selection, as fraction of the shower energy. "
+			      "0 integrates in radial shells as before, a value like 1e-4 integrates along the pad sides, which is faster",
+			      m_showerFitTolerance,
+			      double(0.0) ) ;
+
+registerProcessorParameter ("ShowerFitCovariance",
+			      "Pregenerated only: use the covariance of the tower energies of the background samples in the chi2 "
+			      "of the shower fit. Needs more NumberOfBackgroundSamples than spot pads, otherwise the errors are uncorrelated",
+			      m_showerFitCovariance,
+			      false ) ;
+
+registerProcessorParameter ("CorrelatedTowerErrors",
+			      "Pregenerated only: use the st.dev. of the tower energies of the background samples as tower errors, "
+			      "including the pad-to-pad correlations, instead of adding the pad errors in quadrature",
+			      m_correlatedTowerErrors,
+			      false ) ;
+
+
+registerProcessorParameter ("NumberOfThreads",
+			      "Threads for one event: the two sides and chunks of towers of the chi2 selection run in parallel. "
+			      "1 runs everything in order, the reconstructed particles are the same in either case",
+			      m_nThreads,
+			      int(1) ) ;
 
 registerProcessorParameter ("CreateEfficiencyFile",
 			    "Flag to create the TEfficiency for fast tagging library",
@@ -234,6 +323,16 @@ registerProcessorParameter ("EfficiencyFilename",
 			    m_EfficiencyFileName,
 			    std::string("TaggingEfficiency.root") ) ;
 
+registerProcessorParameter ("TimeStages",
+			    "Measure the time of the reconstruction steps and count hits and clusters, printed at the end",
+			    m_timeStages,
+			    false ) ;
+
+registerProcessorParameter ("StageTimesFileName",
+			    "File for the table of the stage times, if empty the table is printed to the log",
+			    m_stageTimesFileName,
+			    std::string("") ) ;
+
 registerProcessorParameter ("PrintThisEvent",
 			    "Number of Event that should be printed to PDF File",
 			    m_specialEvent,
@@ -269,7 +368,11 @@ void BeamCalClusterReco::init() {
 
   // select which background we have
   if(      string("Pregenerated") == m_bgMethodName ) {
-    m_BCbackground = new BeamCalBkgPregen(m_bgMethodName, m_BCG);
+    BeamCalBkgPregen* pregenerated = new BeamCalBkgPregen(m_bgMethodName, m_BCG);
+    pregenerated->setBlockSummation(m_nBXPerBlock, m_nBlocks);
+    pregenerated->setReplaceFraction(m_bxReplaceFraction);
+    pregenerated->setNumberForAverage(m_nBackgroundSamples);
+    m_BCbackground = pregenerated;
   } else if( string("Gaussian") == m_bgMethodName ) {
     m_BCbackground = new BeamCalBkgGauss(m_bgMethodName, m_BCG);
   } else if( string("Parametrised") == m_bgMethodName ) {
@@ -291,10 +394,75 @@ void BeamCalClusterReco::init() {
 			  m_NShowerCountingLayers,
 			  m_usePadCuts,
 			  m_sigmaCut);
+  m_bcpCuts->setUseConnectedTowerClustering(m_useConnectedTowerClustering);
+  m_clusterWorkspaceLeft = new BCClusterWorkspace();
+  m_clusterWorkspaceRight = new BCClusterWorkspace();
+
+  //the shower fits of the two sides use Minuit2 in different threads
+  if( m_nThreads > 1 ) {
+    ROOT::EnableThreadSafety();
+    m_taskPool = new TaskPool(m_nThreads);
+  }
+
+  m_stageTimers = new StageTimers();
+  m_stageTimers->setEnabled(m_timeStages);
+  m_hitDecodingStage       = m_stageTimers->addStage("hitDecoding");
+  m_backgroundStage        = m_stageTimers->addStage("backgroundOverlay");
+  m_clusteringStage        = m_stageTimers->addStage("clustering");
+  m_towerChi2Stage         = m_stageTimers->addStage("towerChi2");
+  m_showerFitStage         = m_stageTimers->addStage("showerFit");
+  m_createCollectionsStage = m_stageTimers->addStage("createCollections");
+  m_hitsCounter            = m_stageTimers->addCounter("hits");
+  m_clustersCounter        = m_stageTimers->addCounter("clusters per side");
+  m_particlesCounter       = m_stageTimers->addCounter("particles");
+
+  //one shower fitter for each side, which keep their memory from event to event
+  const int ndf = m_BCG->getBCLayers() - m_startLookingInLayer;
+  m_showerFitterLeft = new BeamCalFitShower(BCPadEnergies::kLeft);
+  m_showerFitterRight = new BeamCalFitShower(BCPadEnergies::kRight);
+  BeamCalFitShower* showerFitters[2] = { m_showerFitterLeft, m_showerFitterRight };
+  for (int side = 0; side < 2; ++side) {
+    BeamCalFitShower& shower_fitter = *showerFitters[side];
+    shower_fitter.setGeometry(m_BCG);
+    shower_fitter.setBackground(m_BCbackground);
+    shower_fitter.setStartLayer(m_startLookingInLayer);
+    shower_fitter.setCountingLayers(m_NShowerCountingLayers);
+    shower_fitter.setTowerChi2Limit(m_TowerChi2ndfLimit*ndf);
+    shower_fitter.setIntegrationTolerance(m_showerFitTolerance);
+    shower_fitter.setEshwrLimit(m_requiredClusterEnergy.at(0));
+    shower_fitter.setUseCovariance(m_showerFitCovariance);
+  }
+
+  //the covariance of the towers in a shower spot is estimated with the background
+  if( m_showerFitCovariance ) {
+    if( string("Pregenerated") != m_bgMethodName ) {
+      streamlog_out(WARNING) << "Only the pregenerated background provides the tower covariance, "
+			     << "the shower fit uses uncorrelated errors" << std::endl;
+    }
+    m_BCbackground->setTowerCovarianceDistance(m_showerFitterLeft->getSpotDiameter());
+  }
+
+  if( m_correlatedTowerErrors && string("Pregenerated") != m_bgMethodName ) {
+    streamlog_out(WARNING) << "Only the pregenerated background measures the correlated tower errors, "
+			   << "the pad errors are added in quadrature" << std::endl;
+  }
+  m_BCbackground->setCorrelatedTowerErrors(m_correlatedTowerErrors);
 
   m_BCbackground->setBCPCuts(m_bcpCuts);
   m_BCbackground->init(m_files, m_nBXtoOverlay);
 
+  //the background of the tower chi2 is the same for all events, order it by tower once
+  BCPadEnergies padAveragesLeft(m_BCG, BCPadEnergies::kLeft), padAveragesRight(m_BCG, BCPadEnergies::kRight);
+  BCPadEnergies padErrorsLeft(m_BCG, BCPadEnergies::kLeft), padErrorsRight(m_BCG, BCPadEnergies::kRight);
+  m_BCbackground->getAverageBG(padAveragesLeft, padAveragesRight);
+  m_BCbackground->getErrorsBG(padErrorsLeft, padErrorsRight);
+  m_towerAveragesLeft = new BCTowerEnergies(padAveragesLeft);
+  m_towerAveragesRight = new BCTowerEnergies(padAveragesRight);
+  m_towerErrorsLeft = new BCTowerEnergies(padErrorsLeft);
+  m_towerErrorsRight = new BCTowerEnergies(padErrorsRight);
+  m_towerSignalLeft = new BCTowerEnergies(*m_BCG);
+  m_towerSignalRight = new BCTowerEnergies(*m_BCG);
+
   //Create Efficiency Objects if required
   if(m_createEfficienyFile) {
     const double //angles in mrad
@@ -356,9 +524,11 @@ void BeamCalClusterReco::processEvent( LCEvent * evt ) {
   BCPadEnergies padErrorsLeft(m_BCG, BCPadEnergies::kLeft);
   BCPadEnergies padErrorsRight(m_BCG, BCPadEnergies::kRight);
 
+  StageTimers::Scope backgroundTimer(*m_stageTimers, m_backgroundStage);
   m_BCbackground->getEventBG(padEnergiesLeft, padEnergiesRight);
   m_BCbackground->getAverageBG(padAveragesLeft, padAveragesRight);
   m_BCbackground->getErrorsBG(padErrorsLeft, padErrorsRight);
+  backgroundTimer.stop();
 
   streamlog_out(DEBUG4) << "*************** Event " << std::setw(6) << m_nEvt << " ***************" << std::endl;
 
@@ -369,8 +539,10 @@ void BeamCalClusterReco::processEvent( LCEvent * evt ) {
 
   // add the energy in the event to the background/average energy
   if(colBCal) {
+    StageTimers::Scope timer(*m_stageTimers, m_hitDecodingStage);
     CellIDDecoder<SimCalorimeterHit> mydecoder(colBCal);
     int nHits = colBCal->getNumberOfElements();
+    m_stageTimers->count(m_hitsCounter, nHits);
     for(int i=0; i < nHits; i++) {
       SimCalorimeterHit *bcalhit = static_cast<SimCalorimeterHit*>(colBCal->getElementAt(i));
       int side, layer, ring, sector;
@@ -401,15 +573,41 @@ void BeamCalClusterReco::processEvent( LCEvent * evt ) {
     }//for all entries in the collection
   }//if there were hits from the signal
 
-  // Run the clustering
+  // Run the clustering, for both sides at the same time if there are threads
   std::vector<BCRecoObject*> LeftSide,  RightSide;
+  const bool printMessages = streamlog::out.write< MESSAGE2 >();
+  std::ostringstream messagesLeft, messagesRight;
+  //the warnings of the shower fits of both sides are printed after the fits
+  std::ostringstream fitWarningsLeft, fitWarningsRight;
+  m_showerFitterLeft->setWarnings(&fitWarningsLeft);
+  m_showerFitterRight->setWarnings(&fitWarningsRight);
+
+  {
+    //the shower fits must not change the ROOT error level while running in parallel
+    BCUtil::IgnoreRootError ire( m_taskPool != NULL && m_useChi2Selection );
+    runTasks(2, [&](int side) {
+	if( side == 0 ) {
+	  std::ostream* messages = printMessages ? &messagesLeft : NULL;
+	  LeftSide = m_useChi2Selection ?
+	    FindClustersChi2(padEnergiesLeft, "Chi2 6 L", messages) :
+	    FindClusters    (padEnergiesLeft, padAveragesLeft, padErrorsLeft, "Sig 6 L",  messages);
+	} else {
+	  std::ostream* messages = printMessages ? &messagesRight : NULL;
+	  RightSide = m_useChi2Selection ?
+	    FindClustersChi2(padEnergiesRight, "Chi2 6 R", messages) :
+	    FindClusters    (padEnergiesRight, padAveragesRight, padErrorsRight, "Sig 6 R",  messages);
+	}
+      });
+  }
 
-  if ( ! m_useChi2Selection ) {
-    LeftSide = FindClusters(padEnergiesLeft,  padAveragesLeft,  padErrorsLeft,  "Sig 6 L");
-    RightSide= FindClusters(padEnergiesRight, padAveragesRight, padErrorsRight, "Sig 6 R");
-  } else {
-    LeftSide = FindClustersChi2(padEnergiesLeft,  padAveragesLeft,  padErrorsLeft,  "Chi2 6 L");
-    RightSide= FindClustersChi2(padEnergiesRight, padAveragesRight, padErrorsRight, "Chi2 6 R");
+  m_showerFitterLeft->setWarnings(NULL);
+  m_showerFitterRight->setWarnings(NULL);
+  if( not fitWarningsLeft.str().empty() or not fitWarningsRight.str().empty() ) {
+    streamlog_out(WARNING) << fitWarningsLeft.str() << fitWarningsRight.str();
+  }
+
+  if( printMessages ) {
+    streamlog_out(MESSAGE2) << messagesLeft.str() << messagesRight.str();
   }
 
   //merge the two list of clusters so that we can run in one loop
@@ -431,6 +629,8 @@ void BeamCalClusterReco::processEvent( LCEvent * evt ) {
   // Add the found objects to the RecoParticleCollection //
   /////////////////////////////////////////////////////////
 
+  StageTimers::Scope collectionsTimer(*m_stageTimers, m_createCollectionsStage);
+  m_stageTimers->count(m_particlesCounter, LeftSide.size());
   LCCollectionVec* BCalClusterCol = new LCCollectionVec(LCIO::CLUSTER);
   LCCollectionVec* BCalRPCol = new LCCollectionVec(LCIO::RECONSTRUCTEDPARTICLE);
 
@@ -628,6 +828,16 @@ void BeamCalClusterReco::end(){
 			     << std::endl ;
 
 
+  if( m_timeStages ) {
+    if( m_stageTimesFileName.empty() ) {
+      std::ostringstream table;
+      m_stageTimers->print(table);
+      streamlog_out(MESSAGE4) << table.str();
+    } else {
+      m_stageTimers->write(m_stageTimesFileName);
+    }
+  }
+
   if(m_createEfficienyFile) {
     TFile *effFile = TFile::Open(m_EfficiencyFileName.c_str(),"RECREATE");
     m_totalEfficiency->Write();
@@ -659,6 +869,18 @@ void BeamCalClusterReco::end(){
   delete m_BCG;
   delete m_BCbackground;
   delete m_bcpCuts;
+  delete m_clusterWorkspaceLeft;
+  delete m_clusterWorkspaceRight;
+  delete m_taskPool;
+  delete m_stageTimers;
+  delete m_showerFitterLeft;
+  delete m_showerFitterRight;
+  delete m_towerSignalLeft;
+  delete m_towerSignalRight;
+  delete m_towerAveragesLeft;
+  delete m_towerAveragesRight;
+  delete m_towerErrorsLeft;
+  delete m_towerErrorsRight;
 
 }
 
@@ -667,23 +889,30 @@ void BeamCalClusterReco::end(){
 std::vector<BCRecoObject*> BeamCalClusterReco::FindClusters(const BCPadEnergies& signalPads,
 							    const BCPadEnergies& backgroundPads,
 							    const BCPadEnergies& backgroundSigma,
-							    const TString& title) {
+							    const TString& title,
+							    std::ostream* messages) {
 
   std::vector<BCRecoObject*> recoVec;
+  BCClusterWorkspace& workspace =
+    ( signalPads.getSide() == BCPadEnergies::kLeft ) ? *m_clusterWorkspaceLeft : *m_clusterWorkspaceRight;
 
   //////////////////////////////////////////
   // This calls the clustering function!
   //////////////////////////////////////////
+  StageTimers::Scope timer(*m_stageTimers, m_clusteringStage);
   const std::vector<BeamCalCluster> &bccs =
-    signalPads.lookForNeighbouringClustersOverWithVetoAndCheck(backgroundPads, backgroundSigma, *m_bcpCuts);
+    signalPads.lookForNeighbouringClustersOverWithVetoAndCheck(backgroundPads, backgroundSigma, *m_bcpCuts, workspace);
+  m_stageTimers->count(m_clustersCounter, bccs.size());
   const bool isRealParticle = false; //always false here, decide later
 
   for (std::vector<BeamCalCluster>::const_iterator it = bccs.begin(); it != bccs.end(); ++it) {
 
-    streamlog_out(MESSAGE2) << title;
-    if(signalPads.getSide() == BCPadEnergies::kRight) streamlog_out(MESSAGE2) << LONGSTRING;
-    streamlog_out(MESSAGE2) << " " << (*it);
-    if(signalPads.getSide() == BCPadEnergies::kLeft) streamlog_out(MESSAGE2) << LONGSTRING;
+    if( messages ) {
+      *messages << title;
+      if(signalPads.getSide() == BCPadEnergies::kRight) *messages << LONGSTRING;
+      *messages << " " << (*it);
+      if(signalPads.getSide() == BCPadEnergies::kLeft) *messages << LONGSTRING;
+    }
 
     //Apply cuts on the reconstructed clusters, then calculate angles
     if ( ( it->getNPads() > 2 ) && m_bcpCuts->isClusterAboveThreshold( (*it) ) ) {
@@ -691,17 +920,18 @@ std::vector<BCRecoObject*> BeamCalClusterReco::FindClusters(const BCPadEnergies&
       double theta(it->getTheta());
       double phi  (it->getPhi());
 
-      streamlog_out(MESSAGE2) << " found something "
-			      << std::setw(10) << theta
-			      << std::setw(10) << phi
-	;//ending the streamlog!
+      if( messages ) {
+	*messages << " found something "
+		  << std::setw(10) << theta
+		  << std::setw(10) << phi;
+      }
 
       recoVec.push_back( new BCRecoObject(isRealParticle, true, theta, phi, it->getEnergy(), it->getNPads(), signalPads.getSide() ) );
 
     }//if we have enough pads and energy in the clusters
 
     //Finish the output line
-    streamlog_out(MESSAGE2) << std::endl;
+    if( messages ) *messages << std::endl;
 
   }//clusterloop
 
@@ -714,79 +944,45 @@ std::vector<BCRecoObject*> BeamCalClusterReco::FindClusters(const BCPadEnergies&
 * @brief Method of cluster searching by the chi2 criteria
 *
 *
+* The average and standard deviation of the background are the ones of m_BCbackground,
+* ordered by tower in init.
+*
 * @param signalPads Signal energy depositions
-* @param backgroundPads Background energy depositions
-* @param backgroundSigma Standard deviation of the background
 * @param title Some title?
+* @param messages Stream for the log messages, or NULL
 *
 * @return A pointer to vector of BeamCal reconstruction objects.
 */
 std::vector<BCRecoObject*> BeamCalClusterReco::FindClustersChi2(const BCPadEnergies& signalPads,
-							    const BCPadEnergies& backgroundPads,
-							    const BCPadEnergies& backgroundSigma,
-							    const TString& title) 
+							    const TString& title,
+							    std::ostream* messages) 
 {
-//  using BeamCalFitShower::EdepProfile_t;
-
   std::vector<BCRecoObject*> recoVec;
   const bool isRealParticle = false; //always false here, decide later
 
-  vector<EdepProfile_t*> edep_prof; // energy profile for the calorimeter
-
-  vector<double> te_signal, te_bg, te_sigma;
-  int ndf(m_BCG->getBCLayers());
-  // loop over towers
-  for (int it = 0; it < m_BCG->getPadsPerLayer(); it++){
-    // get tower energies, average, sigma
-    signalPads.getTowerEnergies(it, te_signal);
-    backgroundPads.getTowerEnergies(it, te_bg);
-    backgroundSigma.getTowerEnergies(it, te_sigma);
-    ndf = m_BCG->getBCLayers() - m_startLookingInLayer;
-
-    // sums of signal and background along the tower
-    double te_signal_sum(0.), te_bg_sum(0.);
-    double tot_te_sigma(0.); // st.dev. for sum of the energies in the tower
-    m_BCbackground->getTowerErrorsBG(it, signalPads.getSide(), tot_te_sigma);
-
-    // calculate chi2 for this tower in all layers starting from defined
-    double chi2(0.);
-    for (int il = m_startLookingInLayer; il< m_BCG->getBCLayers(); il++){
-      te_signal_sum += te_signal[il];
-      te_bg_sum += te_bg[il];
-      chi2+= pow((te_signal[il] - te_bg[il])/te_sigma[il],2);
-    }
-
-    // calculate sums for this tower in counting layers
-    te_signal_sum = 0.;
-    te_bg_sum = 0.;
-    for (int il = m_startLookingInLayer; il< m_startLookingInLayer+m_NShowerCountingLayers; il++){
-      te_signal_sum += te_signal[il];
-      te_bg_sum += te_bg[il];
-    }
-
-    // create element of energy deposition profile
-    EdepProfile_t *ep = new EdepProfile_t;
-    ep->id = it;
-    ep->towerChi2 = chi2;
-    ep->totalEdep = te_signal_sum;
-    ep->bkgEdep = te_bg_sum;
-    ep->bkgSigma = tot_te_sigma;
-    //std::cout << it<< "\t" <<chi2 << "\t" <<te_signal_sum-te_bg_sum<< std::endl;
-
-    edep_prof.push_back(ep);
-  }
-
-  // create shower fitter for this profile
-  BeamCalFitShower shower_fitter(edep_prof, signalPads.getSide());
-  shower_fitter.setGeometry(m_BCG);
-  shower_fitter.setBackground(m_BCbackground);
-  shower_fitter.setStartLayer(m_startLookingInLayer);
-  shower_fitter.setCountingLayers(m_NShowerCountingLayers);
-  shower_fitter.setTowerChi2Limit(m_TowerChi2ndfLimit*ndf);
-
-  shower_fitter.setEshwrLimit(m_requiredClusterEnergy.at(0));
+  // the shower fitter of this side holds the energy profile for the calorimeter
+  const bool isLeft = ( signalPads.getSide() == BCPadEnergies::kLeft );
+  BeamCalFitShower& shower_fitter = isLeft ? *m_showerFitterLeft : *m_showerFitterRight;
+  const int nTowers = m_BCG->getPadsPerLayer();
+  shower_fitter.resetProfile(nTowers);
+
+  //energies ordered by tower, so that all layers of a tower are read in one go
+  BCTowerEnergies& towerSignal = isLeft ? *m_towerSignalLeft : *m_towerSignalRight;
+  towerSignal.setEnergies(signalPads);
+  const BCTowerEnergies& towerBackground = isLeft ? *m_towerAveragesLeft : *m_towerAveragesRight;
+  const BCTowerEnergies& towerSigma = isLeft ? *m_towerErrorsLeft : *m_towerErrorsRight;
+
+  // loop over towers, in chunks which can run in parallel
+  StageTimers::Scope towerTimer(*m_stageTimers, m_towerChi2Stage);
+  const int towersPerChunk = 256;
+  runTasks( ( nTowers + towersPerChunk - 1 ) / towersPerChunk, [&](int chunk) {
+    shower_fitter.fillProfile(towerSignal, towerBackground, towerSigma,
+                              chunk*towersPerChunk, std::min(nTowers, (chunk+1)*towersPerChunk));
+  });
+  towerTimer.stop();
 
   // Extract fitted showers untill nothing left above some threshold
+  StageTimers::Scope fitTimer(*m_stageTimers, m_showerFitStage);
   while(1){
     double theta(0.), phi(0.), en_shwr(0.), chi2_shwr(0.);
     double shwr_prob = shower_fitter.fitShower(theta, phi, en_shwr, chi2_shwr);
@@ -799,29 +995,34 @@ std::vector<BCRecoObject*> BeamCalClusterReco::FindClustersChi2(const BCPadEnerg
 	signalPads.getSide() ) );
 
       // print the log message
-      streamlog_out(MESSAGE2) << title;
-      if(signalPads.getSide() == BCPadEnergies::kRight) streamlog_out(MESSAGE2) << LONGSTRING;
-      if(signalPads.getSide() == BCPadEnergies::kLeft) streamlog_out(MESSAGE2) << LONGSTRING;
-//      streamlog_out(MESSAGE2) << "\nParticle candidate(s) found with shower energy above threshold: \n";
-      streamlog_out(MESSAGE2) << "\nFound BeamCal particle: \t\t    " 
-                              << std::setw(13) << theta 
-			      << std::setw(13) << phi
-                              << std::setw(13) << en_shwr << std::endl;
+      if ( !messages ) continue;
+      *messages << title;
+      if(signalPads.getSide() == BCPadEnergies::kRight) *messages << LONGSTRING;
+      if(signalPads.getSide() == BCPadEnergies::kLeft) *messages << LONGSTRING;
+//      *messages << "\nParticle candidate(s) found with shower energy above threshold: \n";
+      *messages << "\nFound BeamCal particle: \t\t    " 
+                << std::setw(13) << theta 
+                << std::setw(13) << phi
+                << std::setw(13) << en_shwr << std::endl;
 			      /*
                               << ";\twith chi2/ndf, p-value: " << std::setw(10) << chi2_shwr 
                               << "/" << te_signal.size() - m_startLookingInLayer << std::setw(14) << shwr_prob << std::endl;*/
     }
   }
 
-  // clean
-  while (edep_prof.size() != 0 ){
-    delete edep_prof.back();
-    edep_prof.pop_back();
-  }
-
   return recoVec;
 }
 
+void BeamCalClusterReco::runTasks(int nTasks, const std::function<void(int)>& task) {
+  if( m_taskPool ) {
+    m_taskPool->parallelFor(nTasks, task);
+  } else {
+    for (int i = 0; i < nTasks; ++i) {
+      task(i);
+    }
+  }
+}
+
 void BeamCalClusterReco::printBeamCalEventDisplay(BCPadEnergies& padEnergiesLeft, BCPadEnergies& padEnergiesRight,
 						  int maxLayer, double maxDeposit, double depositedEnergy,
 						  const std::vector<BCRecoObject*> & RecoedObjects) const {
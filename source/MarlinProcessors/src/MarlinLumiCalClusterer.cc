@@ -8,8 +8,9 @@
 #include <gear/CalorimeterParameters.h>
 #include <gear/LayerLayout.h>
 
-#include <string>
 #include <map>
+#include <sstream>
+#include <string>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -160,6 +161,19 @@ MarlinLumiCalClusterer::MarlinLumiCalClusterer() : Processor("MarlinLumiCalClust
                                "Whether to cut clusters outside of the fiducial volume or not",
                                _cutOnFiducialVolume,
                                false );
+  registerProcessorParameter(  "TimeStages",
+                               "Measure the time of the clustering steps and count hits and clusters, printed at the end",
+                               _timeStages,
+                               false );
+  registerProcessorParameter(  "StageTimesFileName",
+                               "File for the table of the stage times, if empty the table is printed to the log",
+                               _stageTimesFileName,
+                               std::string("") );
+  registerProcessorParameter(  "NumberOfThreads",
+                               "Threads for one event: the two arms are clustered in parallel if larger than 1. "
+                               "The clusters are the same in either case",
+                               _nThreads,
+                               int(1) );
 }
 
 
@@ -192,6 +206,9 @@ void MarlinLumiCalClusterer::init(){
   LumiCalClusterer.setLumiCollectionName(LumiInColName);
   LumiCalClusterer.init( gmc );
   LumiCalClusterer.setCutOnFiducialVolume(_cutOnFiducialVolume);
+  LumiCalClusterer.getStageTimers().setEnabled(_timeStages);
+  LumiCalClusterer.setNumberOfThreads(_nThreads);
+  _createCollectionsStage = LumiCalClusterer.getStageTimers().addStage("createCollections");
 
   //OutputManager = new OutputManagerClass();
   OutputManager.Initialize(MemoryResidentTree, SkipNEvents , NumEventsTree, OutDirName, OutRootFileName);
@@ -260,6 +277,16 @@ void MarlinLumiCalClusterer::end(){
     std::cout << "\t" << OutputManager.Counter[counterName] << "  \t <->  " << counterName << std::endl;
   }
 
+  if( _timeStages ) {
+    if( _stageTimesFileName.empty() ) {
+      std::ostringstream table;
+      LumiCalClusterer.getStageTimers().print(table);
+      streamlog_out( MESSAGE ) << table.str();
+    } else {
+      LumiCalClusterer.getStageTimers().write(_stageTimesFileName);
+    }
+  }
+
   // write to the root tree
   OutputManager.WriteToRootTree("forceWrite" , NumEvt);
 
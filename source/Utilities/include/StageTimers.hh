@@ -0,0 +1,97 @@
+#ifndef StageTimers_hh
+#define StageTimers_hh 1
+
+#include <chrono>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Wall clock times of the stages of a reconstruction, and counters like the number    //
+// of hits or clusters in an event. Stages and counters are registered by name once,   //
+// then filled through their index. When disabled a Scope does not read the clock and  //
+// nothing is filled. Every time or count is one entry of a histogram with logarithmic //
+// bins, from which the report gives the mean, the percentiles and the total           //
+/////////////////////////////////////////////////////////////////////////////////////////
+
+class StageTimers {
+
+  typedef std::chrono::steady_clock Clock_t;
+
+public:
+
+  StageTimers();
+
+  inline void setEnabled(bool enabled) { m_enabled = enabled; }
+  inline bool isEnabled() const { return m_enabled; }
+
+  /// index of the stage with this name, it is added if it does not exist yet
+  int addStage(const std::string& name);
+  /// index of the counter with this name, it is added if it does not exist yet
+  int addCounter(const std::string& name);
+
+  /// add one measurement in seconds to the stage, safe to call from several threads
+  void addTime(int stage, double seconds);
+  /// add one entry, e.g. the number of hits in this event, to the counter
+  inline void count(int counter, double value) { if( m_enabled ) addCount(counter, value); }
+
+  /// print the table of stages and counters
+  void print(std::ostream& out) const;
+  /// print the table into the file, throws std::runtime_error if it cannot be written
+  void write(const std::string& fileName) const;
+
+  /// Adds the time from construction to destruction, or to the call of stop, to the stage
+  class Scope {
+  public:
+    Scope(StageTimers& timers, int stage):
+      m_timers( timers.m_enabled ? &timers : NULL ), m_stage(stage), m_start() {
+      if( m_timers ) m_start = Clock_t::now();
+    }
+    ~Scope() { stop(); }
+    /// adds the time up to now to the stage, later calls and the destructor add nothing
+    void stop() {
+      if( m_timers ) m_timers->addTime(m_stage, std::chrono::duration<double>(Clock_t::now() - m_start).count());
+      m_timers = NULL;
+    }
+  private:
+    StageTimers* m_timers;
+    int m_stage;
+    Clock_t::time_point m_start;
+  public:
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+private:
+
+  /// entries in bins of equal width in log10, with an underflow and an overflow bin
+  class Histogram {
+  public:
+    Histogram(const std::string& name, double lowEdge);
+    void fill(double value);
+    /// value below which the fraction of the entries is, interpolated inside the bin
+    double quantile(double fraction) const;
+    std::string m_name;
+    double m_lowEdge;
+    std::vector<long> m_bins;
+    long m_entries;
+    double m_sum, m_min, m_max;
+  };
+
+  static int find(std::vector<Histogram>& histograms, const std::string& name, double lowEdge);
+  static void printTable(std::ostream& out, const std::vector<Histogram>& histograms, double scale);
+  void addCount(int counter, double value);
+
+  bool m_enabled;
+  std::vector<Histogram> m_stages;
+  std::vector<Histogram> m_counters;
+  std::mutex m_mutex;
+
+public:
+  StageTimers(const StageTimers&) = delete;
+  StageTimers& operator=(const StageTimers&) = delete;
+
+};
+
+#endif // StageTimers_hh
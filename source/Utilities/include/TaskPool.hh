@@ -0,0 +1,53 @@
+#ifndef TaskPool_hh
+#define TaskPool_hh 1
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////
+// A small pool of worker threads for the independent parts of one event, e.g. the    //
+// two sides of a calorimeter or chunks of a loop. parallelFor returns when all tasks //
+// are done. The calling thread runs tasks as well, so that a task can itself call    //
+// parallelFor on the same pool. Which thread runs a task is not fixed, the tasks     //
+// must only write to their own results to keep the output deterministic             //
+////////////////////////////////////////////////////////////////////////////////////////
+
+class TaskPool {
+
+public:
+
+  /// nThreads threads in total including the caller, i.e. nThreads-1 workers, 1 or less runs everything in the caller
+  explicit TaskPool(int nThreads);
+  ~TaskPool();
+
+  inline int getNumberOfThreads() const { return int(m_workers.size()) + 1; }
+
+  /// Call task(i) for i = 0..nTasks-1, the first exception thrown by a task is rethrown here
+  void parallelFor(int nTasks, const std::function<void(int)>& task);
+
+private:
+  struct Batch;
+
+  void work();
+  /// start the next task of the batch, called and returning with the lock held
+  void runTask(std::unique_lock<std::mutex>& lock, Batch& batch);
+
+  std::vector<std::thread> m_workers;
+  /// batches with tasks which are not started yet
+  std::deque<Batch*> m_batches;
+  std::mutex m_mutex;
+  std::condition_variable m_wakeUp;
+  std::condition_variable m_finished;
+  bool m_stop;
+
+public:
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+};
+
+#endif // TaskPool_hh
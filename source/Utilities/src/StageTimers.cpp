@@ -0,0 +1,159 @@
+#include "StageTimers.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+  const int binsPerDecade = 8;
+  const int nDecades = 10;
+  /// 100 ns for the times, 1 for the counters
+  const double lowestTime = 1e-7;
+  const double lowestCount = 1.0;
+}
+
+
+StageTimers::Histogram::Histogram(const std::string& name, double lowEdge):
+  m_name(name),
+  m_lowEdge(lowEdge),
+  m_bins(binsPerDecade*nDecades+2, 0),
+  m_entries(0),
+  m_sum(0.0),
+  m_min(std::numeric_limits<double>::max()),
+  m_max(-std::numeric_limits<double>::max())
+{}
+
+
+void StageTimers::Histogram::fill(double value) {
+  int bin = 0;
+  if( value >= m_lowEdge ) {
+    bin = 1 + int( std::log10(value/m_lowEdge) * binsPerDecade );
+    bin = std::min(bin, int(m_bins.size()) - 1);
+  }
+  ++m_bins[bin];
+  ++m_entries;
+  m_sum += value;
+  m_min = std::min(m_min, value);
+  m_max = std::max(m_max, value);
+}
+
+
+double StageTimers::Histogram::quantile(double fraction) const {
+  if( m_entries == 0 ) return 0.0;
+
+  const double target = fraction * double(m_entries);
+  const int overflow = int(m_bins.size()) - 1;
+  double below = 0.0;
+  for (int bin = 0; bin <= overflow; ++bin) {
+    if( m_bins[bin] == 0 || below + double(m_bins[bin]) < target ) {
+      below += double(m_bins[bin]);
+      continue;
+    }
+    if( bin == 0 ) return m_min;
+    if( bin == overflow ) return m_max;
+    const double exponent = double(bin - 1) + ( target - below ) / double(m_bins[bin]);
+    const double value = m_lowEdge * std::pow(10.0, exponent / binsPerDecade);
+    return std::max(m_min, std::min(m_max, value));
+  }
+  return m_max;
+}
+
+
+StageTimers::StageTimers():
+  m_enabled(false),
+  m_stages(),
+  m_counters(),
+  m_mutex()
+{}
+
+
+int StageTimers::find(std::vector<Histogram>& histograms, const std::string& name, double lowEdge) {
+  for (std::vector<Histogram>::const_iterator it = histograms.begin(); it != histograms.end(); ++it) {
+    if( it->m_name == name ) return it - histograms.begin();
+  }
+  histograms.push_back( Histogram(name, lowEdge) );
+  return int(histograms.size()) - 1;
+}
+
+
+int StageTimers::addStage(const std::string& name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return find(m_stages, name, lowestTime);
+}
+
+
+int StageTimers::addCounter(const std::string& name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return find(m_counters, name, lowestCount);
+}
+
+
+void StageTimers::addTime(int stage, double seconds) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stages.at(stage).fill(seconds);
+}
+
+
+void StageTimers::addCount(int counter, double value) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_counters.at(counter).fill(value);
+}
+
+
+void StageTimers::printTable(std::ostream& out, const std::vector<Histogram>& histograms, double scale) {
+  for (std::vector<Histogram>::const_iterator it = histograms.begin(); it != histograms.end(); ++it) {
+    const Histogram& histogram = *it;
+    const double mean = histogram.m_entries > 0 ? histogram.m_sum / double(histogram.m_entries) : 0.0;
+    out << "  " << std::left << std::setw(24) << histogram.m_name << std::right
+	<< std::setw(10) << histogram.m_entries
+	<< std::setw(12) << mean * scale
+	<< std::setw(12) << histogram.quantile(0.50) * scale
+	<< std::setw(12) << histogram.quantile(0.90) * scale
+	<< std::setw(12) << histogram.quantile(0.99) * scale
+	<< std::setw(12) << ( histogram.m_entries > 0 ? histogram.m_max * scale : 0.0 )
+	<< std::setw(14) << histogram.m_sum * scale
+	<< std::endl;
+  }
+}
+
+
+void StageTimers::print(std::ostream& out) const {
+  const std::ios::fmtflags flags = out.flags();
+  const std::streamsize precision = out.precision();
+  out << std::setprecision(4);
+
+  out << "Stage times [ms]" << std::endl
+      << "  " << std::left << std::setw(24) << "stage" << std::right
+      << std::setw(10) << "calls" << std::setw(12) << "mean"
+      << std::setw(12) << "p50" << std::setw(12) << "p90" << std::setw(12) << "p99"
+      << std::setw(12) << "max" << std::setw(14) << "total" << std::endl;
+  printTable(out, m_stages, 1e3);
+
+  if( not m_counters.empty() ) {
+    out << "Counters" << std::endl
+	<< "  " << std::left << std::setw(24) << "counter" << std::right
+	<< std::setw(10) << "entries" << std::setw(12) << "mean"
+	<< std::setw(12) << "p50" << std::setw(12) << "p90" << std::setw(12) << "p99"
+	<< std::setw(12) << "max" << std::setw(14) << "total" << std::endl;
+    printTable(out, m_counters, 1.0);
+  }
+
+  out.flags(flags);
+  out.precision(precision);
+}
+
+
+void StageTimers::write(const std::string& fileName) const {
+  std::ofstream file(fileName.c_str());
+  if( not file ) {
+    throw std::runtime_error("StageTimers: cannot open the file " + fileName);
+  }
+  print(file);
+  if( not file ) {
+    throw std::runtime_error("StageTimers: cannot write the file " + fileName);
+  }
+}
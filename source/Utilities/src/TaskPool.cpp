@@ -0,0 +1,105 @@
+#include "TaskPool.hh"
+
+#include <algorithm>
+#include <exception>
+
+struct TaskPool::Batch {
+  const std::function<void(int)>* task;
+  int nTasks;
+  /// next task to start, and number of tasks finished
+  int next;
+  int done;
+  std::exception_ptr exception;
+};
+
+
+TaskPool::TaskPool(int nThreads):
+  m_workers(),
+  m_batches(),
+  m_mutex(),
+  m_wakeUp(),
+  m_finished(),
+  m_stop(false)
+{
+  for (int i = 1; i < nThreads; ++i) {
+    m_workers.push_back( std::thread(&TaskPool::work, this) );
+  }
+}
+
+
+TaskPool::~TaskPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wakeUp.notify_all();
+  for (std::vector<std::thread>::iterator it = m_workers.begin(); it != m_workers.end(); ++it) {
+    it->join();
+  }
+}
+
+
+void TaskPool::parallelFor(int nTasks, const std::function<void(int)>& task) {
+
+  if( m_workers.empty() || nTasks < 2 ) {
+    for (int i = 0; i < nTasks; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  Batch batch;
+  batch.task = &task;
+  batch.nTasks = nTasks;
+  batch.next = 0;
+  batch.done = 0;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_batches.push_back(&batch);
+  m_wakeUp.notify_all();
+
+  //take part until all tasks are started, then wait for the ones still running elsewhere
+  while( batch.next < batch.nTasks ) {
+    runTask(lock, batch);
+  }
+  while( batch.done < batch.nTasks ) {
+    m_finished.wait(lock);
+  }
+  lock.unlock();
+
+  if( batch.exception ) std::rethrow_exception(batch.exception);
+}
+
+
+void TaskPool::runTask(std::unique_lock<std::mutex>& lock, Batch& batch) {
+
+  const int i = batch.next++;
+  if( batch.next == batch.nTasks ) {
+    m_batches.erase( std::find(m_batches.begin(), m_batches.end(), &batch) );
+  }
+
+  lock.unlock();
+  std::exception_ptr exception;
+  try {
+    (*batch.task)(i);
+  } catch (...) {
+    exception = std::current_exception();
+  }
+  lock.lock();
+
+  if( exception && not batch.exception ) batch.exception = exception;
+  //notify while locked, the caller destroys the batch once it sees the last task done
+  if( ++batch.done == batch.nTasks ) m_finished.notify_all();
+}
+
+
+void TaskPool::work() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while( true ) {
+    while( not m_stop && m_batches.empty() ) {
+      m_wakeUp.wait(lock);
+    }
+    if( m_batches.empty() ) return;
+    runTask(lock, *m_batches.front());
+  }
+}
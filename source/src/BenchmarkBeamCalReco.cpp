@@ -0,0 +1,440 @@
+#include "BCClusterWorkspace.hh"
+#include "BCGaussianGenerator.hh"
+#include "BCPCuts.hh"
+#include "BCPadEnergies.hh"
+#include "BCRootUtilities.hh"
+#include "BCTowerEnergies.hh"
+#include "BeamCalBkg.hh"
+#include "BeamCalBkgAverage.hh"
+#include "BeamCalBkgContext.hh"
+#include "BeamCalBkgGauss.hh"
+#include "BeamCalBkgParam.hh"
+#include "BeamCalBkgPregen.hh"
+#include "BeamCalCluster.hh"
+#include "BeamCalFitShower.hh"
+#include "BeamCalGeoCached.hh"
+
+//GEAR
+#include <gearxml/GearXML.h>
+#include <gear/GearMgr.h>
+
+#include <marlin/Global.h>
+#include <streamlog/streamlog.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Measures the time and the number of allocations per event for the stages of the
+/// BeamCal reconstruction. The events are synthetic: the background of the given number
+/// of bunch crossings is drawn around the bundled average energy density, and the
+/// bundled electron shower is added to a fraction of the events. The stages follow
+/// BeamCalClusterReco with its default cuts, except for thresholds low enough for the
+/// bundled shower. Its clustering call repeats the subtraction and the pad selection,
+/// which are timed on their own before. The program fails if the largest pad of an
+/// injected shower is not in any of the clusters. The background methods
+/// of BeamCalBkg are timed as well, if their input files are given as
+/// Method=file1,file2,... The result is printed as JSON on stdout, everything else
+/// goes to stderr.
+
+namespace {
+
+  std::atomic<long> allocationCounter(0);
+
+}
+
+//count every allocation of the program, including the ones in the libraries
+void* operator new(std::size_t size) {
+  allocationCounter.fetch_add(1, std::memory_order_relaxed);
+  if( size == 0 ) size = 1;
+  while ( true ) {
+    void* memory = std::malloc(size);
+    if( memory ) return memory;
+    std::new_handler handler = std::get_new_handler();
+    if( not handler ) throw std::bad_alloc();
+    handler();
+  }
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+namespace {
+
+  struct Stage {
+    explicit Stage(std::string const& stageName): name(stageName), nanoseconds(0.0), allocations(0), events(0) {}
+    std::string name;
+    double nanoseconds;
+    long allocations;
+    int events;
+  };
+
+  /// Adds the time and the allocations of its lifetime as one event to the stage
+  class StageTimer {
+  public:
+    explicit StageTimer(Stage& stage):
+      m_stage(stage), m_allocations(allocationCounter.load()), m_start(std::chrono::steady_clock::now()) {}
+    ~StageTimer() {
+      const auto stop = std::chrono::steady_clock::now();
+      m_stage.nanoseconds += std::chrono::duration<double, std::nano>(stop - m_start).count();
+      m_stage.allocations += allocationCounter.load() - m_allocations;
+      ++m_stage.events;
+    }
+  private:
+    Stage& m_stage;
+    long m_allocations;
+    std::chrono::steady_clock::time_point m_start;
+  };
+
+  void printStages(std::vector<Stage> const& stages) {
+    std::cout << "  \"stages\": [" << std::endl;
+    for (size_t i = 0; i < stages.size(); ++i) {
+      Stage const& stage = stages[i];
+      const int events = std::max(stage.events, 1);
+      const double nsPerEvent = stage.nanoseconds / events;
+      std::cout << "    { \"name\": \"" << stage.name << "\""
+		<< ", \"ns_per_event\": " << std::fixed << std::setprecision(1) << nsPerEvent
+		<< ", \"allocations_per_event\": " << std::setprecision(2) << double(stage.allocations) / events
+		<< ", \"events_per_second\": " << std::setprecision(1) << ( nsPerEvent > 0.0 ? 1e9 / nsPerEvent : 0.0 ) << " }"
+		<< ( i + 1 < stages.size() ? "," : "" ) << std::endl;
+    }
+    std::cout << "  ]" << std::endl;
+  }
+
+  std::vector<std::string> splitFiles(std::string const& files) {
+    std::vector<std::string> fileList;
+    size_t start = 0;
+    while ( start <= files.size() ) {
+      const size_t end = std::min(files.find(',', start), files.size());
+      if( end > start ) fileList.push_back(files.substr(start, end - start));
+      start = end + 1;
+    }
+    return fileList;
+  }
+
+  /// The background of the synthetic events: the bundled average energy density of one BX
+  /// times the number of BXs, with the density of one BX as its spread, drawn like BeamCalBkgGauss
+  class BeamCalBkgSynthetic : public BeamCalBkg {
+  public:
+    BeamCalBkgSynthetic(BeamCalGeo const* geo, std::vector<BCPadEnergies> const& densities):
+      BeamCalBkg("Synthetic", geo), m_densities(densities) {}
+
+    using BeamCalBkg::init;
+    /// the files are not used, the densities are given to the constructor
+    virtual void init(std::vector<std::string>&, const int n_bx) {
+      this->BeamCalBkg::init(n_bx);
+      m_BeamCalAverageLeft  = new BCPadEnergies(m_densities[0]);
+      m_BeamCalAverageRight = new BCPadEnergies(m_densities[1]);
+      m_BeamCalAverageLeft->scaleEnergies(double(n_bx));
+      m_BeamCalAverageRight->scaleEnergies(double(n_bx));
+      m_BeamCalErrorsLeft  = new BCPadEnergies(m_densities[0]);
+      m_BeamCalErrorsRight = new BCPadEnergies(m_densities[1]);
+      m_BeamCalErrorsLeft->scaleEnergies(std::sqrt(double(n_bx)));
+      m_BeamCalErrorsRight->scaleEnergies(std::sqrt(double(n_bx)));
+      this->BeamCalBkg::setTowerErrors(BCPadEnergies::kLeft);
+      this->BeamCalBkg::setTowerErrors(BCPadEnergies::kRight);
+    }
+
+    virtual void getEventBG(BeamCalBkgContext &context, BCPadEnergies &peLeft, BCPadEnergies &peRight) const {
+      const int nBCpads = m_BCG->getPadsPerBeamCal();
+      context.getGaussian().fill(&(*peLeft.getEnergies())[0], &(*m_BeamCalAverageLeft->getEnergies())[0],
+				 &(*m_BeamCalErrorsLeft->getEnergies())[0], nBCpads);
+      context.getGaussian().fill(&(*peRight.getEnergies())[0], &(*m_BeamCalAverageRight->getEnergies())[0],
+				 &(*m_BeamCalErrorsRight->getEnergies())[0], nBCpads);
+    }
+
+  private:
+    std::vector<BCPadEnergies> const& m_densities;
+  };
+
+  bool containsPad(BCPadEnergies::BeamCalClusterList const& clusters, int padIndex) {
+    for (BCPadEnergies::BeamCalClusterList::const_iterator it = clusters.begin(); it != clusters.end(); ++it) {
+      BeamCalCluster::PadEnergyList const& pads = it->getPads();
+      for (BeamCalCluster::PadEnergyList::const_iterator pad = pads.begin(); pad != pads.end(); ++pad) {
+	if( pad->first == padIndex ) return true;
+      }
+    }
+    return false;
+  }
+
+  BeamCalBkg* createBackground(std::string const& method, BeamCalGeo const* geo) {
+    if( method == "Pregenerated" ) return new BeamCalBkgPregen(method, geo);
+    if( method == "Gaussian" )     return new BeamCalBkgGauss(method, geo);
+    if( method == "Parametrised" ) return new BeamCalBkgParam(method, geo);
+    if( method == "Averaged" )     return new BeamCalBkgAverage(method, geo);
+    throw std::invalid_argument("Unknown BeamCal background method " + method);
+  }
+
+  /// getEventBG of one background method, with a new seed for every event
+  Stage benchmarkBackground(std::string const& method, std::vector<std::string> files, BeamCalGeo const* geo,
+			    BCPCuts const& cuts, int nBX, int nEvents) {
+    BeamCalBkg* background = createBackground(method, geo);
+    background->setBCPCuts(&cuts);
+    background->init(files, nBX);
+    BeamCalBkgContext* context = background->createContext();
+
+    Stage stage("background_" + method);
+    BCPadEnergies left(geo, BCPadEnergies::kLeft), right(geo, BCPadEnergies::kRight);
+    for (int event = 0; event < nEvents; ++event) {
+      left.resetEnergies();
+      right.resetEnergies();
+      context->setSeed(event + 1);
+      StageTimer timer(stage);
+      background->getEventBG(*context, left, right);
+    }
+
+    delete context;
+    delete background;
+    return stage;
+  }
+
+}
+
+int benchmarkBeamCalReco (int argn, char **argc) {
+
+  if ( argn < 4 ) {
+    throw std::invalid_argument("Not enough parameters\nBenchmarkBeamCalReco GearFile SignalFile BackgroundFile "
+				"[events] [BXs] [showerFraction] [Method=file1,file2,...]...");
+  }
+
+  std::string gearFile(argc[1]);
+  std::string signalFile(argc[2]);
+  std::string backgroundFile(argc[3]);
+  const int nEvents = ( argn > 4 ) ? std::atoi(argc[4]) : 100;
+  const int nBX = ( argn > 5 ) ? std::atoi(argc[5]) : 1;
+  const double showerFraction = ( argn > 6 ) ? std::atof(argc[6]) : 0.5;
+  if( nEvents < 1 || nBX < 1 || showerFraction < 0.0 || showerFraction > 1.0 ) {
+    throw std::invalid_argument("Need at least one event and BX, and a shower fraction between 0 and 1");
+  }
+
+  //keep stdout for the results
+  streamlog::out.init(std::cerr, "BenchmarkBeamCalReco");
+  streamlog::logscope scope(streamlog::out);
+  scope.setLevel<streamlog::WARNING>();
+
+  gear::GearXML gearXML( gearFile ) ;
+  gear::GearMgr* gearMgr = gearXML.createGearMgr() ;
+  //the pregenerated background takes the geometry from here
+  marlin::Global::GEAR = gearMgr;
+  BeamCalGeo* geo = new BeamCalGeoCached (gearMgr);
+  const int padsPerBeamCal = geo->getPadsPerBeamCal();
+  const int padsPerLayer = geo->getPadsPerLayer();
+  const int nLayers = geo->getBCLayers();
+
+  //the default cuts of BeamCalClusterReco, with lower thresholds from the fourth ring
+  //on, where the bundled shower is
+  std::vector<float> startingRings, padCuts, clusterCuts;
+  startingRings.push_back(0.0);  padCuts.push_back(0.5);  clusterCuts.push_back(3.0);
+  startingRings.push_back(1.0);  padCuts.push_back(0.3);  clusterCuts.push_back(2.0);
+  startingRings.push_back(2.0);  padCuts.push_back(0.2);  clusterCuts.push_back(1.0);
+  startingRings.push_back(4.0);  padCuts.push_back(0.1);  clusterCuts.push_back(0.5);
+  const int startLayer = 10, countingLayers = 3;
+  const BCPCuts cuts(startingRings, padCuts, clusterCuts, 4, startLayer, countingLayers, true, 1.0);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // The bundled shower, and the average energy density of one BX
+  std::vector<BCPadEnergies> showers(2, geo), densities(2, geo);
+  BCUtil::ReadBecasFile(signalFile, showers);
+  BCUtil::ReadBecasFile(backgroundFile, densities);
+
+  //average and spread of nBX bunch crossings, and the same ordered by tower as in BeamCalClusterReco
+  BeamCalBkgSynthetic background(geo, densities);
+  std::vector<std::string> noFiles;
+  background.setBCPCuts(&cuts);
+  background.init(noFiles, nBX);
+  BeamCalBkgContext* context = background.createContext();
+  context->setSeed(12345);
+  std::vector<BCPadEnergies> averages(2, geo), sigmas(2, geo);
+  background.getAverageBG(averages[0], averages[1]);
+  background.getErrorsBG(sigmas[0], sigmas[1]);
+  std::vector<BCTowerEnergies> towerAverages, towerSigmas;
+  for (int side = 0; side < 2; ++side) {
+    towerAverages.push_back(BCTowerEnergies(averages[side]));
+    towerSigmas.push_back(BCTowerEnergies(sigmas[side]));
+  }
+
+  //one shower fitter for each side, set up as in BeamCalClusterReco
+  std::vector<BeamCalFitShower> showerFitters;
+  showerFitters.push_back(BeamCalFitShower(BCPadEnergies::kLeft));
+  showerFitters.push_back(BeamCalFitShower(BCPadEnergies::kRight));
+  for (int side = 0; side < 2; ++side) {
+    showerFitters[side].setGeometry(geo);
+    showerFitters[side].setBackground(&background);
+    showerFitters[side].setStartLayer(startLayer);
+    showerFitters[side].setCountingLayers(countingLayers);
+    showerFitters[side].setTowerChi2Limit(5.0*(nLayers - startLayer));
+    showerFitters[side].setEshwrLimit(clusterCuts.at(0));
+  }
+
+  std::cerr << "Pads per BeamCal: " << padsPerBeamCal << ", events: " << nEvents << ", BXs: " << nBX
+	    << ", shower fraction: " << showerFraction << std::endl;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // The reconstruction of both sides, stage by stage
+  enum { kBackground, kInjection, kPadArithmetic, kThresholding, kClustering, kTowerProfile, kShowerFit, kEvent };
+  std::vector<Stage> stages;
+  stages.push_back(Stage("background_synthetic"));
+  stages.push_back(Stage("signal_injection"));
+  stages.push_back(Stage("pad_arithmetic"));
+  stages.push_back(Stage("thresholding"));
+  stages.push_back(Stage("clustering"));
+  stages.push_back(Stage("tower_profile"));
+  stages.push_back(Stage("shower_fit"));
+  stages.push_back(Stage("event"));
+
+  std::vector<BCPadEnergies> events;
+  events.push_back(BCPadEnergies(geo, BCPadEnergies::kLeft));
+  events.push_back(BCPadEnergies(geo, BCPadEnergies::kRight));
+  std::vector<BCPadEnergies> testPads(events);
+  BCClusterWorkspace workspace;
+  BCPadEnergies::PadIndexList selectedPads;
+  BCTowerEnergies towerSignal(*geo);
+  long nClusters = 0, nShowers = 0, nSelectedPads = 0;
+  //the reference: every injected shower has to give a cluster with its largest pad
+  int nMissedShowers = 0;
+  std::vector<int> showerPeaks(2, -1);
+  for (int side = 0; side < 2; ++side) {
+    double peakEnergy = 0.0;
+    for (int pad = 0; pad < padsPerBeamCal; ++pad) {
+      if( showers[side].getEnergy(pad) <= peakEnergy ) continue;
+      peakEnergy = showers[side].getEnergy(pad);
+      showerPeaks[side] = pad;
+    }
+  }
+
+  for (int event = 0; event < nEvents; ++event) {
+    //a shower whenever the fraction of events passes the next integer
+    const bool injectShower = int( ( event + 1 ) * showerFraction ) > int( event * showerFraction );
+
+    StageTimer eventTimer(stages[kEvent]);
+
+    {
+      StageTimer timer(stages[kBackground]);
+      background.getEventBG(*context, events[0], events[1]);
+    }
+
+    {
+      StageTimer timer(stages[kInjection]);
+      if( injectShower ) {
+	for (int side = 0; side < 2; ++side) {
+	  events[side].addEnergies(showers[side]);
+	}
+      }
+    }
+
+    {
+      StageTimer timer(stages[kPadArithmetic]);
+      for (int side = 0; side < 2; ++side) {
+	testPads[side].setEnergies(events[side]);
+	testPads[side].subtractEnergiesWithCheck(averages[side], sigmas[side]);
+      }
+    }
+
+    {
+      StageTimer timer(stages[kThresholding]);
+      for (int side = 0; side < 2; ++side) {
+	selectedPads.clear();
+	const double* energies = &(*testPads[side].getEnergies())[0];
+	if( cuts.useConstPadCuts() ) {
+	  BCPadEnergies::selectPadsAboveThresholds(*geo, energies, cuts, selectedPads);
+	} else {
+	  BCPadEnergies::selectPadsAboveSigma(*geo, energies, sigmas[side], cuts, selectedPads);
+	}
+	nSelectedPads += selectedPads.size();
+      }
+    }
+
+    {
+      //the call of BeamCalClusterReco: subtraction, pad selection, tower clustering and the clusters
+      StageTimer timer(stages[kClustering]);
+      for (int side = 0; side < 2; ++side) {
+	const BCPadEnergies::BeamCalClusterList clusters =
+	  events[side].lookForNeighbouringClustersOverWithVetoAndCheck(averages[side], sigmas[side], cuts, workspace);
+	nClusters += clusters.size();
+	if( injectShower && showerPeaks[side] >= 0 && not containsPad(clusters, showerPeaks[side]) ) {
+	  std::cerr << "ERROR: injected shower not found: event " << event << ", side " << side
+		    << " has no cluster with the pad " << showerPeaks[side] << std::endl;
+	  ++nMissedShowers;
+	}
+      }
+    }
+
+    {
+      //as in BeamCalClusterReco::FindClustersChi2
+      StageTimer timer(stages[kTowerProfile]);
+      for (int side = 0; side < 2; ++side) {
+	showerFitters[side].resetProfile(padsPerLayer);
+	towerSignal.setEnergies(events[side]);
+	showerFitters[side].fillProfile(towerSignal, towerAverages[side], towerSigmas[side], 0, padsPerLayer);
+      }
+    }
+
+    {
+      StageTimer timer(stages[kShowerFit]);
+      BCUtil::IgnoreRootError ire;
+      for (int side = 0; side < 2; ++side) {
+	double theta(0.), phi(0.), energy(0.), chi2(0.);
+	while ( showerFitters[side].fitShower(theta, phi, energy, chi2) >= 0.0 ) {
+	  ++nShowers;
+	}
+      }
+    }
+
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // The background methods with input files
+  for (int arg = 7; arg < argn; ++arg) {
+    const std::string methodFiles(argc[arg]);
+    const size_t equal = methodFiles.find('=');
+    if( equal == std::string::npos ) {
+      throw std::invalid_argument("Background methods are given as Method=file1,file2,... not " + methodFiles);
+    }
+    const std::string method = methodFiles.substr(0, equal);
+    std::cerr << "Background method " << method << std::endl;
+    stages.push_back(benchmarkBackground(method, splitFiles(methodFiles.substr(equal + 1)), geo, cuts, nBX, nEvents));
+  }
+
+  std::cout << "{" << std::endl
+	    << "  \"benchmark\": \"BeamCalReco\"," << std::endl
+	    << "  \"events\": " << nEvents << "," << std::endl
+	    << "  \"bx\": " << nBX << "," << std::endl
+	    << "  \"shower_fraction\": " << showerFraction << "," << std::endl
+	    << "  \"pads_per_beamcal\": " << padsPerBeamCal << "," << std::endl
+	    << "  \"selected_pads_per_event\": " << double(nSelectedPads) / nEvents << "," << std::endl
+	    << "  \"clusters_per_event\": " << double(nClusters) / nEvents << "," << std::endl
+	    << "  \"showers_per_event\": " << double(nShowers) / nEvents << "," << std::endl;
+  printStages(stages);
+  std::cout << "}" << std::endl;
+
+  delete context;
+  delete geo;
+  return nMissedShowers == 0 ? 0 : 1;
+}
+
+
+int main (int argn, char **argc) {
+
+  try {
+    return benchmarkBeamCalReco(argn, argc);
+  } catch (std::out_of_range &e) {
+    std::cerr << "Geometry does not agree with energy in the trees:" << e.what()
+	      << std::endl;
+    return 1;
+  } catch (std::invalid_argument &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  } catch (gear::ParseException &e) {
+    std::cerr << e.what();
+    return 1;
+  }
+
+}
@@ -0,0 +1,114 @@
+#include "BCGaussianGenerator.hh"
+#include "BCPadEnergies.hh"
+#include "BCPadKernels.hh"
+#include "BeamCalGeoCached.hh"
+
+//GEAR
+#include <gearxml/GearXML.h>
+#include <gear/GearMgr.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+/// Measures the time per BeamCal for the element-wise operations on the pad
+/// energies and the gaussian random numbers, for the plain loops and for the
+/// vectorised kernels if the CPU supports them
+
+namespace {
+
+  template<class Operation>
+  double timePerBeamCal(Operation const& operation, int repetitions) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i) {
+      operation();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / repetitions;
+  }
+
+  void printResult(std::string const& name, double nanoseconds, int padsPerBeamCal) {
+    std::cout << std::setw(28) << std::left << name << std::right
+	      << std::setw(12) << std::fixed << std::setprecision(1) << nanoseconds << " ns/BeamCal"
+	      << std::setw(12) << std::setprecision(3) << double(padsPerBeamCal) / nanoseconds << " pads/ns"
+	      << std::endl;
+  }
+
+}
+
+int benchmarkPadKernels (int argn, char **argc) {
+
+  if ( argn < 2 ) {
+    throw std::invalid_argument("Not enough parameters\nBenchmarkPadKernels GearFile [repetitions]");
+  }
+
+  std::string gearFile(argc[1]);
+  const int repetitions = ( argn > 2 ) ? std::atoi(argc[2]) : 10000;
+
+  gear::GearXML gearXML( gearFile ) ;
+  gear::GearMgr* gearMgr = gearXML.createGearMgr() ;
+  BeamCalGeo* geo = new BeamCalGeoCached (gearMgr);
+  const int padsPerBeamCal = geo->getPadsPerBeamCal();
+
+  //some energies in all pads, and a sigma for each pad
+  BCPadEnergies signal(geo), background(geo), sigma(geo);
+  std::srand(12345);
+  for (int i = 0; i < padsPerBeamCal; ++i) {
+    signal.setEnergy(i, 0.3 * std::rand() / double(RAND_MAX));
+    background.setEnergy(i, 0.02 * std::rand() / double(RAND_MAX));
+    sigma.setEnergy(i, 0.05 + 0.05 * std::rand() / double(RAND_MAX));
+  }
+  std::vector<int> indices;
+  indices.reserve(padsPerBeamCal);
+  BCGaussianGenerator gaussian;
+  double sink = 0.0;
+
+  std::cout << "Pads per BeamCal: " << padsPerBeamCal << ", repetitions: " << repetitions << std::endl;
+
+  const BCPadKernels::Implementation_t implementations[] = { BCPadKernels::kScalar, BCPadKernels::kAVX2 };
+  for (auto implementation : implementations) {
+    if( not BCPadKernels::setImplementation(implementation) ) {
+      std::cout << BCPadKernels::getImplementationName(implementation) << " is not supported" << std::endl;
+      continue;
+    }
+    std::cout << "Implementation: " << BCPadKernels::getImplementationName(implementation) << std::endl;
+
+    printResult("addEnergies", timePerBeamCal([&]() { signal.addEnergies(background); }, repetitions), padsPerBeamCal);
+    printResult("subtractEnergies", timePerBeamCal([&]() { signal.subtractEnergies(background); }, repetitions), padsPerBeamCal);
+    printResult("scaleEnergies", timePerBeamCal([&]() { signal.scaleEnergies(1.0); }, repetitions), padsPerBeamCal);
+    printResult("getTotalEnergy", timePerBeamCal([&]() { sink += signal.getTotalEnergy(); }, repetitions), padsPerBeamCal);
+    printResult("subtractEnergiesWithCheck", timePerBeamCal([&]() {
+	  BCPadEnergies testPads(signal);
+	  testPads.subtractEnergiesWithCheck(background, sigma);
+	}, repetitions), padsPerBeamCal);
+    printResult("selectAboveSigma", timePerBeamCal([&]() {
+	  indices.clear();
+	  BCPadKernels::selectAboveSigma(&(*signal.getEnergies())[0], &(*sigma.getEnergies())[0], 1.0, 0.1,
+					 padsPerBeamCal, 0, indices);
+	}, repetitions), padsPerBeamCal);
+
+  }//all implementations
+
+  std::cout << "Selected " << indices.size() << " pads, total energy " << sink << std::endl;
+
+  delete geo;
+  return 0;
+}
+
+
+int main (int argn, char **argc) {
+
+  try {
+    return benchmarkPadKernels(argn, argc);
+  } catch (std::invalid_argument &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  } catch (gear::ParseException &e) {
+    std::cerr << e.what();
+    return 1;
+  }
+
+}
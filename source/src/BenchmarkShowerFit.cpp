@@ -0,0 +1,150 @@
+#include "BeamCalFitShower.hh"
+#include "BeamCalGeoCached.hh"
+#include "BeamCalPadGeometry.hh"
+
+//GEAR
+#include <gearxml/GearXML.h>
+#include <gear/GearMgr.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+/// Measures the wall time per fitted shower in BeamCalFitShower, for the integral in
+/// radial shells and for the integral along the pad sides, with the derivatives of
+/// the chi2 from Minuit2 or from the analytic gradient
+
+namespace {
+
+  const double moliereRadius = 9.3;
+
+  struct Shower {
+    double R, phi, A, sigma;
+  };
+
+  /// energy profile of all towers with one shower and gaussian noise
+  std::vector<EdepProfile_t> makeProfile(BeamCalGeo const& geo, Shower const& shower, double noise,
+                                         std::mt19937& generator) {
+    std::normal_distribution<double> gaussian(0.0, noise);
+    std::vector<EdepProfile_t> profile(geo.getPadsPerLayer());
+    for (int id = 0; id < geo.getPadsPerLayer(); ++id) {
+      double extents[6];
+      geo.getPadExtentsById(id, extents);
+      double dphi = extents[3] - extents[2];
+      if (dphi < 0)
+        dphi += 360.;
+      BeamCalPadGeometry pad(extents[4], extents[5] * M_PI / 180., extents[1] - extents[0], dphi * M_PI / 180.);
+      pad.setLocalCoords(shower.R, shower.phi);
+      const double energy = pad.integrateEdges(shower.A, shower.sigma, 3 * moliereRadius, 1e-6) + gaussian(generator);
+
+      EdepProfile_t& ep = profile[id];
+      ep.id             = id;
+      ep.totalEdep      = energy;
+      ep.bkgEdep        = 0.0;
+      ep.bkgSigma       = noise;
+      ep.towerChi2      = energy * energy / (noise * noise);
+    }
+    return profile;
+  }
+
+  void benchmark(std::string const& name, BeamCalGeo const& geo, std::vector<Shower> const& showers,
+                 std::vector<std::vector<EdepProfile_t> > const& profiles, double tolerance, bool useGradient) {
+    double sumDTheta = 0.0, sumDPhi = 0.0, sumEnergy = 0.0;
+    int    nFitted = 0;
+
+    BeamCalFitShower fitter(BCPadEnergies::kLeft);
+    fitter.setGeometry(&geo);
+    fitter.setTowerChi2Limit(25.0);
+    fitter.setIntegrationTolerance(tolerance);
+    fitter.setUseGradient(useGradient);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < profiles.size(); ++i) {
+      fitter.resetProfile(profiles[i].size());
+      for (size_t tower = 0; tower < profiles[i].size(); ++tower) {
+        fitter.getTower(tower) = profiles[i][tower];
+      }
+
+      double theta(0.), phi(0.), energy(0.), chi2(0.);
+      if (fitter.fitShower(theta, phi, energy, chi2) < 0.)
+        continue;
+
+      const double trueTheta = showers[i].R / geo.getLayerZDistanceToIP(1) * 1000.;
+      double       dPhi      = phi - showers[i].phi * 180. / M_PI;
+      dPhi -= 360. * std::floor(dPhi / 360. + 0.5);
+      sumDTheta += std::fabs(theta - trueTheta);
+      sumDPhi += std::fabs(dPhi);
+      sumEnergy += energy;
+      ++nFitted;
+    }
+    const auto stop = std::chrono::steady_clock::now();
+
+    const double microseconds = std::chrono::duration<double, std::micro>(stop - start).count() / profiles.size();
+    std::cout << std::setw(28) << std::left << name << std::right << std::setw(10) << std::fixed
+              << std::setprecision(1) << microseconds << " us/shower" << std::setw(8) << nFitted << " fitted"
+              << std::setprecision(4) << "  <|dtheta|> " << sumDTheta / std::max(nFitted, 1) << " mrad"
+              << "  <|dphi|> " << sumDPhi / std::max(nFitted, 1) << " deg"
+              << "  <E> " << sumEnergy / std::max(nFitted, 1) << std::endl;
+  }
+
+}
+
+int benchmarkShowerFit (int argn, char **argc) {
+
+  if ( argn < 2 ) {
+    throw std::invalid_argument("Not enough parameters\nBenchmarkShowerFit GearFile [showers] [tolerance]");
+  }
+
+  std::string gearFile(argc[1]);
+  const int nShowers = ( argn > 2 ) ? std::atoi(argc[2]) : 200;
+  const double tolerance = ( argn > 3 ) ? std::atof(argc[3]) : 1e-4;
+
+  gear::GearXML gearXML( gearFile ) ;
+  gear::GearMgr* gearMgr = gearXML.createGearMgr() ;
+  BeamCalGeo* geo = new BeamCalGeoCached (gearMgr);
+
+  //showers in the middle of the BeamCal, away from the inner and outer edge
+  std::mt19937 generator(12345);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  const double innerRadius = geo->getBCInnerRadius() + 2 * moliereRadius;
+  const double outerRadius = geo->getBCOuterRadius() - 2 * moliereRadius;
+  std::vector<Shower> showers;
+  std::vector<std::vector<EdepProfile_t> > profiles;
+  for (int i = 0; i < nShowers; ++i) {
+    Shower shower;
+    shower.R     = innerRadius + ( outerRadius - innerRadius ) * uniform(generator);
+    shower.phi   = 2 * M_PI * uniform(generator);
+    shower.sigma = ( 0.2 + 0.3 * uniform(generator) ) * moliereRadius;
+    shower.A     = 5.0 / ( 2 * M_PI * shower.sigma * shower.sigma );
+    showers.push_back(shower);
+    profiles.push_back(makeProfile(*geo, shower, 0.01, generator));
+  }
+
+  std::cout << "Showers: " << nShowers << ", tolerance of the integral along the sides: " << tolerance << std::endl;
+  benchmark("shells", *geo, showers, profiles, 0.0, false);
+  benchmark("sides, numerical gradient", *geo, showers, profiles, tolerance, false);
+  benchmark("sides, analytic gradient", *geo, showers, profiles, tolerance, true);
+
+  delete geo;
+  return 0;
+}
+
+
+int main (int argn, char **argc) {
+
+  try {
+    return benchmarkShowerFit(argn, argc);
+  } catch (std::invalid_argument &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  } catch (gear::ParseException &e) {
+    std::cerr << e.what();
+    return 1;
+  }
+
+}
@@ -0,0 +1,81 @@
+#include "BCBackgroundLibrary.hh"
+
+//ROOT
+#include <TChain.h>
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Packs the bunch crossings in the bcTree of the pregenerated background files
+/// into a binary background library, which can be given to the Pregenerated
+/// background method instead of the ROOT files
+
+int convertBeamCalBackground (int argn, char **argc) {
+
+  if ( argn < 4 ) {
+    throw std::invalid_argument("Not enough parameters\n"
+				"ConvertBeamCalBackground <float|double> <OutputFile> <RootFile> [RootFile...]");
+  }
+
+  const std::string type(argc[1]);
+  BCBackgroundLibrary::ElementType_t elementType;
+  if( type == "float" ) {
+    elementType = BCBackgroundLibrary::kFloat;
+  } else if( type == "double" ) {
+    elementType = BCBackgroundLibrary::kDouble;
+  } else {
+    throw std::invalid_argument("Element type has to be float or double, not " + type);
+  }
+
+  TChain backgroundBX("bcTree");
+  for (int i = 3; i < argn; ++i) {
+    backgroundBX.Add(argc[i]);
+  }
+
+  std::vector<double> *depositsLeft(NULL), *depositsRight(NULL);
+  backgroundBX.SetBranchAddress("vec_left" , &depositsLeft);
+  backgroundBX.SetBranchAddress("vec_right", &depositsRight);
+
+  const int nBunchCrossings = backgroundBX.GetEntries();
+  if( nBunchCrossings == 0 ) {
+    throw std::invalid_argument("No bunch crossings found in the bcTree of the input files");
+  }
+  backgroundBX.GetEntry(0);
+  const int nPads = depositsLeft->size();
+
+  std::ofstream output(argc[2], std::ios::binary);
+  BCBackgroundLibrary::writeHeader(output, elementType, nPads, nBunchCrossings);
+  for (int bx = 0; bx < nBunchCrossings; ++bx) {
+    backgroundBX.GetEntry(bx);
+    if( int(depositsLeft->size()) != nPads || int(depositsRight->size()) != nPads ) {
+      throw std::invalid_argument("Bunch crossings have different numbers of pads");
+    }
+    BCBackgroundLibrary::writeBunchCrossing(output, elementType, *depositsLeft, *depositsRight);
+  }
+  output.close();
+  if( output.fail() ) {
+    throw std::runtime_error(std::string("Failed to write ") + argc[2]);
+  }
+
+  std::cout << "Wrote " << nBunchCrossings << " bunch crossings with " << nPads
+	    << " pads as " << type << " to " << argc[2] << std::endl;
+
+  delete depositsLeft;
+  delete depositsRight;
+  return 0;
+}
+
+
+int main (int argn, char **argc) {
+
+  try {
+    return convertBeamCalBackground(argn, argc);
+  } catch (std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+}
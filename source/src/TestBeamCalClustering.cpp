@@ -0,0 +1,195 @@
+#include "BCClusterBatch.hh"
+#include "BCClusterWorkspace.hh"
+#include "BCPCuts.hh"
+#include "BCPadEnergies.hh"
+#include "BCPadKernels.hh"
+#include "BeamCalCluster.hh"
+#include "BeamCalGeoCached.hh"
+#include "TaskPool.hh"
+
+//GEAR
+#include <gearxml/GearXML.h>
+#include <gear/GearMgr.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Compare the clusters of the faster ways to cluster the BeamCal with the clusters of
+/// BCPadEnergies with the plain loops and the nearest neighbour tower clustering: the
+/// connected tower clustering, the vectorised pad kernels and BCClusterBatch with and
+/// without threads. All of them have to give the same clusters bit for bit
+
+namespace {
+
+  typedef std::vector<BCClusterBatch::Cluster_t> ClusterTable;
+
+  bool sameDouble(double a, double b) { return std::memcmp(&a, &b, sizeof(double)) == 0; }
+
+  bool sameCluster(BCClusterBatch::Cluster_t const& a, BCClusterBatch::Cluster_t const& b) {
+    return a.event == b.event && a.seedTower == b.seedTower && a.nPads == b.nPads &&
+      sameDouble(a.energy, b.energy) && sameDouble(a.theta, b.theta) &&
+      sameDouble(a.phi, b.phi) && sameDouble(a.ring, b.ring);
+  }
+
+  /// the clusters of every event from the BCPadEnergies functions, in the rows of BCClusterBatch
+  ClusterTable clusterEvents(BeamCalGeo const* geo, BCPadEnergies::BeamCalSide_t side,
+			     std::vector<double> const& energies, BCPadEnergies const& background,
+			     BCPadEnergies const& sigmas, BCPCuts const& cuts, bool withVeto) {
+    const int padsPerBeamCal = geo->getPadsPerBeamCal();
+    const int nEvents = energies.size() / padsPerBeamCal;
+    BCPadEnergies event(geo, side);
+    BCClusterWorkspace workspace;
+    ClusterTable table;
+    for (int iEvent = 0; iEvent < nEvents; ++iEvent) {
+      for (int pad = 0; pad < padsPerBeamCal; ++pad) {
+	event.setEnergy(pad, energies[iEvent*padsPerBeamCal + pad]);
+      }
+      const BCPadEnergies::BeamCalClusterList clusters = withVeto ?
+	event.lookForNeighbouringClustersOverWithVetoAndCheck(background, sigmas, cuts, workspace) :
+	event.lookForNeighbouringClustersOverSigma(sigmas, cuts, workspace);
+      for (BCPadEnergies::BeamCalClusterList::const_iterator it = clusters.begin(); it != clusters.end(); ++it) {
+	BCClusterBatch::Cluster_t row;
+	row.event = iEvent;
+	row.seedTower = it->getPadIndexInLayer();
+	row.nPads = it->getNPads();
+	row.energy = it->getEnergy();
+	row.theta = it->getTheta();
+	row.phi = it->getPhi();
+	row.ring = it->getRing();
+	table.push_back(row);
+      }
+    }
+    return table;
+  }
+
+  ClusterTable clusterBatch(BeamCalGeo const* geo, BCPadEnergies::BeamCalSide_t side,
+			    std::vector<double> const& energies, BCPadEnergies const& background,
+			    BCPadEnergies const& sigmas, BCPCuts const& cuts, bool withVeto, TaskPool* pool) {
+    BCClusterBatch batch(*geo, side);
+    if( withVeto ) {
+      batch.lookForNeighbouringClustersOverWithVetoAndCheck(energies, background, sigmas, cuts, pool);
+    } else {
+      batch.lookForNeighbouringClustersOverSigma(energies, sigmas, cuts, pool);
+    }
+    return batch.getClusters();
+  }
+
+  /// returns the number of differences, which are printed
+  int compare(std::string const& name, ClusterTable const& reference, ClusterTable const& clusters) {
+    if( reference.size() != clusters.size() ) {
+      std::cout << "ERROR: clusters differ: " << name << " found " << clusters.size()
+		<< " clusters instead of " << reference.size() << std::endl;
+      return 1;
+    }
+    int nDifferences = 0;
+    for (size_t i = 0; i < reference.size(); ++i) {
+      if( sameCluster(reference[i], clusters[i]) ) continue;
+      if( ++nDifferences > 10 ) continue;
+      std::cout << "ERROR: clusters differ: " << name << std::setprecision(17) << " event " << clusters[i].event
+		<< " seed " << clusters[i].seedTower << " pads " << clusters[i].nPads
+		<< " energy " << clusters[i].energy << " instead of event " << reference[i].event
+		<< " seed " << reference[i].seedTower << " pads " << reference[i].nPads
+		<< " energy " << reference[i].energy << std::endl;
+    }
+    return nDifferences;
+  }
+
+}
+
+int testBeamCalClustering(int argn, char **argc) {
+
+  if ( argn < 2 ) {
+    throw std::invalid_argument("Not enough parameters\nTestBeamCalClustering GearFile [events]");
+  }
+
+  gear::GearXML gearXML( argc[1] ) ;
+  gear::GearMgr* gearMgr = gearXML.createGearMgr() ;
+  BeamCalGeo* geo = new BeamCalGeoCached (gearMgr);
+  const int padsPerBeamCal = geo->getPadsPerBeamCal();
+  const int nEvents = ( argn > 2 ) ? std::atoi(argc[2]) : 200;
+
+  //sigma cuts and constant pad cuts, as in the tests of BeamCalClusterReco
+  std::vector<BCPCuts> allCuts(1);
+  allCuts[0].setSigmaCut(1.0).setStartLayer(10).setMinimumTowerSize(3);
+  std::vector<float> startingRings, padCuts, clusterCuts;
+  startingRings.push_back(0.0);  padCuts.push_back(0.15);  clusterCuts.push_back(3.0);
+  startingRings.push_back(3.0);  padCuts.push_back(0.1);   clusterCuts.push_back(2.0);
+  startingRings.push_back(6.0);  padCuts.push_back(0.2);   clusterCuts.push_back(1.0);
+  allCuts.push_back(BCPCuts(startingRings, padCuts, clusterCuts, 3, 10, 3, true, 1.0));
+
+  const BCPadKernels::Implementation_t bestKernels = BCPadKernels::getBestImplementation();
+  TaskPool pool(4);
+
+  std::mt19937 generator(12345);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  int nDifferences = 0;
+  long nClusters = 0;
+
+  for (int side = 0; side < 2; ++side) {
+    const BCPadEnergies::BeamCalSide_t bcSide = ( side == 0 ) ? BCPadEnergies::kLeft : BCPadEnergies::kRight;
+
+    //a fifth of the pads are hit, so that there are clusters of all sizes
+    BCPadEnergies background(geo, bcSide), sigmas(geo, bcSide);
+    for (int pad = 0; pad < padsPerBeamCal; ++pad) {
+      sigmas.setEnergy(pad, 0.05 + 0.05*uniform(generator));
+      background.setEnergy(pad, 0.02*uniform(generator));
+    }
+    std::vector<double> energies(size_t(nEvents)*padsPerBeamCal, 0.0);
+    for (size_t pad = 0; pad < energies.size(); ++pad) {
+      if( uniform(generator) < 0.2 ) energies[pad] = 0.3*uniform(generator);
+    }
+
+    for (size_t iCuts = 0; iCuts < allCuts.size(); ++iCuts) {
+      BCPCuts cuts(allCuts[iCuts]);
+      for (int withVeto = 0; withVeto < 2; ++withVeto) {
+	const std::string setup = std::string( side == 0 ? "left" : "right" ) +
+	  ( cuts.useConstPadCuts() ? ", pad cuts" : ", sigma cuts" ) + ( withVeto ? ", veto" : "" );
+
+	BCPadKernels::setImplementation(BCPadKernels::kScalar);
+	cuts.setUseConnectedTowerClustering(false);
+	const ClusterTable reference = clusterEvents(geo, bcSide, energies, background, sigmas, cuts, withVeto);
+	nClusters += reference.size();
+
+	nDifferences += compare("batch, " + setup, reference,
+				clusterBatch(geo, bcSide, energies, background, sigmas, cuts, withVeto, NULL));
+
+	cuts.setUseConnectedTowerClustering(true);
+	nDifferences += compare("connected towers, " + setup, reference,
+				clusterEvents(geo, bcSide, energies, background, sigmas, cuts, withVeto));
+
+	BCPadKernels::setImplementation(bestKernels);
+	nDifferences += compare(std::string(BCPadKernels::getImplementationName(bestKernels)) + " kernels, " + setup,
+				reference, clusterEvents(geo, bcSide, energies, background, sigmas, cuts, withVeto));
+	nDifferences += compare("batch with threads, " + setup, reference,
+				clusterBatch(geo, bcSide, energies, background, sigmas, cuts, withVeto, &pool));
+      }
+    }
+  }
+
+  std::cout << "Compared " << nClusters << " clusters in " << nEvents << " events per side, with the "
+	    << BCPadKernels::getImplementationName(bestKernels) << " kernels" << std::endl;
+
+  delete geo;
+  return nDifferences == 0 ? 0 : 1;
+}
+
+
+int main (int argn, char **argc) {
+
+  try {
+    return testBeamCalClustering(argn, argc);
+  } catch (std::invalid_argument &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  } catch (gear::ParseException &e) {
+    std::cerr << e.what();
+    return 1;
+  }
+
+}
@@ -0,0 +1,100 @@
+#include "LCCalHit.hh"
+#include "LCCellGrid.hh"
+
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+/// Compare LCCellGrid with the std::map < int , LCCalHit* > it replaces in the LumiCal
+/// clustering: the same hits have to be found, and the cellIds have to be looped over
+/// in the same order, after inserting, replacing, erasing and clearing hits
+
+namespace {
+
+  typedef std::map < int , LCCalHit* > HitMap;
+
+  /// returns the number of differences, which are printed
+  int compare(int step, LCCellGrid const& grid, HitMap const& hits, std::vector<int> const& allCellIds) {
+    int nDifferences = 0;
+    if( grid.size() != int(hits.size()) ) {
+      std::cout << "ERROR: cell grid differs: step " << step << " has " << grid.size()
+		<< " hits instead of " << hits.size() << std::endl;
+      ++nDifferences;
+    }
+
+    std::vector<int> mapCellIds;
+    for (HitMap::const_iterator it = hits.begin(); it != hits.end(); ++it) {
+      mapCellIds.push_back(it->first);
+    }
+    if( grid.cellIds() != mapCellIds ) {
+      std::cout << "ERROR: cell grid differs: step " << step << " loops over the cellIds in another order" << std::endl;
+      ++nDifferences;
+    }
+
+    for (std::vector<int>::const_iterator it = allCellIds.begin(); it != allCellIds.end(); ++it) {
+      HitMap::const_iterator hit = hits.find(*it);
+      if( grid.find(*it) != ( hit == hits.end() ? NULL : hit->second ) ) {
+	std::cout << "ERROR: cell grid differs: step " << step << " finds another hit in cellId " << *it << std::endl;
+	++nDifferences;
+      }
+    }
+    return nDifferences;
+  }
+
+}
+
+int testLCCellGrid() {
+  //the size of the LumiCal layers, with the arm and layer fields above R and phi
+  const int cellRMax = 64, cellPhiMax = 48;
+  const int upperFields = ( 1 << 20 ) | ( 7 << 22 );
+  const int nSteps = 20000;
+
+  std::vector<int> allCellIds;
+  std::vector<LCCalHit> allHits;
+  const float position[3] = { 0.0, 0.0, 0.0 };
+  for (int phi = 0; phi < cellPhiMax; ++phi) {
+    for (int r = 0; r < cellRMax; ++r) {
+      const int cellId = upperFields | ( phi << 10 ) | r;
+      allCellIds.push_back(cellId);
+      allHits.push_back(LCCalHit(cellId, 1, 7, r, phi, 1.0, position));
+      allHits.push_back(LCCalHit(cellId, 1, 7, r, phi, 2.0, position));
+    }
+  }
+
+  LCCellGrid grid;
+  grid.setSize(cellRMax, cellPhiMax);
+  HitMap hits;
+
+  std::mt19937 generator(12345);
+  std::uniform_int_distribution<int> anyCell(0, allCellIds.size() - 1);
+  std::uniform_int_distribution<int> anyOperation(0, 999);
+  int nDifferences = 0;
+
+  for (int step = 0; step < nSteps; ++step) {
+    const int cell = anyCell(generator);
+    const int cellId = allCellIds[cell];
+    const int operation = anyOperation(generator);
+    if( operation < 600 ) {
+      //new hits and replaced hits
+      LCCalHit* calHit = &allHits[2*cell + ( hits.count(cellId) ? 1 : 0 )];
+      grid.insert(cellId, calHit);
+      hits[cellId] = calHit;
+    } else if( operation < 999 ) {
+      grid.erase(cellId);
+      hits.erase(cellId);
+    } else {
+      grid.clear();
+      hits.clear();
+    }
+    //the order is only checked now and then, so that erased cells pile up in between
+    if( step % 97 == 0 ) nDifferences += compare(step, grid, hits, allCellIds);
+  }
+  nDifferences += compare(nSteps, grid, hits, allCellIds);
+
+  std::cout << "Compared the cell grid with the map in " << nSteps << " steps" << std::endl;
+
+  return nDifferences == 0 ? 0 : 1;
+}
+
+int main() { return testLCCellGrid(); }
@@ -0,0 +1,93 @@
+#include "LCCellIdDecoder.hh"
+
+#include <IMPL/SimCalorimeterHitImpl.h>
+#include <UTIL/BitField64.h>
+#include <lcio.h>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/// Compare LCCellIdDecoder with UTIL::BitField64 for the Mokka and the DD4hep encodings of
+/// the LumiCal. The DD4hep encodings have their last field in the highest bits, signed and
+/// unsigned, so that cellIDs with the highest bit set and negative values there are decoded
+/// as well
+
+namespace {
+
+  struct Encoding_t {
+    Encoding_t(std::string const& enc, bool dd4hep): encoding(enc), useDD4hep(dd4hep) {}
+    std::string encoding;
+    bool useDD4hep;
+  };
+
+  /// returns the number of differences, which are printed
+  int compare(Encoding_t const& setup, int nCellIds, std::mt19937& generator) {
+    const char* mokkaNames[4] = { "S-1", "I", "J", "K" };
+    const char* dd4hepNames[4] = { "barrel", "r", "phi", "layer" };
+    const char** names = setup.useDD4hep ? dd4hepNames : mokkaNames;
+
+    LCCellIdDecoder decoder;
+    decoder.setEncoding(setup.encoding, setup.useDD4hep);
+    UTIL::BitField64 bitField(setup.encoding);
+
+    int nDifferences = 0;
+    for (int i = 0; i < nCellIds; ++i) {
+      //every field gets a random value in its range, the first cellIDs get the smallest
+      //and the largest values of all fields
+      bitField.reset();
+      for (size_t field = 0; field < bitField.size(); ++field) {
+	UTIL::BitFieldValue& value = bitField[field];
+	const lcio::long64 range = 1LL << value.width();
+	const lcio::long64 minimum = value.isSigned() ? -range/2 : 0;
+	const lcio::long64 maximum = minimum + range - 1;
+	if( i == 0 ) {
+	  value = minimum;
+	} else if( i == 1 ) {
+	  value = maximum;
+	} else {
+	  value = std::uniform_int_distribution<lcio::long64>(minimum, maximum)(generator);
+	}
+      }
+
+      IMPL::SimCalorimeterHitImpl hit;
+      hit.setCellID0( bitField.lowWord() );
+      hit.setCellID1( bitField.highWord() );
+
+      int decoded[4] = { 0, 0, 0, 0 };
+      decoder.decode( &hit, decoded[0], decoded[1], decoded[2], decoded[3] );
+      for (int field = 0; field < 4; ++field) {
+	const lcio::long64 expected = bitField[ names[field] ].value();
+	if( decoded[field] == expected ) continue;
+	if( ++nDifferences > 10 ) continue;
+	std::cout << "ERROR: cellID decoded differently: " << setup.encoding << " cellID " << bitField.getValue()
+		  << " field " << names[field] << " is " << decoded[field] << " instead of " << expected << std::endl;
+      }
+    }
+    return nDifferences;
+  }
+
+}
+
+int testLCCellIdDecoder() {
+  std::vector<Encoding_t> encodings;
+  encodings.push_back(Encoding_t("I:10,J:10,K:10,S-1:2", false));
+  //the LumiCal readout of DD4hep, with the signed phi field in the highest bits
+  encodings.push_back(Encoding_t("system:8,barrel:3,layer:8,slice:5,r:32:16,phi:-16", true));
+  encodings.push_back(Encoding_t("system:8,barrel:3,layer:8,slice:5,r:32:16,phi:16", true));
+  encodings.push_back(Encoding_t("system:8,barrel:-3,layer:8,slice:5,r:32:-16,phi:-16", true));
+
+  std::mt19937 generator(12345);
+  const int nCellIds = 10000;
+  int nDifferences = 0;
+  for (size_t i = 0; i < encodings.size(); ++i) {
+    nDifferences += compare(encodings[i], nCellIds, generator);
+  }
+
+  std::cout << "Compared " << nCellIds << " cellIDs in " << encodings.size() << " encodings" << std::endl;
+
+  return nDifferences == 0 ? 0 : 1;
+}
+
+int main() { return testLCCellIdDecoder(); }
@@ -0,0 +1,104 @@
+#include "BeamCalPadGeometry.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/// Compare the integral along the pad sides with the integral in radial shells used in BeamCalFitShower,
+/// and its derivatives with finite differences
+int testShowerIntegration() {
+  const double moliereRadius = 9.3;
+  const double rmax          = 3 * moliereRadius;
+  const double padSize       = 8.0;
+
+  std::mt19937                           generator(12345);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  double maxFineDifference = 0.0, maxShellDifference = 0.0, maxToleranceDifference = 0.0;
+  double maxDerivativeDifference = 0.0;
+  int    nFailures = 0;
+
+  for (int test = 0; test < 500; ++test) {
+    const double padR    = 20.0 + 110.0 * uniform(generator);
+    const int    nPhi    = 8 * (2 + int(8 * uniform(generator)));
+    const double padDPhi = 2 * M_PI / nPhi;
+    const double padPhi  = 2 * M_PI * uniform(generator);
+    const double sigma   = 0.5 + (moliereRadius - 0.5) * uniform(generator);
+
+    //shower center inside the central pad, whose outer side is a chord
+    const double centerPhi = padPhi + 0.9 * (uniform(generator) - 0.5) * padDPhi;
+    const double innerR    = padR - 0.45 * padSize;
+    const double outerR =
+        (padR + 0.5 * padSize) * std::cos(0.5 * padDPhi) / std::cos(centerPhi - padPhi) - 0.05 * padSize;
+    const double centerR = innerR + (outerR - innerR) * uniform(generator);
+
+    const double showerEnergy = 2 * M_PI * sigma * sigma;
+
+    for (int ring = -2; ring <= 2; ++ring) {
+      for (int sector = -3; sector <= 3; ++sector) {
+        BeamCalPadGeometry pad(padR + ring * padSize, padPhi + sector * padDPhi, padSize, padDPhi);
+        pad.m_isCentral = (ring == 0 && sector == 0);
+        pad.setLocalCoords(centerR, centerPhi);
+
+        const double edges     = pad.integrateEdges(1.0, sigma, rmax, 1e-9);
+        const double fine      = pad.integrateShells(1.0, sigma, 0.0005 * moliereRadius, rmax);
+        const double shells    = pad.integrateShells(1.0, sigma, 0.05 * moliereRadius, rmax);
+        const double tolerance = pad.integrateEdges(1.0, sigma, rmax, 1e-4);
+
+        //derivatives by sigma and the shower center, relative to the shower energy over sigma
+        double       dSigma(0.), dX(0.), dY(0.);
+        const double step = 1e-4;
+        pad.integrateEdges(1.0, sigma, rmax, 1e-6, dSigma, dX, dY);
+        const double finiteSigma =
+            (pad.integrateEdges(1.0, sigma + step, rmax, 1e-11) - pad.integrateEdges(1.0, sigma - step, rmax, 1e-11)) /
+            (2 * step);
+        const double x = centerR * std::cos(centerPhi), y = centerR * std::sin(centerPhi);
+        const auto   shifted = [&](double dx, double dy) {
+          pad.setLocalCoords(std::hypot(x + dx, y + dy), std::atan2(y + dy, x + dx));
+          return pad.integrateEdges(1.0, sigma, rmax, 1e-11);
+        };
+        const double finiteX = (shifted(step, 0.0) - shifted(-step, 0.0)) / (2 * step);
+        const double finiteY = (shifted(0.0, step) - shifted(0.0, -step)) / (2 * step);
+        pad.setLocalCoords(centerR, centerPhi);
+        const double derivativeDifference =
+            std::max(std::fabs(dSigma - finiteSigma), std::max(std::fabs(dX - finiteX), std::fabs(dY - finiteY))) *
+            sigma / showerEnergy;
+        maxDerivativeDifference = std::max(maxDerivativeDifference, derivativeDifference);
+
+        const double fineDifference      = std::fabs(edges - fine) / showerEnergy;
+        const double toleranceDifference = std::fabs(edges - tolerance) / showerEnergy;
+        maxFineDifference                = std::max(maxFineDifference, fineDifference);
+        maxToleranceDifference           = std::max(maxToleranceDifference, toleranceDifference);
+
+        //the shells of the fit are too coarse for narrow showers
+        const double shellDifference = std::fabs(edges - shells) / showerEnergy;
+        if (sigma > 0.2 * moliereRadius) {
+          maxShellDifference = std::max(maxShellDifference, shellDifference);
+        }
+
+        if (fineDifference > 1e-3 || toleranceDifference > 1e-4 || derivativeDifference > 1e-5 ||
+            (sigma > 0.2 * moliereRadius && shellDifference > 2e-2)) {
+          std::cout << "ERROR: shower integrals disagree: R " << padR + ring * padSize << " phi "
+                    << padPhi + sector * padDPhi << " sigma " << sigma << " sides " << edges << " shells " << shells
+                    << " fine shells " << fine << " derivatives " << dSigma << " " << dX << " " << dY
+                    << " finite differences " << finiteSigma << " " << finiteX << " " << finiteY << std::endl;
+          ++nFailures;
+        }
+      }
+    }
+  }
+
+  std::cout << "Largest difference to the shell integral as fraction of the shower energy" << std::endl;
+  std::cout << "  fine shells:      " << std::setw(12) << maxFineDifference << std::endl;
+  std::cout << "  shells of fit:    " << std::setw(12) << maxShellDifference << std::endl;
+  std::cout << "  tolerance 1e-4:   " << std::setw(12) << maxToleranceDifference << std::endl;
+  std::cout << "Largest difference of the derivatives to finite differences, times sigma" << std::endl;
+  std::cout << "  derivatives:      " << std::setw(12) << maxDerivativeDifference << std::endl;
+
+  return nFailures == 0 ? 0 : 1;
+}
+
+int main() { return testShowerIntegration(); }